@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * Helpers shared by the benchmarks: percentiles of samples, running code on
+ * the message thread and what the process holds (memory, children).
+ */
+
+#pragma once
+
+#include <juce_cmp/juce_cmp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include <unistd.h>
+
+#if __APPLE__
+#include <mach/mach.h>
+#endif
+
+namespace benchmark
+{
+    /** The p-th percentile of values, sorting them. */
+    inline double percentile(std::vector<double>& values, int p)
+    {
+        if (values.empty())
+            return 0.0;
+        std::sort(values.begin(), values.end());
+        return values[(values.size() - 1) * static_cast<size_t>(p) / 100];
+    }
+
+    /** p50, p90, p99 and max of samples, each named with unit appended. */
+    inline void addPercentiles(juce::DynamicObject& result, std::vector<double>& samples, const juce::String& unit = {})
+    {
+        result.setProperty("p50" + unit, percentile(samples, 50));
+        result.setProperty("p90" + unit, percentile(samples, 90));
+        result.setProperty("p99" + unit, percentile(samples, 99));
+        result.setProperty("max" + unit, samples.empty() ? 0.0 : samples.back());
+    }
+
+    /** p50, p90, p99 and max of samples as an object of their own. */
+    inline juce::var percentiles(std::vector<double>& samples)
+    {
+        auto* result = new juce::DynamicObject();
+        addPercentiles(*result, samples);
+        return juce::var(result);
+    }
+
+    /** Runs a function on the message thread and waits for it. */
+    inline void onMessageThread(const std::function<void()>& function)
+    {
+        juce::WaitableEvent done;
+        juce::MessageManager::callAsync([&]() {
+            function();
+            done.signal();
+        });
+        done.wait();
+    }
+
+    /** Resident memory of this process. */
+    inline uint64_t residentBytes()
+    {
+#if __linux__
+        unsigned long long pages = 0, resident = 0;
+        if (auto* statm = std::fopen("/proc/self/statm", "r"))
+        {
+            if (std::fscanf(statm, "%llu %llu", &pages, &resident) != 2)
+                resident = 0;
+            std::fclose(statm);
+        }
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#elif __APPLE__
+        mach_task_basic_info_data_t info {};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+            return 0;
+        return info.resident_size;
+#else
+        return 0;
+#endif
+    }
+
+    struct Children
+    {
+        int alive = -1;
+        int zombies = -1;
+    };
+
+    /** Child processes of this one, -1 each where they can't be listed. */
+    inline Children countChildren()
+    {
+        Children children;
+#if __APPLE__ || __linux__
+        children = { 0, 0 };
+        for (const auto& child : juce_cmp::ChildProcess::listChildren())
+        {
+            if (child.zombie)
+                ++children.zombies;
+            else
+                ++children.alive;
+        }
+#endif
+        return children;
+    }
+}  // namespace benchmark
@@ -0,0 +1,287 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * allocation-benchmark - Heap allocations per message on the IPC hot path.
+ *
+ * Connects an Ipc to a stand-in UI over a socketpair, completes the
+ * handshake, warms up, then counts every allocation in the process (all
+ * threads, the message thread included) while messages flow: input events,
+ * typed messages and ValueTrees to the UI, typed messages and ValueTrees
+ * back. Input events and typed messages should allocate nothing; the exit
+ * code is 1 if they do, so it can gate a CI job. ValueTrees are listed for
+ * comparison, the tree itself is always allocated.
+ *
+ * On glibc, malloc itself is counted (juce::HeapBlock uses it directly);
+ * elsewhere only operator new.
+ *
+ * Usage: allocation-benchmark [messages per case]
+ */
+
+#include <juce_cmp/juce_cmp.h>
+#include "Messages.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace juce_cmp;
+
+namespace
+{
+    std::atomic<bool> counting { false };
+    std::atomic<uint64_t> allocations { 0 };
+
+    inline void countAllocation()
+    {
+        if (counting.load(std::memory_order_relaxed))
+            allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+
+    void* malloc(size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_realloc(ptr, size);
+    }
+}
+#else
+void* operator new(std::size_t size)
+{
+    countAllocation();
+    if (void* ptr = std::malloc(size > 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+
+namespace
+{
+    void waitUntil(const std::function<bool()>& done)
+    {
+        while (!done())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool writeAll(int fd, const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0)
+        {
+            const auto n = ::write(fd, bytes, size);
+            if (n <= 0)
+                return false;
+            bytes += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /** The UI end: answers nothing, reads everything. */
+    struct FakeUi
+    {
+        int fd = -1;
+        std::atomic<uint64_t> bytesRead { 0 };
+        std::thread reader;
+
+        void start()
+        {
+            reader = std::thread([this]() {
+                uint8_t buffer[64 * 1024];
+                ssize_t n;
+                while ((n = ::read(fd, buffer, sizeof(buffer))) > 0)
+                    bytesRead.fetch_add(static_cast<uint64_t>(n));
+            });
+        }
+
+        void sendHello()
+        {
+            HelloMessage hello = {};
+            hello.magic = IPC_HELLO_MAGIC;
+            hello.version = IPC_PROTOCOL_VERSION;
+            hello.capabilities = IPC_CAP_CHUNKS | IPC_CAP_TYPED;
+            hello.transports = IPC_TRANSPORT_SOCKET;
+            hello.codecs = IPC_CODEC_RAW | IPC_CODEC_DICT;
+            hello.maxMessageSize = IPC_MAX_MESSAGE_SIZE;
+
+            uint8_t message[2 + sizeof(HelloMessage)] = { EVENT_TYPE_CMP, CMP_EVENT_HELLO };
+            std::memcpy(message + 2, &hello, sizeof(hello));
+            writeAll(fd, message, sizeof(message));
+        }
+    };
+
+    struct Case
+    {
+        const char* name;
+        bool mustBeFree;
+        std::function<void(int)> send;     // One message
+        std::function<bool()> delivered;   // All sent so far arrived
+    };
+
+    double measure(const Case& c, int count)
+    {
+        // Warm up pools, queues and the inbox, then count a second batch
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            allocations.store(0);
+            counting.store(pass == 1);
+
+            for (int i = 0; i < count; ++i)
+                c.send(i);
+            waitUntil(c.delivered);
+
+            counting.store(false);
+        }
+        return static_cast<double>(allocations.load()) / count;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int count = argc > 1 ? juce::jmax(1, std::atoi(argv[1])) : 10000;
+
+    juce::ScopedJuceInitialiser_GUI init;
+    std::atomic<int> exitCode { 0 };
+
+    std::thread worker([&]() {
+        int fds[2] = { -1, -1 };
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            std::fprintf(stderr, "socketpair failed\n");
+            exitCode.store(2);
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+            return;
+        }
+
+        std::atomic<uint64_t> typedReceived { 0 };
+        std::atomic<uint64_t> eventsReceived { 0 };
+
+        Ipc ipc;
+        ipc.setSocketFD(fds[0]);
+        ipc.setTypedHandler([&](const TypedMessage&) { typedReceived.fetch_add(1); });
+        ipc.setEventHandler([&](const juce::ValueTree&) { eventsReceived.fetch_add(1); });
+        ipc.startReceiving();
+
+        FakeUi ui;
+        ui.fd = fds[1];
+        ui.start();
+        ui.sendHello();
+        waitUntil([&]() { return ipc.hasCapability(IPC_CAP_TYPED); });
+
+        const auto sentAll = [&]() {
+            return ipc.getPendingTxBytes() == 0 && ui.bytesRead.load() == ipc.getCounters().txBytes;
+        };
+
+        // Messages from the UI, encoded up front
+        uint8_t typedMessage[5 + messages::Parameter::wireSize] = { EVENT_TYPE_TYPED };
+        {
+            const uint16_t header[2] = { messages::Parameter::id, messages::Parameter::wireSize };
+            std::memcpy(typedMessage + 1, header, sizeof(header));
+            messages::Parameter { 1, 0.5 }.encode(typedMessage + 5);
+        }
+
+        juce::ValueTree param("param");
+        param.setProperty("id", 1, nullptr);
+        param.setProperty("value", 0.5, nullptr);
+
+        juce::MemoryOutputStream treeMessage;
+        {
+            juce::MemoryOutputStream tree;
+            param.writeToStream(tree);
+            const auto size = static_cast<uint32_t>(tree.getDataSize());
+            treeMessage.writeByte(static_cast<char>(EVENT_TYPE_JUCE));
+            treeMessage.write(&size, sizeof(size));
+            treeMessage.write(tree.getData(), tree.getDataSize());
+        }
+
+        uint64_t typedExpected = 0;
+        uint64_t eventsExpected = 0;
+
+        const Case cases[] = {
+            { "input event, to UI", true,
+              [&](int i) {
+                  InputEvent event = {};
+                  event.type = INPUT_EVENT_MOUSE;
+                  event.x = static_cast<int16_t>(i & 0xFF);
+                  ipc.sendInput(event);
+              },
+              sentAll },
+            { "typed, to UI", true,
+              [&](int i) {
+                  uint8_t data[messages::Parameter::wireSize];
+                  messages::Parameter { i & 7, i * 0.001 }.encode(data);
+                  ipc.sendTyped(messages::Parameter::id, data, sizeof(data), IPC_LANE_CONTROL);
+              },
+              sentAll },
+            { "ValueTree, to UI", false,
+              [&](int i) {
+                  param.setProperty("value", i * 0.001, nullptr);
+                  ipc.sendEvent(param);
+              },
+              sentAll },
+            { "typed, from UI", true,
+              [&](int) {
+                  ++typedExpected;
+                  writeAll(ui.fd, typedMessage, sizeof(typedMessage));
+              },
+              [&]() { return typedReceived.load() == typedExpected; } },
+            { "ValueTree, from UI", false,
+              [&](int) {
+                  ++eventsExpected;
+                  writeAll(ui.fd, treeMessage.getData(), treeMessage.getDataSize());
+              },
+              [&]() { return eventsReceived.load() == eventsExpected; } },
+        };
+
+        std::printf("%-22s %16s\n", "case", "allocs/message");
+        for (const auto& c : cases)
+        {
+            const double perMessage = measure(c, count);
+            std::printf("%-22s %16.3f%s\n", c.name, perMessage, c.mustBeFree && perMessage > 0.0 ? "  FAIL" : "");
+            if (c.mustBeFree && perMessage > 0.0)
+                exitCode.store(1);
+        }
+
+        ipc.stop();
+        ui.reader.join();
+        ::close(fds[1]);
+
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    });
+
+    // Typed messages and trees from the UI are delivered here
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    worker.join();
+
+    return exitCode.load();
+}
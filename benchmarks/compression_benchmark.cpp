@@ -0,0 +1,223 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * compression-benchmark - Where LZ4 starts paying off on a local socket.
+ *
+ * Sends serialized ValueTrees of increasing size over a Unix socket pair,
+ * raw and LZ4 compressed, and times each message from the start of encoding
+ * until the receiving thread has decoded it and acknowledged. The first
+ * size from which compression wins every time is the crossover point that
+ * IPC_COMPRESS_THRESHOLD should sit near.
+ *
+ * Usage: compression-benchmark [iterations]
+ */
+
+#include <juce_cmp/juce_cmp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace juce_cmp;
+
+namespace
+{
+    // Preset-like tree: parameters with ids, names and values
+    juce::MemoryBlock makePayload(size_t targetSize)
+    {
+        juce::ValueTree state("STATE");
+        juce::Random random(1);
+
+        for (int i = 0;; ++i)
+        {
+            juce::ValueTree param("PARAM");
+            param.setProperty("id", "param" + juce::String(i), nullptr);
+            param.setProperty("name", "Parameter " + juce::String(i), nullptr);
+            param.setProperty("value", random.nextDouble(), nullptr);
+            param.setProperty("automated", (i % 3) == 0, nullptr);
+            state.appendChild(param, nullptr);
+
+            // Serializing is the slow part, check the size every so often
+            if ((i % 64) != 63)
+                continue;
+
+            juce::MemoryOutputStream stream;
+            state.writeToStream(stream);
+            if (stream.getDataSize() >= targetSize)
+                return stream.getMemoryBlock();
+        }
+    }
+
+    bool writeAll(int fd, const void* data, size_t size)
+    {
+        auto* p = static_cast<const uint8_t*>(data);
+        while (size > 0)
+        {
+            const ssize_t n = write(fd, p, size);
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool readAll(int fd, void* data, size_t size)
+    {
+        auto* p = static_cast<uint8_t*>(data);
+        while (size > 0)
+        {
+            const ssize_t n = read(fd, p, size);
+            if (n <= 0)
+                return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Receiver: [1-byte compressed flag][4-byte length][4-byte size][data], answers 1 byte
+    void receiverLoop(int fd)
+    {
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> inflated;
+
+        for (;;)
+        {
+            uint8_t header[9];
+            if (!readAll(fd, header, sizeof(header)))
+                return;
+
+            uint32_t length = 0;
+            uint32_t size = 0;
+            std::memcpy(&length, header + 1, 4);
+            std::memcpy(&size, header + 5, 4);
+
+            data.resize(length);
+            if (!readAll(fd, data.data(), length))
+                return;
+
+            const void* tree = data.data();
+            if (header[0] != 0)
+            {
+                inflated.resize(size);
+                if (!Lz4Compressor::decompress(data.data(), length, inflated.data(), size))
+                    return;
+                tree = inflated.data();
+            }
+
+            // Decode as the real receiver would
+            juce::ValueTree::readFromData(tree, size);
+
+            const uint8_t ack = 1;
+            if (!writeAll(fd, &ack, 1))
+                return;
+        }
+    }
+
+    double median(std::vector<double>& values)
+    {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int iterations = argc > 1 ? juce::jmax(1, std::atoi(argv[1])) : 200;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        std::perror("socketpair");
+        return 1;
+    }
+
+    std::thread receiver([fd = fds[1]]() { receiverLoop(fd); });
+
+    Lz4Compressor compressor;
+    std::vector<uint8_t> message;
+    size_t crossover = 0;
+
+    std::printf("%10s %10s %8s %12s %12s %8s\n", "size", "lz4 size", "ratio", "raw (us)", "lz4 (us)", "speedup");
+
+    for (size_t targetSize = 256; targetSize <= IPC_MAX_MESSAGE_SIZE; targetSize *= 2)
+    {
+        const auto payload = makePayload(targetSize);
+        const auto* data = static_cast<const uint8_t*>(payload.getData());
+        const auto size = static_cast<uint32_t>(payload.getSize());
+
+        std::vector<double> rawTimes;
+        std::vector<double> lz4Times;
+        size_t compressedSize = 0;
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            for (bool compress : { false, true })
+            {
+                const auto start = std::chrono::steady_clock::now();
+
+                message.resize(9 + Lz4Compressor::maxCompressedSize(size));
+                uint32_t length = size;
+                if (compress)
+                {
+                    length = static_cast<uint32_t>(compressor.compress(data, size, message.data() + 9, message.size() - 9));
+                    compressedSize = length;
+                }
+                else
+                {
+                    std::memcpy(message.data() + 9, data, size);
+                }
+
+                message[0] = compress ? 1 : 0;
+                std::memcpy(message.data() + 1, &length, 4);
+                std::memcpy(message.data() + 5, &size, 4);
+
+                uint8_t ack = 0;
+                if (!writeAll(fds[0], message.data(), 9 + length) || !readAll(fds[0], &ack, 1))
+                {
+                    std::fprintf(stderr, "Socket error\n");
+                    return 1;
+                }
+
+                const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+                (compress ? lz4Times : rawTimes).push_back(elapsed.count());
+            }
+        }
+
+        const double raw = median(rawTimes);
+        const double lz4 = median(lz4Times);
+
+        std::printf("%10u %10zu %7.2fx %12.1f %12.1f %7.2fx\n", size, compressedSize,
+                    static_cast<double>(size) / static_cast<double>(compressedSize), raw, lz4, raw / lz4);
+
+        if (lz4 < raw)
+        {
+            if (crossover == 0)
+                crossover = size;
+        }
+        else
+        {
+            crossover = 0;
+        }
+    }
+
+    shutdown(fds[0], SHUT_RDWR);
+    receiver.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    if (crossover > 0)
+        std::printf("\nLZ4 is faster from %zu bytes (IPC_COMPRESS_THRESHOLD is %d)\n", crossover, IPC_COMPRESS_THRESHOLD);
+    else
+        std::printf("\nLZ4 never consistently faster on this machine\n");
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * editor-benchmark - Editor open/close churn and time to first frame.
+ *
+ * Opens and closes an editor holding a ComposeComponent, wired like the
+ * demo's PluginEditor, --cycles times in a row. Each open goes on screen
+ * (addToDesktop), waits for onFirstFrame and closes again. Every cycle is
+ * split into stages from ComposeComponent::getLaunchTimes():
+ *   construction    Editor constructor
+ *   tryLaunch       Until the component has a peer and starts launching
+ *   spawn           Surface created and the child process spawned
+ *   connect         Until the UI's HELLO arrives (JVM startup for the real UI)
+ *   initialSurface  Until the initial surface has been handed over
+ *   surfaceReady    Until the first SURFACE_READY reaches the message thread
+ *   onFirstFrame    View swap, then onFirstFrame runs
+ *   total           Construction until onFirstFrame
+ *   close           Editor destructor (ComposeProvider::stop())
+ *
+ * After the run it reports what the churn left behind, compared to after
+ * the warm-up cycles: open file descriptors, child processes still around
+ * (alive or zombie, Linux only) and resident memory growth.
+ *
+ * The UI is whatever executable named `ui` sits next to this one, like the
+ * plugin looks for it; the build puts stub-child there. On Linux it needs a
+ * display for the editor's window (xvfb-run works). Results go to stdout as
+ * JSON, progress to stderr.
+ *
+ * Usage: editor-benchmark [--cycles=1000] [--warmup=10]
+ */
+
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+
+using namespace juce_cmp;
+using namespace benchmark;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // =========================================================================
+    // What a cycle can leave behind
+    // =========================================================================
+
+    int countOpenFiles()
+    {
+        int count = 0;
+        if (auto* dir = opendir("/dev/fd"))
+        {
+            while (auto* entry = readdir(dir))
+            {
+                if (entry->d_name[0] != '.')
+                    ++count;
+            }
+            closedir(dir);
+        }
+        return count - 1;  // The one opendir() holds
+    }
+
+    // =========================================================================
+    // Editor
+    // =========================================================================
+
+    /** Stand-in for the demo's PluginEditor. */
+    class Editor : public juce::Component
+    {
+    public:
+        Editor(ProcessWatcher& watcher, std::function<void()> firstFrameCallback)
+        {
+            composeComponent.setProcessWatcher(watcher);
+            composeComponent.onFirstFrame(std::move(firstFrameCallback));
+            addAndMakeVisible(composeComponent);
+            setSize(768, 480);
+        }
+
+        void resized() override { composeComponent.setBounds(getLocalBounds()); }
+
+        ComposeComponent composeComponent;
+    };
+
+    using Times = ComposeProvider::LaunchTimes;
+
+    /** Stage durations in ms, consecutive except total and close. */
+    struct Stages
+    {
+        static constexpr int count = 9;
+        static constexpr const char* names[count] = {
+            "construction", "tryLaunch", "spawn", "connect", "initialSurface",
+            "surfaceReady", "onFirstFrame", "total", "close"
+        };
+
+        std::vector<double> samples[count];
+
+        void add(int64_t start, int64_t constructed, const Times& times, double closeMs)
+        {
+            const int64_t points[] = { start, constructed, times.tryLaunch, times.spawned, times.connected,
+                                       times.surfaceSent, times.surfaceReady, times.firstFrame };
+            for (int i = 0; i < 7; ++i)
+                samples[i].push_back((double)(points[i + 1] - points[i]) / 1.0e6);
+            samples[7].push_back((double)(times.firstFrame - start) / 1.0e6);
+            samples[8].push_back(closeMs);
+        }
+
+        juce::var toVar()
+        {
+            auto* result = new juce::DynamicObject();
+            for (int i = 0; i < count; ++i)
+                result->setProperty(names[i], percentiles(samples[i]));
+            return juce::var(result);
+        }
+    };
+
+    /** Opens an editor, waits for its first frame and closes it. Returns false on timeout. */
+    bool cycle(ProcessWatcher& watcher, Stages* stages)
+    {
+        std::unique_ptr<Editor> editor;
+        std::atomic<bool> shown { false };
+        int64_t start = 0, constructed = 0;
+
+        onMessageThread([&]() {
+            start = Tracer::now();
+            editor = std::make_unique<Editor>(watcher, [&shown]() { shown.store(true); });
+            constructed = Tracer::now();
+
+            // Like a host opening the plugin window
+            editor->addToDesktop(0);
+            editor->setVisible(true);
+        });
+
+        const auto deadline = Clock::now() + std::chrono::seconds(30);
+        while (!shown.load() && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+        Times times;
+        double closeMs = 0.0;
+        onMessageThread([&]() {
+            times = editor->composeComponent.getLaunchTimes();
+            const auto closeStart = Clock::now();
+            editor.reset();
+            closeMs = std::chrono::duration<double, std::milli>(Clock::now() - closeStart).count();
+        });
+
+        if (!shown.load())
+            return false;
+        if (stages != nullptr)
+            stages->add(start, constructed, times, closeMs);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int cycles = 1000;
+    int warmup = 10;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto value = arg.fromFirstOccurrenceOf("=", false, false).getIntValue();
+        if (arg.startsWith("--cycles=")) cycles = juce::jmax(1, value);
+        else if (arg.startsWith("--warmup=")) warmup = juce::jmax(0, value);
+    }
+
+    const auto ui = juce::File::getSpecialLocation(juce::File::currentExecutableFile).getSiblingFile("ui");
+    if (!ui.existsAsFile())
+    {
+        std::fprintf(stderr, "No UI executable at %s\n", ui.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    juce::ScopedJuceInitialiser_GUI init;
+    std::atomic<int> exitCode { 0 };
+
+    // Outlives the editors, like the demo processor's
+    ProcessWatcher watcher;
+
+    std::thread worker([&]() {
+        // Settled before counting: children of the warm-up exit after their EOF
+        const auto settle = []() { std::this_thread::sleep_for(std::chrono::milliseconds(500)); };
+
+        for (int i = 0; i < warmup; ++i)
+            cycle(watcher, nullptr);
+        settle();
+
+        const int filesBefore = countOpenFiles();
+        const auto childrenBefore = countChildren();
+        const auto residentBefore = residentBytes();
+
+        Stages stages;
+        int failures = 0;
+        for (int i = 0; i < cycles; ++i)
+        {
+            if ((i % 100) == 0)
+                std::fprintf(stderr, "cycle %d/%d\n", i, cycles);
+            if (!cycle(watcher, &stages) && ++failures >= 3)
+                break;  // Something is wrong with the UI, not worth timing out a thousand times
+        }
+        settle();
+
+        const int filesAfter = countOpenFiles();
+        const auto childrenAfter = countChildren();
+        const auto residentAfter = residentBytes();
+        const int completed = static_cast<int>(stages.samples[0].size());
+
+        auto* leaks = new juce::DynamicObject();
+        leaks->setProperty("fds", filesAfter - filesBefore);
+        leaks->setProperty("aliveChildren", childrenAfter.alive);
+        leaks->setProperty("zombieChildren", childrenAfter.zombies);
+        leaks->setProperty("zombieChildrenBefore", childrenBefore.zombies);
+        leaks->setProperty("rssGrowthBytes", static_cast<juce::int64>(residentAfter) - static_cast<juce::int64>(residentBefore));
+        leaks->setProperty("rssGrowthPerCycleBytes",
+                           completed > 0 ? ((double)residentAfter - (double)residentBefore) / completed : 0.0);
+
+        auto* report = new juce::DynamicObject();
+        report->setProperty("benchmark", "editor-benchmark");
+        report->setProperty("protocolVersion", IPC_PROTOCOL_VERSION);
+        report->setProperty("platform", juce::SystemStats::getOperatingSystemName());
+        report->setProperty("cpu", juce::SystemStats::getCpuModel());
+        report->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+        report->setProperty("ui", ui.getFullPathName());
+        report->setProperty("cycles", completed);
+        report->setProperty("failures", failures);
+        report->setProperty("stagesMs", stages.toVar());
+        report->setProperty("leaks", juce::var(leaks));
+        std::printf("%s\n", juce::JSON::toString(juce::var(report)).toRawUTF8());
+
+        if (failures > 0)
+            exitCode.store(1);
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    });
+
+    // The editors live here
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    worker.join();
+
+    return exitCode.load();
+}
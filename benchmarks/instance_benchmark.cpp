@@ -0,0 +1,440 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * instance-benchmark - What N ComposeProviders cost in one host process.
+ *
+ * Launches 1, 2, 4 ... --max providers side by side, each with its own
+ * stub-child (or the real UI with --ui), the way a session with many plugin
+ * instances does. Once every instance has shown its first frame, all of them
+ * get the same synthetic traffic for --seconds:
+ *   input      Mouse moves on the input lane (--input-rate per instance)
+ *   params     Small ValueTrees like parameter changes (--param-rate)
+ *   pings      Typed messages the stub echoes, timed from send until the
+ *              message thread sees the echo (--ping-rate)
+ *
+ * Recorded for each N:
+ *   threads            Process threads, and how many each instance added
+ *   hostRssBytes       Resident memory of this process
+ *   childRssBytes      Sum over the UIs, as their stats reports give it
+ *   messageThreadLoad  CPU time of the message thread over wall time
+ *   dispatchLagUs      How late a callAsync() posted every ms runs
+ *   latencyUs          Ping round trips over all instances, plus the worst
+ *                      instance's p99
+ *   firstFrameMs       From launch() until the first SURFACE_READY
+ *
+ * Something that grows per instance (a thread, a timer, a poll loop) shows
+ * up as a slope in these columns. Results go to stdout as JSON, progress to
+ * stderr.
+ *
+ * Usage: instance-benchmark [--max=128] [--seconds=2] [--input-rate=200]
+ *                           [--param-rate=100] [--ping-rate=20] [--fps=30]
+ *                           [--stub=<stub-child>] [--ui=<UI executable>]
+ *
+ * Only stub-child echoes pings, so with --ui the latency columns stay empty.
+ */
+
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#if __APPLE__
+#include <mach/mach.h>
+#endif
+
+using namespace juce_cmp;
+using namespace benchmark;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint16_t pingId = 1;  // Typed message id, the stub echoes any
+
+    struct Options
+    {
+        int maxInstances = 128;
+        double seconds = 2.0;
+        int inputRate = 200;
+        int paramRate = 100;
+        int pingRate = 20;
+        int fps = 30;
+        std::string executable;
+        bool stub = true;
+    };
+
+    // =========================================================================
+    // Process numbers
+    // =========================================================================
+
+    int countThreads()
+    {
+#if __linux__
+        return juce::File("/proc/self/task").getNumberOfChildFiles(juce::File::findDirectories);
+#elif __APPLE__
+        thread_act_array_t threads = nullptr;
+        mach_msg_type_number_t count = 0;
+        if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS)
+            return 0;
+        for (mach_msg_type_number_t i = 0; i < count; ++i)
+            mach_port_deallocate(mach_task_self(), threads[i]);
+        vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+        return static_cast<int>(count);
+#else
+        return 0;
+#endif
+    }
+
+    /** CPU time of one thread, readable from any other. */
+    class ThreadCpuClock
+    {
+    public:
+        /** Call on the thread to be measured. */
+        void captureCurrentThread()
+        {
+#if __linux__
+            if (pthread_getcpuclockid(pthread_self(), &clock_) != 0)
+                clock_ = CLOCK_THREAD_CPUTIME_ID;
+#elif __APPLE__
+            thread_ = pthread_mach_thread_np(pthread_self());
+#endif
+        }
+
+        double seconds() const
+        {
+#if __linux__
+            timespec ts {};
+            clock_gettime(clock_, &ts);
+            return (double)ts.tv_sec + (double)ts.tv_nsec / 1.0e9;
+#elif __APPLE__
+            thread_basic_info_data_t info {};
+            mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+            if (thread_info(thread_, THREAD_BASIC_INFO, (thread_info_t)&info, &count) != KERN_SUCCESS)
+                return 0.0;
+            return (double)(info.user_time.seconds + info.system_time.seconds)
+                 + (double)(info.user_time.microseconds + info.system_time.microseconds) / 1.0e6;
+#else
+            return 0.0;
+#endif
+        }
+
+    private:
+#if __linux__
+        clockid_t clock_ = CLOCK_THREAD_CPUTIME_ID;
+#elif __APPLE__
+        thread_t thread_ = 0;
+#endif
+    };
+
+    // =========================================================================
+    // Instances
+    // =========================================================================
+
+    /** One provider and what its callbacks saw (message thread only). */
+    struct Instance
+    {
+        ComposeProvider provider;
+        int64_t launchTime = 0;
+        int64_t firstFrameTime = 0;
+        std::vector<double> latenciesUs;
+        bool measuring = false;
+
+        // Read by the traffic thread while waiting for the first frames
+        std::atomic<bool> shown { false };
+
+        bool launch(const Options& options, std::vector<std::string> args)
+        {
+            provider.setFirstFrameCallback([this]() {
+                if (firstFrameTime == 0)
+                    firstFrameTime = Tracer::now();
+                shown.store(true);
+            });
+
+            provider.setMessageCallback([this](const TypedMessage& message) {
+                int64_t sent = 0;
+                if (!measuring || message.id != pingId || message.size != sizeof(sent))
+                    return;
+                std::memcpy(&sent, message.data, sizeof(sent));
+                latenciesUs.push_back((double)(Tracer::now() - sent) / 1000.0);
+            });
+
+            // Parameter trees are one-way, the stub drops them
+            provider.setEventViewCallback([](const ValueTreeView&) {});
+
+            launchTime = Tracer::now();
+            return provider.launch(options.executable, 400, 300, 1.0f, args);
+        }
+    };
+
+    /** Sends each kind of traffic at its rate to every instance, staggered so they don't move in lockstep. */
+    class Traffic
+    {
+    public:
+        Traffic(std::vector<std::unique_ptr<Instance>>& instances, const Options& options)
+            : instances_(instances), options_(options),
+              sent_(instances.size() * 3, 0)
+        {
+        }
+
+        /** Runs for the given time on the calling thread, posting a dispatch probe every ms. */
+        std::vector<double> run(double seconds)
+        {
+            auto lags = std::make_shared<std::vector<double>>();
+            const auto start = Clock::now();
+            const int rates[3] = { options_.inputRate, options_.paramRate, options_.pingRate };
+            const double count = (double)instances_.size();
+
+            for (;;)
+            {
+                const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                if (elapsed >= seconds)
+                    break;
+
+                for (size_t i = 0; i < instances_.size(); ++i)
+                {
+                    for (int kind = 0; kind < 3; ++kind)
+                    {
+                        auto& sent = sent_[i * 3 + static_cast<size_t>(kind)];
+                        const auto due = static_cast<uint64_t>(elapsed * rates[kind] + (double)i / count);
+                        for (; sent < due; ++sent)
+                            send(*instances_[i], kind, sent);
+                    }
+                }
+
+                const int64_t posted = Tracer::now();
+                juce::MessageManager::callAsync([lags, posted]() {
+                    lags->push_back((double)(Tracer::now() - posted) / 1000.0);
+                });
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            // The probes still queued belong to this run too
+            std::vector<double> result;
+            onMessageThread([&]() { result = std::move(*lags); });
+            return result;
+        }
+
+    private:
+        void send(Instance& instance, int kind, uint64_t sequence)
+        {
+            switch (kind)
+            {
+                case 0:
+                {
+                    auto event = InputEventFactory::mouseMove(static_cast<int>(sequence % 400), static_cast<int>(sequence % 300), 0);
+                    instance.provider.sendInput(event);
+                    break;
+                }
+                case 1:
+                {
+                    juce::ValueTree param("param");
+                    param.setProperty("id", static_cast<int>(sequence % 32), nullptr);
+                    param.setProperty("value", (double)(sequence % 1000) / 1000.0, nullptr);
+                    instance.provider.sendEvent(param);
+                    break;
+                }
+                default:
+                {
+                    const int64_t now = Tracer::now();
+                    instance.provider.sendMessage(pingId, &now, sizeof(now), IPC_LANE_CONTROL);
+                    break;
+                }
+            }
+        }
+
+        std::vector<std::unique_ptr<Instance>>& instances_;
+        const Options& options_;
+        std::vector<uint64_t> sent_;  // Per instance and kind
+    };
+
+    juce::var failure(int count, const juce::String& error)
+    {
+        auto* result = new juce::DynamicObject();
+        result->setProperty("instances", count);
+        result->setProperty("error", error);
+        return juce::var(result);
+    }
+
+    juce::var runRound(int count, const Options& options, const ThreadCpuClock& messageThread, int baselineThreads)
+    {
+        std::vector<std::unique_ptr<Instance>> instances;
+        std::vector<std::string> args;
+        if (options.stub)
+            args = { "--echo=typed", "--fps=" + std::to_string(options.fps) };
+
+        bool launched = true;
+        const auto launchStart = Clock::now();
+        onMessageThread([&]() {
+            for (int i = 0; i < count && launched; ++i)
+            {
+                instances.push_back(std::make_unique<Instance>());
+                launched = instances.back()->launch(options, args);
+            }
+        });
+        const double launchMs = std::chrono::duration<double, std::milli>(Clock::now() - launchStart).count();
+
+        // Providers must go on the message thread, whatever happens here
+        auto result = [&]() -> juce::var {
+            if (!launched)
+                return failure(count, "launch() failed");
+
+            const auto deadline = Clock::now() + std::chrono::seconds(60);
+            for (const auto& instance : instances)
+            {
+                while (!instance->shown.load())
+                {
+                    if (Clock::now() > deadline)
+                        return failure(count, "no first frame within 60 s");
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+            }
+
+            onMessageThread([&]() {
+                for (auto& instance : instances)
+                    instance->measuring = true;
+            });
+
+            const double cpuBefore = messageThread.seconds();
+            const auto trafficStart = Clock::now();
+            Traffic traffic(instances, options);
+            auto lags = traffic.run(options.seconds);
+            const double wall = std::chrono::duration<double>(Clock::now() - trafficStart).count();
+            const double cpu = messageThread.seconds() - cpuBefore;
+
+            // Echoes still in flight are late, not lost
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            std::vector<double> latencies, firstFrames;
+            double worstP99 = 0.0;
+            uint64_t childResident = 0, dropped = 0;
+            onMessageThread([&]() {
+                for (auto& instance : instances)
+                {
+                    instance->measuring = false;
+                    worstP99 = std::max(worstP99, percentile(instance->latenciesUs, 99));
+                    latencies.insert(latencies.end(), instance->latenciesUs.begin(), instance->latenciesUs.end());
+                    firstFrames.push_back((double)(instance->firstFrameTime - instance->launchTime) / 1.0e6);
+
+                    const auto stats = instance->provider.getStats();
+                    childResident += stats.childResidentBytes;
+                    dropped += stats.txDropped;
+                }
+            });
+
+            const int threads = countThreads();
+
+            auto* round = new juce::DynamicObject();
+            round->setProperty("instances", count);
+            round->setProperty("threads", threads);
+            round->setProperty("threadsPerInstance", (double)(threads - baselineThreads) / count);
+            round->setProperty("hostRssBytes", static_cast<juce::int64>(residentBytes()));
+            round->setProperty("childRssBytes", static_cast<juce::int64>(childResident));
+            round->setProperty("messageThreadLoad", wall > 0.0 ? cpu / wall : 0.0);
+            round->setProperty("dispatchLagUs", percentiles(lags));
+            auto latency = percentiles(latencies);
+            latency.getDynamicObject()->setProperty("worstInstanceP99", worstP99);
+            latency.getDynamicObject()->setProperty("samples", static_cast<int>(latencies.size()));
+            round->setProperty("latencyUs", latency);
+            round->setProperty("launchMs", launchMs);
+            round->setProperty("firstFrameMs", percentiles(firstFrames));
+            round->setProperty("dropped", static_cast<juce::int64>(dropped));
+            return juce::var(round);
+        }();
+
+        const auto stopStart = Clock::now();
+        onMessageThread([&]() { instances.clear(); });
+        if (auto* round = result.getDynamicObject())
+            round->setProperty("stopMs", std::chrono::duration<double, std::milli>(Clock::now() - stopStart).count());
+
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+#ifdef JUCE_CMP_STUB_CHILD
+    options.executable = JUCE_CMP_STUB_CHILD;
+#endif
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto value = arg.fromFirstOccurrenceOf("=", false, false);
+        if (arg.startsWith("--max=")) options.maxInstances = juce::jmax(1, value.getIntValue());
+        else if (arg.startsWith("--seconds=")) options.seconds = juce::jmax(0.1, value.getDoubleValue());
+        else if (arg.startsWith("--input-rate=")) options.inputRate = value.getIntValue();
+        else if (arg.startsWith("--param-rate=")) options.paramRate = value.getIntValue();
+        else if (arg.startsWith("--ping-rate=")) options.pingRate = value.getIntValue();
+        else if (arg.startsWith("--fps=")) options.fps = value.getIntValue();
+        else if (arg.startsWith("--stub=")) options.executable = value.toStdString();
+        else if (arg.startsWith("--ui="))
+        {
+            options.executable = value.toStdString();
+            options.stub = false;
+        }
+    }
+
+    if (options.executable.empty())
+    {
+        std::fprintf(stderr, "Usage: instance-benchmark [--max=N] [--seconds=S] [--stub=<stub-child>] [--ui=<UI>], see instance_benchmark.cpp\n");
+        return 2;
+    }
+
+    juce::ScopedJuceInitialiser_GUI init;
+
+    // The message thread is this one, measured from the worker
+    ThreadCpuClock messageThread;
+    messageThread.captureCurrentThread();
+
+    std::thread worker([&]() {
+        const int baselineThreads = countThreads();
+        juce::Array<juce::var> rounds;
+
+        for (int count = 1;; count *= 2)
+        {
+            count = std::min(count, options.maxInstances);
+            std::fprintf(stderr, "%d instance%s\n", count, count == 1 ? "" : "s");
+            rounds.add(runRound(count, options, messageThread, baselineThreads));
+            if (count == options.maxInstances)
+                break;
+        }
+
+        auto* report = new juce::DynamicObject();
+        report->setProperty("benchmark", "instance-benchmark");
+        report->setProperty("protocolVersion", IPC_PROTOCOL_VERSION);
+        report->setProperty("platform", juce::SystemStats::getOperatingSystemName());
+        report->setProperty("cpu", juce::SystemStats::getCpuModel());
+        report->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+        report->setProperty("child", options.stub ? "stub-child" : juce::String(options.executable));
+        report->setProperty("baselineThreads", baselineThreads);
+        report->setProperty("seconds", options.seconds);
+        report->setProperty("inputRate", options.inputRate);
+        report->setProperty("paramRate", options.paramRate);
+        report->setProperty("pingRate", options.pingRate);
+        report->setProperty("rounds", rounds);
+        std::printf("%s\n", juce::JSON::toString(juce::var(report)).toRawUTF8());
+
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    });
+
+    // Provider callbacks and the dispatch probes run here
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    worker.join();
+
+    return 0;
+}
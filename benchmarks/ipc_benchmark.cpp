@@ -0,0 +1,465 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * ipc-benchmark - Latency and throughput of Ipc against a real child process.
+ *
+ * Launches stub-child through ChildProcess, the way ComposeProvider launches
+ * the UI, once per scenario:
+ *   pingPong           Typed message and small ValueTree round trips (p50/p90/p99)
+ *   throughput         One-way ValueTrees of several sizes, to and from the UI
+ *   inputBackpressure  Input events at fixed rates while the UI stalls reading
+ *                      half the time (GC-like pauses): cost of sendInput(),
+ *                      queue growth and how long the backlog takes to drain
+ *   valueTree          Preset-like trees: sendEvent() cost (encoding) and the
+ *                      round trip until the echo is decoded into a tree
+ *
+ * Each transport mode runs the full set:
+ *   socket             Everything inline on the socket
+ *   blob               Payloads from IPC_BLOB_THRESHOLD on in shared memory
+ *   compressed         Inline, LZ4 from IPC_COMPRESS_THRESHOLD on
+ *
+ * Results go to stdout as JSON, progress to stderr, so runs can be stored
+ * and compared over time.
+ *
+ * Usage: ipc-benchmark [--mode=socket|blob|compressed] [--stub=<stub-child>]
+ */
+
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace juce_cmp;
+using namespace benchmark;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint16_t pingId = 1;  // Typed message id, the stub echoes any
+
+    double microsecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    bool waitUntil(const std::function<bool()>& condition, int timeoutMs = 10000)
+    {
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (!condition())
+        {
+            if (Clock::now() > deadline)
+                return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    /** Preset-like tree: parameters with ids, names and values. */
+    juce::ValueTree makeTree(size_t targetSize)
+    {
+        juce::ValueTree state("STATE");
+        juce::Random random(1);
+
+        for (int i = 0;; ++i)
+        {
+            juce::ValueTree param("PARAM");
+            param.setProperty("id", "param" + juce::String(i), nullptr);
+            param.setProperty("name", "Parameter " + juce::String(i), nullptr);
+            param.setProperty("value", random.nextDouble(), nullptr);
+            state.appendChild(param, nullptr);
+
+            // Serializing is the slow part, check the size every so often
+            if ((i % 16) != 15 && targetSize > 1024)
+                continue;
+
+            juce::MemoryOutputStream stream;
+            state.writeToStream(stream);
+            if (stream.getDataSize() >= targetSize)
+                return state;
+        }
+    }
+
+    struct Mode
+    {
+        const char* name;
+        bool blob;
+        bool compressed;
+    };
+
+    constexpr Mode modes[] = {
+        { "socket", false, false },
+        { "blob", true, false },
+        { "compressed", false, true },
+    };
+
+    /** One stub-child and the channel to it. */
+    class Session
+    {
+    public:
+        std::atomic<uint64_t> typedReceived { 0 };
+        std::atomic<uint64_t> eventsReceived { 0 };
+        std::atomic<int64_t> lastEventTime { 0 };
+        std::atomic<int64_t> handshakeTime { 0 };
+        Ipc ipc;
+
+        ~Session()
+        {
+            // Ipc has its own descriptor (see start()), so neither closes the other's
+            ipc.stop();
+            child.stop();
+        }
+
+        bool start(const std::string& stub, const Mode& mode, std::vector<std::string> args, bool buildTrees = false)
+        {
+            if (!mode.blob)
+                args.push_back("--no-blob");
+
+            if (!child.launch(stub, 1.0f, {}, {}, args))
+                return false;
+
+            ipc.setSocketFD(dup(child.getSocketFD()));
+            ipc.setCompressionEnabled(mode.compressed);
+            ipc.setTypedHandler([this](const TypedMessage&) { typedReceived.fetch_add(1); });
+            ipc.setHandshakeHandler([this]() { handshakeTime.store(Tracer::now()); });
+
+            // Built like an app's onEvent would, or read in place like onEventView
+            if (buildTrees)
+                ipc.setEventHandler([this](const juce::ValueTree&) { received(); });
+            else
+                ipc.setEventViewHandler([this](const ValueTreeView&) { received(); });
+
+            ipc.startReceiving();
+            return waitUntil([this]() { return handshakeTime.load() != 0; });
+        }
+
+        bool sendPing(uint64_t sequence)
+        {
+            return ipc.sendTyped(pingId, &sequence, sizeof(sequence), IPC_LANE_CONTROL);
+        }
+
+        bool waitForTyped(uint64_t count, int timeoutMs = 10000) const
+        {
+            return waitUntil([this, count]() { return typedReceived.load() >= count; }, timeoutMs);
+        }
+
+        bool waitForEvents(uint64_t count, int timeoutMs = 10000) const
+        {
+            return waitUntil([this, count]() { return eventsReceived.load() >= count; }, timeoutMs);
+        }
+
+    private:
+        void received()
+        {
+            lastEventTime.store(Tracer::now());
+            eventsReceived.fetch_add(1);
+        }
+
+        ChildProcess child;
+    };
+
+    juce::var failure(const juce::String& error)
+    {
+        auto* result = new juce::DynamicObject();
+        result->setProperty("error", error);
+        return juce::var(result);
+    }
+
+    // =========================================================================
+    // Scenarios
+    // =========================================================================
+
+    juce::var pingPong(const std::string& stub, const Mode& mode)
+    {
+        juce::Array<juce::var> results;
+        constexpr int count = 5000;
+
+        for (const bool typed : { true, false })
+        {
+            Session session;
+            if (!session.start(stub, mode, { "--echo" }))
+                return failure("stub-child did not start");
+
+            juce::ValueTree ping("ping");
+            std::vector<double> samples;
+            samples.reserve(count);
+
+            // First rounds warm up pools, caches and the scheduler
+            for (int i = 0; i < count + count / 10; ++i)
+            {
+                const auto start = Clock::now();
+                bool ok = false;
+                if (typed)
+                {
+                    ok = session.sendPing(static_cast<uint64_t>(i)) && session.waitForTyped(static_cast<uint64_t>(i) + 1);
+                }
+                else
+                {
+                    ping.setProperty("seq", i, nullptr);
+                    session.ipc.sendEvent(ping);
+                    ok = session.waitForEvents(static_cast<uint64_t>(i) + 1);
+                }
+
+                if (!ok)
+                    return failure("timed out waiting for the echo");
+                if (i >= count / 10)
+                    samples.push_back(microsecondsSince(start));
+            }
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty("message", typed ? "typed" : "ValueTree");
+            result->setProperty("count", count);
+            addPercentiles(*result, samples, "Us");
+            results.add(juce::var(result));
+        }
+        return results;
+    }
+
+    juce::var throughput(const std::string& stub, const Mode& mode)
+    {
+        juce::Array<juce::var> results;
+        const size_t sizes[] = { 64, 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1000 * 1000 };
+
+        for (const size_t size : sizes)
+        {
+            // About 64 MB per direction, within sensible bounds on the count
+            const int count = static_cast<int>(juce::jlimit<size_t>(50, 20000, (64u << 20) / size));
+
+            // To the UI: trees, then a typed ping that can only come back after all of them
+            {
+                Session session;
+                if (!session.start(stub, mode, { "--echo=typed" }))
+                    return failure("stub-child did not start");
+
+                const auto tree = makeTree(size);
+                juce::MemoryOutputStream encoded;
+                tree.writeToStream(encoded);
+
+                const auto start = Clock::now();
+                for (int i = 0; i < count; ++i)
+                    session.ipc.sendEvent(tree);
+                session.sendPing(0);
+                if (!session.waitForTyped(1, 60000))
+                    return failure("timed out waiting for the UI");
+                const double seconds = microsecondsSince(start) / 1.0e6;
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty("direction", "toUi");
+                result->setProperty("payloadBytes", static_cast<int>(encoded.getDataSize()));
+                result->setProperty("messages", count);
+                result->setProperty("messagesPerSecond", count / seconds);
+                result->setProperty("megabytesPerSecond", count * (double)encoded.getDataSize() / seconds / 1.0e6);
+                result->setProperty("dropped", static_cast<juce::int64>(session.ipc.getCounters().txDropped));
+                results.add(juce::var(result));
+            }
+
+            // From the UI: the stub floods as soon as the handshake is done
+            {
+                Session session;
+                const std::vector<std::string> args = { "--flood=" + std::to_string(count),
+                                                        "--flood-size=" + std::to_string(size) };
+                if (!session.start(stub, mode, args) || !session.waitForEvents(static_cast<uint64_t>(count), 60000))
+                    return failure("timed out waiting for the flood");
+
+                const double seconds = (session.lastEventTime.load() - session.handshakeTime.load()) / 1.0e9;
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty("direction", "fromUi");
+                result->setProperty("payloadBytes", static_cast<int>(size));
+                result->setProperty("messages", count);
+                result->setProperty("messagesPerSecond", count / seconds);
+                result->setProperty("megabytesPerSecond", count * (double)size / seconds / 1.0e6);
+                results.add(juce::var(result));
+            }
+        }
+        return results;
+    }
+
+    juce::var inputBackpressure(const std::string& stub, const Mode& mode)
+    {
+        juce::Array<juce::var> results;
+
+        for (const int rate : { 1000, 10000, 100000 })
+        {
+            Session session;
+            if (!session.start(stub, mode, { "--pause-ms=50", "--pause-every-ms=100" }))
+                return failure("stub-child did not start");
+
+            std::vector<double> callTimes;
+            callTimes.reserve(static_cast<size_t>(rate));
+            size_t peakQueued = 0;
+
+            // One second of events at the offered rate; sendInput() must never block
+            const auto before = session.ipc.getCounters();
+            const auto start = Clock::now();
+            for (int i = 0; i < rate; ++i)
+            {
+                const auto due = start + std::chrono::nanoseconds(1000000000LL * i / rate);
+                while (Clock::now() < due) {}
+
+                auto event = InputEventFactory::mouseMove(i % 800, i % 600, 0);
+                const auto callStart = Clock::now();
+                session.ipc.sendInput(event);
+                callTimes.push_back(std::chrono::duration<double, std::nano>(Clock::now() - callStart).count());
+
+                if ((i % 64) == 0)
+                    peakQueued = std::max(peakQueued, session.ipc.getPendingTxBytes());
+            }
+            const double seconds = microsecondsSince(start) / 1.0e6;
+            const auto during = session.ipc.getCounters();
+
+            // Then how long the backlog takes to reach the UI's socket
+            const auto drainStart = Clock::now();
+            const bool drained = waitUntil([&]() { return session.ipc.getPendingTxBytes() == 0; }, 30000);
+            const double drainMs = microsecondsSince(drainStart) / 1000.0;
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty("offeredPerSecond", rate);
+            result->setProperty("sentPerSecond", (double)(during.txMessages - before.txMessages) / seconds);
+            addPercentiles(*result, callTimes, "CallNs");
+            result->setProperty("peakQueuedBytes", static_cast<juce::int64>(peakQueued));
+            result->setProperty("drainMs", drained ? drainMs : -1.0);
+            result->setProperty("dropped", static_cast<juce::int64>(during.txDropped - before.txDropped));
+            results.add(juce::var(result));
+        }
+        return results;
+    }
+
+    juce::var valueTree(const std::string& stub, const Mode& mode)
+    {
+        juce::Array<juce::var> results;
+        const size_t sizes[] = { 1024, 16 * 1024, 256 * 1024 };
+
+        for (const size_t size : sizes)
+        {
+            Session session;
+            if (!session.start(stub, mode, { "--echo" }, true))
+                return failure("stub-child did not start");
+
+            const auto tree = makeTree(size);
+            juce::MemoryOutputStream encoded;
+            tree.writeToStream(encoded);
+
+            const int count = size > 64 * 1024 ? 100 : 1000;
+            std::vector<double> sendTimes, roundTrips;
+
+            for (int i = 0; i < count + count / 10; ++i)
+            {
+                const auto start = Clock::now();
+                session.ipc.sendEvent(tree);
+                const double sent = microsecondsSince(start);
+
+                if (!session.waitForEvents(static_cast<uint64_t>(i) + 1))
+                    return failure("timed out waiting for the echo");
+
+                if (i >= count / 10)
+                {
+                    sendTimes.push_back(sent);
+                    roundTrips.push_back(microsecondsSince(start));
+                }
+            }
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty("treeBytes", static_cast<int>(encoded.getDataSize()));
+            result->setProperty("count", count);
+            result->setProperty("sendEventP50Us", percentile(sendTimes, 50));
+            addPercentiles(*result, roundTrips, "RoundTripUs");
+            results.add(juce::var(result));
+        }
+        return results;
+    }
+
+    juce::var runMode(const std::string& stub, const Mode& mode)
+    {
+        auto* scenarios = new juce::DynamicObject();
+
+        const std::pair<const char*, std::function<juce::var(const std::string&, const Mode&)>> all[] = {
+            { "pingPong", pingPong },
+            { "throughput", throughput },
+            { "inputBackpressure", inputBackpressure },
+            { "valueTree", valueTree },
+        };
+
+        for (const auto& [name, scenario] : all)
+        {
+            std::fprintf(stderr, "%s: %s\n", mode.name, name);
+            scenarios->setProperty(name, scenario(stub, mode));
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("mode", mode.name);
+        result->setProperty("scenarios", juce::var(scenarios));
+        return juce::var(result);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::String onlyMode;
+    std::string stub;
+#ifdef JUCE_CMP_STUB_CHILD
+    stub = JUCE_CMP_STUB_CHILD;
+#endif
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        if (arg.startsWith("--mode="))
+            onlyMode = arg.fromFirstOccurrenceOf("=", false, false);
+        else if (arg.startsWith("--stub="))
+            stub = arg.fromFirstOccurrenceOf("=", false, false).toStdString();
+    }
+
+    if (stub.empty())
+    {
+        std::fprintf(stderr, "Usage: ipc-benchmark [--mode=socket|blob|compressed] [--stub=<stub-child>]\n");
+        return 2;
+    }
+
+    juce::ScopedJuceInitialiser_GUI init;
+    std::atomic<int> exitCode { 0 };
+
+    std::thread worker([&]() {
+        juce::Array<juce::var> results;
+        for (const auto& mode : modes)
+        {
+            if (onlyMode.isEmpty() || onlyMode == mode.name)
+                results.add(runMode(stub, mode));
+        }
+
+        if (results.isEmpty())
+        {
+            std::fprintf(stderr, "Unknown mode %s\n", onlyMode.toRawUTF8());
+            exitCode.store(2);
+        }
+        else
+        {
+            auto* report = new juce::DynamicObject();
+            report->setProperty("benchmark", "ipc-benchmark");
+            report->setProperty("protocolVersion", IPC_PROTOCOL_VERSION);
+            report->setProperty("platform", juce::SystemStats::getOperatingSystemName());
+            report->setProperty("cpu", juce::SystemStats::getCpuModel());
+            report->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+            report->setProperty("results", results);
+            std::printf("%s\n", juce::JSON::toString(juce::var(report)).toRawUTF8());
+        }
+
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    });
+
+    // Events and typed messages from the UI are delivered here
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    worker.join();
+
+    return exitCode.load();
+}
@@ -0,0 +1,263 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * ipc-replay - Plays a recorded session back into a UI and times its frames.
+ *
+ * Reads a log written by IpcRecorder (ComposeComponent::setRecordingFile),
+ * launches a fresh UI and, once it has shown its first frame, sends it every
+ * host-to-UI message of the log again: input, parameter trees, typed
+ * messages, blobs. Resizes get new surfaces from this session; the recorded
+ * handshake, clock sync and trace control are left out. With --realtime the
+ * messages keep their recorded spacing, otherwise they go as fast as the
+ * message thread posts them.
+ *
+ * The UI renders on a virtual frame clock (--frame-clock), so animations
+ * advance by the same step every frame whatever the machine, and the same
+ * log renders the same frames run after run. Frame render times come from
+ * the UI's trace ("Frame" events), per run and over all runs.
+ *
+ * The UI is stub-child unless --ui names another; the stub gets --fps in
+ * place of --frame-clock. Results go to stdout as JSON, progress to stderr.
+ *
+ * Usage: ipc-replay <log> [--realtime] [--runs=3] [--frame-clock=60]
+ *                         [--stub=<stub-child>] [--ui=<UI executable>]
+ */
+
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace juce_cmp;
+using namespace benchmark;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        juce::File log;
+        bool realtime = false;
+        int runs = 3;
+        int frameClock = 60;
+        std::string executable;
+        bool stub = true;
+    };
+
+    /** Durations in ms of the UI's "Frame" events in a Chrome trace file. */
+    std::vector<double> readFrameTimes(const juce::File& trace)
+    {
+        std::vector<double> frames;
+        const auto json = juce::JSON::parse(trace);
+        if (auto* events = json["traceEvents"].getArray())
+        {
+            for (const auto& event : *events)
+            {
+                if (event["name"].toString() == "Frame" && event["ph"].toString() == "X")
+                    frames.push_back((double)event["dur"] / 1000.0);
+            }
+        }
+        return frames;
+    }
+
+    struct Run
+    {
+        bool ok = false;
+        juce::String error;
+        int sent = 0;
+        double replayMs = 0.0;
+        std::vector<double> framesMs;
+    };
+
+    Run replayOnce(const IpcRecording& recording, const Options& options)
+    {
+        Run run;
+        std::unique_ptr<ComposeProvider> provider;
+        std::atomic<bool> shown { false };
+
+        std::vector<std::string> args;
+        if (options.stub)
+            args = { "--fps=" + std::to_string(options.frameClock) };
+        else
+            args = { "--frame-clock=" + std::to_string(options.frameClock) };
+
+        bool launched = false;
+        onMessageThread([&]() {
+            provider = std::make_unique<ComposeProvider>();
+            provider->setFirstFrameCallback([&shown]() { shown.store(true); });
+            provider->setEventViewCallback([](const ValueTreeView&) {});
+            launched = provider->launch(options.executable, 768, 480, 1.0f, args);
+            if (launched)
+                provider->updateViewBounds(0, 0, 768, 480);
+        });
+
+        auto finish = [&](const juce::String& error) {
+            onMessageThread([&]() { provider.reset(); });
+            run.error = error;
+            return run;
+        };
+
+        if (!launched)
+            return finish("launch() failed");
+
+        const auto deadline = Clock::now() + std::chrono::seconds(60);
+        while (!shown.load() && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (!shown.load())
+            return finish("no first frame");
+
+        onMessageThread([&]() { provider->startTracing(); });
+
+        // Posted in order; the message thread sends them as it gets to them
+        auto* target = provider.get();
+        const auto start = Clock::now();
+        for (const auto& record : recording.getRecords())
+        {
+            if (record.direction != IpcRecorder::Direction::toUi)
+                continue;
+
+            if (options.realtime)
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.time));
+
+            juce::MessageManager::callAsync([target, &record, &run]() {
+                if (target->replay(record))
+                    ++run.sent;
+            });
+        }
+        onMessageThread([]() {});
+        run.replayMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        // Whatever the last messages started gets rendered
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        const auto trace = juce::File::createTempFile(".json");
+        juce::WaitableEvent written;
+        std::atomic<bool> traced { false };
+        onMessageThread([&]() {
+            provider->stopTracing(trace, [&](bool success) {
+                traced.store(success);
+                written.signal();
+            });
+        });
+
+        if (!written.wait(10000) || !traced.load())
+        {
+            trace.deleteFile();
+            return finish("no trace from the UI");
+        }
+
+        run.framesMs = readFrameTimes(trace);
+        trace.deleteFile();
+        run.ok = true;
+        return finish({});
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+#ifdef JUCE_CMP_STUB_CHILD
+    options.executable = JUCE_CMP_STUB_CHILD;
+#endif
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto value = arg.fromFirstOccurrenceOf("=", false, false);
+        if (arg == "--realtime") options.realtime = true;
+        else if (arg.startsWith("--runs=")) options.runs = juce::jmax(1, value.getIntValue());
+        else if (arg.startsWith("--frame-clock=")) options.frameClock = juce::jmax(1, value.getIntValue());
+        else if (arg.startsWith("--stub=")) options.executable = value.toStdString();
+        else if (arg.startsWith("--ui="))
+        {
+            options.executable = value.toStdString();
+            options.stub = false;
+        }
+        else if (!arg.startsWith("--"))
+            options.log = juce::File::getCurrentWorkingDirectory().getChildFile(arg);
+    }
+
+    if (options.log == juce::File() || options.executable.empty())
+    {
+        std::fprintf(stderr, "Usage: ipc-replay <log> [--realtime] [--runs=N] [--frame-clock=FPS] [--stub=<stub-child>] [--ui=<UI>]\n");
+        return 2;
+    }
+
+    IpcRecording recording;
+    if (!recording.load(options.log))
+    {
+        std::fprintf(stderr, "Not an IPC log: %s\n", options.log.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    // Frames of a newer protocol could mean something else to this UI
+    if (recording.getProtocolVersion() != IPC_PROTOCOL_VERSION)
+        std::fprintf(stderr, "Log is protocol %d, this build %d\n", (int)recording.getProtocolVersion(), IPC_PROTOCOL_VERSION);
+
+    int toUi = 0;
+    for (const auto& record : recording.getRecords())
+        toUi += record.direction == IpcRecorder::Direction::toUi ? 1 : 0;
+
+    juce::ScopedJuceInitialiser_GUI init;
+    std::atomic<int> exitCode { 0 };
+
+    std::thread worker([&]() {
+        juce::Array<juce::var> runs;
+        std::vector<double> allFrames;
+
+        for (int i = 0; i < options.runs; ++i)
+        {
+            std::fprintf(stderr, "run %d/%d\n", i + 1, options.runs);
+            auto run = replayOnce(recording, options);
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty("ok", run.ok);
+            if (!run.ok)
+            {
+                result->setProperty("error", run.error);
+                exitCode.store(1);
+            }
+            result->setProperty("sent", run.sent);
+            result->setProperty("replayMs", run.replayMs);
+            result->setProperty("frames", static_cast<int>(run.framesMs.size()));
+            allFrames.insert(allFrames.end(), run.framesMs.begin(), run.framesMs.end());
+            result->setProperty("frameMs", percentiles(run.framesMs));
+            runs.add(juce::var(result));
+        }
+
+        auto* report = new juce::DynamicObject();
+        report->setProperty("benchmark", "ipc-replay");
+        report->setProperty("protocolVersion", IPC_PROTOCOL_VERSION);
+        report->setProperty("platform", juce::SystemStats::getOperatingSystemName());
+        report->setProperty("cpu", juce::SystemStats::getCpuModel());
+        report->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+        report->setProperty("child", options.stub ? "stub-child" : juce::String(options.executable));
+        report->setProperty("log", options.log.getFileName());
+        report->setProperty("logProtocolVersion", (int)recording.getProtocolVersion());
+        report->setProperty("records", static_cast<int>(recording.getRecords().size()));
+        report->setProperty("hostToUiRecords", toUi);
+        report->setProperty("realtime", options.realtime);
+        report->setProperty("frameClock", options.frameClock);
+        report->setProperty("runs", runs);
+        report->setProperty("frames", static_cast<int>(allFrames.size()));
+        report->setProperty("frameMs", percentiles(allFrames));
+        std::printf("%s\n", juce::JSON::toString(juce::var(report)).toRawUTF8());
+
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    });
+
+    // The provider and its callbacks live here
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    worker.join();
+
+    return exitCode.load();
+}
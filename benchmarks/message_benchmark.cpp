@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * message-benchmark - Cost of a parameter message in each encoding.
+ *
+ * Encodes and decodes the demo's parameter change the three ways the IPC
+ * can carry it: a ValueTree in JUCE's stream format, the same tree with
+ * interned names (IPC_CODEC_DICT), and the typed struct generated from
+ * demo/messages.schema. Each round covers what the sender and receiver do
+ * per message, down to reading the id and value back out; the socket is
+ * left out, it costs the same per byte for all three.
+ *
+ * Usage: message-benchmark [messages per round]
+ */
+
+#include <juce_cmp/juce_cmp.h>
+#include "Messages.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace juce_cmp;
+
+namespace
+{
+    constexpr int rounds = 7;
+
+    // Keeps the decoded values alive so the work isn't optimized out
+    volatile double sink = 0.0;
+
+    struct Result
+    {
+        double nsPerMessage = 0.0;
+        size_t bytes = 0;  // After the event type byte
+    };
+
+    template <typename Fn>
+    Result measure(int count, Fn&& roundTrip)
+    {
+        std::vector<double> times;
+        size_t bytes = 0;
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; ++i)
+                bytes = roundTrip(i);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            times.push_back(elapsed.count() / count);
+        }
+
+        std::sort(times.begin(), times.end());
+        return { times[times.size() / 2], bytes };
+    }
+
+    // What PluginEditor did before typed messages
+    size_t valueTreeRoundTrip(int i)
+    {
+        juce::ValueTree tree("param");
+        tree.setProperty("id", i & 7, nullptr);
+        tree.setProperty("value", i * 0.001, nullptr);
+
+        juce::MemoryOutputStream stream;
+        tree.writeToStream(stream);
+
+        const auto received = juce::ValueTree::readFromData(stream.getData(), stream.getDataSize());
+        if (received.getType() == juce::Identifier("param"))
+            sink = static_cast<int>(received.getProperty("id", -1)) + static_cast<double>(received.getProperty("value", 0.0));
+
+        return 4 + stream.getDataSize();  // With the size header
+    }
+
+    struct Interned
+    {
+        IdentifierEncoder encoder;
+        IdentifierDecoder decoder;
+
+        size_t roundTrip(int i)
+        {
+            juce::ValueTree tree("param");
+            tree.setProperty("id", i & 7, nullptr);
+            tree.setProperty("value", i * 0.001, nullptr);
+
+            juce::MemoryOutputStream stream;
+            encoder.writeTree(tree, stream);
+
+            juce::MemoryInputStream input(stream.getData(), stream.getDataSize(), false);
+            const auto received = decoder.readTree(input);
+            if (received.getType() == juce::Identifier("param"))
+                sink = static_cast<int>(received.getProperty("id", -1)) + static_cast<double>(received.getProperty("value", 0.0));
+
+            return 4 + stream.getDataSize();
+        }
+    };
+
+    struct Typed : messages::Handler
+    {
+        size_t roundTrip(int i)
+        {
+            uint8_t data[messages::Parameter::wireSize];
+            messages::Parameter { i & 7, i * 0.001 }.encode(data);
+
+            messages::dispatch(TypedMessage { messages::Parameter::id, data, sizeof(data) }, *this);
+            return 4 + sizeof(data);  // With the id and size header
+        }
+
+        void handle(const messages::Parameter& message) override
+        {
+            sink = message.index + message.value;
+        }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    const int count = argc > 1 ? juce::jmax(1, std::atoi(argv[1])) : 200000;
+
+    Interned interned;
+    Typed typed;
+
+    // The dictionary is warm in steady state
+    interned.roundTrip(0);
+
+    const Result results[] = {
+        measure(count, valueTreeRoundTrip),
+        measure(count, [&](int i) { return interned.roundTrip(i); }),
+        measure(count, [&](int i) { return typed.roundTrip(i); }),
+    };
+    const char* names[] = { "ValueTree", "ValueTree, interned", "Typed" };
+
+    std::printf("%-22s %8s %14s %10s\n", "encoding", "bytes", "ns/message", "speedup");
+    for (int i = 0; i < 3; ++i)
+    {
+        std::printf("%-22s %8zu %14.1f %9.1fx\n", names[i], results[i].bytes, results[i].nsPerMessage,
+                    results[0].nsPerMessage / results[i].nsPerMessage);
+    }
+
+    return 0;
+}
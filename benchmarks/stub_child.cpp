@@ -0,0 +1,1111 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * stub-child - Native stand-in for the Compose UI process.
+ *
+ * Launched by ChildProcess like the real UI (--socket-fd, --scale,
+ * --protocol) and speaks the same protocol from the other end: HELLO,
+ * chunks, blobs, LZ4, state batches (EVENT_TYPE_BATCH), clock sync and
+ * trace batches, stats reports, memory trims (malloc_trim, nothing else to
+ * release), and on Linux the shared surface
+ * (CMP_EVENT_SURFACE) it renders into before answering SURFACE_READY. No JVM, no Compose and no GPU, so Ipc,
+ * ChildProcess and ComposeProvider can be benchmarked and stress-tested on
+ * a headless Linux box. Built on the protocol headers alone, sharing no
+ * code with the host side but the LZ4 block codec.
+ *
+ * Interned trees (IPC_CODEC_DICT) are not offered: echoing the host's
+ * tokens back would not match the host's receiving dictionary.
+ *
+ * Behaviour is scripted with options, all off by default:
+ *   --echo                 Send JUCE and typed messages back, answer RPC
+ *                          requests with their own tree
+ *   --echo=typed           Only typed messages, e.g. as a barrier after a
+ *                          one-way transfer
+ *   --reply-delay-us=N     Wait before each echo (slow message handler)
+ *   --flood=N              Send N ValueTrees once the handshake is done
+ *   --flood-size=BYTES     Approximate size of each (default 64)
+ *   --flood-rate=N         Messages per second, 0 = as fast as possible
+ *   --flood-typed=ID       Send typed messages with this id instead
+ *   --fps=N                Render synthetic frames continuously
+ *   --render-ms=N          Busy time per frame (default 1)
+ *   --pause-ms=N           Freeze reading, writing and rendering for N ms...
+ *   --pause-every-ms=N     ...this often (default 1000), like a GC pause
+ *   --startup-delay-ms=N   Wait before saying HELLO (slow JVM startup)
+ *   --no-blob              Don't offer IPC_TRANSPORT_BLOB, everything inline
+ *   --exit-after-ms=N      Exit cleanly after N ms
+ *   --crash-after-ms=N     Abort after N ms
+ *   --shutdown-ms=N        Take N ms to exit after SHUTDOWN or EOF (slow flush)
+ *   --ignore-sigterm       Only SIGKILL stops it (hung UI)
+ *   --summary              Print traffic counters to stderr on exit
+ *
+ * A frame is rendered and SURFACE_READY sent for every new surface (or
+ * every resize without one), whether or not --fps is given.
+ */
+
+#include "ipc_protocol.h"
+#include "input_event.h"
+#include "Lz4.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#if __linux__
+#include <malloc.h>
+#endif
+
+namespace
+{
+    constexpr uint32_t varMarkerInt = 1;     // JUCE var stream markers
+    constexpr uint32_t varMarkerBinary = 8;
+
+    struct Options
+    {
+        int socketFD = -1;
+        int protocol = 0;
+        bool echo = false;
+        bool echoTrees = false;
+        int replyDelayUs = 0;
+        int floodCount = 0;
+        int floodSize = 64;
+        int floodRate = 0;
+        int floodTypedId = -1;
+        int fps = 0;
+        int renderMs = 1;
+        int pauseMs = 0;
+        int pauseEveryMs = 1000;
+        int startupDelayMs = 0;
+        bool blob = true;
+        int exitAfterMs = 0;
+        int crashAfterMs = 0;
+        int shutdownMs = 0;
+        bool ignoreSigterm = false;
+        bool summary = false;
+    };
+
+    Options parseOptions(int argc, char* argv[])
+    {
+        Options options;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg(argv[i]);
+            const auto equals = arg.find('=');
+            const std::string name = arg.substr(0, equals);
+            const int value = equals == std::string::npos ? 0 : std::atoi(arg.c_str() + equals + 1);
+
+            // --scale and --mach-service are accepted and ignored
+            if (name == "--socket-fd") options.socketFD = value;
+            else if (name == "--protocol") options.protocol = value;
+            else if (name == "--echo")
+            {
+                options.echo = true;
+                options.echoTrees = arg != "--echo=typed";
+            }
+            else if (name == "--reply-delay-us") options.replyDelayUs = value;
+            else if (name == "--flood") options.floodCount = value;
+            else if (name == "--flood-size") options.floodSize = value;
+            else if (name == "--flood-rate") options.floodRate = value;
+            else if (name == "--flood-typed") options.floodTypedId = value;
+            else if (name == "--fps") options.fps = value;
+            else if (name == "--render-ms") options.renderMs = value;
+            else if (name == "--pause-ms") options.pauseMs = value;
+            else if (name == "--pause-every-ms") options.pauseEveryMs = value;
+            else if (name == "--startup-delay-ms") options.startupDelayMs = value;
+            else if (name == "--no-blob") options.blob = false;
+            else if (name == "--exit-after-ms") options.exitAfterMs = value;
+            else if (name == "--crash-after-ms") options.crashAfterMs = value;
+            else if (name == "--shutdown-ms") options.shutdownMs = value;
+            else if (name == "--ignore-sigterm") options.ignoreSigterm = true;
+            else if (name == "--summary") options.summary = true;
+        }
+        return options;
+    }
+
+    int64_t now()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    constexpr int64_t msToNs(int64_t ms) { return ms * 1000000; }
+
+    void writeCompressedInt(std::vector<uint8_t>& out, uint32_t value)
+    {
+        uint8_t bytes[5] = {};
+        uint8_t count = 0;
+        while (value > 0)
+        {
+            bytes[++count] = static_cast<uint8_t>(value);
+            value >>= 8;
+        }
+        bytes[0] = count;
+        out.insert(out.end(), bytes, bytes + count + 1);
+    }
+
+    void writeName(std::vector<uint8_t>& out, const char* name)
+    {
+        out.insert(out.end(), name, name + std::strlen(name) + 1);
+    }
+
+    /** The shared surface, mapped read-write. */
+    struct Surface
+    {
+        void* pixels = nullptr;
+        size_t size = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+
+        ~Surface() { unmap(); }
+
+        void unmap()
+        {
+            if (pixels != nullptr)
+                munmap(pixels, size);
+            pixels = nullptr;
+            size = 0;
+        }
+    };
+
+    class StubChild
+    {
+    public:
+        explicit StubChild(const Options& o) : options(o) {}
+
+        int run()
+        {
+            start = now();
+
+            if (options.startupDelayMs > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.startupDelayMs));
+
+            if (options.protocol > 0)
+                sendHello();
+            else
+                startScript();  // Version 0: no handshake to wait for
+
+            nextPause = start + msToNs(options.pauseEveryMs);
+            nextStats = now() + msToNs(1000);
+            lastStats = now();
+
+            while (connected)
+            {
+                runTimers();
+                if (!connected)
+                    break;
+
+                struct pollfd pfd = { options.socketFD, POLLIN, 0 };
+                const int ready = poll(&pfd, 1, pollTimeout());
+                if (ready < 0 && errno != EINTR)
+                    break;
+                if (ready <= 0)
+                    continue;
+
+                // Drain what's there, but let timers and the flood run in between
+                for (int i = 0; i < 64 && connected; ++i)
+                {
+                    if (!readMessage())
+                        connected = false;
+
+                    struct pollfd more = { options.socketFD, POLLIN, 0 };
+                    if (poll(&more, 1, 0) <= 0)
+                        break;
+                }
+            }
+
+            if (options.shutdownMs > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.shutdownMs));
+
+            if (options.summary)
+            {
+                std::fprintf(stderr, "stub-child: rx %llu messages %llu bytes, tx %llu messages %llu bytes, "
+                                     "%llu frames, %llu echoed\n",
+                             (unsigned long long)rxMessages, (unsigned long long)rxBytes,
+                             (unsigned long long)txMessages, (unsigned long long)txBytes,
+                             (unsigned long long)framesRendered, (unsigned long long)echoed);
+            }
+            return 0;
+        }
+
+    private:
+        // =====================================================================
+        // Timers: pauses, frames, flood, stats, exit
+        // =====================================================================
+
+        void runTimers()
+        {
+            int64_t t = now();
+
+            if (options.crashAfterMs > 0 && t - start >= msToNs(options.crashAfterMs))
+                std::abort();
+
+            if (options.exitAfterMs > 0 && t - start >= msToNs(options.exitAfterMs))
+            {
+                connected = false;
+                return;
+            }
+
+            if (options.pauseMs > 0 && t >= nextPause)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.pauseMs));
+                t = now();
+                nextPause = t + msToNs(std::max(1, options.pauseEveryMs));
+            }
+
+            if (scripted && options.fps > 0 && t >= nextFrame)
+            {
+                renderFrame();
+                nextFrame = std::max<int64_t>(nextFrame + 1000000000LL / options.fps, t);
+            }
+
+            if (floodRemaining > 0)
+                flood(t);
+
+            if (t >= nextStats)
+            {
+                sendStats(t);
+                nextStats = t + msToNs(1000);
+            }
+        }
+
+        int pollTimeout() const
+        {
+            if (floodRemaining > 0 && options.floodRate <= 0)
+                return 0;
+
+            int64_t next = nextStats;
+            if (options.pauseMs > 0) next = std::min(next, nextPause);
+            if (scripted && options.fps > 0) next = std::min(next, nextFrame);
+            if (floodRemaining > 0) next = std::min(next, nextFlood);
+            if (options.exitAfterMs > 0) next = std::min(next, start + msToNs(options.exitAfterMs));
+            if (options.crashAfterMs > 0) next = std::min(next, start + msToNs(options.crashAfterMs));
+
+            const int64_t wait = (next - now() + 999999) / 1000000;
+            return static_cast<int>(std::clamp<int64_t>(wait, 0, 100));
+        }
+
+        /** Called once the protocol is settled. */
+        void startScript()
+        {
+            scripted = true;
+            floodRemaining = options.floodCount;
+            nextFlood = now();
+            nextFrame = now();
+        }
+
+        void flood(int64_t t)
+        {
+            // Unthrottled floods go out in batches so incoming messages still get read
+            int batch = 64;
+            if (options.floodRate > 0)
+            {
+                if (t < nextFlood)
+                    return;
+                batch = 1;
+                nextFlood += 1000000000 / options.floodRate;
+            }
+
+            for (; batch > 0 && floodRemaining > 0 && connected; --batch, --floodRemaining)
+            {
+                const auto sequence = static_cast<uint32_t>(options.floodCount - floodRemaining);
+
+                if (options.floodTypedId >= 0)
+                {
+                    // Sequence first, zero padding up to the size
+                    std::vector<uint8_t> body(std::clamp(options.floodSize, 4, IPC_TYPED_MAX_SIZE));
+                    std::memcpy(body.data(), &sequence, sizeof(sequence));
+                    sendTyped(static_cast<uint16_t>(options.floodTypedId), body.data(), body.size());
+                }
+                else
+                {
+                    sendPayload(EVENT_TYPE_JUCE, makeFloodTree(sequence));
+                }
+            }
+        }
+
+        /** <flood seq=n data=binary/>, about --flood-size bytes in JUCE's stream format. */
+        std::vector<uint8_t> makeFloodTree(uint32_t sequence) const
+        {
+            constexpr int overhead = 32;
+            const auto dataSize = static_cast<uint32_t>(std::max(0, options.floodSize - overhead));
+
+            std::vector<uint8_t> tree;
+            tree.reserve(overhead + dataSize);
+            writeName(tree, "flood");
+            writeCompressedInt(tree, 2);
+
+            writeName(tree, "seq");
+            writeCompressedInt(tree, 5);
+            tree.push_back(varMarkerInt);
+            tree.insert(tree.end(), reinterpret_cast<const uint8_t*>(&sequence),
+                        reinterpret_cast<const uint8_t*>(&sequence) + sizeof(sequence));
+
+            writeName(tree, "data");
+            writeCompressedInt(tree, 1 + dataSize);
+            tree.push_back(varMarkerBinary);
+            tree.resize(tree.size() + dataSize, static_cast<uint8_t>(sequence));
+
+            writeCompressedInt(tree, 0);
+            return tree;
+        }
+
+        // =====================================================================
+        // Frames
+        // =====================================================================
+
+        void renderFrame()
+        {
+            const int64_t frameStart = now();
+
+            // A band that moves down a row per frame, so a viewer can tell frames apart
+            if (surface.pixels != nullptr)
+            {
+                auto* pixels = static_cast<uint32_t*>(surface.pixels);
+                const uint32_t band = static_cast<uint32_t>(framesRendered % std::max(1u, surface.height));
+                for (uint32_t y = 0; y < surface.height; ++y)
+                {
+                    const uint32_t color = y == band ? 0xFFFFFFFF : 0xFF000000 | (y * 255 / surface.height) << 8;
+                    std::fill_n(pixels + static_cast<size_t>(y) * surface.stride, surface.width, color);
+                }
+            }
+
+            // Simulated layout and draw time
+            const int64_t renderEnd = frameStart + msToNs(options.renderMs);
+            while (now() < renderEnd) {}
+
+            const int64_t frameEnd = now();
+            ++framesRendered;
+            frameTimesUs.push_back(static_cast<uint32_t>((frameEnd - frameStart) / 1000));
+            record(TRACE_NAME_FRAME, TRACE_PHASE_COMPLETE, frameStart, frameEnd - frameStart,
+                   static_cast<uint32_t>(framesRendered));
+
+            const uint8_t message[2] = { EVENT_TYPE_CMP, CMP_EVENT_SURFACE_READY };
+            send(message, sizeof(message));
+            record(TRACE_NAME_SURFACE_READY, TRACE_PHASE_INSTANT, now(), 0, 0);
+        }
+
+        void handleSurface(int fd)
+        {
+            uint32_t dimensions[3] = {};  // Width, height, stride
+            const bool ok = readFully(dimensions, sizeof(dimensions));
+            const size_t size = static_cast<size_t>(dimensions[2]) * dimensions[1] * 4;
+
+            struct stat st;
+            if (!ok || fd < 0 || dimensions[2] < dimensions[0] || size == 0
+                || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size)
+            {
+                if (fd >= 0)
+                    close(fd);
+                return;
+            }
+
+            void* pixels = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (pixels == MAP_FAILED)
+                return;
+
+            surface.unmap();
+            surface.pixels = pixels;
+            surface.size = size;
+            surface.width = dimensions[0];
+            surface.height = dimensions[1];
+            surface.stride = dimensions[2];
+
+            // First frame on the new surface, then the host swaps to it
+            renderFrame();
+        }
+
+        // =====================================================================
+        // RX
+        // =====================================================================
+
+        /** One message from the socket, or from a reassembled chunk. */
+        bool readMessage()
+        {
+            uint8_t eventType = 0;
+            int fd = -1;
+            if (!readEventType(eventType, fd))
+                return false;
+
+            return dispatch(eventType, fd);
+        }
+
+        bool dispatch(uint8_t eventType, int fd)
+        {
+            if (eventType != EVENT_TYPE_CHUNK)
+                ++rxMessages;
+
+            // Only blobs and surfaces come with a descriptor
+            if (fd >= 0 && eventType != EVENT_TYPE_BLOB && eventType != EVENT_TYPE_CMP)
+            {
+                close(fd);
+                fd = -1;
+            }
+
+            switch (eventType)
+            {
+                case EVENT_TYPE_INPUT:
+                    return handleInput();
+                case EVENT_TYPE_CMP:
+                    return handleCmp(fd);
+                case EVENT_TYPE_JUCE:
+                case EVENT_TYPE_RPC:
+                case EVENT_TYPE_MIRROR:
+                    return handleInline(eventType);
+                case EVENT_TYPE_JUCE | EVENT_FLAG_COMPRESSED:
+                case EVENT_TYPE_RPC | EVENT_FLAG_COMPRESSED:
+                case EVENT_TYPE_MIRROR | EVENT_FLAG_COMPRESSED:
+                    return handleCompressed(static_cast<uint8_t>(eventType & ~EVENT_FLAG_COMPRESSED));
+                case EVENT_TYPE_BLOB:
+                    return handleBlob(fd);
+                case EVENT_TYPE_TYPED:
+                    return handleTyped();
+                case EVENT_TYPE_BATCH:
+                    return handleBatch();
+                case EVENT_TYPE_CHUNK:
+                    return replayData == nullptr && handleChunk();
+                default:
+                    // Unknown length, can't find the next message
+                    std::fprintf(stderr, "stub-child: unexpected event type %d\n", eventType);
+                    return false;
+            }
+        }
+
+        bool handleInput()
+        {
+            InputEvent event = {};
+            if (!readFully(&event, sizeof(event)))
+                return false;
+
+            // Without a surface by descriptor a resize is all there is to render for
+            if (event.type == INPUT_EVENT_RESIZE && (transports & IPC_TRANSPORT_SURFACE_FD) == 0)
+                renderFrame();
+            return true;
+        }
+
+        bool handleCmp(int fd)
+        {
+            uint8_t subtype = 0;
+            const bool ok = readFully(&subtype, 1);
+
+            if (ok && subtype == CMP_EVENT_SURFACE)
+            {
+                handleSurface(fd);
+                return true;
+            }
+            if (fd >= 0)
+                close(fd);
+            if (!ok)
+                return false;
+
+            switch (subtype)
+            {
+                case CMP_EVENT_SHUTDOWN:
+                    connected = false;
+                    return true;
+                case CMP_EVENT_MEMORY_PRESSURE:
+                {
+                    uint8_t level = 0;
+                    if (!readFully(&level, 1))
+                        return false;
+                    if (level != IPC_MEMORY_PRESSURE_NONE)
+                        trimMemory(level);
+                    return true;
+                }
+                case CMP_EVENT_HELLO:
+                {
+                    HelloMessage hello = {};
+                    if (!readFully(&hello, sizeof(hello)) || hello.magic != IPC_HELLO_MAGIC)
+                        return false;
+                    capabilities = hello.capabilities;
+                    transports = hello.transports;
+                    codecs = hello.codecs;
+                    maxMessageSize = hello.maxMessageSize;
+                    startScript();
+                    return true;
+                }
+                case CMP_EVENT_CLOCK_SYNC:
+                {
+                    int64_t times[2] = {};  // Echoed host time, our time
+                    if (!readFully(times, sizeof(int64_t)))
+                        return false;
+                    times[1] = now();
+                    sendCmp(CMP_EVENT_CLOCK_SYNC, times, sizeof(times));
+                    return true;
+                }
+                case CMP_EVENT_TRACE_CONTROL:
+                {
+                    uint8_t enable = 0;
+                    if (!readFully(&enable, 1))
+                        return false;
+                    tracing = enable != 0;
+                    if (!tracing)
+                        sendTraceData();
+                    else
+                        traceRecords.clear();
+                    return true;
+                }
+                default:
+                    std::fprintf(stderr, "stub-child: unexpected CMP event %d\n", subtype);
+                    return false;
+            }
+        }
+
+        bool handleInline(uint8_t eventType)
+        {
+            uint32_t size = 0;
+            if (!readFully(&size, sizeof(size)) || size > IPC_MAX_MESSAGE_SIZE)
+                return false;
+
+            rxPayload.resize(size);
+            if (!readFully(rxPayload.data(), size))
+                return false;
+
+            handlePayload(eventType, rxPayload.data(), size);
+            return true;
+        }
+
+        bool handleCompressed(uint8_t eventType)
+        {
+            uint32_t sizes[2] = {};  // Compressed, uncompressed
+            if (!readFully(sizes, sizeof(sizes)) || sizes[0] > IPC_MAX_MESSAGE_SIZE || sizes[1] > IPC_MAX_MESSAGE_SIZE)
+                return false;
+
+            rxCompressed.resize(sizes[0]);
+            if (!readFully(rxCompressed.data(), sizes[0]))
+                return false;
+
+            rxPayload.resize(sizes[1]);
+            if (juce_cmp::Lz4Compressor::decompress(rxCompressed.data(), sizes[0], rxPayload.data(), sizes[1]))
+                handlePayload(eventType, rxPayload.data(), sizes[1]);
+            return true;
+        }
+
+        bool handleBlob(int fd)
+        {
+            uint8_t header[9] = {};  // Payload event type + 8-byte size
+            const bool ok = readFully(header, sizeof(header));
+            uint64_t size = 0;
+            std::memcpy(&size, header + 1, sizeof(size));
+
+            void* data = MAP_FAILED;
+            if (ok && fd >= 0 && size > 0 && size <= IPC_MAX_BLOB_SIZE)
+                data = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+            if (fd >= 0)
+                close(fd);
+
+            if (data != MAP_FAILED)
+            {
+                handlePayload(header[0], static_cast<const uint8_t*>(data), static_cast<size_t>(size));
+                munmap(data, static_cast<size_t>(size));
+            }
+            return ok;
+        }
+
+        bool handleTyped()
+        {
+            uint16_t header[2] = {};  // Message id, size
+            if (!readFully(header, sizeof(header)) || header[1] > IPC_TYPED_MAX_SIZE)
+                return false;
+
+            rxPayload.resize(header[1]);
+            if (!readFully(rxPayload.data(), header[1]))
+                return false;
+
+            if (options.echo)
+            {
+                replyDelay();
+                sendTyped(header[0], rxPayload.data(), header[1]);
+                ++echoed;
+            }
+            return true;
+        }
+
+        bool handleBatch()
+        {
+            uint32_t size = 0;
+            if (!readFully(&size, sizeof(size)) || size > IPC_MAX_MESSAGE_SIZE)
+                return false;
+
+            std::vector<uint8_t> batch(size);
+            if (!readFully(batch.data(), size))
+                return false;
+
+            // Each message read from memory like a reassembled chunk; the
+            // batch itself may be one
+            const uint8_t* outerData = replayData;
+            const size_t outerRemaining = replayRemaining;
+            bool ok = true;
+
+            for (size_t offset = 0; ok && offset + 4 <= batch.size();)
+            {
+                uint32_t length = 0;
+                std::memcpy(&length, batch.data() + offset, sizeof(length));
+                if (length == 0 || length > batch.size() - offset - 4)
+                    break;
+
+                const uint8_t eventType = batch[offset + 4];
+                replayData = batch.data() + offset + 5;
+                replayRemaining = length - 1;
+                if (eventType == EVENT_TYPE_TYPED || eventType == EVENT_TYPE_JUCE || eventType == EVENT_TYPE_MIRROR)
+                    ok = dispatch(eventType, -1);
+                offset += 4 + length;
+            }
+
+            replayData = outerData;
+            replayRemaining = outerRemaining;
+            return ok;
+        }
+
+        bool handleChunk()
+        {
+            uint8_t header[4] = {};  // Lane + flags + 2-byte length
+            if (!readFully(header, sizeof(header)) || header[0] >= IPC_LANE_COUNT)
+                return false;
+
+            uint16_t length = 0;
+            std::memcpy(&length, header + 2, sizeof(length));
+
+            auto& chunks = rxChunks[header[0]];
+            if ((header[1] & IPC_CHUNK_FIRST) != 0)
+                chunks.clear();
+
+            const size_t offset = chunks.size();
+            chunks.resize(offset + length);
+            if (!readFully(chunks.data() + offset, length))
+                return false;
+
+            if ((header[1] & IPC_CHUNK_LAST) == 0 || chunks.empty())
+                return true;
+
+            // The whole message is in memory now; read it from there
+            std::vector<uint8_t> message;
+            message.swap(chunks);
+            replayData = message.data() + 1;
+            replayRemaining = message.size() - 1;
+            const bool ok = dispatch(message[0], -1);
+            replayData = nullptr;
+            replayRemaining = 0;
+            return ok;
+        }
+
+        /** JUCE, RPC or mirror payload, after the size field. */
+        void handlePayload(uint8_t eventType, const uint8_t* data, size_t size)
+        {
+            if (!options.echoTrees)
+                return;
+
+            if (eventType == EVENT_TYPE_JUCE)
+            {
+                replyDelay();
+                sendPayload(eventType, std::vector<uint8_t>(data, data + size));
+                ++echoed;
+            }
+            else if (eventType == EVENT_TYPE_RPC && size >= sizeof(RpcHeader) && data[0] == IPC_RPC_REQUEST)
+            {
+                // The request's tree is the response
+                replyDelay();
+                std::vector<uint8_t> response(data, data + size);
+                response[0] = IPC_RPC_RESPONSE;
+                sendPayload(EVENT_TYPE_RPC, std::move(response));
+                ++echoed;
+            }
+        }
+
+        void replyDelay() const
+        {
+            if (options.replyDelayUs > 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(options.replyDelayUs));
+        }
+
+        bool readEventType(uint8_t& type, int& fd)
+        {
+            fd = -1;
+
+            struct iovec iov = { &type, 1 };
+            alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+            struct msghdr msg = {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            ssize_t n = -1;
+            do
+                n = recvmsg(options.socketFD, &msg, 0);
+            while (n < 0 && errno == EINTR);
+
+            if (n != 1)
+                return false;
+            ++rxBytes;
+
+            for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+                    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+            return true;
+        }
+
+        bool readFully(void* buffer, size_t size)
+        {
+            auto* ptr = static_cast<uint8_t*>(buffer);
+
+            if (replayData != nullptr)
+            {
+                if (size > replayRemaining)
+                    return false;
+                std::memcpy(ptr, replayData, size);
+                replayData += size;
+                replayRemaining -= size;
+                return true;
+            }
+
+            // The rest of a message follows its first byte closely, so just block
+            size_t done = 0;
+            while (done < size)
+            {
+                const ssize_t n = ::read(options.socketFD, ptr + done, size - done);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                done += static_cast<size_t>(n);
+            }
+            rxBytes += size;
+            return true;
+        }
+
+        // =====================================================================
+        // TX
+        // =====================================================================
+
+        void sendHello()
+        {
+            HelloMessage hello = {};
+            hello.magic = IPC_HELLO_MAGIC;
+            hello.version = static_cast<uint16_t>(std::min(options.protocol, IPC_PROTOCOL_VERSION));
+            hello.capabilities = IPC_CAP_TRACE | IPC_CAP_STATS | IPC_CAP_CHUNKS | IPC_CAP_RPC | IPC_CAP_TYPED
+                               | IPC_CAP_BATCH | IPC_CAP_SHUTDOWN | IPC_CAP_MEMORY;
+            hello.transports = IPC_TRANSPORT_SOCKET;
+            if (options.blob)
+                hello.transports |= IPC_TRANSPORT_BLOB;
+#if __linux__
+            hello.transports |= IPC_TRANSPORT_SURFACE_FD;
+#endif
+            hello.codecs = IPC_CODEC_RAW | IPC_CODEC_LZ4;
+            hello.maxMessageSize = IPC_MAX_MESSAGE_SIZE;
+            sendCmp(CMP_EVENT_HELLO, &hello, sizeof(hello));
+        }
+
+        void sendCmp(uint8_t subtype, const void* data, size_t size)
+        {
+            std::vector<uint8_t> message = { EVENT_TYPE_CMP, subtype };
+            message.insert(message.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+            send(message.data(), message.size());
+        }
+
+        void sendStats(int64_t t)
+        {
+            if ((capabilities & IPC_CAP_STATS) == 0)
+            {
+                frameTimesUs.clear();
+                return;
+            }
+
+            StatsReport report = {};
+            report.intervalMs = static_cast<uint32_t>((t - lastStats) / 1000000);
+            report.frames = static_cast<uint32_t>(frameTimesUs.size());
+
+            if (!frameTimesUs.empty())
+            {
+                std::sort(frameTimesUs.begin(), frameTimesUs.end());
+                auto percentile = [this](size_t p) { return frameTimesUs[(frameTimesUs.size() - 1) * p / 100]; };
+                report.frameTimeP50 = percentile(50);
+                report.frameTimeP95 = percentile(95);
+                report.frameTimeP99 = percentile(99);
+                report.frameTimeMax = frameTimesUs.back();
+            }
+
+            struct timespec cpu = {};
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+            report.cpuTimeNs = static_cast<uint64_t>(cpu.tv_sec) * 1000000000ull + static_cast<uint64_t>(cpu.tv_nsec);
+
+            report.residentBytes = residentBytes();
+
+            sendCmp(CMP_EVENT_STATS, &report, sizeof(report));
+            frameTimesUs.clear();
+            lastStats = t;
+        }
+
+        static uint64_t residentBytes()
+        {
+            uint64_t bytes = 0;
+#if __linux__
+            if (FILE* statm = std::fopen("/proc/self/statm", "r"))
+            {
+                unsigned long long pages = 0, resident = 0;
+                if (std::fscanf(statm, "%llu %llu", &pages, &resident) == 2)
+                    bytes = resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+                std::fclose(statm);
+            }
+#endif
+            return bytes;
+        }
+
+        void trimMemory(uint8_t level)
+        {
+            MemoryTrimReport report = {};
+            report.level = level;
+            report.residentBefore = residentBytes();
+
+            const int64_t trimStart = now();
+#if __GLIBC__
+            malloc_trim(0);
+#endif
+            report.durationUs = static_cast<uint32_t>((now() - trimStart) / 1000);
+            report.residentAfter = residentBytes();
+
+            if ((capabilities & IPC_CAP_MEMORY) != 0)
+                sendCmp(CMP_EVENT_MEMORY_TRIMMED, &report, sizeof(report));
+        }
+
+        void record(uint8_t name, uint8_t phase, int64_t timestamp, int64_t duration, uint32_t arg)
+        {
+            if (!tracing || traceRecords.size() >= 65536)
+                return;
+
+            TraceRecord r = {};
+            r.timestamp = timestamp;
+            r.duration = duration;
+            r.arg = arg;
+            r.name = name;
+            r.phase = phase;
+            traceRecords.push_back(r);
+        }
+
+        /** Everything recorded since tracing started, as the final batch. */
+        void sendTraceData()
+        {
+            if ((capabilities & IPC_CAP_TRACE) == 0)
+                return;
+
+            const auto count = static_cast<uint32_t>(traceRecords.size());
+            std::vector<uint8_t> message(7 + count * sizeof(TraceRecord));
+            message[0] = EVENT_TYPE_CMP;
+            message[1] = CMP_EVENT_TRACE_DATA;
+            message[2] = 1;  // Final
+            std::memcpy(message.data() + 3, &count, sizeof(count));
+            if (count > 0)
+                std::memcpy(message.data() + 7, traceRecords.data(), count * sizeof(TraceRecord));
+            send(message.data(), message.size());
+            traceRecords.clear();
+        }
+
+        void sendTyped(uint16_t id, const void* data, size_t size)
+        {
+            if ((capabilities & IPC_CAP_TYPED) == 0)
+                return;
+
+            std::vector<uint8_t> message(5 + size);
+            const uint16_t header[2] = { id, static_cast<uint16_t>(size) };
+            message[0] = EVENT_TYPE_TYPED;
+            std::memcpy(message.data() + 1, header, sizeof(header));
+            std::memcpy(message.data() + 5, data, size);
+            send(message.data(), message.size());
+        }
+
+        /** Inline, compressed or as a blob, the way the real UI would pick. */
+        void sendPayload(uint8_t eventType, std::vector<uint8_t> payload)
+        {
+            const size_t size = payload.size();
+
+            if ((transports & IPC_TRANSPORT_BLOB) != 0 && size >= IPC_BLOB_THRESHOLD && sendBlob(eventType, payload))
+                return;
+
+            if ((codecs & IPC_CODEC_LZ4) != 0 && size >= IPC_COMPRESS_THRESHOLD)
+            {
+                std::vector<uint8_t> message(9 + juce_cmp::Lz4Compressor::maxCompressedSize(size));
+                const size_t compressedSize = compressor.compress(payload.data(), size, message.data() + 9,
+                                                                  message.size() - 9);
+                if (compressedSize > 0 && compressedSize < size)
+                {
+                    const uint32_t sizes[2] = { static_cast<uint32_t>(compressedSize), static_cast<uint32_t>(size) };
+                    message[0] = static_cast<uint8_t>(eventType | EVENT_FLAG_COMPRESSED);
+                    std::memcpy(message.data() + 1, sizes, sizeof(sizes));
+                    send(message.data(), 9 + compressedSize);
+                    return;
+                }
+            }
+
+            if (size > maxMessageSize)
+                return;  // The host would drop it
+
+            const auto size32 = static_cast<uint32_t>(size);
+            payload.insert(payload.begin(), 5, 0);
+            payload[0] = eventType;
+            std::memcpy(payload.data() + 1, &size32, sizeof(size32));
+            send(payload.data(), payload.size());
+        }
+
+        bool sendBlob(uint8_t eventType, const std::vector<uint8_t>& payload)
+        {
+#if __linux__
+            // Sealed, or the host refuses to map it
+            int fd = memfd_create("stub_child_blob", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+            if (fd < 0)
+                return false;
+
+            const bool written = ::write(fd, payload.data(), payload.size()) == static_cast<ssize_t>(payload.size())
+                              && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+
+            uint8_t message[10] = { EVENT_TYPE_BLOB, eventType };
+            const uint64_t size = payload.size();
+            std::memcpy(message + 2, &size, sizeof(size));
+
+            const bool ok = written && send(message, sizeof(message), fd);
+            close(fd);
+            return ok;
+#else
+            (void)eventType;
+            (void)payload;
+            return false;
+#endif
+        }
+
+        bool send(const void* data, size_t size, int fd = -1)
+        {
+            if (!connected)
+                return false;
+
+            auto* ptr = static_cast<const uint8_t*>(data);
+            size_t done = 0;
+
+            if (fd >= 0)
+            {
+                // The descriptor travels with the first byte
+                struct iovec iov = { const_cast<uint8_t*>(ptr), size };
+                alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+                struct msghdr msg = {};
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+
+                auto* cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+                std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+                ssize_t n = -1;
+                do
+                    n = sendmsg(options.socketFD, &msg, 0);
+                while (n < 0 && errno == EINTR);
+
+                if (n <= 0)
+                {
+                    connected = false;
+                    return false;
+                }
+                done = static_cast<size_t>(n);
+            }
+
+            while (done < size)
+            {
+                const ssize_t n = ::write(options.socketFD, ptr + done, size - done);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                {
+                    connected = false;
+                    return false;
+                }
+                done += static_cast<size_t>(n);
+            }
+
+            ++txMessages;
+            txBytes += size;
+            return true;
+        }
+
+        const Options options;
+        bool connected = true;
+        int64_t start = 0;
+
+        // Agreed in the handshake; version 0 has none of it
+        uint32_t capabilities = 0;
+        uint32_t transports = IPC_TRANSPORT_SOCKET;
+        uint32_t codecs = IPC_CODEC_RAW;
+        uint32_t maxMessageSize = IPC_MAX_MESSAGE_SIZE;
+
+        // Timers
+        int64_t nextPause = 0;
+        int64_t nextFrame = 0;
+        int64_t nextFlood = 0;
+        int64_t nextStats = 0;
+        int64_t lastStats = 0;
+        int floodRemaining = 0;
+        bool scripted = false;  // Handshake done, frames and flood may start
+
+        // RX buffers, reused between messages
+        std::vector<uint8_t> rxPayload;
+        std::vector<uint8_t> rxCompressed;
+        std::vector<uint8_t> rxChunks[IPC_LANE_COUNT];
+        const uint8_t* replayData = nullptr;
+        size_t replayRemaining = 0;
+
+        juce_cmp::Lz4Compressor compressor;
+        Surface surface;
+
+        // Frames and trace records since the last report
+        std::vector<uint32_t> frameTimesUs;
+        std::vector<TraceRecord> traceRecords;
+        bool tracing = false;
+
+        // Counters for --summary
+        uint64_t rxMessages = 0;
+        uint64_t rxBytes = 0;
+        uint64_t txMessages = 0;
+        uint64_t txBytes = 0;
+        uint64_t framesRendered = 0;
+        uint64_t echoed = 0;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    const auto options = parseOptions(argc, argv);
+    if (options.socketFD < 0)
+    {
+        std::fprintf(stderr, "Usage: stub-child --socket-fd=N [--protocol=V] [options], see stub_child.cpp\n");
+        return 2;
+    }
+
+    // A host that goes away shows up as a failed write, not a signal
+    std::signal(SIGPIPE, SIG_IGN);
+    if (options.ignoreSigterm)
+        std::signal(SIGTERM, SIG_IGN);
+
+    StubChild child(options);
+    return child.run();
+}
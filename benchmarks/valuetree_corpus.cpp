@@ -0,0 +1,517 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * valuetree-corpus - ValueTree codec conformance between JUCE and the UI.
+ *
+ * JuceValueTree.kt reimplements ValueTree::writeToStream, and both sides
+ * have their own in-place readers and interned codec, so any of them can
+ * drift. This generates a corpus with JUCE as the reference - every var
+ * type, edge values, Unicode, deep nesting, wide trees, large binaries - and
+ * checks everything against it:
+ *
+ *   generate <dir>   Write the corpus: <case>.tree (writeToStream),
+ *                    interned.stream (all cases through one IdentifierEncoder,
+ *                    each prefixed with its 4-byte size) and cases.txt
+ *   verify <dir>     Check ValueTree, ValueTreeView and IdentifierDecoder
+ *                    against it, then what the JVM wrote back if present
+ *                    (<case>.jvm.tree, interned.jvm.stream). Exits with 1 on
+ *                    any mismatch
+ *   bench <dir> [MB] Encode and decode throughput per case, each measured
+ *                    over about MB megabytes (default 64)
+ *
+ * The JVM side is ./gradlew :lib:corpusCheck -Pcorpus=<dir>, run between
+ * generate and verify, and CorpusBenchmark for its throughput (both in
+ * juce_cmp_ui/lib/src/jmh). Var has no undefined, arrays or objects; those
+ * read back as void on the JVM, so for cases holding them the expected JVM
+ * output is written to <case>.jvm-expected.tree.
+ *
+ * Usage: valuetree-corpus generate|verify|bench <dir> [MB]
+ */
+
+#include <juce_cmp/juce_cmp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+using namespace juce_cmp;
+
+namespace
+{
+    constexpr int rounds = 5;
+
+    struct Case
+    {
+        juce::String name;
+        juce::ValueTree tree;
+    };
+
+    // ---- The corpus ----
+
+    juce::ValueTree makeScalars()
+    {
+        juce::ValueTree tree("scalars");
+        tree.setProperty("void", juce::var(), nullptr);
+        tree.setProperty("intZero", 0, nullptr);
+        tree.setProperty("intMinusOne", -1, nullptr);
+        tree.setProperty("intMin", std::numeric_limits<int>::min(), nullptr);
+        tree.setProperty("intMax", std::numeric_limits<int>::max(), nullptr);
+        tree.setProperty("int64One", static_cast<juce::int64>(1), nullptr);  // Stays int64
+        tree.setProperty("int64Min", std::numeric_limits<juce::int64>::min(), nullptr);
+        tree.setProperty("int64Max", std::numeric_limits<juce::int64>::max(), nullptr);
+        tree.setProperty("boolTrue", true, nullptr);
+        tree.setProperty("boolFalse", false, nullptr);
+        tree.setProperty("doubleZero", 0.0, nullptr);
+        tree.setProperty("doubleMinusZero", -0.0, nullptr);
+        tree.setProperty("doublePi", juce::MathConstants<double>::pi, nullptr);
+        tree.setProperty("doubleDenormal", std::numeric_limits<double>::denorm_min(), nullptr);
+        tree.setProperty("doubleMax", std::numeric_limits<double>::max(), nullptr);
+        tree.setProperty("doubleInfinity", std::numeric_limits<double>::infinity(), nullptr);
+        tree.setProperty("doubleMinusInfinity", -std::numeric_limits<double>::infinity(), nullptr);
+        tree.setProperty("doubleNaN", std::numeric_limits<double>::quiet_NaN(), nullptr);
+        return tree;
+    }
+
+    juce::ValueTree makeStrings()
+    {
+        juce::ValueTree tree("strings");
+        tree.setProperty("empty", juce::String(), nullptr);
+        tree.setProperty("ascii", "Init Patch", nullptr);
+        tree.setProperty("whitespace", " \t\r\n ", nullptr);
+        tree.setProperty("number", "42", nullptr);
+        tree.setProperty("latin", juce::String::fromUTF8("Gr\xc3\xbc\xc3\x9f" "e"), nullptr);
+        tree.setProperty("cjk", juce::String::fromUTF8("\xe9\x9f\xb3\xe9\x87\x8f"), nullptr);
+        tree.setProperty("emoji", juce::String::fromUTF8("\xf0\x9f\x8e\x9b\xef\xb8\x8f \xf0\x9f\x8e\x9a"), nullptr);
+        tree.setProperty("combining", juce::String::fromUTF8("e\xcc\x81"), nullptr);
+        tree.setProperty("long", juce::String::repeatedString("0123456789abcdef", 256), nullptr);
+        return tree;
+    }
+
+    juce::ValueTree makeBinary()
+    {
+        juce::MemoryBlock allBytes(256);
+        for (int i = 0; i < 256; ++i)
+            allBytes[i] = static_cast<char>(i);
+
+        juce::ValueTree tree("binary");
+        tree.setProperty("empty", juce::var(juce::MemoryBlock()), nullptr);
+        tree.setProperty("one", juce::var(juce::MemoryBlock(1, true)), nullptr);
+        tree.setProperty("allBytes", juce::var(allBytes), nullptr);
+        return tree;
+    }
+
+    // Types Var doesn't have; the JVM must skip them and read what follows
+    juce::ValueTree makeUnsupported()
+    {
+        juce::Array<juce::var> nested;
+        nested.add(1);
+        nested.add(juce::Array<juce::var>{ "inner", 2.5 });
+
+        juce::ValueTree tree("unsupported");
+        tree.setProperty("before", 1, nullptr);
+        tree.setProperty("undefined", juce::var::undefined(), nullptr);
+        tree.setProperty("array", juce::Array<juce::var>{ 1, "two", 3.0 }, nullptr);
+        tree.setProperty("nestedArray", nested, nullptr);
+        tree.setProperty("after", "still read", nullptr);
+        return tree;
+    }
+
+    juce::ValueTree makeUnicodeNames()
+    {
+        juce::ValueTree tree(juce::Identifier(juce::String::fromUTF8("\xc3\x9cnic\xc3\xb6" "de")));
+        tree.setProperty(juce::Identifier(juce::String::fromUTF8("gr\xc3\xb6\xc3\x9f" "e")), 1, nullptr);
+        tree.setProperty(juce::Identifier(juce::String::fromUTF8("\xe9\x9f\xb3\xe9\x87\x8f")), 0.5, nullptr);
+        tree.setProperty(juce::Identifier(juce::String::fromUTF8("\xf0\x9f\x8e\x9a" "level")), "max", nullptr);
+        tree.appendChild(juce::ValueTree(juce::Identifier(juce::String::fromUTF8("\xe5\xad\x90"))), nullptr);
+        return tree;
+    }
+
+    // Close to the 256 levels the readers accept
+    juce::ValueTree makeDeep()
+    {
+        juce::ValueTree root("node");
+        auto node = root;
+        for (int depth = 1; depth < 200; ++depth)
+        {
+            juce::ValueTree child("node");
+            child.setProperty("depth", depth, nullptr);
+            node.appendChild(child, nullptr);
+            node = child;
+        }
+        return root;
+    }
+
+    // More names than the interned dictionary holds, so later ones are sent as literals
+    juce::ValueTree makeWide()
+    {
+        juce::ValueTree tree("wide");
+        for (int i = 0; i < IPC_DICT_MAX_ENTRIES + 100; ++i)
+            tree.setProperty(juce::Identifier("p" + juce::String(i)), i, nullptr);
+        return tree;
+    }
+
+    juce::ValueTree makeChildren()
+    {
+        juce::ValueTree tree("list");
+        for (int i = 0; i < 1000; ++i)
+        {
+            juce::ValueTree item("item");
+            item.setProperty("id", i, nullptr);
+            item.setProperty("label", "Item " + juce::String(i), nullptr);
+            tree.appendChild(item, nullptr);
+        }
+        return tree;
+    }
+
+    juce::ValueTree makeLargeBinary()
+    {
+        // Fixed LCG, so every run writes the same bytes
+        juce::MemoryBlock data(1024 * 1024);
+        uint32_t state = 1;
+        for (size_t i = 0; i < data.getSize(); ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            data[i] = static_cast<char>(state >> 24);
+        }
+
+        juce::ValueTree tree("sample");
+        tree.setProperty("rate", 48000, nullptr);
+        tree.setProperty("data", juce::var(data), nullptr);
+        return tree;
+    }
+
+    juce::ValueTree makeLargeString()
+    {
+        const auto chunk = juce::String::fromUTF8("Preset \xe9\x9f\xb3\xe9\x87\x8f \xf0\x9f\x8e\x9b\xef\xb8\x8f gr\xc3\xb6\xc3\x9f" "e\n");
+        juce::ValueTree tree("text");
+        tree.setProperty("body", juce::String::repeatedString(chunk, 256 * 1024 / chunk.getNumBytesAsUTF8()), nullptr);
+        return tree;
+    }
+
+    juce::ValueTree makeParam(int id, double value)
+    {
+        juce::ValueTree tree("param");
+        tree.setProperty("id", id, nullptr);
+        tree.setProperty("value", value, nullptr);
+        return tree;
+    }
+
+    juce::ValueTree makePreset()
+    {
+        juce::ValueTree tree("preset");
+        tree.setProperty("name", "Init", nullptr);
+        for (int i = 0; i < 128; ++i)
+            tree.appendChild(makeParam(i, i / 128.0), nullptr);
+        return tree;
+    }
+
+    // In the order they go through the interned stream; keep CorpusBenchmark's list in step
+    std::vector<Case> makeCorpus()
+    {
+        return {
+            { "param", makeParam(3, 0.5) },
+            { "preset", makePreset() },
+            { "scalars", makeScalars() },
+            { "strings", makeStrings() },
+            { "binary", makeBinary() },
+            { "unsupported", makeUnsupported() },
+            { "unicode-names", makeUnicodeNames() },
+            { "deep", makeDeep() },
+            { "children", makeChildren() },
+            { "wide", makeWide() },
+            { "large-binary", makeLargeBinary() },
+            { "large-string", makeLargeString() },
+        };
+    }
+
+    /** What JuceValueTree keeps of tree: Var has no undefined, arrays or objects, which read back as void. */
+    void stripUnsupported(juce::ValueTree tree)
+    {
+        for (int i = 0; i < tree.getNumProperties(); ++i)
+        {
+            const auto name = tree.getPropertyName(i);
+            const auto& value = tree.getProperty(name);
+            if (value.isUndefined() || value.isArray() || value.isObject() || value.isMethod())
+                tree.setProperty(name, juce::var(), nullptr);
+        }
+
+        for (auto child : tree)
+            stripUnsupported(child);
+    }
+
+    // ---- Files ----
+
+    juce::MemoryBlock encode(const juce::ValueTree& tree)
+    {
+        juce::MemoryOutputStream out;
+        tree.writeToStream(out);
+        return out.getMemoryBlock();
+    }
+
+    juce::MemoryBlock load(const juce::File& file)
+    {
+        juce::MemoryBlock data;
+        file.loadFileAsData(data);
+        return data;
+    }
+
+    /** Messages prefixed with their 4-byte size. */
+    std::vector<juce::MemoryBlock> loadMessages(const juce::File& file)
+    {
+        const auto data = load(file);
+        juce::MemoryInputStream in(data, false);
+
+        std::vector<juce::MemoryBlock> messages;
+        while (in.getNumBytesRemaining() >= 4)
+        {
+            const auto size = in.readInt();
+            if (size < 0 || size > in.getNumBytesRemaining())
+                break;
+
+            messages.emplace_back();
+            in.readIntoMemoryBlock(messages.back(), size);
+        }
+        return messages;
+    }
+
+    juce::StringArray loadCaseNames(const juce::File& dir)
+    {
+        juce::StringArray names;
+        names.addLines(dir.getChildFile("cases.txt").loadFileAsString());
+        names.removeEmptyStrings();
+        return names;
+    }
+
+    int generate(const juce::File& dir)
+    {
+        const auto created = dir.createDirectory();
+        if (created.failed())
+        {
+            std::fprintf(stderr, "%s\n", created.getErrorMessage().toRawUTF8());
+            return 1;
+        }
+
+        IdentifierEncoder encoder;
+        juce::MemoryOutputStream interned;
+        juce::StringArray names;
+
+        for (const auto& c : makeCorpus())
+        {
+            const auto plain = encode(c.tree);
+            dir.getChildFile(c.name + ".tree").replaceWithData(plain.getData(), plain.getSize());
+
+            auto expected = c.tree.createCopy();
+            stripUnsupported(expected);
+            const auto jvmFile = dir.getChildFile(c.name + ".jvm-expected.tree");
+            const auto jvm = encode(expected);
+            if (jvm != plain)
+                jvmFile.replaceWithData(jvm.getData(), jvm.getSize());
+            else
+                jvmFile.deleteFile();
+
+            juce::MemoryOutputStream message;
+            encoder.writeTree(c.tree, message);
+            interned.writeInt(static_cast<int>(message.getDataSize()));
+            interned.write(message.getData(), message.getDataSize());
+
+            names.add(c.name);
+            std::printf("%-16s %9d bytes, %9d interned\n", c.name.toRawUTF8(), static_cast<int>(plain.getSize()),
+                        static_cast<int>(message.getDataSize()));
+        }
+
+        dir.getChildFile("interned.stream").replaceWithData(interned.getData(), interned.getDataSize());
+        dir.getChildFile("cases.txt").replaceWithText(names.joinIntoString("\n") + "\n");
+        return 0;
+    }
+
+    // ---- Verifying ----
+
+    struct Checker
+    {
+        int checks = 0;
+        int failures = 0;
+
+        void expect(bool ok, const juce::String& caseName, const char* what)
+        {
+            ++checks;
+            if (ok)
+                return;
+
+            ++failures;
+            std::printf("FAIL %-16s %s\n", caseName.toRawUTF8(), what);
+        }
+    };
+
+    int verify(const juce::File& dir)
+    {
+        const auto names = loadCaseNames(dir);
+        if (names.isEmpty())
+        {
+            std::fprintf(stderr, "No corpus in %s, run generate first\n", dir.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        const auto interned = loadMessages(dir.getChildFile("interned.stream"));
+        const auto jvmInterned = loadMessages(dir.getChildFile("interned.jvm.stream"));
+        const bool hasJvm = dir.getChildFile("interned.jvm.stream").existsAsFile();
+
+        Checker check;
+        IdentifierDecoder decoder, viewDecoder, jvmDecoder;
+
+        for (int i = 0; i < names.size(); ++i)
+        {
+            const auto& name = names[i];
+            const auto plain = load(dir.getChildFile(name + ".tree"));
+            check.expect(!plain.isEmpty(), name, "missing .tree");
+
+            // JUCE itself: read and written back unchanged
+            const auto tree = juce::ValueTree::readFromData(plain.getData(), plain.getSize());
+            check.expect(tree.isValid() && encode(tree) == plain, name, "ValueTree round trip");
+
+            const ValueTreeView view(plain.getData(), plain.getSize());
+            check.expect(view.isValid() && view.getSize() == plain.getSize(), name, "ValueTreeView extent");
+            check.expect(encode(view.toValueTree()) == plain, name, "ValueTreeView::toValueTree");
+
+            // Interned: both readers must stay in step with the encoder over the whole stream
+            const bool hasMessage = i < static_cast<int>(interned.size());
+            check.expect(hasMessage, name, "missing from interned.stream");
+            if (hasMessage)
+            {
+                const auto& message = interned[static_cast<size_t>(i)];
+                juce::MemoryInputStream in(message, false);
+                check.expect(encode(decoder.readTree(in)) == plain, name, "IdentifierDecoder::readTree");
+
+                const auto internedView = ValueTreeView::readInterned(message.getData(), message.getSize(), viewDecoder);
+                check.expect(encode(internedView.toValueTree()) == plain, name, "ValueTreeView::readInterned");
+            }
+
+            if (!hasJvm)
+                continue;
+
+            // The JVM, which keeps what Var can hold
+            const auto expectedFile = dir.getChildFile(name + ".jvm-expected.tree");
+            const auto expected = expectedFile.existsAsFile() ? load(expectedFile) : plain;
+
+            const auto jvm = load(dir.getChildFile(name + ".jvm.tree"));
+            check.expect(jvm == expected, name, "JVM writeTo");
+
+            const bool hasJvmMessage = i < static_cast<int>(jvmInterned.size());
+            check.expect(hasJvmMessage, name, "missing from interned.jvm.stream");
+            if (hasJvmMessage)
+            {
+                juce::MemoryInputStream in(jvmInterned[static_cast<size_t>(i)], false);
+                check.expect(encode(jvmDecoder.readTree(in)) == expected, name, "JVM interned writeTo");
+            }
+        }
+
+        std::printf("%d cases, %d checks, %d failed%s\n", names.size(), check.checks, check.failures,
+                    hasJvm ? "" : " (no JVM output, run corpusCheck to include it)");
+        return check.failures == 0 ? 0 : 1;
+    }
+
+    // ---- Throughput ----
+
+    template <typename Fn>
+    double measure(int count, Fn&& run)
+    {
+        std::vector<double> times;
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; ++i)
+                run();
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            times.push_back(elapsed.count() / count);
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    // Keeps the results alive so the work isn't optimized out
+    volatile size_t sink = 0;
+
+    int bench(const juce::File& dir, int megabytes)
+    {
+        const auto names = loadCaseNames(dir);
+        if (names.isEmpty())
+        {
+            std::fprintf(stderr, "No corpus in %s, run generate first\n", dir.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        std::printf("%-16s %10s %10s %10s %10s %10s %10s\n", "MB/s", "bytes", "encode", "decode", "view",
+                    "dict enc", "dict dec");
+
+        for (const auto& name : names)
+        {
+            const auto plain = load(dir.getChildFile(name + ".tree"));
+            const auto tree = juce::ValueTree::readFromData(plain.getData(), plain.getSize());
+            const auto bytes = static_cast<double>(plain.getSize());
+            const int count = juce::jmax(1, static_cast<int>(megabytes * 1024.0 * 1024.0 / bytes));
+
+            // Second message of a fresh dictionary, so names are tokens like in steady state
+            IdentifierEncoder encoder;
+            IdentifierDecoder decoder;
+            juce::MemoryOutputStream first, second;
+            encoder.writeTree(tree, first);
+            juce::MemoryInputStream firstInput(first.getData(), first.getDataSize(), false);
+            decoder.readTree(firstInput);
+            encoder.writeTree(tree, second);
+
+            juce::MemoryOutputStream out;
+            const auto rate = [bytes](double ns) { return bytes / ns * 1.0e9 / (1024.0 * 1024.0); };
+
+            const auto encodeNs = measure(count, [&]() {
+                out.reset();
+                tree.writeToStream(out);
+                sink = out.getDataSize();
+            });
+            const auto decodeNs = measure(count, [&]() {
+                sink = static_cast<size_t>(juce::ValueTree::readFromData(plain.getData(), plain.getSize()).getNumProperties());
+            });
+            const auto viewNs = measure(count, [&]() {
+                sink = ValueTreeView(plain.getData(), plain.getSize()).getSize();
+            });
+            const auto internedEncodeNs = measure(count, [&]() {
+                out.reset();
+                encoder.writeTree(tree, out);
+                sink = out.getDataSize();
+            });
+            const auto internedDecodeNs = measure(count, [&]() {
+                juce::MemoryInputStream in(second.getData(), second.getDataSize(), false);
+                sink = static_cast<size_t>(decoder.readTree(in).getNumProperties());
+            });
+
+            std::printf("%-16s %10d %10.1f %10.1f %10.1f %10.1f %10.1f\n", name.toRawUTF8(), static_cast<int>(plain.getSize()),
+                        rate(encodeNs), rate(decodeNs), rate(viewNs), rate(internedEncodeNs), rate(internedDecodeNs));
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "Usage: valuetree-corpus generate|verify|bench <dir> [MB]\n");
+        return 2;
+    }
+
+    const juce::String command(argv[1]);
+    const auto dir = juce::File::getCurrentWorkingDirectory().getChildFile(argv[2]);
+
+    if (command == "generate")
+        return generate(dir);
+    if (command == "verify")
+        return verify(dir);
+    if (command == "bench")
+        return bench(dir, argc > 3 ? juce::jmax(1, std::atoi(argv[3])) : 64);
+
+    std::fprintf(stderr, "Unknown command %s\n", argv[1]);
+    return 2;
+}
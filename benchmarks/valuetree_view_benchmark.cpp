@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+/**
+ * valuetree-view-benchmark - Reading a received ValueTree: built vs in place.
+ *
+ * Times what an event handler does with a tree that just arrived, once with
+ * ValueTree::readFromData() and once with a ValueTreeView over the same
+ * bytes: read the demo's parameter change, look up one property of a tree
+ * with many, and walk the children of a preset-sized tree. Each case is run
+ * on the JUCE stream format and on the interned format Ipc uses on the
+ * control lane.
+ *
+ * Usage: valuetree-view-benchmark [reads per round]
+ */
+
+#include <juce_cmp/juce_cmp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace juce_cmp;
+
+namespace
+{
+    constexpr int rounds = 7;
+
+    // Keeps the values alive so the work isn't optimized out
+    volatile double sink = 0.0;
+
+    template <typename Fn>
+    double measure(int count, Fn&& read)
+    {
+        std::vector<double> times;
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; ++i)
+                read();
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            times.push_back(elapsed.count() / count);
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    juce::ValueTree makeParam()
+    {
+        juce::ValueTree tree("param");
+        tree.setProperty("id", 3, nullptr);
+        tree.setProperty("value", 0.5, nullptr);
+        return tree;
+    }
+
+    // A settings-like node where the handler wants one property near the end
+    juce::ValueTree makeWide()
+    {
+        juce::ValueTree tree("settings");
+        for (int i = 0; i < 32; ++i)
+            tree.setProperty(juce::Identifier("setting" + juce::String(i)), i * 0.25, nullptr);
+        tree.setProperty("name", "Init", nullptr);
+        return tree;
+    }
+
+    // A preset: one child per parameter
+    juce::ValueTree makePreset()
+    {
+        juce::ValueTree tree("preset");
+        tree.setProperty("name", "Init", nullptr);
+        for (int i = 0; i < 128; ++i)
+        {
+            juce::ValueTree param("param");
+            param.setProperty("id", i, nullptr);
+            param.setProperty("value", i / 128.0, nullptr);
+            tree.appendChild(param, nullptr);
+        }
+        return tree;
+    }
+
+    struct Encoded
+    {
+        juce::MemoryBlock plain;
+        juce::MemoryBlock interned;
+        IdentifierDecoder dictionary;  // Names for interned, as the receiver has them
+    };
+
+    void encode(const juce::ValueTree& tree, IdentifierEncoder& encoder, Encoded& out)
+    {
+        juce::MemoryOutputStream plain(out.plain, false);
+        tree.writeToStream(plain);
+
+        // Second message, so names are tokens like in steady state
+        juce::MemoryOutputStream first;
+        encoder.writeTree(tree, first);
+        juce::MemoryInputStream firstInput(first.getData(), first.getDataSize(), false);
+        out.dictionary.readTree(firstInput);
+
+        juce::MemoryOutputStream interned(out.interned, false);
+        encoder.writeTree(tree, interned);
+    }
+
+    void report(const char* name, const char* format, double built, double view)
+    {
+        std::printf("%-16s %-9s %12.1f %12.1f %9.1fx\n", name, format, built, view, built / view);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int count = argc > 1 ? juce::jmax(1, std::atoi(argv[1])) : 100000;
+
+    const juce::Identifier param("param"), id("id"), value("value"), name("name");
+
+    IdentifierEncoder encoder;
+    Encoded encodedParam, encodedWide, encodedPreset;
+    encode(makeParam(), encoder, encodedParam);
+    encode(makeWide(), encoder, encodedWide);
+    encode(makePreset(), encoder, encodedPreset);
+
+    std::printf("%-16s %-9s %12s %12s %10s\n", "case", "format", "built ns", "view ns", "speedup");
+
+    // The demo's parameter change: check the type, read two properties
+    {
+        auto& e = encodedParam;
+        report("param", "plain",
+               measure(count, [&]() {
+                   const auto tree = juce::ValueTree::readFromData(e.plain.getData(), e.plain.getSize());
+                   if (tree.hasType(param))
+                       sink = static_cast<int>(tree.getProperty(id)) + static_cast<double>(tree.getProperty(value));
+               }),
+               measure(count, [&]() {
+                   const ValueTreeView tree(e.plain.getData(), e.plain.getSize());
+                   if (tree.hasType(param))
+                       sink = tree.getProperty(id).toInt() + tree.getProperty(value).toDouble();
+               }));
+        report("param", "interned",
+               measure(count, [&]() {
+                   juce::MemoryInputStream input(e.interned, false);
+                   const auto tree = e.dictionary.readTree(input);
+                   if (tree.hasType(param))
+                       sink = static_cast<int>(tree.getProperty(id)) + static_cast<double>(tree.getProperty(value));
+               }),
+               measure(count, [&]() {
+                   const ValueTreeView tree(e.interned.getData(), e.interned.getSize(), e.dictionary);
+                   if (tree.hasType(param))
+                       sink = tree.getProperty(id).toInt() + tree.getProperty(value).toDouble();
+               }));
+    }
+
+    // One property out of 33
+    {
+        auto& e = encodedWide;
+        report("one of many", "plain",
+               measure(count, [&]() {
+                   const auto tree = juce::ValueTree::readFromData(e.plain.getData(), e.plain.getSize());
+                   sink = tree.getProperty(name).toString().length();
+               }),
+               measure(count, [&]() {
+                   const ValueTreeView tree(e.plain.getData(), e.plain.getSize());
+                   sink = static_cast<double>(tree.getProperty(name).getSize());
+               }));
+        report("one of many", "interned",
+               measure(count, [&]() {
+                   juce::MemoryInputStream input(e.interned, false);
+                   sink = e.dictionary.readTree(input).getProperty(name).toString().length();
+               }),
+               measure(count, [&]() {
+                   const ValueTreeView tree(e.interned.getData(), e.interned.getSize(), e.dictionary);
+                   sink = static_cast<double>(tree.getProperty(name).getSize());
+               }));
+    }
+
+    // Every child's value, as when applying a preset
+    {
+        auto& e = encodedPreset;
+        const int presetCount = juce::jmax(1, count / 100);
+
+        const auto sumBuilt = [&](const juce::ValueTree& tree) {
+            double sum = 0.0;
+            for (const auto& child : tree)
+                sum += static_cast<double>(child.getProperty(value));
+            sink = sum;
+        };
+        const auto sumView = [&](const ValueTreeView& tree) {
+            double sum = 0.0;
+            for (const auto child : tree)
+                sum += child.getProperty(value).toDouble();
+            sink = sum;
+        };
+
+        report("preset children", "plain",
+               measure(presetCount, [&]() { sumBuilt(juce::ValueTree::readFromData(e.plain.getData(), e.plain.getSize())); }),
+               measure(presetCount, [&]() { sumView(ValueTreeView(e.plain.getData(), e.plain.getSize())); }));
+        report("preset children", "interned",
+               measure(presetCount, [&]() {
+                   juce::MemoryInputStream input(e.interned, false);
+                   sumBuilt(e.dictionary.readTree(input));
+               }),
+               measure(presetCount, [&]() { sumView(ValueTreeView(e.interned.getData(), e.interned.getSize(), e.dictionary)); }));
+    }
+
+    return 0;
+}
@@ -0,0 +1,248 @@
+# generate_messages.cmake - Typed message codecs from a schema
+#
+# Writes a C++ header with one fixed-layout struct per message plus a
+# dispatch() switch, and a Kotlin file with the matching data classes, so
+# host and UI agree on ids and layouts by construction (see
+# juce_cmp/TypedMessage.h). Runs in script mode:
+#
+#   cmake -DSCHEMA=messages.schema
+#         -DCPP_OUT=Messages.h -DCPP_NAMESPACE=messages
+#         -DKOTLIN_OUT=Messages.kt -DKOTLIN_PACKAGE=com.example
+#         -P generate_messages.cmake
+#
+# Schema format, one declaration per line, '#' starts a comment:
+#
+#   message <Name> <id>       id in 1..65535, unique, never reused
+#       <type> <field>        bool, int8, int16, int32, int64, float32, float64
+#
+# Fields are packed little-endian in declaration order. Only append fields
+# to existing messages: receivers accept bodies longer than they know.
+
+cmake_minimum_required(VERSION 3.15)
+
+foreach(var SCHEMA CPP_OUT CPP_NAMESPACE KOTLIN_OUT KOTLIN_PACKAGE)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "generate_messages: ${var} is not set")
+    endif()
+endforeach()
+
+# Type table: C++ type, size, Kotlin type, Kotlin default, ByteBuffer accessor suffix
+set(TYPE_bool    "bool;1;Boolean;false;")
+set(TYPE_int8    "int8_t;1;Byte;0;")
+set(TYPE_int16   "int16_t;2;Short;0;Short")
+set(TYPE_int32   "int32_t;4;Int;0;Int")
+set(TYPE_int64   "int64_t;8;Long;0L;Long")
+set(TYPE_float32 "float;4;Float;0f;Float")
+set(TYPE_float64 "double;8;Double;0.0;Double")
+
+#
+# 1. Parse
+#
+# Read by hand: file(STRINGS) skips blank lines and splits at non-ASCII text
+file(READ "${SCHEMA}" content)
+string(REPLACE ";" "," content "${content}")
+string(REPLACE "\n" ";" lines "${content}")
+get_filename_component(schema_name "${SCHEMA}" NAME)
+
+set(messages "")
+set(ids "")
+set(current "")
+set(line_number 0)
+
+foreach(line IN LISTS lines)
+    math(EXPR line_number "${line_number} + 1")
+    string(REGEX REPLACE "#.*$" "" line "${line}")
+    string(STRIP "${line}" line)
+
+    if(line STREQUAL "")
+        continue()
+    endif()
+
+    if(line MATCHES "^message[ \t]+([A-Za-z_][A-Za-z0-9_]*)[ \t]+([0-9]+)$")
+        set(current "${CMAKE_MATCH_1}")
+        set(id "${CMAKE_MATCH_2}")
+
+        if(current IN_LIST messages)
+            message(FATAL_ERROR "${schema_name}:${line_number}: duplicate message ${current}")
+        endif()
+        if(id LESS 1 OR id GREATER 65535)
+            message(FATAL_ERROR "${schema_name}:${line_number}: message id ${id} out of range")
+        endif()
+        if(id IN_LIST ids)
+            message(FATAL_ERROR "${schema_name}:${line_number}: message id ${id} already used")
+        endif()
+
+        list(APPEND messages "${current}")
+        list(APPEND ids "${id}")
+        set(MSG_${current}_ID "${id}")
+        set(MSG_${current}_FIELDS "")
+        set(MSG_${current}_SIZE 0)
+    elseif(line MATCHES "^([a-z0-9]+)[ \t]+([A-Za-z_][A-Za-z0-9_]*)$")
+        set(type "${CMAKE_MATCH_1}")
+        set(field "${CMAKE_MATCH_2}")
+
+        if(current STREQUAL "")
+            message(FATAL_ERROR "${schema_name}:${line_number}: field outside a message")
+        endif()
+        if(NOT DEFINED TYPE_${type})
+            message(FATAL_ERROR "${schema_name}:${line_number}: unknown type ${type}")
+        endif()
+        foreach(existing IN LISTS MSG_${current}_FIELDS)
+            if(existing MATCHES ":${field}$")
+                message(FATAL_ERROR "${schema_name}:${line_number}: duplicate field ${field}")
+            endif()
+        endforeach()
+
+        list(GET TYPE_${type} 1 size)
+        list(APPEND MSG_${current}_FIELDS "${type}:${field}")
+        math(EXPR MSG_${current}_SIZE "${MSG_${current}_SIZE} + ${size}")
+    else()
+        message(FATAL_ERROR "${schema_name}:${line_number}: expected 'message <Name> <id>' or '<type> <field>'")
+    endif()
+endforeach()
+
+foreach(name IN LISTS messages)
+    # IPC_TYPED_MAX_SIZE
+    if(MSG_${name}_SIZE GREATER 1024)
+        message(FATAL_ERROR "${schema_name}: message ${name} is larger than 1024 bytes")
+    endif()
+endforeach()
+
+#
+# 2. C++
+#
+set(cpp "// Generated from ${schema_name} by generate_messages.cmake - do not edit.\n\n")
+string(APPEND cpp "#pragma once\n\n#include <juce_cmp/juce_cmp.h>\n\n")
+string(APPEND cpp "namespace ${CPP_NAMESPACE}\n{\n\n")
+
+foreach(name IN LISTS messages)
+    string(APPEND cpp "struct ${name}\n{\n")
+    string(APPEND cpp "    static constexpr uint16_t id = ${MSG_${name}_ID};\n")
+    string(APPEND cpp "    static constexpr size_t wireSize = ${MSG_${name}_SIZE};\n")
+
+    set(members "")
+    set(writes "")
+    set(reads "")
+    set(offset 0)
+    foreach(entry IN LISTS MSG_${name}_FIELDS)
+        string(REPLACE ":" ";" entry "${entry}")
+        list(GET entry 0 type)
+        list(GET entry 1 field)
+        list(GET TYPE_${type} 0 cpp_type)
+        list(GET TYPE_${type} 1 size)
+
+        if(type STREQUAL "bool")
+            string(APPEND members "    bool ${field} = false;\n")
+        else()
+            string(APPEND members "    ${cpp_type} ${field} = 0;\n")
+        endif()
+        string(APPEND writes "        juce_cmp::wire::write(out + ${offset}, ${field});\n")
+        string(APPEND reads "        message.${field} = juce_cmp::wire::read<${cpp_type}>(in + ${offset});\n")
+        math(EXPR offset "${offset} + ${size}")
+    endforeach()
+
+    if(NOT members STREQUAL "")
+        string(APPEND cpp "\n${members}")
+    endif()
+
+    string(APPEND cpp "\n    void encode(uint8_t* out) const noexcept\n    {\n")
+    if(writes STREQUAL "")
+        string(APPEND cpp "        juce::ignoreUnused(out);\n")
+    else()
+        string(APPEND cpp "${writes}")
+    endif()
+    string(APPEND cpp "    }\n")
+
+    string(APPEND cpp "\n    static ${name} decode(const uint8_t* in) noexcept\n    {\n")
+    if(reads STREQUAL "")
+        string(APPEND cpp "        juce::ignoreUnused(in);\n        return {};\n")
+    else()
+        string(APPEND cpp "        ${name} message;\n${reads}        return message;\n")
+    endif()
+    string(APPEND cpp "    }\n};\n\n")
+endforeach()
+
+string(APPEND cpp "/** Receives decoded messages; override the ones you handle. */\n")
+string(APPEND cpp "class Handler\n{\npublic:\n    virtual ~Handler() = default;\n\n")
+foreach(name IN LISTS messages)
+    string(APPEND cpp "    virtual void handle(const ${name}&) {}\n")
+endforeach()
+string(APPEND cpp "};\n\n")
+
+string(APPEND cpp "/** Decode a message and pass it to the handler. Returns false if unknown or too short. */\n")
+string(APPEND cpp "inline bool dispatch(const juce_cmp::TypedMessage& message, Handler& handler)\n{\n")
+string(APPEND cpp "    switch (message.id)\n    {\n")
+foreach(name IN LISTS messages)
+    string(APPEND cpp "        case ${name}::id:\n")
+    string(APPEND cpp "            if (message.size < ${name}::wireSize)\n                return false;\n")
+    string(APPEND cpp "            handler.handle(${name}::decode(message.data));\n            return true;\n")
+endforeach()
+string(APPEND cpp "        default:\n            return false;\n    }\n}\n\n")
+string(APPEND cpp "}  // namespace ${CPP_NAMESPACE}\n")
+
+#
+# 3. Kotlin
+#
+set(kt "// Generated from ${schema_name} by generate_messages.cmake - do not edit.\n\n")
+string(APPEND kt "package ${KOTLIN_PACKAGE}\n\n")
+string(APPEND kt "import juce_cmp.ipc.TypedMessage\nimport java.nio.ByteBuffer\n\n")
+string(APPEND kt "/** A message declared in ${schema_name}. */\nsealed interface Message : TypedMessage\n")
+
+foreach(name IN LISTS messages)
+    set(params "")
+    set(puts "")
+    set(gets "")
+    foreach(entry IN LISTS MSG_${name}_FIELDS)
+        string(REPLACE ":" ";" entry "${entry}")
+        list(GET entry 0 type)
+        list(GET entry 1 field)
+        list(GET TYPE_${type} 2 kt_type)
+        list(GET TYPE_${type} 3 kt_default)
+        list(GET TYPE_${type} 4 accessor)
+
+        if(NOT params STREQUAL "")
+            string(APPEND params ",\n")
+            string(APPEND gets ",\n")
+        endif()
+        string(APPEND params "    val ${field}: ${kt_type} = ${kt_default}")
+
+        if(type STREQUAL "bool")
+            string(APPEND puts "        buffer.put((if (${field}) 1 else 0).toByte())\n")
+            string(APPEND gets "            ${field} = buffer.get() != 0.toByte()")
+        else()
+            string(APPEND puts "        buffer.put${accessor}(${field})\n")
+            string(APPEND gets "            ${field} = buffer.get${accessor}()")
+        endif()
+    endforeach()
+
+    if(params STREQUAL "")
+        string(APPEND kt "\nobject ${name} : Message {\n")
+    else()
+        string(APPEND kt "\ndata class ${name}(\n${params}\n) : Message {\n")
+    endif()
+    string(APPEND kt "    override val messageId: Int get() = ID\n")
+    string(APPEND kt "    override val wireSize: Int get() = WIRE_SIZE\n\n")
+    string(APPEND kt "    override fun encode(buffer: ByteBuffer) {\n${puts}    }\n")
+
+    if(params STREQUAL "")
+        string(APPEND kt "\n    const val ID = ${MSG_${name}_ID}\n")
+        string(APPEND kt "    const val WIRE_SIZE = 0\n\n")
+        string(APPEND kt "    fun decode(buffer: ByteBuffer): ${name} = this\n}\n")
+    else()
+        string(APPEND kt "\n    companion object {\n")
+        string(APPEND kt "        const val ID = ${MSG_${name}_ID}\n")
+        string(APPEND kt "        const val WIRE_SIZE = ${MSG_${name}_SIZE}\n\n")
+        string(APPEND kt "        fun decode(buffer: ByteBuffer): ${name} = ${name}(\n${gets}\n        )\n    }\n}\n")
+    endif()
+endforeach()
+
+string(APPEND kt "\nobject Messages {\n")
+string(APPEND kt "    /** Decode a message received from the host, null if unknown or too short. Little-endian buffer. */\n")
+string(APPEND kt "    fun decode(id: Int, buffer: ByteBuffer): Message? = when (id) {\n")
+foreach(name IN LISTS messages)
+    string(APPEND kt "        ${name}.ID -> if (buffer.remaining() >= ${name}.WIRE_SIZE) ${name}.decode(buffer) else null\n")
+endforeach()
+string(APPEND kt "        else -> null\n    }\n}\n")
+
+file(WRITE "${CPP_OUT}" "${cpp}")
+file(WRITE "${KOTLIN_OUT}" "${kt}")
@@ -0,0 +1,57 @@
+// Generated from messages.schema by generate_messages.cmake - do not edit.
+
+#pragma once
+
+#include <juce_cmp/juce_cmp.h>
+
+namespace messages
+{
+
+struct Parameter
+{
+    static constexpr uint16_t id = 1;
+    static constexpr size_t wireSize = 12;
+
+    int32_t index = 0;
+    double value = 0;
+
+    void encode(uint8_t* out) const noexcept
+    {
+        juce_cmp::wire::write(out + 0, index);
+        juce_cmp::wire::write(out + 4, value);
+    }
+
+    static Parameter decode(const uint8_t* in) noexcept
+    {
+        Parameter message;
+        message.index = juce_cmp::wire::read<int32_t>(in + 0);
+        message.value = juce_cmp::wire::read<double>(in + 4);
+        return message;
+    }
+};
+
+/** Receives decoded messages; override the ones you handle. */
+class Handler
+{
+public:
+    virtual ~Handler() = default;
+
+    virtual void handle(const Parameter&) {}
+};
+
+/** Decode a message and pass it to the handler. Returns false if unknown or too short. */
+inline bool dispatch(const juce_cmp::TypedMessage& message, Handler& handler)
+{
+    switch (message.id)
+    {
+        case Parameter::id:
+            if (message.size < Parameter::wireSize)
+                return false;
+            handler.handle(Parameter::decode(message.data));
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace messages
@@ -23,45 +23,33 @@ PluginEditor::PluginEditor(PluginProcessor& p)
         juce::ImageFileFormat::loadFrom(loading_preview_png, loading_preview_png_len),
         juce::Colour(0xFF6F97FF));
 
-    // Wire up UI→Host events (interpret JuceValueTree as parameter changes)
-    composeComponent.onEvent([&p](const juce::ValueTree& tree) {
-        if (tree.getType() == juce::Identifier("param"))
-        {
-            auto paramId = static_cast<int>(tree.getProperty("id", -1));
-            auto value = static_cast<float>(static_cast<double>(tree.getProperty("value", 0.0)));
-
-            switch (paramId) {
-                case 0:
-                    if (p.shapeParameter != nullptr)
-                        p.shapeParameter->setValueNotifyingHost(value);
-                    break;
-                // Add more parameters here as needed
-            }
-        }
+    // Wire up UI→Host messages (decoded by the switch generated from messages.schema)
+    composeComponent.onMessage([this](const juce_cmp::TypedMessage& message) {
+        messages::dispatch(message, *this);
     });
 
-    // Wire up Host→UI parameter changes (automation from DAW, etc.)
+    // Wire up Host→UI parameter changes (automation from DAW, etc.). Sent as
+    // state, so a UI that connects later or restarts gets the latest values
     p.setParameterChangedCallback([this](int paramIndex, float value) {
-        // Forward to Compose UI as event of type JUCE with ValueTree payload
-        juce::ValueTree tree("param");
-        tree.setProperty("id", paramIndex, nullptr);
-        tree.setProperty("value", static_cast<double>(value), nullptr);
-        composeComponent.sendEvent(tree);
+        composeComponent.sendState(messages::Parameter { paramIndex, static_cast<double>(value) },
+                                   static_cast<uint16_t>(paramIndex));
     });
 
-    // Send initial parameter values when child process is ready
-    composeComponent.onProcessReady([this, &p]() {
-        if (p.shapeParameter != nullptr) {
-            juce::ValueTree tree("param");
-            tree.setProperty("id", 0, nullptr);
-            tree.setProperty("value", static_cast<double>(p.shapeParameter->get()), nullptr);
-            composeComponent.sendEvent(tree);
-        }
-        // Add more parameters here as needed
-    });
+    // Initial parameter values, sent as soon as the UI connects
+    if (p.shapeParameter != nullptr)
+        composeComponent.sendState(messages::Parameter { 0, static_cast<double>(p.shapeParameter->get()) }, 0);
+    // Add more parameters here as needed
+
+    // Closing the editor leaves its UI process to the processor's watcher
+    composeComponent.setProcessWatcher(p.uiProcesses);
+
+    // Let an editor left closed give back its memory
+    juce_cmp::ComposeProvider::MemoryPolicy memoryPolicy;
+    memoryPolicy.enabled = true;
+    composeComponent.setMemoryPolicy(memoryPolicy);
 
-    // Hide loading text when first frame is rendered
     composeComponent.onFirstFrame([this] {
+        // Hide loading text
         uiReady = true;
         this->repaint();
     });
@@ -70,6 +58,17 @@ PluginEditor::PluginEditor(PluginProcessor& p)
     repaint();  // Trigger initial paint to show "Starting UI..." text
 }
 
+void PluginEditor::handle(const messages::Parameter& message)
+{
+    switch (message.index) {
+        case 0:
+            if (processorRef.shapeParameter != nullptr)
+                processorRef.shapeParameter->setValueNotifyingHost(static_cast<float>(message.value));
+            break;
+        // Add more parameters here as needed
+    }
+}
+
 PluginEditor::~PluginEditor()
 {
     // Clear the callback to avoid dangling reference
@@ -6,12 +6,14 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_cmp/juce_cmp.h>
 #include "PluginProcessor.h"
+#include "Messages.h"        // Generated from messages.schema
 #include "LoadingPreview.h"  // Binary resource data
 
 /**
  * Plugin Editor - hosts the ComposeComponent that displays Compose UI.
  */
-class PluginEditor : public juce::AudioProcessorEditor
+class PluginEditor : public juce::AudioProcessorEditor,
+                     private messages::Handler
 {
 public:
     explicit PluginEditor(PluginProcessor&);
@@ -22,6 +24,9 @@ public:
     void resized() override;
 
 private:
+    // UI→Host messages
+    void handle(const messages::Parameter& message) override;
+
     PluginProcessor& processorRef;
     juce_cmp::ComposeComponent composeComponent;
     bool uiReady = false;
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_cmp/juce_cmp.h>
 #include <functional>
 
 /**
@@ -61,6 +62,9 @@ public:
     /// Shape parameter (0 = sine, 1 = square) - exposed to host
     juce::AudioParameterFloat* shapeParameter = nullptr;
 
+    /// Sees the UI processes of closed editors out; outlives the editors
+    juce_cmp::ProcessWatcher uiProcesses;
+
 private:
     ParameterChangedCallback paramCallback;
     double currentSampleRate = 44100.0;
@@ -43,6 +43,16 @@ compose.desktop {
     }
 }
 
+// ./gradlew -q :composeApp:renderBenchmark [-Pargs="--workload=snow --frames=1200"]
+tasks.register<JavaExec>("renderBenchmark") {
+    group = "verification"
+    description = "Renders the benchmark workloads offscreen (Skia raster) and prints frame times as JSON"
+    classpath = sourceSets["main"].runtimeClasspath
+    mainClass.set("juce_cmp.demo.benchmark.RenderBenchmarkKt")
+    jvmArgs("-Djava.awt.headless=true", "--enable-native-access=ALL-UNNAMED")
+    providers.gradleProperty("args").orNull?.let { args(it.split(" ").filter(String::isNotEmpty)) }
+}
+
 compose.resources {
     packageOfResClass = "juce_cmp.demo.resources"
 }
@@ -21,10 +21,11 @@ import androidx.compose.ui.unit.IntOffset
 import androidx.compose.ui.unit.dp
 import kotlin.random.Random
 
+/** @param count Number of flakes; the render benchmark runs it with many more */
 @Composable
-fun FallingSnow() {
+fun FallingSnow(count: Int = 50) {
     BoxWithConstraints(Modifier.fillMaxSize()) {
-        repeat(50) {
+        repeat(count) {
             val size = remember { 20.dp + 10.dp * Random.nextFloat() }
             val alpha = remember { 0.10f + 0.15f * Random.nextFloat() }
             val sizePx = with(LocalDensity.current) { size.toPx() }
@@ -0,0 +1,40 @@
+// Generated from messages.schema by generate_messages.cmake - do not edit.
+
+package juce_cmp.demo
+
+import juce_cmp.ipc.TypedMessage
+import java.nio.ByteBuffer
+
+/** A message declared in messages.schema. */
+sealed interface Message : TypedMessage
+
+data class Parameter(
+    val index: Int = 0,
+    val value: Double = 0.0
+) : Message {
+    override val messageId: Int get() = ID
+    override val wireSize: Int get() = WIRE_SIZE
+
+    override fun encode(buffer: ByteBuffer) {
+        buffer.putInt(index)
+        buffer.putDouble(value)
+    }
+
+    companion object {
+        const val ID = 1
+        const val WIRE_SIZE = 12
+
+        fun decode(buffer: ByteBuffer): Parameter = Parameter(
+            index = buffer.getInt(),
+            value = buffer.getDouble()
+        )
+    }
+}
+
+object Messages {
+    /** Decode a message received from the host, null if unknown or too short. Little-endian buffer. */
+    fun decode(id: Int, buffer: ByteBuffer): Message? = when (id) {
+        Parameter.ID -> if (buffer.remaining() >= Parameter.WIRE_SIZE) Parameter.decode(buffer) else null
+        else -> null
+    }
+}
@@ -6,13 +6,13 @@ package juce_cmp.demo
 import androidx.compose.runtime.mutableStateMapOf
 import androidx.compose.runtime.snapshots.SnapshotStateMap
 import juce_cmp.Library
-import juce_cmp.ipc.JuceValueTree
+import java.nio.ByteBuffer
 
 /**
  * Global parameter state that syncs between host and UI.
  *
  * Handles bidirectional parameter synchronization:
- * - RX: Host sends "param" events via onHostEvent() to update UI state
+ * - RX: Host sends Parameter messages via onMessage() to update UI state
  * - TX: UI calls set() which updates state and notifies host
  *
  * The Compose UI observes these values and recomposes automatically.
@@ -51,10 +51,7 @@ object ParameterState {
      */
     fun set(paramId: Int, value: Float) {
         parameters[paramId] = value
-        val tree = JuceValueTree("param")
-        tree["id"] = paramId
-        tree["value"] = value.toDouble()
-        Library.send(tree)
+        Library.send(Parameter(paramId, value.toDouble()))
     }
 
     /**
@@ -63,16 +60,15 @@ object ParameterState {
     fun getState(): SnapshotStateMap<Int, Float> = parameters
 
     /**
-     * Handle a "param" event from the host.
+     * Handle a typed message from the host (see messages.schema).
      * Updates local state without sending back to host.
      */
-    fun onEvent(tree: JuceValueTree) {
-        if (tree.type == "param") {
-            val id = tree["id"].toInt()
-            val value = tree["value"].toDouble().toFloat()
-            if (id >= 0) {
-                parameters[id] = value
+    fun onMessage(id: Int, payload: ByteBuffer) {
+        when (val message = Messages.decode(id, payload)) {
+            is Parameter -> if (message.index >= 0) {
+                parameters[message.index] = message.value.toFloat()
             }
+            null -> {}
         }
     }
 }
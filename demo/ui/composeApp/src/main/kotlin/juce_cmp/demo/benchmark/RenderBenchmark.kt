@@ -0,0 +1,246 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.demo.benchmark
+
+import androidx.compose.animation.core.*
+import androidx.compose.foundation.Canvas
+import androidx.compose.foundation.background
+import androidx.compose.foundation.layout.*
+import androidx.compose.foundation.lazy.LazyColumn
+import androidx.compose.foundation.lazy.rememberLazyListState
+import androidx.compose.material3.MaterialTheme
+import androidx.compose.material3.Text
+import androidx.compose.runtime.*
+import androidx.compose.ui.Alignment
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.graphics.Color
+import androidx.compose.ui.platform.LocalDensity
+import androidx.compose.ui.unit.dp
+import androidx.compose.ui.unit.sp
+import juce_cmp.demo.FallingSnow
+import juce_cmp.demo.Knob
+import juce_cmp.renderer.renderHeadless
+import kotlin.system.exitProcess
+
+/*
+ * Headless render benchmark: renders each workload offscreen with the Skia
+ * raster backend for a fixed number of frames, at the demo editor's size
+ * (768x480) and fixed scale factors, so results compare across commits:
+ *   lazyList    10,000 rows scrolling a few pixels every frame
+ *   denseText   48 lines of small text, one line changing every frame
+ *   knobs       128 demo Knobs, each animated on its own period
+ *   snow        FallingSnow with 1,000 flakes
+ *
+ * For each workload and scale it prints frame time percentiles, recomposer
+ * passes and recomposed scopes per frame (null for snow, not instrumented), and
+ * allocation per frame and per second, as JSON on stdout.
+ *
+ * ./gradlew -q :composeApp:renderBenchmark [-Pargs="--frames=1200 --workload=snow --scale=2"]
+ */
+
+private const val WIDTH = 768
+private const val HEIGHT = 480
+
+/** Recomposed scopes of a workload, counted by the scopes themselves. */
+private class ScopeCounter {
+    var count = 0L
+}
+
+private class Workload(
+    val name: String,
+    val instrumented: Boolean,
+    val content: @Composable (ScopeCounter) -> Unit
+)
+
+private val workloads = listOf(
+    Workload("lazyList", true) { counter -> LazyListWorkload(counter) },
+    Workload("denseText", true) { counter -> DenseTextWorkload(counter) },
+    Workload("knobs", true) { counter -> KnobsWorkload(counter) },
+    Workload("snow", false) { _ -> SnowWorkload() }
+)
+
+// =============================================================================
+// Workloads
+// =============================================================================
+
+@Composable
+private fun LazyListWorkload(counter: ScopeCounter) {
+    val state = rememberLazyListState()
+    val step = with(LocalDensity.current) { 6.dp.toPx() }
+
+    // Scrolls by the same distance every frame, whatever the frame took
+    LaunchedEffect(state) {
+        while (true) {
+            withFrameNanos { }
+            state.dispatchRawDelta(step)
+        }
+    }
+
+    LazyColumn(state = state, modifier = Modifier.fillMaxSize()) {
+        items(10_000) { index ->
+            SideEffect { counter.count++ }
+            Row(
+                modifier = Modifier.fillMaxWidth().height(40.dp).padding(horizontal = 12.dp),
+                verticalAlignment = Alignment.CenterVertically
+            ) {
+                Canvas(Modifier.size(24.dp)) {
+                    drawCircle(Color(0xFF000000 or (index * 2654435761L and 0xFFFFFF)))
+                }
+                Spacer(Modifier.width(12.dp))
+                Column {
+                    Text("Preset $index", fontSize = 14.sp)
+                    Text("Bank ${index / 128}, slot ${index % 128}", fontSize = 11.sp, color = Color.Gray)
+                }
+            }
+        }
+    }
+}
+
+@Composable
+private fun DenseTextWorkload(counter: ScopeCounter) {
+    val lines = 48
+    val texts = remember { List(lines) { mutableStateOf(denseLine(it, 0)) } }
+
+    LaunchedEffect(Unit) {
+        var frame = 0
+        while (true) {
+            withFrameNanos { }
+            frame++
+            texts[frame % lines].value = denseLine(frame % lines, frame)
+        }
+    }
+
+    Column(Modifier.fillMaxSize().padding(4.dp)) {
+        for (line in texts) {
+            DenseTextLine(line, counter)
+        }
+    }
+}
+
+@Composable
+private fun DenseTextLine(text: State<String>, counter: ScopeCounter) {
+    SideEffect { counter.count++ }
+    Text(text.value, fontSize = 8.sp, lineHeight = 9.5.sp, maxLines = 1)
+}
+
+private fun denseLine(line: Int, frame: Int): String =
+    "%02d  frame %6d  ".format(line, frame) +
+        "The quick brown fox jumps over the lazy dog 0123456789 ".repeat(3)
+
+@Composable
+private fun KnobsWorkload(counter: ScopeCounter) {
+    Column(Modifier.fillMaxSize().background(Color.Black).padding(4.dp)) {
+        for (row in 0 until 8) {
+            Row {
+                for (column in 0 until 16) {
+                    AnimatedKnob(row * 16 + column, counter)
+                }
+            }
+        }
+    }
+}
+
+@Composable
+private fun AnimatedKnob(index: Int, counter: ScopeCounter) {
+    val transition = rememberInfiniteTransition()
+    val value by transition.animateFloat(
+        initialValue = 0f,
+        targetValue = 1f,
+        animationSpec = infiniteRepeatable(
+            animation = tween(1000 + 37 * index, easing = LinearEasing),
+            repeatMode = RepeatMode.Reverse
+        )
+    )
+    SideEffect { counter.count++ }
+    Knob(value = value, onValueChange = {}, size = 40.dp, trackWidth = 4.dp)
+}
+
+@Composable
+private fun SnowWorkload() {
+    Box(Modifier.fillMaxSize().background(Color(0xFF202830))) {
+        FallingSnow(count = 1_000)
+    }
+}
+
+// =============================================================================
+// Runner
+// =============================================================================
+
+private fun percentile(sorted: DoubleArray, p: Int): Double =
+    if (sorted.isEmpty()) 0.0 else sorted[(sorted.size - 1) * p / 100]
+
+private fun json(value: Double) = "%.4f".format(java.util.Locale.ROOT, value)
+
+private fun runWorkload(workload: Workload, scale: Float, frames: Int, warmup: Int): String {
+    val counter = ScopeCounter()
+    val run = renderHeadless(
+        WIDTH, HEIGHT, scale, frames, warmup,
+        onMeasureStart = { counter.count = 0 }
+    ) {
+        MaterialTheme {
+            workload.content(counter)
+        }
+    }
+
+    val frameMs = run.frameTimesNs.map { it / 1.0e6 }.sorted().toDoubleArray()
+    val seconds = run.elapsedNs / 1.0e9
+    // FallingSnow isn't instrumented, its scopes aren't ours to count
+    val scopes = if (workload.instrumented) json(counter.count.toDouble() / frames) else "null"
+
+    return buildString {
+        append("{\"workload\":\"${workload.name}\",\"scale\":${json(scale.toDouble())},")
+        append("\"width\":$WIDTH,\"height\":$HEIGHT,\"frames\":$frames,")
+        append("\"frameMs\":{\"p50\":${json(percentile(frameMs, 50))},\"p90\":${json(percentile(frameMs, 90))},")
+        append("\"p99\":${json(percentile(frameMs, 99))},\"max\":${json(frameMs.lastOrNull() ?: 0.0)},")
+        append("\"mean\":${json(frameMs.average())}},")
+        append("\"recomposerPassesPerFrame\":${json(run.recompositions.toDouble() / frames)},")
+        append("\"scopeRecompositionsPerFrame\":$scopes,")
+        append("\"allocBytesPerFrame\":${json(run.allocatedBytes.toDouble() / frames)},")
+        append("\"allocMBPerSecond\":${json(if (seconds > 0) run.allocatedBytes / 1.0e6 / seconds else 0.0)}}")
+    }
+}
+
+fun main(args: Array<String>) {
+    var frames = 600
+    var warmup = 120
+    var only: String? = null
+    var scales = listOf(1f, 2f)
+
+    for (arg in args) {
+        val value = arg.substringAfter("=", "")
+        when {
+            arg.startsWith("--frames=") -> frames = value.toIntOrNull()?.coerceAtLeast(1) ?: frames
+            arg.startsWith("--warmup=") -> warmup = value.toIntOrNull()?.coerceAtLeast(0) ?: warmup
+            arg.startsWith("--workload=") -> only = value
+            arg.startsWith("--scale=") -> scales = listOfNotNull(value.toFloatOrNull())
+            else -> {
+                System.err.println("Usage: renderBenchmark [--frames=N] [--warmup=N] [--workload=NAME] [--scale=F]")
+                exitProcess(2)
+            }
+        }
+    }
+
+    val selected = workloads.filter { only == null || it.name == only }
+    if (selected.isEmpty() || scales.isEmpty()) {
+        System.err.println("Workloads: ${workloads.joinToString { it.name }}")
+        exitProcess(2)
+    }
+
+    val results = ArrayList<String>()
+    for (workload in selected) {
+        for (scale in scales) {
+            System.err.println("${workload.name} @${scale}x")
+            results.add(runWorkload(workload, scale, frames, warmup))
+        }
+    }
+
+    println(buildString {
+        append("{\"benchmark\":\"render-benchmark\",")
+        append("\"jvm\":\"${System.getProperty("java.vm.name")} ${System.getProperty("java.version")}\",")
+        append("\"os\":\"${System.getProperty("os.name")} ${System.getProperty("os.arch")}\",")
+        append("\"cpus\":${Runtime.getRuntime().availableProcessors()},")
+        append("\"frameClockHz\":60,\"warmupFrames\":$warmup,")
+        append("\"results\":[${results.joinToString(",")}]}")
+    })
+}
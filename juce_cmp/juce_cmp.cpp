@@ -4,6 +4,22 @@
 #include "juce_cmp.h"
 
 // Include all C++ implementation files
+#include "juce_cmp/Trace.cpp"
+#include "juce_cmp/IpcRecorder.cpp"
+#include "juce_cmp/ProcessWatcher.cpp"
 #include "juce_cmp/ChildProcess.cpp"
+#include "juce_cmp/SharedBlob.cpp"
+#include "juce_cmp/Lz4.cpp"
+#include "juce_cmp/IdentifierDictionary.cpp"
+#include "juce_cmp/ValueTreeView.cpp"
 #include "juce_cmp/Ipc.cpp"
+#include "juce_cmp/Rpc.cpp"
 #include "juce_cmp/ComposeProvider.cpp"
+#include "juce_cmp/MirroredValueTree.cpp"
+#include "juce_cmp/StatsOverlay.cpp"
+
+#if JUCE_LINUX
+// Shared memory surfaces, no native view yet
+#include "juce_cmp/SurfaceLinux.cpp"
+#include "juce_cmp/SurfaceViewLinux.cpp"
+#endif
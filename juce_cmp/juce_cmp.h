@@ -34,8 +34,20 @@ namespace juce_cmp
 // Internal implementation headers
 #include "juce_cmp/ipc_protocol.h"
 #include "juce_cmp/input_event.h"
+#include "juce_cmp/Trace.h"
+#include "juce_cmp/Stats.h"
+#include "juce_cmp/SharedBlob.h"
+#include "juce_cmp/Lz4.h"
+#include "juce_cmp/IdentifierDictionary.h"
+#include "juce_cmp/TypedMessage.h"
+#include "juce_cmp/BufferPool.h"
+#include "juce_cmp/ValueTreeView.h"
+#include "juce_cmp/IpcRecorder.h"
 #include "juce_cmp/Ipc.h"
+#include "juce_cmp/Rpc.h"
 #include "juce_cmp/MachPort.h"
 #include "juce_cmp/ComposeProvider.h"
+#include "juce_cmp/StatsOverlay.h"
 #include "juce_cmp/ComposeComponent.h"
+#include "juce_cmp/MirroredValueTree.h"
 #include "juce_cmp/ui_helpers.h"
@@ -4,9 +4,19 @@
 #include "juce_cmp.h"
 
 // Include all C++ implementation files (can be compiled in .mm on macOS)
+#include "juce_cmp/Trace.cpp"
+#include "juce_cmp/IpcRecorder.cpp"
+#include "juce_cmp/ProcessWatcher.cpp"
 #include "juce_cmp/ChildProcess.cpp"
+#include "juce_cmp/SharedBlob.cpp"
+#include "juce_cmp/Lz4.cpp"
+#include "juce_cmp/IdentifierDictionary.cpp"
+#include "juce_cmp/ValueTreeView.cpp"
 #include "juce_cmp/Ipc.cpp"
+#include "juce_cmp/Rpc.cpp"
 #include "juce_cmp/ComposeProvider.cpp"
+#include "juce_cmp/MirroredValueTree.cpp"
+#include "juce_cmp/StatsOverlay.cpp"
 
 // Include all Objective-C++ implementation files
 #include "juce_cmp/Surface.mm"
@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace juce_cmp
+{
+
+/**
+ * BufferPool - Recycles message buffers, so steady-state traffic allocates nothing.
+ *
+ * A released buffer keeps its capacity and comes back from the next
+ * acquire(). One that grew past maxCapacity (a preset, a whole-tree mirror)
+ * is freed instead, so a single large message doesn't pin its memory for the
+ * life of the connection. Thread-safe.
+ */
+class BufferPool
+{
+public:
+    static constexpr size_t maxBuffers = 64;
+    static constexpr size_t minCapacity = 256;
+    static constexpr size_t maxCapacity = 64 * 1024;
+
+    BufferPool() { free_.reserve(maxBuffers); }
+
+    /** A buffer of size bytes; the contents are unspecified. */
+    std::vector<uint8_t> acquire(size_t size)
+    {
+        std::vector<uint8_t> buffer;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!free_.empty())
+            {
+                buffer = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+
+        if (buffer.capacity() < size)
+            buffer.reserve(std::max(size, minCapacity));
+        buffer.resize(size);
+        return buffer;
+    }
+
+    void release(std::vector<uint8_t> buffer)
+    {
+        if (buffer.capacity() == 0 || buffer.capacity() > maxCapacity)
+            return;
+
+        buffer.clear();
+        std::lock_guard<std::mutex> lock(lock_);
+        if (free_.size() < maxBuffers)
+            free_.push_back(std::move(buffer));
+    }
+
+private:
+    std::mutex lock_;
+    std::vector<std::vector<uint8_t>> free_;
+};
+
+/**
+ * BufferOutputStream - Appends to a std::vector, e.g. one from a BufferPool,
+ * so a message can be encoded straight into the buffer that gets queued.
+ */
+class BufferOutputStream : public juce::OutputStream
+{
+public:
+    explicit BufferOutputStream(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+    void flush() override {}
+    bool setPosition(juce::int64) override { return false; }
+    juce::int64 getPosition() override { return static_cast<juce::int64>(buffer_.size()); }
+
+    bool write(const void* data, size_t size) override
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+        return true;
+    }
+
+private:
+    std::vector<uint8_t>& buffer_;
+};
+
+}  // namespace juce_cmp
@@ -2,20 +2,39 @@
 // SPDX-License-Identifier: MIT
 
 #include "ChildProcess.h"
+#include "ipc_protocol.h"
 
+#include <thread>
+#include <utility>
 #include <vector>
 
 #if __APPLE__ || __linux__
 #include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
 #include <signal.h>
 #include <spawn.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
 
 extern char** environ;
 #endif
 
+#if __linux__
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#elif __APPLE__
+#include <libproc.h>
+#include <stdlib.h>
+#include <sys/proc.h>
+#endif
+
 namespace juce_cmp
 {
 
@@ -29,7 +48,9 @@ ChildProcess::~ChildProcess()
 bool ChildProcess::launch(const std::string& executable,
                           float scale,
                           const std::string& machServiceName,
-                          const std::string& workingDir)
+                          const std::string& workingDir,
+                          const std::vector<std::string>& extraArgs,
+                          const LaunchPolicy& policy)
 {
 #if __APPLE__ || __linux__
     // Verify executable exists
@@ -38,14 +59,24 @@ bool ChildProcess::launch(const std::string& executable,
         return false;
 
     std::string scaleArg = "--scale=" + std::to_string(scale);
+    std::string protocolArg = "--protocol=" + std::to_string(IPC_PROTOCOL_VERSION);
     std::string machServiceArg;
     if (!machServiceName.empty())
         machServiceArg = "--mach-service=" + machServiceName;
 
-    // Create Unix socket pair for bidirectional IPC
+    // Create Unix socket pair for bidirectional IPC. Both ends close on exec,
+    // so no UI spawned later, by this or another instance, holds one open and
+    // keeps its UI from seeing EOF; only the child's end is let through below
     int sockets[2];
+#if __linux__
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+        return false;
+#else
     if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
         return false;
+    fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+    fcntl(sockets[1], F_SETFD, FD_CLOEXEC);
+#endif
 
     // Build argument list
     std::string socketArg = "--socket-fd=" + std::to_string(sockets[1]);
@@ -54,23 +85,75 @@ bool ChildProcess::launch(const std::string& executable,
     argv.push_back(const_cast<char*>(executable.c_str()));
     argv.push_back(const_cast<char*>(socketArg.c_str()));
     argv.push_back(const_cast<char*>(scaleArg.c_str()));
+    argv.push_back(const_cast<char*>(protocolArg.c_str()));
     if (!machServiceArg.empty())
         argv.push_back(const_cast<char*>(machServiceArg.c_str()));
+    for (const auto& arg : extraArgs)
+        argv.push_back(const_cast<char*>(arg.c_str()));
     argv.push_back(nullptr);
 
-    // Set up file actions to close parent's socket end in child
+    // The child's socket end is the one descriptor it inherits on purpose
     posix_spawn_file_actions_t fileActions;
     posix_spawn_file_actions_init(&fileActions);
-    posix_spawn_file_actions_addclose(&fileActions, sockets[0]);
+#if __linux__
+    posix_spawn_file_actions_adddup2(&fileActions, sockets[1], sockets[1]);  // Same fd: clears FD_CLOEXEC (glibc 2.29+)
+#else
+    posix_spawn_file_actions_addinherit_np(&fileActions, sockets[1]);
+#endif
 
     // Set working directory (macOS 10.15+, glibc 2.29+)
     if (!workingDir.empty())
         posix_spawn_file_actions_addchdir_np(&fileActions, workingDir.c_str());
 
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+#if __APPLE__
+    // QoS class, set by posix_spawn before exec
+    if (policy.background)
+        posix_spawnattr_set_qos_class_np(&attributes, QOS_CLASS_UTILITY);
+#endif
+
     // Spawn the child process
     pid_t pid;
-    int result = posix_spawn(&pid, executable.c_str(), &fileActions, nullptr, argv.data(), environ);
+    auto spawn = [&]() {
+        return posix_spawn(&pid, executable.c_str(), &fileActions, &attributes, argv.data(), environ);
+    };
 
+    int result;
+#if __linux__
+    // Scheduling policy, nice level and affinity are per thread here and
+    // inherited from the spawning thread, so one that has them spawns the
+    // UI (posix_spawnattr only takes SCHED_OTHER, FIFO and RR)
+    if (policy.background || policy.niceness != 0 || !policy.cpus.empty())
+    {
+        std::thread spawner([&]() {
+            if (policy.background)
+            {
+                struct sched_param param = {};
+                sched_setscheduler(0, SCHED_BATCH, &param);
+            }
+            if (policy.niceness != 0)
+                setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), policy.niceness);
+            if (!policy.cpus.empty())
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                for (int cpu : policy.cpus)
+                {
+                    if (cpu >= 0 && cpu < CPU_SETSIZE)
+                        CPU_SET(cpu, &set);
+                }
+                sched_setaffinity(0, sizeof(set), &set);
+            }
+            result = spawn();
+        });
+        spawner.join();
+    }
+    else
+#endif
+        result = spawn();
+
+    posix_spawnattr_destroy(&attributes);
     posix_spawn_file_actions_destroy(&fileActions);
 
     if (result != 0)
@@ -85,12 +168,34 @@ bool ChildProcess::launch(const std::string& executable,
     socketFD_ = sockets[0];
     childPid_ = pid;
 
+#if __linux__ && defined(SYS_pidfd_open)
+    // Linux 5.3+; without it the watcher polls
+    pidFD_ = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#endif
+
+    // No spawn attribute for these; the UI is still loading its runtime
+#if __linux__
+    cgroupDir_ = joinCgroup(pid, policy);
+    if (policy.maxMemoryBytes > 0 && cgroupDir_.empty())
+    {
+        const struct rlimit limit = { static_cast<rlim_t>(policy.maxMemoryBytes),
+                                      static_cast<rlim_t>(policy.maxMemoryBytes) };
+        prlimit(pid, RLIMIT_DATA, &limit, nullptr);
+    }
+#elif __APPLE__
+    // Per process here, unlike Linux
+    if (policy.niceness != 0)
+        setpriority(PRIO_PROCESS, static_cast<id_t>(pid), policy.niceness);
+#endif
+
     return true;
 #else
     (void)executable;
     (void)scale;
     (void)machServiceName;
     (void)workingDir;
+    (void)extraArgs;
+    (void)policy;
     return false;
 #endif
 }
@@ -105,33 +210,30 @@ void ChildProcess::stop()
         socketFD_ = -1;
     }
 
+    int pidFD = -1;
+    std::string cgroupDir;
+#if __linux__
+    pidFD = std::exchange(pidFD_, -1);
+    cgroupDir = std::exchange(cgroupDir_, {});
+#endif
+
     if (childPid_ > 0)
     {
+        // Exited already, e.g. crashed; otherwise it gets time to exit cleanly
+        // and the waiting happens off this thread
         int status;
-
-        // Check if already exited (non-blocking)
-        pid_t result = waitpid(childPid_, &status, WNOHANG);
-        if (result != 0)
+        if (waitpid(childPid_, &status, WNOHANG) == 0)
         {
-            childPid_ = 0;
-            return;
+            watcher_->reap(childPid_, pidFD, std::exchange(cgroupDir, {}));
+            pidFD = -1;
         }
-
-        // Send SIGTERM and check once more (non-blocking)
-        kill(childPid_, SIGTERM);
-        result = waitpid(childPid_, &status, WNOHANG);
-        if (result != 0)
-        {
-            childPid_ = 0;
-            return;
-        }
-
-        // Force kill - child will become zombie until reaped
-        kill(childPid_, SIGKILL);
-        // Non-blocking reap - zombie is harmless, OS cleans up on parent exit
-        waitpid(childPid_, &status, WNOHANG);
         childPid_ = 0;
     }
+
+    if (pidFD >= 0)
+        close(pidFD);
+    if (!cgroupDir.empty())
+        rmdir(cgroupDir.c_str());
 #endif
 }
 
@@ -146,9 +248,134 @@ bool ChildProcess::isRunning() const
 #endif
 }
 
+#if __linux__
+std::string ChildProcess::joinCgroup(pid_t pid, const LaunchPolicy& policy)
+{
+    if (policy.cgroup.empty() || (policy.cpuQuotaPercent <= 0 && policy.maxMemoryBytes == 0))
+        return {};
+
+    const std::string dir = policy.cgroup + "/juce-cmp-ui-" + std::to_string(pid);
+    if (mkdir(dir.c_str(), 0755) != 0)
+        return {};
+
+    auto writeFile = [&dir](const char* name, const std::string& value) {
+        const int fd = open((dir + "/" + name).c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+        const bool ok = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+        close(fd);
+        return ok;
+    };
+
+    // Quota per 100 ms period
+    if (policy.cpuQuotaPercent > 0)
+        writeFile("cpu.max", std::to_string(policy.cpuQuotaPercent * 1000) + " 100000");
+    if (policy.maxMemoryBytes > 0)
+        writeFile("memory.max", std::to_string(policy.maxMemoryBytes));
+
+    // Moves every thread of the UI
+    if (!writeFile("cgroup.procs", std::to_string(pid)))
+    {
+        rmdir(dir.c_str());
+        return {};
+    }
+    return dir;
+}
+#endif
+
 int ChildProcess::getSocketFD() const
 {
     return socketFD_;
 }
 
+#if __APPLE__ || __linux__
+std::vector<ChildProcess::Child> ChildProcess::listChildren()
+{
+    std::vector<Child> children;
+
+#if __linux__
+    // The parent in /proc/<pid>/stat is the process whichever thread spawned
+    // the child, even one that has exited since (/proc/self/task/*/children
+    // isn't, and needs CONFIG_PROC_CHILDREN)
+    DIR* processes = opendir("/proc");
+    if (processes == nullptr)
+        return children;
+
+    const pid_t self = getpid();
+
+    while (auto* entry = readdir(processes))
+    {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9')
+            continue;
+
+        // "pid (comm) state ppid ...", where comm may hold spaces and parentheses
+        char stat[512];
+        const int fd = open((std::string("/proc/") + entry->d_name + "/stat").c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        const ssize_t size = read(fd, stat, sizeof(stat) - 1);
+        close(fd);
+        if (size <= 0)
+            continue;
+        stat[size] = '\0';
+
+        const char* fields = strrchr(stat, ')');
+        char state;
+        int ppid;
+        if (fields == nullptr || sscanf(fields + 1, " %c %d", &state, &ppid) != 2 || ppid != self)
+            continue;
+
+        children.push_back({ static_cast<pid_t>(atoi(entry->d_name)), state == 'Z' });
+    }
+    closedir(processes);
+#else
+    std::vector<pid_t> pids(256);
+    const int listed = proc_listchildpids(getpid(), pids.data(), static_cast<int>(pids.size() * sizeof(pid_t)));
+    for (int i = 0; i < listed && i < static_cast<int>(pids.size()); ++i)
+    {
+        struct proc_bsdinfo info;
+        const bool zombie = proc_pidinfo(pids[i], PROC_PIDTBSDINFO, 0, &info, sizeof(info)) == sizeof(info)
+                         && info.pbi_status == SZOMB;
+        children.push_back({ pids[i], zombie });
+    }
+#endif
+
+    return children;
+}
+#endif
+
+int ChildProcess::countRunning(const std::string& executable)
+{
+#if __APPLE__ || __linux__
+    char resolved[PATH_MAX];
+    if (realpath(executable.c_str(), resolved) == nullptr)
+        return 0;
+    const std::string target = resolved;
+    int count = 0;
+
+    for (const auto& child : listChildren())
+    {
+        if (child.zombie)
+            continue;
+
+#if __linux__
+        char path[PATH_MAX];
+        const auto exe = "/proc/" + std::to_string(child.pid) + "/exe";
+        const ssize_t length = readlink(exe.c_str(), path, sizeof(path) - 1);
+        if (length > 0 && target.compare(0, std::string::npos, path, static_cast<size_t>(length)) == 0)
+            ++count;
+#else
+        char path[PROC_PIDPATHINFO_MAXSIZE];
+        if (proc_pidpath(child.pid, path, sizeof(path)) > 0 && target == path)
+            ++count;
+#endif
+    }
+
+    return count;
+#else
+    (void)executable;
+    return 0;
+#endif
+}
+
 }  // namespace juce_cmp
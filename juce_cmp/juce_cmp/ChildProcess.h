@@ -3,12 +3,45 @@
 
 #pragma once
 
+#include "ProcessWatcher.h"
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace juce_cmp
 {
 
+/**
+ * LaunchPolicy - Keeps a busy UI off the cores and memory the host's audio
+ * threads need. The default leaves the UI scheduled like the host.
+ *
+ * Best effort: what the system refuses (no cgroup delegation, a negative
+ * nice level without privilege) is skipped and the UI launches anyway.
+ */
+struct LaunchPolicy
+{
+    /** Nice level of the UI, 1..19 to yield to the host. */
+    int niceness = 0;
+
+    /** SCHED_BATCH on Linux, utility QoS class on macOS. */
+    bool background = false;
+
+    /** Cores the UI may run on, e.g. all but the audio ones; empty for any.
+     *  Linux only, macOS has no affinity API. */
+    std::vector<int> cpus;
+
+    /** cgroup v2 directory, delegated to the user with the cpu and memory
+     *  controllers enabled, in which a group is made per UI. Linux only. */
+    std::string cgroup;
+
+    /** CPU quota of that group, in percent of one core; 0 for none. */
+    int cpuQuotaPercent = 0;
+
+    /** memory.max of that group; without a group, RLIMIT_DATA (Linux),
+     *  which counts the writable memory a JVM commits. 0 for no limit. */
+    uint64_t maxMemoryBytes = 0;
+};
+
 /**
  * ChildProcess - Manages the child UI process lifecycle.
  *
@@ -27,24 +60,72 @@ public:
 
     /** Launch the child process with the given executable and arguments.
      *  machServiceName: (macOS) Mach service name for IOSurface port sharing
+     *  extraArgs: appended after the standard flags (e.g. stub-child options)
+     *  policy: scheduling and limits; the background class, and on Linux
+     *  nice level and affinity, are in place before the UI runs any code, the
+     *  cgroup and memory limit right after spawn
      */
     bool launch(const std::string& executable,
                 float scale,
                 const std::string& machServiceName = "",
-                const std::string& workingDir = "");
+                const std::string& workingDir = "",
+                const std::vector<std::string>& extraArgs = {},
+                const LaunchPolicy& policy = {});
 
-    /** Stop the child process gracefully, with fallback to force kill. */
+    /** Close the socket and let the child exit. Never waits: a child still
+     *  running is handed to the ProcessWatcher, see setProcessWatcher().
+     */
     void stop();
 
+    /** Where stop() hands children still running; must outlive this object.
+     *  Without one, a watcher of this object's own is used, and destroying
+     *  this object kills what it hasn't seen exit yet instead of waiting. */
+    void setProcessWatcher(ProcessWatcher* watcher) { watcher_ = watcher != nullptr ? watcher : &ownWatcher_; }
+    ProcessWatcher& getProcessWatcher() const { return *watcher_; }
+
     /** Check if child is still running. */
     bool isRunning() const;
 
+
     /** Get the socket file descriptor for IPC with child. */
     int getSocketFD() const;
 
+#if __APPLE__ || __linux__
+    /** A process whose parent is this one, see listChildren(). */
+    struct Child
+    {
+        pid_t pid;
+        bool zombie;  // Exited, not reaped yet
+    };
+
+    /** Children of this process, whichever thread spawned them, from the OS
+     *  process table; empty if it can't be listed. Reads every process's
+     *  /proc/<pid>/stat on Linux, so call it seldom. */
+    static std::vector<Child> listChildren();
+#endif
+
+    /** Children of this process running the given executable, i.e. UIs of
+     *  every instance in the host, counted from listChildren() rather than
+     *  state shared between instances; 0 if they can't be listed. Use
+     *  ProcessWatcher::countRunning() to keep it off the message thread.
+     *  The executable is what the child runs as: a script that execs a JVM
+     *  counts as the JVM, and isn't matched. */
+    static int countRunning(const std::string& executable);
+
 private:
+    // Declared first, so it's destroyed after stop() has handed it the child
+    ProcessWatcher ownWatcher_;
+    ProcessWatcher* watcher_ = &ownWatcher_;
+
 #if __APPLE__ || __linux__
     pid_t childPid_ = 0;
+#endif
+#if __linux__
+    // Group made for the child, removed once it's reaped
+    static std::string joinCgroup(pid_t pid, const LaunchPolicy& policy);
+
+    int pidFD_ = -1;  // Readable once the child exits, for the watcher
+    std::string cgroupDir_;
 #endif
     int socketFD_ = -1;
 };
@@ -9,6 +9,7 @@ namespace juce_cmp
 {
 
 ComposeComponent::ComposeComponent()
+    : constructedTime_(Tracer::now())
 {
     setOpaque(false);
     setWantsKeyboardFocus(true);
@@ -17,6 +18,7 @@ ComposeComponent::ComposeComponent()
 
 ComposeComponent::~ComposeComponent()
 {
+    statsOverlay_.reset();
     provider_.stop();
 }
 
@@ -27,6 +29,45 @@ void ComposeComponent::setLoadingPreview(const juce::Image& image, juce::Colour
     repaint();
 }
 
+ComposeProvider::LaunchTimes ComposeComponent::getLaunchTimes() const
+{
+    auto times = provider_.getLaunchTimes();
+    times.constructed = constructedTime_;
+    times.tryLaunch = tryLaunchTime_;
+    return times;
+}
+
+void ComposeComponent::setStatsOverlayVisible(bool visible)
+{
+    if (visible == (statsOverlay_ != nullptr))
+        return;
+
+    if (visible)
+        statsOverlay_ = std::make_unique<StatsOverlay>([this]() { return provider_.getStats(); });
+    else
+        statsOverlay_.reset();
+
+    updateStatsOverlay();
+}
+
+void ComposeComponent::updateStatsOverlay()
+{
+    if (!statsOverlay_)
+        return;
+
+    auto* peer = getPeer();
+    if (!launched_ || peer == nullptr)
+    {
+        statsOverlay_->attach(nullptr);
+        return;
+    }
+
+    // Attached after the surface view so it stays on top of it
+    auto topLeftInPeer = peer->getComponent().getLocalPoint(this, juce::Point<int>(0, 0));
+    statsOverlay_->setTopLeftPosition(topLeftInPeer.x + 8, topLeftInPeer.y + 8);
+    statsOverlay_->attach(peer->getNativeHandle());
+}
+
 void ComposeComponent::parentHierarchyChanged()
 {
     tryLaunch();
@@ -37,6 +78,15 @@ void ComposeComponent::parentHierarchyChanged()
         provider_.attachView(peer->getNativeHandle());
         updateViewBounds();
     }
+
+    updateStatsOverlay();
+    provider_.setVisible(isShowing());
+}
+
+void ComposeComponent::visibilityChanged()
+{
+    // Hidden views count toward the memory policy
+    provider_.setVisible(isShowing());
 }
 
 void ComposeComponent::paint(juce::Graphics& g)
@@ -80,6 +130,7 @@ void ComposeComponent::tryLaunch()
     if (launched_ || getPeer() == nullptr || getLocalBounds().isEmpty())
         return;
 
+    tryLaunchTime_ = Tracer::now();
     auto bounds = getLocalBounds();
 
     // Get backing scale factor
@@ -96,9 +147,16 @@ void ComposeComponent::tryLaunch()
         return;
 
     // Set up callbacks before launch
-    provider_.setEventCallback([this](const juce::ValueTree& tree) {
-        if (eventCallback_)
-            eventCallback_(tree);
+    provider_.setEventViewCallback([this](const ValueTreeView& tree) {
+        if (eventViewCallback_)
+            eventViewCallback_(tree);
+        else if (eventCallback_)
+            eventCallback_(tree.toValueTree());
+    });
+
+    provider_.setMessageCallback([this](const TypedMessage& message) {
+        if (messageCallback_)
+            messageCallback_(message);
     });
 
     provider_.setFirstFrameCallback([this]() {
@@ -117,6 +175,7 @@ void ComposeComponent::tryLaunch()
         {
             provider_.attachView(peer->getNativeHandle());
             updateViewBounds();
+            updateStatsOverlay();
         }
 
         if (readyCallback_)
@@ -150,6 +209,9 @@ void ComposeComponent::updateViewBounds()
 
     auto topLeftInPeer = peer->getComponent().getLocalPoint(this, juce::Point<int>(0, 0));
     provider_.updateViewBounds(topLeftInPeer.x, topLeftInPeer.y, getWidth(), getHeight());
+
+    if (statsOverlay_)
+        statsOverlay_->setTopLeftPosition(topLeftInPeer.x + 8, topLeftInPeer.y + 8);
 }
 
 int ComposeComponent::getModifiers() const
@@ -6,7 +6,9 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_data_structures/juce_data_structures.h>
 #include "ComposeProvider.h"
+#include "StatsOverlay.h"
 #include <functional>
+#include <memory>
 
 namespace juce_cmp
 {
@@ -29,16 +31,94 @@ public:
     using EventCallback = std::function<void(const juce::ValueTree& tree)>;
     void onEvent(EventCallback callback) { eventCallback_ = std::move(callback); }
 
+    /// Like onEvent, but the tree is read in place from the receive buffer and only
+    /// valid during the call (see ValueTreeView). Replaces onEvent when set
+    using EventViewCallback = std::function<void(const ValueTreeView& tree)>;
+    void onEventView(EventViewCallback callback) { eventViewCallback_ = std::move(callback); }
+
+    /// Set callback for typed messages from the UI; decode them with the generated dispatch()
+    using MessageCallback = std::function<void(const TypedMessage& message)>;
+    void onMessage(MessageCallback callback) { messageCallback_ = std::move(callback); }
+
     /// Set callback for when the child process is ready to receive events
     using ReadyCallback = std::function<void()>;
     void onProcessReady(ReadyCallback callback) { readyCallback_ = std::move(callback); }
 
-    /// Set callback for when the UI has rendered its first frame
+    /// Set callback for when the UI has rendered its first frame, again after each restart
     using FirstFrameCallback = std::function<void()>;
     void onFirstFrame(FirstFrameCallback callback) { firstFrameCallback_ = std::move(callback); }
 
-    /// Send an event to the UI
-    void sendEvent(const juce::ValueTree& tree) { provider_.sendEvent(tree); }
+    /// Send an event to the UI. Events on the same lane arrive in order; use
+    /// IPC_LANE_BULK for large trees so they don't hold up input and small events.
+    /// Returns false if the event was dropped: no UI connected, or a tree over
+    /// IPC_MAX_MESSAGE_SIZE (1 MB) when the UI doesn't take shared memory blobs
+    bool sendEvent(const juce::ValueTree& tree, uint8_t lane = IPC_LANE_CONTROL) { return provider_.sendEvent(tree, lane); }
+
+    /// Send a struct generated from the message schema (see TypedMessage). Needs a UI
+    /// built from the same schema; dropped until it has rendered its first frame
+    template <typename Message>
+    bool sendMessage(const Message& message, uint8_t lane = IPC_LANE_CONTROL)
+    {
+        uint8_t data[Message::wireSize > 0 ? Message::wireSize : 1];
+        message.encode(data);
+        return provider_.sendMessage(Message::id, data, Message::wireSize, lane);
+    }
+
+    /// Like sendMessage, for state the UI must always have, such as parameter values: the
+    /// latest message per type and key is kept and sent again whenever a UI connects, also
+    /// after a crash. Can be called before the UI launches
+    template <typename Message>
+    bool sendState(const Message& message, uint16_t key = 0, uint8_t lane = IPC_LANE_CONTROL)
+    {
+        uint8_t data[Message::wireSize > 0 ? Message::wireSize : 1];
+        message.encode(data);
+        return provider_.sendState(Message::id, key, data, Message::wireSize, lane);
+    }
+
+    /// LZ4 compress large trees in both directions (off by default). Only worth it
+    /// where benchmarks/compression_benchmark shows a gain; set before the UI launches
+    void setCompressionEnabled(bool enabled) { provider_.setCompressionEnabled(enabled); }
+
+    /// Call UI methods and answer UI requests (available once the UI has rendered its first frame)
+    Rpc& getRpc() { return provider_.getRpc(); }
+
+    /// The provider behind this component, for helpers built on it such as MirroredValueTree
+    ComposeProvider& getProvider() { return provider_; }
+
+    /// Start recording host and UI timelines (IPC, callAsync, resizes, frames)
+    void startTracing() { provider_.startTracing(); }
+
+    /// Stop recording and write a Chrome trace JSON file once the UI has flushed its events
+    void stopTracing(const juce::File& output, std::function<void(bool success)> callback = nullptr)
+    {
+        provider_.stopTracing(output, std::move(callback));
+    }
+
+    /// Log every IPC message of the session to a file, for benchmarks/ipc_replay (set before the UI launches)
+    void setRecordingFile(const juce::File& file) { provider_.setRecordingFile(file); }
+
+    /// Nice level, affinity, cgroup and memory limit of the UI process (set before the UI launches)
+    void setLaunchPolicy(const LaunchPolicy& policy) { provider_.setLaunchPolicy(policy); }
+
+    /// Where UI processes go when the editor closes, to exit and be reaped; keep it where it
+    /// outlives the editor, e.g. in the AudioProcessor. Without one, a UI still running when
+    /// the editor is destroyed is killed
+    void setProcessWatcher(ProcessWatcher& watcher) { provider_.setProcessWatcher(&watcher); }
+
+    /// Ask the UI to release memory (IPC_MEMORY_PRESSURE_*), e.g. on an OS memory warning
+    void setMemoryPressure(uint8_t level) { provider_.setMemoryPressure(level); }
+
+    /// When memory pressure goes up by itself: hidden for a while, many UIs in the host
+    void setMemoryPolicy(const ComposeProvider::MemoryPolicy& policy) { provider_.setMemoryPolicy(policy); }
+
+    /// Current frame times, UI process resources and IPC traffic (any thread)
+    Stats getStats() const { return provider_.getStats(); }
+
+    /// When each startup stage happened, from construction to the first frame (message thread)
+    ComposeProvider::LaunchTimes getLaunchTimes() const;
+
+    /// Show a debug overlay with the numbers from getStats()
+    void setStatsOverlayVisible(bool visible);
 
     /// Set an image to display while the child process loads
     void setLoadingPreview(const juce::Image& image,
@@ -50,6 +130,7 @@ public:
     void resized() override;
     void paint(juce::Graphics& g) override;
     void parentHierarchyChanged() override;
+    void visibilityChanged() override;
 
     // Mouse events
     void mouseMove(const juce::MouseEvent& event) override;
@@ -71,21 +152,28 @@ public:
 private:
     void tryLaunch();
     void updateViewBounds();
+    void updateStatsOverlay();
     int getModifiers() const;
     int mapMouseButton(const juce::MouseEvent& event) const;
 
     ComposeProvider provider_;
     EventCallback eventCallback_;
+    EventViewCallback eventViewCallback_;
+    MessageCallback messageCallback_;
     ReadyCallback readyCallback_;
     FirstFrameCallback firstFrameCallback_;
 
     bool launched_ = false;
     bool firstFrameReceived_ = false;
+    int64_t constructedTime_ = 0;
+    int64_t tryLaunchTime_ = 0;
 
     // Loading state visuals
     juce::Image loadingPreview_;
     juce::Colour loadingBackgroundColor_;
 
+    std::unique_ptr<StatsOverlay> statsOverlay_;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ComposeComponent)
 };
 
@@ -2,8 +2,14 @@
 // SPDX-License-Identifier: MIT
 
 #include "ComposeProvider.h"
+#include "MirroredValueTree.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
 
 #if __APPLE__ || __linux__
+#include <fcntl.h>
 #include <unistd.h>
 #endif
 
@@ -21,9 +27,14 @@ ComposeProvider::~ComposeProvider()
     stop();
 }
 
-bool ComposeProvider::launch(const std::string& executable, int width, int height, float scale)
+bool ComposeProvider::launch(const std::string& executable, int width, int height, float scale,
+                             const std::vector<std::string>& args)
 {
     scale_ = scale;
+    executable_ = executable;
+    args_ = args;
+    restartAttempts_ = 0;
+    restartCount_ = 0;
 
     // Create surface at pixel dimensions
     int pixelW = (int)(width * scale);
@@ -32,43 +43,132 @@ bool ComposeProvider::launch(const std::string& executable, int width, int heigh
     if (!surface_.create(pixelW, pixelH))
         return false;
 
+    tracer_.setCurrentThreadName("Message thread");
+
+    if (recordingFile_ != juce::File() && recorder_.start(recordingFile_))
+        ipc_.setRecorder(&recorder_);
+
+    stopped_ = false;
+    if (!spawn())
+    {
+        stopped_ = true;
+        surface_.release();
+        return false;
+    }
+
+    // Set up view
+    view_.create();
+    view_.setSurface(surface_.getNativeHandle());
+    view_.setBackingScale(scale);
+
+    if (memoryPolicy_.enabled)
+        startTimer(memoryTimer, memoryCheckIntervalMs);
+
+    return true;
+}
+
+bool ComposeProvider::spawn()
+{
+    launchTime_.store(Tracer::now());
+    spawnedTime_.store(0);
+    connectedTime_.store(0);
+    surfaceSentTime_.store(0);
+    surfaceReadyTime_ = 0;
+    firstFrameTime_ = 0;
+    memoryPressure_.store(IPC_MEMORY_PRESSURE_NONE);  // A new UI has released nothing
+
 #if __APPLE__
     // Set up Mach IPC for surface sharing
     std::string machService = machPort_.createServer();
     if (machService.empty())
-    {
-        surface_.release();
         return false;
-    }
 #else
     std::string machService;
 #endif
 
     // Launch child process
-    if (!child_.launch(executable, scale, machService))
+    if (!child_.launch(executable_, scale_, machService, {}, args_, policy_))
     {
-        surface_.release();
 #if __APPLE__
         machPort_.destroyServer();
 #endif
         return false;
     }
+    spawnedTime_.store(Tracer::now());
 
-    // Set up IPC on socket
-    ipc_.setSocketFD(child_.getSocketFD());
+    // Set up IPC on its own descriptor for the socket: both close theirs, and
+    // closing the same number twice could hit another instance's socket.
+    // Close-on-exec like the original, see ChildProcess::launch()
+#if __APPLE__ || __linux__
+    const int socketFD = fcntl(child_.getSocketFD(), F_DUPFD_CLOEXEC, 0);
+    if (socketFD < 0)
+    {
+        child_.stop();
+#if __APPLE__
+        machPort_.destroyServer();
+#endif
+        return false;
+    }
+    ipc_.setSocketFD(socketFD);
+#endif
+    ipc_.setTracer(&tracer_);
+
+    // Trees are read in place; only built if someone wants the whole thing
+    ipc_.setEventViewHandler([this](const ValueTreeView& tree) {
+        if (eventViewCallback_)
+            eventViewCallback_(tree);
+        else if (eventCallback_)
+            eventCallback_(tree.toValueTree());
+    });
 
-    ipc_.setEventHandler([this](const juce::ValueTree& tree) {
-        if (eventCallback_)
-            eventCallback_(tree);
+    ipc_.setTypedHandler([this](const TypedMessage& message) {
+        if (messageCallback_)
+            messageCallback_(message);
     });
 
     ipc_.setFrameReadyHandler([this]() {
+        const bool first = surfaceReadyTime_ == 0;
+        if (first)
+            surfaceReadyTime_ = Tracer::now();
+
+        tracer_.instant(TRACE_NAME_SURFACE_SWAP);
+
         // Apply pending bounds and swap surface atomically
         view_.setFrame(pendingViewX_, pendingViewY_, pendingViewW_, pendingViewH_);
         view_.setPendingSurface(surface_.getNativeHandle());
 
-        if (firstFrameCallback_)
-            firstFrameCallback_();
+        // Only once per UI process; later SURFACE_READYs follow resizes
+        if (first)
+        {
+            firstFrameTime_ = Tracer::now();
+
+            // Resizes while restarting were held back, see resize()
+            if (std::exchange(restarting_, false)
+                && ((int)(pendingViewW_ * scale_) != surface_.getWidth()
+                    || (int)(pendingViewH_ * scale_) != surface_.getHeight()))
+                resize(pendingViewW_, pendingViewH_, pendingViewX_, pendingViewY_);
+
+            if (firstFrameCallback_)
+                firstFrameCallback_();
+        }
+    });
+
+    ipc_.setTraceFinishedHandler([this]() { writeTrace(); });
+    ipc_.setStatsHandler([this](const StatsReport& report) { updateStats(report); });
+    ipc_.setMemoryTrimmedHandler([this](const MemoryTrimReport& report) { updateTrimStats(report); });
+    ipc_.setMirrorHandler([this](const void* data, size_t size) { handleMirrorMessage(data, size); });
+
+    // A new UI starts with empty replicas and no state
+    ipc_.setHandshakeHandler([this]() {
+        connectedTime_.store(Tracer::now());
+        handshakePending_.store(true);
+        triggerAsyncUpdate();
+    });
+
+    // EOF or a failed write: the UI crashed or quit, handled on the message thread
+    ipc_.setDisconnectHandler([this]() {
+        disconnectPending_.store(true);
+        triggerAsyncUpdate();
     });
 
     ipc_.startReceiving();
@@ -81,30 +181,191 @@ bool ComposeProvider::launch(const std::string& executable, int width, int heigh
 
         // Send initial IOSurface
         sendSurfacePort();
+        surfaceSentTime_.store(Tracer::now());
     });
 #endif
 
-    // Set up view
-    view_.create();
-    view_.setSurface(surface_.getNativeHandle());
-    view_.setBackingScale(scale);
-
     return true;
 }
 
 void ComposeProvider::stop()
 {
+    // Anything the reader thread queues from here on is ignored
+    stopped_ = true;
+
 #if __APPLE__
     machPort_.destroyServer();
     if (machPortThread_.joinable())
         machPortThread_.join();
 #endif
-    child_.stop();
-    ipc_.stop();
+    ipc_.stop(true);  // SHUTDOWN last
+    child_.stop();    // Last descriptor for the socket, the UI sees EOF; reaped in the background
+
+    // After the reader thread is gone, so it can't trigger another update
+    stopTimer(restartTimer);
+    stopTimer(memoryTimer);
+    cancelPendingUpdate();
+    handshakePending_.store(false);
+    disconnectPending_.store(false);
+    takePendingResyncs();
+    restarting_ = false;
+
+    recorder_.stop();
+    rpc_.failAll("Disconnected");
     view_.destroy();
     surface_.release();
 }
 
+void ComposeProvider::handleAsyncUpdate()
+{
+    if (stopped_)
+        return;
+
+    // A UI that connected and died before this ran needs nothing sent
+    if (disconnectPending_.exchange(false))
+    {
+        handshakePending_.store(false);
+        takePendingResyncs();
+        handleDisconnect();
+        return;
+    }
+
+    if (handshakePending_.exchange(false))
+    {
+#if __linux__
+        // Initial surface, on the message thread like resize() replacing it
+        sendSurfaceFD();
+        surfaceSentTime_.store(Tracer::now());
+#endif
+        sendRetainedState();
+    }
+
+    for (const auto& name : takePendingResyncs())
+        resyncMirrors(name);
+}
+
+void ComposeProvider::handleDisconnect()
+{
+    // The socket closes as the process dies; a UI that closed it and kept
+    // running is stopped by child_.stop(), both reaped in the background
+#if __APPLE__
+    machPort_.destroyServer();
+    if (machPortThread_.joinable())
+        machPortThread_.join();
+#endif
+    ipc_.stop();
+    child_.stop();
+    rpc_.failAll("Disconnected");
+
+    // The view keeps the surface with the last frame until the new UI's
+    // first frame; if the previous attempt never got that far, its surface
+    // was never shown and is reused
+    if (!std::exchange(restarting_, true))
+        surface_.resize(surface_.getWidth(), surface_.getHeight());
+
+    // A UI that had been up for a while starts the backoff over
+    constexpr int64_t stableNs = 10'000'000'000;
+    if (firstFrameTime_ != 0 && Tracer::now() - firstFrameTime_ > stableNs)
+        restartAttempts_ = 0;
+
+    scheduleRestart();
+}
+
+void ComposeProvider::scheduleRestart()
+{
+    if (stopped_)
+        return;
+
+    // 100 ms, doubling up to 10 s
+    startTimer(restartTimer, juce::jmin(10000, 100 << juce::jmin(restartAttempts_, 7)));
+    ++restartAttempts_;
+}
+
+void ComposeProvider::timerCallback(int timerID)
+{
+    if (stopped_)
+        return;
+
+    if (timerID == memoryTimer)
+    {
+        updateMemoryPressure();
+        return;
+    }
+
+    stopTimer(restartTimer);
+
+    if (!spawn())
+    {
+        scheduleRestart();
+        return;
+    }
+
+    ++restartCount_;
+}
+
+void ComposeProvider::setMemoryPolicy(const MemoryPolicy& policy)
+{
+    memoryPolicy_ = policy;
+
+    if (memoryPolicy_.enabled && !stopped_)
+        startTimer(memoryTimer, memoryCheckIntervalMs);
+    else
+        stopTimer(memoryTimer);
+
+    updateMemoryPressure();
+}
+
+void ComposeProvider::setMemoryPressure(uint8_t level)
+{
+    requestedPressure_ = juce::jmin<uint8_t>(level, IPC_MEMORY_PRESSURE_CRITICAL);
+    updateMemoryPressure();
+}
+
+void ComposeProvider::setVisible(bool visible)
+{
+    if (visible)
+        hiddenSince_ = 0;
+    else if (hiddenSince_ == 0)
+        hiddenSince_ = Tracer::now();
+
+    updateMemoryPressure();
+}
+
+void ComposeProvider::updateMemoryPressure()
+{
+    if (executable_.empty() || !ipc_.isConnected())
+        return;
+
+    uint8_t level = requestedPressure_;
+
+    if (memoryPolicy_.enabled)
+    {
+        const bool hidden = hiddenSince_ != 0;
+        const int64_t hiddenMs = hidden ? (Tracer::now() - hiddenSince_) / 1'000'000 : 0;
+        const int critical = memoryPolicy_.criticalInstances;
+        const int moderate = memoryPolicy_.moderateInstances;
+
+        // Counted on the watcher's thread, as of the previous check at most;
+        // not asked for when nothing uses it
+        const int instances = critical > 0 || moderate > 0
+                                  ? child_.getProcessWatcher().countRunning(executable_, memoryCheckIntervalMs)
+                                  : 0;
+
+        uint8_t policyLevel = IPC_MEMORY_PRESSURE_NONE;
+        if (hidden && (hiddenMs >= memoryPolicy_.criticalAfterHiddenMs || (critical > 0 && instances >= critical)))
+            policyLevel = IPC_MEMORY_PRESSURE_CRITICAL;
+        else if ((hidden && hiddenMs >= memoryPolicy_.moderateAfterHiddenMs) || (moderate > 0 && instances >= moderate))
+            policyLevel = IPC_MEMORY_PRESSURE_MODERATE;
+
+        level = juce::jmax(level, policyLevel);
+    }
+
+    // Not stored if the UI can't take it yet (not connected, older UI); the
+    // next check tries again
+    if (level != memoryPressure_.load() && ipc_.sendMemoryPressure(level))
+        memoryPressure_.store(level);
+}
+
 bool ComposeProvider::isRunning() const
 {
     return child_.isRunning();
@@ -137,9 +398,16 @@ void ComposeProvider::resize(int width, int height, int viewX, int viewY)
     pendingViewW_ = width;
     pendingViewH_ = height;
 
+    // The view still shows the last frame of the UI that's gone; the new UI
+    // gets a surface this size once it has rendered into the current one
+    if (restarting_)
+        return;
+
     int pixelW = (int)(width * scale_);
     int pixelH = (int)(height * scale_);
 
+    tracer_.instant(TRACE_NAME_RESIZE, (uint32_t)(pixelW & 0xFFFF) << 16 | (uint32_t)(pixelH & 0xFFFF));
+
     if (surface_.resize(pixelW, pixelH))
     {
         auto e = InputEventFactory::resize(pixelW, pixelH, scale_);
@@ -149,6 +417,8 @@ void ComposeProvider::resize(int width, int height, int viewX, int viewY)
         // Send new surface via Mach port
         // Child will send SURFACE_READY after rendering, then we swap surfaces
         sendSurfacePort();
+#elif __linux__
+        sendSurfaceFD();
 #endif
     }
 }
@@ -158,9 +428,262 @@ void ComposeProvider::sendInput(InputEvent& event)
     ipc_.sendInput(event);
 }
 
-void ComposeProvider::sendEvent(const juce::ValueTree& tree)
+bool ComposeProvider::sendEvent(const juce::ValueTree& tree, uint8_t lane)
+{
+    return ipc_.sendEvent(tree, lane);
+}
+
+bool ComposeProvider::sendState(uint16_t id, uint16_t key, const void* data, size_t size, uint8_t lane)
+{
+    jassert(size <= IPC_TYPED_MAX_SIZE);
+
+    // Sent under the lock, so a UI connecting now never gets an older value after it
+    std::lock_guard<std::mutex> lock(stateLock_);
+    auto& body = state_[static_cast<uint32_t>(id) << 16 | key];
+    body.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
+    // Otherwise the UI gets it when it connects
+    return ipc_.sendTyped(id, data, size, lane);
+}
+
+bool ComposeProvider::sendMirror(const void* data, size_t size)
+{
+    if (!batching_)
+        return ipc_.sendMirror(data, size);
+
+    Ipc::addMirrorToBatch(batch_, data, size);
+    return true;
+}
+
+void ComposeProvider::sendRetainedState()
+{
+    // In one message if the UI takes batches, so it never renders half of it
+    batching_ = ipc_.hasCapability(IPC_CAP_BATCH);
+    batch_.clear();
+
+    resyncMirrors({});
+    for (auto* mirror : mirrors_)
+        mirror->flush();
+
+    {
+        std::lock_guard<std::mutex> lock(stateLock_);
+        for (const auto& [idAndKey, body] : state_)
+        {
+            const auto id = static_cast<uint16_t>(idAndKey >> 16);
+            if (!batching_)
+                ipc_.sendTyped(id, body.data(), body.size(), IPC_LANE_CONTROL);
+            else if (ipc_.hasCapability(IPC_CAP_TYPED))
+                Ipc::addTypedToBatch(batch_, id, body.data(), body.size());
+        }
+
+        if (!std::exchange(batching_, false) || batch_.empty() || ipc_.sendBatch(batch_))
+            return;
+    }
+
+    // Over the message size limit: the same messages, one by one
+    for (size_t offset = 0; offset + 4 <= batch_.size();)
+    {
+        uint32_t size = 0;
+        std::memcpy(&size, batch_.data() + offset, 4);
+        ipc_.sendEncoded(batch_.data() + offset + 4, size, IPC_LANE_CONTROL);
+        offset += 4 + size;
+    }
+}
+
+bool ComposeProvider::replay(const IpcRecording::Record& record)
+{
+    if (record.direction != IpcRecorder::Direction::toUi || record.data.empty())
+        return false;
+
+    // Surfaces are this session's, sent by resize()
+    if (record.attachment == IpcRecorder::Attachment::surface)
+        return false;
+
+    const auto* data = record.data.data();
+    const size_t size = record.data.size();
+
+    if (data[0] == EVENT_TYPE_CMP)
+    {
+        // Already exchanged with this UI, or up to whoever is replaying
+        if (size < 2 || data[1] == CMP_EVENT_HELLO || data[1] == CMP_EVENT_CLOCK_SYNC
+            || data[1] == CMP_EVENT_TRACE_CONTROL)
+            return false;
+    }
+    else if (data[0] == EVENT_TYPE_INPUT && size == 1 + sizeof(InputEvent))
+    {
+        InputEvent event;
+        std::memcpy(&event, data + 1, sizeof(event));
+        if (event.type == INPUT_EVENT_RESIZE)
+        {
+            if (event.data1 <= 0)
+                return false;
+            resize(event.x * 100 / event.data1, event.y * 100 / event.data1, pendingViewX_, pendingViewY_);
+            return true;
+        }
+    }
+
+    const bool hasBlob = record.attachment == IpcRecorder::Attachment::blob;
+    return ipc_.sendEncoded(data, size, record.lane, hasBlob ? record.blob.data() : nullptr, record.blob.size());
+}
+
+void ComposeProvider::startTracing()
+{
+    tracer_.start();
+    ipc_.sendTraceControl(true);
+
+    // Several samples so at least one sees an undisturbed round trip
+    for (int i = 0; i < 4; ++i)
+        ipc_.sendClockSync();
+}
+
+void ComposeProvider::stopTracing(const juce::File& output, TraceWrittenCallback callback)
+{
+    tracer_.stop();
+    traceFile_ = output;
+    traceWrittenCallback_ = std::move(callback);
+
+    // Host events only if the UI can't record (older UI binary)
+    if (!ipc_.isValid() || !ipc_.hasCapability(IPC_CAP_TRACE))
+    {
+        writeTrace();
+        return;
+    }
+
+    // UI answers with its final batch of records, then writeTrace() runs
+    ipc_.sendClockSync();
+    ipc_.sendTraceControl(false);
+}
+
+void ComposeProvider::writeTrace()
 {
-    ipc_.sendEvent(tree);
+    if (traceFile_ == juce::File())
+        return;
+
+    bool success = tracer_.writeChromeTrace(traceFile_);
+    traceFile_ = juce::File();
+
+    if (auto callback = std::move(traceWrittenCallback_))
+    {
+        traceWrittenCallback_ = nullptr;
+        callback(success);
+    }
+}
+
+void ComposeProvider::addMirror(MirroredValueTree* mirror)
+{
+    mirrors_.push_back(mirror);
+}
+
+void ComposeProvider::removeMirror(MirroredValueTree* mirror)
+{
+    mirrors_.erase(std::remove(mirrors_.begin(), mirrors_.end(), mirror), mirrors_.end());
+}
+
+void ComposeProvider::handleMirrorMessage(const void* data, size_t size)
+{
+    // The UI only ever asks for the whole tree
+    juce::MemoryInputStream stream(data, size, false);
+    const auto name = stream.readString();
+    stream.readInt();  // Sequence, unused in this direction
+
+    if (stream.readByte() != IPC_MIRROR_RESYNC_REQUEST)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(resyncLock_);
+        pendingResyncs_.addIfNotAlreadyThere(name);
+    }
+
+    triggerAsyncUpdate();
+}
+
+juce::StringArray ComposeProvider::takePendingResyncs()
+{
+    std::lock_guard<std::mutex> lock(resyncLock_);
+    return std::exchange(pendingResyncs_, {});
+}
+
+void ComposeProvider::resyncMirrors(const juce::String& name)
+{
+    for (auto* mirror : mirrors_)
+    {
+        if (name.isEmpty() || mirror->getName() == name)
+            mirror->resync();
+    }
+}
+
+Stats ComposeProvider::getStats() const
+{
+    auto stats = stats_.load();
+
+    const auto counters = ipc_.getCounters();
+    stats.txMessages = counters.txMessages;
+    stats.txBytes = counters.txBytes;
+    stats.rxMessages = counters.rxMessages;
+    stats.rxBytes = counters.rxBytes;
+    stats.txDropped = counters.txDropped;
+    stats.txQueueBytes = ipc_.getPendingTxBytes();
+    stats.memoryPressure = memoryPressure_.load();
+    for (size_t i = 0; i < IPC_LANE_COUNT; ++i)
+        stats.txLaneBytes[i] = counters.txLaneBytes[i];
+
+    return stats;
+}
+
+ComposeProvider::LaunchTimes ComposeProvider::getLaunchTimes() const
+{
+    LaunchTimes times;
+    times.launch = launchTime_.load();
+    times.spawned = spawnedTime_.load();
+    times.connected = connectedTime_.load();
+    times.surfaceSent = surfaceSentTime_.load();
+    times.surfaceReady = surfaceReadyTime_;
+    times.firstFrame = firstFrameTime_;
+    return times;
+}
+
+void ComposeProvider::updateStats(const StatsReport& report)
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const auto counters = ipc_.getCounters();
+    auto stats = stats_.load();
+
+    stats.fps = report.intervalMs > 0 ? (float)report.frames * 1000.0f / (float)report.intervalMs : 0.0f;
+    stats.frameTimeP50 = (float)report.frameTimeP50 / 1000.0f;
+    stats.frameTimeP95 = (float)report.frameTimeP95 / 1000.0f;
+    stats.frameTimeP99 = (float)report.frameTimeP99 / 1000.0f;
+    stats.frameTimeMax = (float)report.frameTimeMax / 1000.0f;
+    stats.childResidentBytes = report.residentBytes;
+    stats.childCpuSeconds = (double)report.cpuTimeNs / 1.0e9;
+
+    // Rates from counter deltas since the previous report
+    const double seconds = (now - lastStatsTime_) / 1000.0;
+    if (lastStatsTime_ > 0.0 && seconds > 0.0)
+    {
+        stats.txMessagesPerSecond = (float)((double)(counters.txMessages - lastCounters_.txMessages) / seconds);
+        stats.txBytesPerSecond = (float)((double)(counters.txBytes - lastCounters_.txBytes) / seconds);
+        stats.rxMessagesPerSecond = (float)((double)(counters.rxMessages - lastCounters_.rxMessages) / seconds);
+        stats.rxBytesPerSecond = (float)((double)(counters.rxBytes - lastCounters_.rxBytes) / seconds);
+        if (report.cpuTimeNs >= lastChildCpuTime_)
+            stats.childCpuLoad = (float)((double)(report.cpuTimeNs - lastChildCpuTime_) / 1.0e9 / seconds);
+    }
+
+    lastCounters_ = counters;
+    lastStatsTime_ = now;
+    lastChildCpuTime_ = report.cpuTimeNs;
+
+    stats_.store(stats);
+}
+
+void ComposeProvider::updateTrimStats(const MemoryTrimReport& report)
+{
+    // Same thread as updateStats(), the only other writer
+    auto stats = stats_.load();
+    ++stats.memoryTrims;
+    stats.trimResidentBefore = report.residentBefore;
+    stats.trimResidentAfter = report.residentAfter;
+    stats.childResidentBytes = report.residentAfter;
+    stats_.store(stats);
 }
 
 #if __APPLE__
@@ -173,6 +696,11 @@ void ComposeProvider::sendSurfacePort()
         mach_port_deallocate(mach_task_self(), (mach_port_t)surfacePort);
     }
 }
+#elif __linux__
+void ComposeProvider::sendSurfaceFD()
+{
+    ipc_.sendSurface(surface_.getFD(), surface_.getWidth(), surface_.getHeight(), surface_.getStride());
+}
 #endif
 
 }  // namespace juce_cmp
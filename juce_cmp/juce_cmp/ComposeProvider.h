@@ -7,40 +7,102 @@
 #include "Surface.h"
 #include "SurfaceView.h"
 #include "Ipc.h"
+#include "Rpc.h"
 #include "MachPort.h"
+#include "Trace.h"
+#include "Stats.h"
 #include <juce_core/juce_core.h>
 #include <juce_data_structures/juce_data_structures.h>
+#include <juce_events/juce_events.h>
+#include <atomic>
 #include <cstdint>
+#include <map>
+#include <mutex>
 #include <string>
 #include <functional>
 #include <thread>
+#include <vector>
 
 namespace juce_cmp
 {
 
+class MirroredValueTree;
+
 /**
  * ComposeProvider - Orchestrates Compose UI embedding.
  *
  * Owns and coordinates: Surface, SurfaceView, ChildProcess, Ipc.
- * Core logic is C++, with platform-specific surface sharing (MachPort on macOS).
+ * Core logic is C++, with platform-specific surface sharing (MachPort on macOS,
+ * the IPC socket on Linux).
+ *
+ * If the UI process crashes or exits, it is started again: after 100 ms,
+ * doubling up to 10 s while it keeps failing. The view shows the last frame
+ * in the meantime, and the new UI gets the state kept with sendState() and
+ * the mirrored trees in one batch as soon as it connects.
+ *
+ * Memory pressure asks the UI to release what it can rebuild (see
+ * IPC_MEMORY_PRESSURE_*). Besides setMemoryPressure(), an enabled
+ * MemoryPolicy raises it while the view is hidden and when many UIs run in
+ * the host.
  */
-class ComposeProvider
+class ComposeProvider : private juce::MultiTimer,
+                        private juce::AsyncUpdater
 {
 public:
     using EventCallback = std::function<void(const juce::ValueTree&)>;
+    using EventViewCallback = std::function<void(const ValueTreeView&)>;
+    using MessageCallback = std::function<void(const TypedMessage&)>;
     using FirstFrameCallback = std::function<void()>;
+    using TraceWrittenCallback = std::function<void(bool success)>;
+
+    /** When each startup stage of the last launch or restart happened (Tracer::now() ns, 0 = not reached). */
+    struct LaunchTimes
+    {
+        int64_t constructed = 0;   // ComposeComponent created (set by ComposeComponent)
+        int64_t tryLaunch = 0;     // ComposeComponent on screen and launching (ditto)
+        int64_t launch = 0;        // launch() called, or the UI restarted
+        int64_t spawned = 0;       // Child process started
+        int64_t connected = 0;     // UI's HELLO received
+        int64_t surfaceSent = 0;   // Initial surface handed to the UI
+        int64_t surfaceReady = 0;  // First SURFACE_READY delivered to the message thread
+        int64_t firstFrame = 0;    // First frame swapped in, first frame callback about to run
+    };
+
+    /** When the provider raises memory pressure by itself; levels are IPC_MEMORY_PRESSURE_*.
+     *  Off unless enabled: a trimmed UI is slower to show again. */
+    struct MemoryPolicy
+    {
+        bool enabled = false;
+        int moderateAfterHiddenMs = 30'000;    // View hidden this long
+        int criticalAfterHiddenMs = 300'000;
+        int moderateInstances = 4;    // UIs of the same executable running in the host, any instance; 0 for no limit
+        int criticalInstances = 8;    // Applies to hidden views, visible ones stay moderate
+    };
 
     ComposeProvider();
-    ~ComposeProvider();
+    ~ComposeProvider() override;
 
     // Callbacks
     void setEventCallback(EventCallback callback) { eventCallback_ = std::move(callback); }
+    void setEventViewCallback(EventViewCallback callback) { eventViewCallback_ = std::move(callback); }
+    void setMessageCallback(MessageCallback callback) { messageCallback_ = std::move(callback); }
     void setFirstFrameCallback(FirstFrameCallback callback) { firstFrameCallback_ = std::move(callback); }
 
-    // Lifecycle
-    bool launch(const std::string& executable, int width, int height, float scale);
+    // Lifecycle - args are passed to the UI after the standard flags
+    bool launch(const std::string& executable, int width, int height, float scale,
+                const std::vector<std::string>& args = {});
     void stop();
     bool isRunning() const;
+    int getRestartCount() const { return restartCount_; }  // UI restarts since launch()
+    void setLaunchPolicy(const LaunchPolicy& policy) { policy_ = policy; }  // Before launch, kept for restarts
+    void setProcessWatcher(ProcessWatcher* watcher) { child_.setProcessWatcher(watcher); }  // Must outlive this
+
+    // Memory pressure (message thread). The UI gets the higher of the level set
+    // here, e.g. on an OS memory warning, and the policy's; only changes are sent
+    void setMemoryPolicy(const MemoryPolicy& policy);
+    void setMemoryPressure(uint8_t level);
+    uint8_t getMemoryPressure() const { return memoryPressure_.load(); }  // Last level the UI got
+    void setVisible(bool visible);  // Called by Component
 
     // View management (called by Component)
     void attachView(void* parentNativeHandle);
@@ -51,29 +113,136 @@ public:
 
     // IPC
     void sendInput(InputEvent& event);
-    void sendEvent(const juce::ValueTree& tree);
+    bool sendEvent(const juce::ValueTree& tree, uint8_t lane = IPC_LANE_CONTROL);
+    bool sendMessage(uint16_t id, const void* data, size_t size, uint8_t lane) { return ipc_.sendTyped(id, data, size, lane); }
+
+    // Like sendMessage(), and the latest message per id and key is kept and
+    // sent again to every UI that connects, restarts included (any thread)
+    bool sendState(uint16_t id, uint16_t key, const void* data, size_t size, uint8_t lane);
+    void setCompressionEnabled(bool enabled) { ipc_.setCompressionEnabled(enabled); }  // Before launch
+
+    // Request/response calls in both directions
+    Rpc& getRpc() { return rpc_; }
+
+    // ValueTree replicas in the UI, see MirroredValueTree (message thread)
+    void addMirror(MirroredValueTree* mirror);
+    void removeMirror(MirroredValueTree* mirror);
+    bool canMirror() const { return ipc_.isValid() && ipc_.hasCapability(IPC_CAP_MIRROR); }
+    bool sendMirror(const void* data, size_t size);
+
+    // Tracing - records host and UI timelines, written as Chrome trace JSON
+    void startTracing();
+    void stopTracing(const juce::File& output, TraceWrittenCallback callback = nullptr);
+
+    // Session log of every IPC message, see IpcRecorder. Set before launch(),
+    // an empty file turns it off; the log is complete after stop()
+    void setRecordingFile(const juce::File& file) { recordingFile_ = file; }
+
+    // Send a host-to-UI message from a log: resizes go through resize() and
+    // get a new surface, the handshake and trace control are left out
+    bool replay(const IpcRecording::Record& record);
+
+    // Performance numbers - lock-free, callable from any thread
+    Stats getStats() const;
+    LaunchTimes getLaunchTimes() const;  // Message thread
 
     // State
     float getScale() const { return scale_; }
 
 private:
+    bool spawn();
+    void scheduleRestart();
+    void handleAsyncUpdate() override;  // Reader thread events, see handshakePending_
+    void handleDisconnect();
+    void timerCallback(int timerID) override;
+    void updateMemoryPressure();
+    void sendRetainedState();
 #if __APPLE__
     void sendSurfacePort();
+#elif __linux__
+    void sendSurfaceFD();
 #endif
-
+    void writeTrace();
+    void updateStats(const StatsReport& report);
+    void updateTrimStats(const MemoryTrimReport& report);
+    void handleMirrorMessage(const void* data, size_t size);
+    juce::StringArray takePendingResyncs();
+    void resyncMirrors(const juce::String& name);
+
+    Tracer tracer_;  // Declared before ipc_, which records into it
+    IpcRecorder recorder_;
     Surface surface_;
     SurfaceView view_;
     ChildProcess child_;
     Ipc ipc_;
+    Rpc rpc_ { ipc_ };
 #if __APPLE__
     MachPort machPort_;
     std::thread machPortThread_;
 #endif
 
     float scale_ = 1.0f;
+    std::string executable_;
+    std::vector<std::string> args_;
+    LaunchPolicy policy_;
+
+    // Timers: restart due, memory policy check
+    enum { restartTimer, memoryTimer };
+    static constexpr int memoryCheckIntervalMs = 5000;
     EventCallback eventCallback_;
+    EventViewCallback eventViewCallback_;
+    MessageCallback messageCallback_;
     FirstFrameCallback firstFrameCallback_;
 
+    // Trace output requested by stopTracing()
+    juce::File traceFile_;
+    TraceWrittenCallback traceWrittenCallback_;
+
+    juce::File recordingFile_;
+
+    std::vector<MirroredValueTree*> mirrors_;
+
+    // Latest sendState() message bodies, by typed id << 16 | key
+    std::mutex stateLock_;
+    std::map<uint32_t, std::vector<uint8_t>> state_;
+
+    // Messages for the UI that just connected, see sendRetainedState()
+    bool batching_ = false;
+    std::vector<uint8_t> batch_;
+
+    // Set on the reader thread, handled in handleAsyncUpdate(); stop() cancels
+    // them, so nothing queued runs after the provider is gone
+    std::atomic<bool> handshakePending_ { false };
+    std::atomic<bool> disconnectPending_ { false };
+    std::mutex resyncLock_;
+    juce::StringArray pendingResyncs_;  // Mirror names asking for a resync, "" for all
+
+    // Crash recovery: the UI is gone from disconnect until the new one's first frame
+    bool stopped_ = true;  // Not launched, or stop() called: no restarts or updates
+    bool restarting_ = false;
+    int restartAttempts_ = 0;  // In a row, for the backoff
+    int restartCount_ = 0;
+
+    // Memory pressure: the policy's inputs, and the level the UI has
+    MemoryPolicy memoryPolicy_;
+    uint8_t requestedPressure_ = IPC_MEMORY_PRESSURE_NONE;
+    int64_t hiddenSince_ = 0;  // Tracer::now(), 0 while visible
+    std::atomic<uint8_t> memoryPressure_ { IPC_MEMORY_PRESSURE_NONE };
+
+    // Stats snapshot, written on the IPC reader thread
+    SeqLock<Stats> stats_;
+    Ipc::Counters lastCounters_;
+    double lastStatsTime_ = 0.0;
+    uint64_t lastChildCpuTime_ = 0;
+
+    // Startup stages, see LaunchTimes (some are written off the message thread)
+    std::atomic<int64_t> launchTime_ { 0 };
+    std::atomic<int64_t> spawnedTime_ { 0 };
+    std::atomic<int64_t> connectedTime_ { 0 };
+    std::atomic<int64_t> surfaceSentTime_ { 0 };
+    int64_t surfaceReadyTime_ = 0;
+    int64_t firstFrameTime_ = 0;
+
     // Pending view bounds (applied when new surface is ready)
     int pendingViewX_ = 0;
     int pendingViewY_ = 0;
@@ -0,0 +1,294 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "IdentifierDictionary.h"
+
+namespace juce_cmp
+{
+
+namespace
+{
+    constexpr int maxDepth = 256;  // Bounds the recursion on malformed input
+
+    void writeVarint(juce::OutputStream& out, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.writeByte(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.writeByte(static_cast<char>(value));
+    }
+
+    bool readVarint(juce::InputStream& in, uint32_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (in.isExhausted())
+                return false;
+
+            const auto byte = static_cast<uint8_t>(in.readByte());
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // A count can't exceed the bytes left, whatever the input claims
+    bool readCount(juce::InputStream& in, int& count)
+    {
+        uint32_t value = 0;
+        if (!readVarint(in, value) || static_cast<int64_t>(value) > in.getNumBytesRemaining())
+            return false;
+
+        count = static_cast<int>(value);
+        return true;
+    }
+
+    // JUCE's VariantStreamMarkers
+    enum : uint8_t
+    {
+        markerInt = 1,
+        markerBoolTrue = 2,
+        markerBoolFalse = 3,
+        markerDouble = 4,
+        markerString = 5,
+        markerInt64 = 6,
+        markerBinary = 8,
+        markerUndefined = 9
+    };
+
+    void writeValue(const juce::var& value, juce::OutputStream& out)
+    {
+        if (value.isVoid())
+        {
+            out.writeByte(static_cast<char>(IPC_DICT_VAR_VOID));
+        }
+        else if (value.isInt())
+        {
+            out.writeByte(static_cast<char>(markerInt));
+            out.writeInt(static_cast<int>(value));
+        }
+        else if (value.isBool())
+        {
+            out.writeByte(static_cast<char>(static_cast<bool>(value) ? markerBoolTrue : markerBoolFalse));
+        }
+        else if (value.isDouble())
+        {
+            out.writeByte(static_cast<char>(markerDouble));
+            out.writeDouble(static_cast<double>(value));
+        }
+        else if (value.isString())
+        {
+            out.writeByte(static_cast<char>(markerString));
+            out.writeString(value.toString());
+        }
+        else if (value.isInt64())
+        {
+            out.writeByte(static_cast<char>(markerInt64));
+            out.writeInt64(static_cast<juce::int64>(value));
+        }
+        else if (value.isBinaryData())
+        {
+            const auto* block = value.getBinaryData();
+            out.writeByte(static_cast<char>(markerBinary));
+            writeVarint(out, static_cast<uint32_t>(block->getSize()));
+            out.write(block->getData(), block->getSize());
+        }
+        else if (value.isUndefined())
+        {
+            out.writeByte(static_cast<char>(markerUndefined));
+        }
+        else
+        {
+            out.writeByte(static_cast<char>(IPC_DICT_VAR_STREAM));
+            value.writeToStream(out);
+        }
+    }
+
+    bool readValue(juce::InputStream& in, juce::var& value)
+    {
+        if (in.isExhausted())
+            return false;
+
+        switch (static_cast<uint8_t>(in.readByte()))
+        {
+            case IPC_DICT_VAR_VOID:  value = juce::var(); return true;
+            case markerInt:          value = in.readInt(); return true;
+            case markerBoolTrue:     value = true; return true;
+            case markerBoolFalse:    value = false; return true;
+            case markerDouble:       value = in.readDouble(); return true;
+            case markerString:       value = in.readString(); return true;
+            case markerInt64:        value = in.readInt64(); return true;
+            case markerUndefined:    value = juce::var::undefined(); return true;
+            case IPC_DICT_VAR_STREAM: value = juce::var::readFromStream(in); return true;
+
+            case markerBinary:
+            {
+                int size = 0;
+                if (!readCount(in, size))
+                    return false;
+
+                juce::MemoryBlock block(static_cast<size_t>(size));
+                if (in.read(block.getData(), size) != size)
+                    return false;
+
+                value = block;
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
+}
+
+// =============================================================================
+// IdentifierEncoder
+// =============================================================================
+
+void IdentifierEncoder::writeTree(const juce::ValueTree& tree, juce::OutputStream& out)
+{
+    writeIdentifier(tree.getType(), out);
+
+    const int numProperties = tree.getNumProperties();
+    writeVarint(out, static_cast<uint32_t>(numProperties));
+    for (int i = 0; i < numProperties; ++i)
+    {
+        const auto name = tree.getPropertyName(i);
+        writeIdentifier(name, out);
+        writeValue(tree.getProperty(name), out);
+    }
+
+    const int numChildren = tree.getNumChildren();
+    writeVarint(out, static_cast<uint32_t>(numChildren));
+    for (int i = 0; i < numChildren; ++i)
+        writeTree(tree.getChild(i), out);
+}
+
+void IdentifierEncoder::writeIdentifier(const juce::Identifier& name, juce::OutputStream& out)
+{
+    const void* key = name.getCharPointer().getAddress();
+
+    auto it = tokens_.find(key);
+    if (it != tokens_.end())
+    {
+        writeVarint(out, IPC_DICT_FIRST_TOKEN + it->second);
+        return;
+    }
+
+    if (entries_.size() < IPC_DICT_MAX_ENTRIES)
+    {
+        tokens_.emplace(key, static_cast<uint32_t>(entries_.size()));
+        entries_.push_back(name);
+        writeVarint(out, IPC_DICT_DEFINE);
+    }
+    else
+    {
+        writeVarint(out, IPC_DICT_LITERAL);
+    }
+
+    out.writeString(name.toString());
+}
+
+void IdentifierEncoder::truncate(size_t size)
+{
+    while (entries_.size() > size)
+    {
+        tokens_.erase(entries_.back().getCharPointer().getAddress());
+        entries_.pop_back();
+    }
+}
+
+// =============================================================================
+// IdentifierDecoder
+// =============================================================================
+
+juce::ValueTree IdentifierDecoder::readTree(juce::InputStream& in)
+{
+    return readTree(in, 0);
+}
+
+juce::ValueTree IdentifierDecoder::readTree(juce::InputStream& in, int depth)
+{
+    juce::Identifier type;
+    if (depth > maxDepth || !readIdentifier(in, type) || !type.isValid())
+        return {};
+
+    juce::ValueTree tree(type);
+
+    int numProperties = 0;
+    if (!readCount(in, numProperties))
+        return {};
+
+    for (int i = 0; i < numProperties; ++i)
+    {
+        juce::Identifier name;
+        juce::var value;
+        if (!readIdentifier(in, name) || !name.isValid() || !readValue(in, value))
+            return {};
+
+        tree.setProperty(name, value, nullptr);
+    }
+
+    int numChildren = 0;
+    if (!readCount(in, numChildren))
+        return {};
+
+    for (int i = 0; i < numChildren; ++i)
+    {
+        auto child = readTree(in, depth + 1);
+        if (!child.isValid())
+            return {};
+
+        tree.appendChild(child, nullptr);
+    }
+
+    return tree;
+}
+
+bool IdentifierDecoder::readIdentifier(juce::InputStream& in, juce::Identifier& name)
+{
+    uint32_t reference = 0;
+    if (!readVarint(in, reference))
+        return false;
+
+    if (reference >= IPC_DICT_FIRST_TOKEN)
+    {
+        const auto* entry = lookup(reference - IPC_DICT_FIRST_TOKEN);
+        if (entry == nullptr)
+            return false;  // Out of step with the encoder
+
+        name = *entry;
+        return true;
+    }
+
+    const auto string = in.readString();
+    if (string.isEmpty())
+        return false;
+
+    name = juce::Identifier(string);
+    return reference != IPC_DICT_DEFINE || define(name);
+}
+
+bool IdentifierDecoder::define(const juce::Identifier& name)
+{
+    const auto size = size_.load(std::memory_order_relaxed);
+    if (size >= IPC_DICT_MAX_ENTRIES)
+        return false;
+
+    entries_[size] = name;
+    size_.store(size + 1, std::memory_order_release);
+    return true;
+}
+
+void IdentifierDecoder::reset()
+{
+    const auto size = size_.exchange(0);
+    for (size_t i = 0; i < size; ++i)
+        entries_[i] = {};
+}
+
+}  // namespace juce_cmp
@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "ipc_protocol.h"
+
+namespace juce_cmp
+{
+
+/**
+ * IdentifierEncoder - Writes ValueTrees in the compact IPC_CODEC_DICT format.
+ *
+ * Same layout as ValueTree::writeToStream, but the type and property names
+ * are tokens from a per-connection dictionary: the first use of a name sends
+ * the string and assigns it the next token, later uses send only the token
+ * (one byte for the first 128 names). Counts are 7-bit varints and values
+ * drop their size prefix, so {"param", id: 0, value: 0.5} takes 19 bytes
+ * instead of 36.
+ *
+ * Each direction has one encoder and one decoder, which must see the same
+ * messages in the same order; see EVENT_FLAG_INTERNED. Not thread-safe.
+ */
+class IdentifierEncoder
+{
+public:
+    void writeTree(const juce::ValueTree& tree, juce::OutputStream& out);
+
+    /** Number of names defined so far. */
+    size_t getSize() const { return entries_.size(); }
+
+    /** Forget names defined after the first size, e.g. of a message that was never sent. */
+    void truncate(size_t size);
+
+    void reset() { truncate(0); }
+
+private:
+    void writeIdentifier(const juce::Identifier& name, juce::OutputStream& out);
+
+    // Identifiers share one pooled string per name, so its address is the key
+    std::unordered_map<const void*, uint32_t> tokens_;
+    std::vector<juce::Identifier> entries_;  // Keeps the pooled strings alive
+};
+
+/**
+ * IdentifierDecoder - Reads what IdentifierEncoder writes.
+ *
+ * Known names come back as the Identifier created on first use, so decoding
+ * a repeated message makes no string lookups or allocations for its names.
+ *
+ * Names are added by one thread; lookup() is safe from others meanwhile,
+ * which lets a ValueTreeView be read on the message thread.
+ */
+class IdentifierDecoder
+{
+public:
+    IdentifierDecoder() : entries_(new juce::Identifier[IPC_DICT_MAX_ENTRIES]) {}
+
+    /** Returns an invalid tree for malformed input. */
+    juce::ValueTree readTree(juce::InputStream& in);
+
+    /** The name for a token, null if it isn't defined (yet). */
+    const juce::Identifier* lookup(uint32_t token) const noexcept
+    {
+        return token < size_.load(std::memory_order_acquire) ? &entries_[token] : nullptr;
+    }
+
+    /** Give name the next token (IPC_DICT_DEFINE). Returns false if the dictionary is full. */
+    bool define(const juce::Identifier& name);
+
+    void reset();
+
+private:
+    juce::ValueTree readTree(juce::InputStream& in, int depth);
+    bool readIdentifier(juce::InputStream& in, juce::Identifier& name);
+
+    // Fixed storage, so entries never move under a reader on another thread
+    std::unique_ptr<juce::Identifier[]> entries_;
+    std::atomic<size_t> size_ { 0 };
+};
+
+}  // namespace juce_cmp
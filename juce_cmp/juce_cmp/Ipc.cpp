@@ -3,28 +3,80 @@
 
 #include "Ipc.h"
 
+#include <cstring>
+#include <vector>
+
 #if JUCE_MAC || JUCE_LINUX
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
 #endif
 
 namespace juce_cmp
 {
 
+#if JUCE_LINUX
+// A UI that crashed must not take the host down with SIGPIPE; on macOS the
+// socket itself is set up for that in setSocketFD()
+constexpr int sendFlags = MSG_NOSIGNAL;
+#elif JUCE_MAC
+constexpr int sendFlags = 0;
+#endif
+
 Ipc::Ipc() = default;
 
 Ipc::~Ipc()
 {
     stop();
+    cancelPendingUpdate();
 }
 
 void Ipc::setSocketFD(int fd)
 {
     socketFD = fd;
+#if JUCE_MAC
+    // No MSG_NOSIGNAL here; a crashed UI gets EPIPE instead of SIGPIPE
+    if (fd >= 0)
+    {
+        const int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+    }
+#endif
+    disconnected.store(false);
+    txAtBoundary = true;
+
+    // Nothing is agreed with a new UI until its HELLO
+    version.store(0);
+    capabilities.store(0);
+    transports.store(IPC_TRANSPORT_SOCKET);
+    codecs.store(IPC_CODEC_RAW);
+    maxMessageSize.store(IPC_MAX_MESSAGE_SIZE);
+
+    // A message cut off with the previous connection never completes
+    for (auto& chunks : rxChunks)
+        chunks.clear();
+    for (auto& discarding : rxDiscarding)
+        discarding = false;
+
+    // A new connection starts with empty dictionaries on both sides
+    {
+        std::lock_guard<std::mutex> lock(dictionaryLock);
+        txDictionary.reset();
+    }
+    rxDictionary.reset();
+
+    // Queued views refer to the old dictionary
+    {
+        std::lock_guard<std::mutex> lock(inboxLock);
+        inbox.clear();
+        inboxBytes.clear();
+    }
+
 #if JUCE_MAC || JUCE_LINUX
-    // Set non-blocking mode to prevent UI thread stalls
+    // Non-blocking so the reader and writer threads can poll the running flag
     if (fd >= 0)
     {
         int flags = fcntl(fd, F_GETFL, 0);
@@ -37,25 +89,49 @@ void Ipc::setSocketFD(int fd)
 void Ipc::startReceiving()
 {
     if (running.load()) return;
-    if (socketFD < 0) return;
+    if (!isConnected()) return;
 
     running.store(true);
     readerThread = std::thread([this]() { readerLoop(); });
+    writerThread = std::thread([this]() { writerLoop(); });
 }
 
-void Ipc::stop()
+void Ipc::stop(bool shutdown)
 {
-    running.store(false);
+    {
+        std::lock_guard<std::mutex> lock(txLock);
+        running.store(false);
+    }
+    txReady.notify_all();
 
     if (readerThread.joinable())
         readerThread.join();
+    if (writerThread.joinable())
+        writerThread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(txLock);
+        for (auto& queue : txQueues)
+            queue.clear();
+        txQueuedBytes.store(0);
+    }
 
 #if JUCE_MAC || JUCE_LINUX
     if (socketFD >= 0)
     {
+        // Two bytes into the socket buffer or nothing; never waits on the UI
+        if (shutdown && txAtBoundary && !disconnected.load() && hasCapability(IPC_CAP_SHUTDOWN))
+        {
+            const uint8_t message[2] = { EVENT_TYPE_CMP, CMP_EVENT_SHUTDOWN };
+            if (send(socketFD, message, sizeof(message), sendFlags) == static_cast<ssize_t>(sizeof(message)))
+                countSent(IPC_LANE_CONTROL, sizeof(message), true);
+        }
+
         close(socketFD);
         socketFD = -1;
     }
+#else
+    (void)shutdown;
 #endif
 }
 
@@ -65,34 +141,527 @@ void Ipc::stop()
 
 void Ipc::sendInput(InputEvent& event)
 {
-    if (socketFD < 0) return;
+    auto message = txBuffers.acquire(1 + sizeof(InputEvent));
+    message[0] = EVENT_TYPE_INPUT;
+    std::memcpy(message.data() + 1, &event, sizeof(InputEvent));
+    enqueue(IPC_LANE_INPUT, std::move(message));
+}
 
-#if JUCE_MAC || JUCE_LINUX
-    uint8_t prefix = EVENT_TYPE_INPUT;
-    if (!writeNonBlocking(&prefix, 1))
-        return;
-    writeNonBlocking(&event, sizeof(InputEvent));
-#endif
+bool Ipc::sendEvent(const juce::ValueTree& tree, uint8_t lane)
+{
+    if (!isConnected()) { countDropped(); return false; }
+    if (lane >= IPC_LANE_COUNT) lane = IPC_LANE_BULK;
+
+    return sendTree(EVENT_TYPE_JUCE, nullptr, 0, tree, lane);
 }
 
-void Ipc::sendEvent(const juce::ValueTree& tree)
+bool Ipc::sendRpc(uint8_t kind, uint32_t id, uint32_t timeoutMs, const juce::ValueTree& tree, uint8_t lane)
 {
-    if (socketFD < 0) return;
+    if (!hasCapability(IPC_CAP_RPC)) return false;
+    if (!isConnected()) { countDropped(); return false; }
+    if (lane >= IPC_LANE_COUNT) lane = IPC_LANE_BULK;
 
-    juce::MemoryOutputStream stream;
-    tree.writeToStream(stream);
+    RpcHeader header = {};
+    header.kind = kind;
+    header.id = id;
+    header.timeoutMs = timeoutMs;
 
-    const void* data = stream.getData();
-    uint32_t dataSize = static_cast<uint32_t>(stream.getDataSize());
+    return sendTree(EVENT_TYPE_RPC, &header, sizeof(header), tree, lane);
+}
 
-#if JUCE_MAC || JUCE_LINUX
-    uint8_t prefix = EVENT_TYPE_JUCE;
-    if (!writeNonBlocking(&prefix, 1))
-        return;
-    if (!writeNonBlocking(&dataSize, 4))
+bool Ipc::sendTree(uint8_t eventType, const void* header, size_t headerSize, const juce::ValueTree& tree, uint8_t lane)
+{
+    // Encoded straight into the queued buffer, after room for the header sendPayload() fills in
+    auto message = txBuffers.acquire(5);
+    BufferOutputStream stream(message);
+    if (headerSize > 0)
+        stream.write(header, headerSize);
+
+    // Interning relies on the order within a lane, and only bulk may drop messages
+    if (lane == IPC_LANE_CONTROL && (codecs.load() & IPC_CODEC_DICT) != 0)
+    {
+        // Encoded and queued in one go, so names are defined in the order the UI reads them
+        std::lock_guard<std::mutex> lock(dictionaryLock);
+        const auto defined = txDictionary.getSize();
+
+        if (tree.isValid())
+            txDictionary.writeTree(tree, stream);
+
+        if (sendPayload(static_cast<uint8_t>(eventType | EVENT_FLAG_INTERNED), std::move(message), lane))
+            return true;
+
+        // The UI never sees the names this message defined
+        txDictionary.truncate(defined);
+        return false;
+    }
+
+    if (tree.isValid())
+        tree.writeToStream(stream);
+
+    return sendPayload(eventType, std::move(message), lane);
+}
+
+bool Ipc::sendMirror(const void* data, size_t size)
+{
+    if (!hasCapability(IPC_CAP_MIRROR)) return false;
+    if (!isConnected()) { countDropped(); return false; }
+
+    auto message = txBuffers.acquire(5 + size);
+    std::memcpy(message.data() + 5, data, size);
+    return sendPayload(EVENT_TYPE_MIRROR, std::move(message), IPC_LANE_CONTROL);
+}
+
+bool Ipc::sendTyped(uint16_t id, const void* data, size_t size, uint8_t lane)
+{
+    if (!hasCapability(IPC_CAP_TYPED) || size > IPC_TYPED_MAX_SIZE) return false;
+    if (!isConnected()) { countDropped(); return false; }
+    if (lane >= IPC_LANE_COUNT) lane = IPC_LANE_BULK;
+
+    // Small by design: no blob, compression or chunking to consider
+    const auto bodySize = static_cast<uint16_t>(size);
+    auto message = txBuffers.acquire(5 + size);
+    message[0] = EVENT_TYPE_TYPED;
+    std::memcpy(message.data() + 1, &id, 2);
+    std::memcpy(message.data() + 3, &bodySize, 2);
+    if (size > 0)
+        std::memcpy(message.data() + 5, data, size);
+    return enqueue(lane, std::move(message));
+}
+
+bool Ipc::sendPayload(uint8_t eventType, std::vector<uint8_t> message, uint8_t lane)
+{
+    const uint8_t* data = message.data() + 5;
+    const auto dataSize = static_cast<uint32_t>(message.size() - 5);
+
+    // Large payloads go through shared memory, only a handle uses the socket
+    if (dataSize >= IPC_BLOB_THRESHOLD && (transports.load() & IPC_TRANSPORT_BLOB) != 0)
+    {
+        if (sendBlob(eventType, data, dataSize, lane))
+        {
+            txBuffers.release(std::move(message));
+            return true;
+        }
+    }
+
+    // The UI would drop it anyway; don't block the socket with it
+    if (dataSize > maxMessageSize.load())
+    {
+        countDropped();
+        txBuffers.release(std::move(message));
+        return false;
+    }
+
+    if (dataSize >= IPC_COMPRESS_THRESHOLD && (codecs.load() & IPC_CODEC_LZ4) != 0)
+    {
+        if (sendCompressed(eventType, data, dataSize, lane))
+        {
+            txBuffers.release(std::move(message));
+            return true;
+        }
+    }
+
+    // Sent as built, the header goes in the room left for it
+    message[0] = eventType;
+    std::memcpy(message.data() + 1, &dataSize, 4);
+    return enqueue(lane, std::move(message));
+}
+
+bool Ipc::sendCompressed(uint8_t eventType, const void* data, uint32_t dataSize, uint8_t lane)
+{
+    constexpr size_t headerSize = 9;
+    auto message = txBuffers.acquire(headerSize + Lz4Compressor::maxCompressedSize(dataSize));
+
+    size_t compressedSize = 0;
+    {
+        // Shared context, reused across messages
+        std::lock_guard<std::mutex> lock(compressLock);
+        compressedSize = txCompressor.compress(static_cast<const uint8_t*>(data), dataSize,
+                                               message.data() + headerSize, message.size() - headerSize);
+    }
+
+    // Not worth it, send raw
+    if (compressedSize == 0 || compressedSize >= dataSize)
+    {
+        txBuffers.release(std::move(message));
+        return false;
+    }
+
+    const auto size = static_cast<uint32_t>(compressedSize);
+    message[0] = eventType | EVENT_FLAG_COMPRESSED;
+    std::memcpy(message.data() + 1, &size, 4);
+    std::memcpy(message.data() + 5, &dataSize, 4);
+    message.resize(headerSize + compressedSize);
+    enqueue(lane, std::move(message));
+    return true;
+}
+
+void Ipc::sendClockSync()
+{
+    if (!hasCapability(IPC_CAP_TRACE)) return;
+
+    // Stamped when queued; the queueing delay ends up in the round trip,
+    // which the shortest-round-trip filter in Tracer tolerates
+    auto message = txBuffers.acquire(10);
+    message[0] = EVENT_TYPE_CMP;
+    message[1] = CMP_EVENT_CLOCK_SYNC;
+    int64_t hostTime = Tracer::now();
+    std::memcpy(message.data() + 2, &hostTime, sizeof(hostTime));
+    enqueue(IPC_LANE_CONTROL, std::move(message));
+}
+
+void Ipc::sendTraceControl(bool enable)
+{
+    if (!hasCapability(IPC_CAP_TRACE)) return;
+
+    auto message = txBuffers.acquire(3);
+    message[0] = EVENT_TYPE_CMP;
+    message[1] = CMP_EVENT_TRACE_CONTROL;
+    message[2] = static_cast<uint8_t>(enable ? 1 : 0);
+    enqueue(IPC_LANE_CONTROL, std::move(message));
+}
+
+bool Ipc::sendMemoryPressure(uint8_t level)
+{
+    if (!hasCapability(IPC_CAP_MEMORY)) return false;
+
+    auto message = txBuffers.acquire(3);
+    message[0] = EVENT_TYPE_CMP;
+    message[1] = CMP_EVENT_MEMORY_PRESSURE;
+    message[2] = level;
+    return enqueue(IPC_LANE_CONTROL, std::move(message));
+}
+
+bool Ipc::sendSurface(int fd, int width, int height, int stride)
+{
+    if ((transports.load() & IPC_TRANSPORT_SURFACE_FD) == 0) return false;
+    if (!isConnected()) { countDropped(); return false; }
+
+    auto descriptor = SharedBlob::share(fd);
+    if (!descriptor.isValid())
+        return false;
+
+    auto message = txBuffers.acquire(14);
+    message[0] = EVENT_TYPE_CMP;
+    message[1] = CMP_EVENT_SURFACE;
+    const uint32_t dimensions[3] = { static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+                                     static_cast<uint32_t>(stride) };
+    std::memcpy(message.data() + 2, dimensions, sizeof(dimensions));
+
+    // Control lane, so it can't overtake the resize input event before it
+    return enqueue(IPC_LANE_CONTROL, std::move(message), std::move(descriptor));
+}
+
+bool Ipc::sendBlob(uint8_t eventType, const void* data, size_t size, uint8_t lane)
+{
+    if (size > IPC_MAX_BLOB_SIZE)
+        return false;
+
+    auto blob = SharedBlob::create(data, size);
+    if (!blob.isValid())
+        return false;  // Caller falls back to inline
+
+    auto message = txBuffers.acquire(10);
+    message[0] = EVENT_TYPE_BLOB;
+    message[1] = eventType;
+    const uint64_t blobSize = size;
+    std::memcpy(message.data() + 2, &blobSize, sizeof(blobSize));
+
+    // Our descriptor closes when the frame is written; the UI holds its own
+    enqueue(lane, std::move(message), std::move(blob), data, size);
+    return true;
+}
+
+void Ipc::sendHello(const Protocol& agreed)
+{
+    HelloMessage hello = {};
+    hello.magic = IPC_HELLO_MAGIC;
+    hello.version = agreed.version;
+    hello.capabilities = agreed.capabilities;
+    hello.transports = agreed.transports;
+    hello.codecs = agreed.codecs;
+    hello.maxMessageSize = agreed.maxMessageSize;
+
+    auto message = txBuffers.acquire(2 + sizeof(HelloMessage));
+    message[0] = EVENT_TYPE_CMP;
+    message[1] = CMP_EVENT_HELLO;
+    std::memcpy(message.data() + 2, &hello, sizeof(hello));
+    enqueue(IPC_LANE_CONTROL, std::move(message));
+}
+
+bool Ipc::sendEncoded(const void* data, size_t size, uint8_t lane, const void* blob, size_t blobSize)
+{
+    if (!isConnected() || size == 0) { countDropped(); return false; }
+    if (lane >= IPC_LANE_COUNT) lane = IPC_LANE_BULK;
+
+    SharedBlob descriptor;
+    if (blob != nullptr)
+    {
+        descriptor = SharedBlob::create(blob, blobSize);
+        if (!descriptor.isValid())
+            return false;
+    }
+
+    auto message = txBuffers.acquire(size);
+    std::memcpy(message.data(), data, size);
+    return enqueue(lane, std::move(message), std::move(descriptor), blob, blobSize);
+}
+
+bool Ipc::sendBatch(const std::vector<uint8_t>& batch)
+{
+    if (!hasCapability(IPC_CAP_BATCH) || batch.empty() || batch.size() > maxMessageSize.load()) return false;
+    if (!isConnected()) { countDropped(); return false; }
+
+    // Inline only: a batch may be chunked but never goes as a blob or compressed
+    const auto size = static_cast<uint32_t>(batch.size());
+    auto message = txBuffers.acquire(5 + batch.size());
+    message[0] = EVENT_TYPE_BATCH;
+    std::memcpy(message.data() + 1, &size, 4);
+    std::memcpy(message.data() + 5, batch.data(), batch.size());
+    return enqueue(IPC_LANE_CONTROL, std::move(message));
+}
+
+void Ipc::addTypedToBatch(std::vector<uint8_t>& batch, uint16_t id, const void* data, size_t size)
+{
+    jassert(size <= IPC_TYPED_MAX_SIZE);
+
+    // Same bytes as sendTyped(), after the message size
+    const auto messageSize = static_cast<uint32_t>(5 + size);
+    const auto bodySize = static_cast<uint16_t>(size);
+    const auto offset = batch.size();
+    batch.resize(offset + 4 + messageSize);
+    auto* p = batch.data() + offset;
+    std::memcpy(p, &messageSize, 4);
+    p[4] = EVENT_TYPE_TYPED;
+    std::memcpy(p + 5, &id, 2);
+    std::memcpy(p + 7, &bodySize, 2);
+    if (size > 0)
+        std::memcpy(p + 9, data, size);
+}
+
+void Ipc::addMirrorToBatch(std::vector<uint8_t>& batch, const void* data, size_t size)
+{
+    // Same bytes as an uncompressed sendMirror(), after the message size
+    const auto messageSize = static_cast<uint32_t>(5 + size);
+    const auto payloadSize = static_cast<uint32_t>(size);
+    const auto offset = batch.size();
+    batch.resize(offset + 4 + messageSize);
+    auto* p = batch.data() + offset;
+    std::memcpy(p, &messageSize, 4);
+    p[4] = EVENT_TYPE_MIRROR;
+    std::memcpy(p + 5, &payloadSize, 4);
+    if (size > 0)
+        std::memcpy(p + 9, data, size);
+}
+
+bool Ipc::enqueue(uint8_t lane, std::vector<uint8_t> data, SharedBlob blob, const void* blobData, size_t blobSize)
+{
+    const size_t size = data.size();
+
+    // Bulk may be dropped under backlog; input and control always get through
+    if (!isConnected() || (lane == IPC_LANE_BULK && txQueuedBytes.load() + size > maxQueuedBytes))
+    {
+        countDropped();
+        txBuffers.release(std::move(data));
+        return false;
+    }
+
+    // Decided now rather than when written, so nothing queued before the
+    // HELLO reply is chunked
+    const bool chunked = size > IPC_CHUNK_SIZE && !blob.isValid() && hasCapability(IPC_CAP_CHUNKS);
+
+    {
+        std::lock_guard<std::mutex> lock(txLock);
+
+        if (txSpareFrames.empty())
+            txSpareFrames.emplace_back();
+
+        auto& queue = txQueues[lane];
+        queue.splice(queue.end(), txSpareFrames, txSpareFrames.begin());
+
+        auto& frame = queue.back();
+        frame.data = std::move(data);
+        frame.blob = std::move(blob);
+        frame.offset = 0;
+        frame.chunked = chunked;
+        txQueuedBytes.fetch_add(size);
+
+        // In queue order, which is the order within each lane on the wire
+        if (recorder != nullptr && recorder->isRecording())
+        {
+            const auto attachment = !frame.blob.isValid() ? IpcRecorder::Attachment::none
+                                  : blobData != nullptr   ? IpcRecorder::Attachment::blob
+                                                          : IpcRecorder::Attachment::surface;
+            recorder->record(IpcRecorder::Direction::toUi, lane, frame.data.data(), size, attachment, blobData, blobSize);
+        }
+    }
+    txReady.notify_one();
+    return true;
+}
+
+void Ipc::writerLoop()
+{
+    if (tracer != nullptr)
+        tracer->setCurrentThreadName("Ipc writer");
+
+    std::unique_lock<std::mutex> lock(txLock);
+
+    while (running.load())
+    {
+        txReady.wait(lock, [this]() {
+            if (!running.load())
+                return true;
+            for (const auto& queue : txQueues)
+                if (!queue.empty())
+                    return true;
+            return false;
+        });
+
+        if (!running.load())
+            break;
+
+        // Highest-priority lane with something to send
+        uint8_t lane = 0;
+        while (txQueues[lane].empty())
+            ++lane;
+
+        // Only this thread pops, so the front frame stays put while unlocked
+        auto& frame = txQueues[lane].front();
+        lock.unlock();
+        txAtBoundary = false;
+        const bool ok = writeFrame(lane, frame);
+        txAtBoundary = ok;
+        lock.lock();
+
+        if (!ok)
+        {
+            // Socket is gone; everything still queued is lost
+            for (auto& queue : txQueues)
+            {
+                for (size_t i = 0; i < queue.size(); ++i)
+                    countDropped();
+                queue.clear();
+            }
+            txQueuedBytes.store(0);
+            break;
+        }
+
+        if (frame.offset == frame.data.size())
+        {
+            txQueuedBytes.fetch_sub(frame.data.size());
+            txBuffers.release(std::move(frame.data));
+            txSpareFrames.splice(txSpareFrames.end(), txQueues[lane], txQueues[lane].begin());
+        }
+    }
+}
+
+bool Ipc::writeFrame(uint8_t lane, Frame& frame)
+{
+    const size_t size = frame.data.size();
+
+    if (!frame.chunked)
+    {
+        TraceScope trace(tracer, TRACE_NAME_IPC_SEND, static_cast<uint32_t>(size));
+
+        const bool ok = frame.blob.isValid()
+            ? writeWithDescriptor(frame.data.data(), size, frame.blob.getFD())
+            : writeBlocking(frame.data.data(), size);
+        if (!ok)
+            return false;
+
+        frame.offset = size;
+        frame.blob.release();
+        countSent(lane, size, true);
+        return true;
+    }
+
+    // One chunk, then back to the loop so higher lanes can go first
+    const size_t length = juce::jmin<size_t>(IPC_CHUNK_SIZE, size - frame.offset);
+    uint8_t flags = 0;
+    if (frame.offset == 0) flags |= IPC_CHUNK_FIRST;
+    if (frame.offset + length == size) flags |= IPC_CHUNK_LAST;
+
+    uint8_t header[5] = { EVENT_TYPE_CHUNK, lane, flags };
+    const uint16_t length16 = static_cast<uint16_t>(length);
+    std::memcpy(header + 3, &length16, sizeof(length16));
+
+    TraceScope trace(tracer, TRACE_NAME_IPC_SEND, static_cast<uint32_t>(sizeof(header) + length));
+
+    if (!writeBlocking(header, sizeof(header)) || !writeBlocking(frame.data.data() + frame.offset, length))
+        return false;
+
+    frame.offset += length;
+    countSent(lane, sizeof(header) + length, frame.offset == size);
+    return true;
+}
+
+void Ipc::countSent(uint8_t lane, size_t size, bool messageDone)
+{
+    if (messageDone)
+        txMessages.fetch_add(1, std::memory_order_relaxed);
+    txBytes.fetch_add(size, std::memory_order_relaxed);
+    txLaneBytes[lane].fetch_add(size, std::memory_order_relaxed);
+}
+
+void Ipc::countDropped()
+{
+    // Only count while connected, not before launch or after stop()
+    if (running.load(std::memory_order_relaxed))
+        txDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Ipc::disconnect()
+{
+    // The reader and writer may both find out; stop() closes the socket
+    if (disconnected.exchange(true) || !running.load())
         return;
-    writeNonBlocking(data, dataSize);
+
+    if (onDisconnect)
+        onDisconnect();
+}
+
+Ipc::Protocol Ipc::getProtocol() const
+{
+    Protocol p;
+    p.version = version.load();
+    p.capabilities = capabilities.load();
+    p.transports = transports.load();
+    p.codecs = codecs.load();
+    p.maxMessageSize = maxMessageSize.load();
+    return p;
+}
+
+Ipc::Counters Ipc::getCounters() const
+{
+    Counters c;
+    c.txMessages = txMessages.load(std::memory_order_relaxed);
+    c.txBytes = txBytes.load(std::memory_order_relaxed);
+    c.rxMessages = rxMessages.load(std::memory_order_relaxed);
+    c.rxBytes = rxBytes.load(std::memory_order_relaxed);
+    c.txDropped = txDropped.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < IPC_LANE_COUNT; ++i)
+        c.txLaneBytes[i] = txLaneBytes[i].load(std::memory_order_relaxed);
+    return c;
+}
+
+size_t Ipc::getPendingTxBytes() const
+{
+    // Queued here plus waiting in the socket send buffer
+    size_t pending = txQueuedBytes.load();
+
+    const int fd = socketFD;
+    if (fd < 0) return pending;
+
+#if JUCE_MAC
+    int socketPending = 0;
+    socklen_t length = sizeof(socketPending);
+    if (getsockopt(fd, SOL_SOCKET, SO_NWRITE, &socketPending, &length) == 0 && socketPending > 0)
+        pending += static_cast<size_t>(socketPending);
+#elif JUCE_LINUX
+    int socketPending = 0;
+    if (ioctl(fd, TIOCOUTQ, &socketPending) == 0 && socketPending > 0)
+        pending += static_cast<size_t>(socketPending);
 #endif
+    return pending;
 }
 
 // =============================================================================
@@ -101,69 +670,514 @@ void Ipc::sendEvent(const juce::ValueTree& tree)
 
 void Ipc::readerLoop()
 {
+    if (tracer != nullptr)
+        tracer->setCurrentThreadName("Ipc reader");
+
     while (running.load())
     {
         uint8_t eventType = 0;
-        if (readFully(&eventType, 1) != 1)
+        int fd = -1;
+        if (!readEventType(eventType, fd))
+        {
+            disconnect();
             break;
+        }
 
-        switch (eventType)
+        const bool hadDescriptor = fd >= 0;
+        dispatchMessage(eventType, fd);
+
+        // Chunks are logged one by one, as they came
+        if (!rxRecord.empty())
         {
-            case EVENT_TYPE_CMP:
-                handleCmpEvent();
-                break;
-            case EVENT_TYPE_JUCE:
-                handleJuceEvent();
-                break;
-            default:
-                break;
+            recorder->record(IpcRecorder::Direction::fromUi, 0, rxRecord.data(), rxRecord.size(),
+                             hadDescriptor ? IpcRecorder::Attachment::descriptor : IpcRecorder::Attachment::none);
+            rxRecord.clear();
         }
     }
 }
 
+void Ipc::dispatchMessage(uint8_t eventType, int fd)
+{
+    if (eventType != EVENT_TYPE_CHUNK)
+        rxMessages.fetch_add(1, std::memory_order_relaxed);
+
+    switch (eventType)
+    {
+        case EVENT_TYPE_CMP:
+            handleCmpEvent();
+            break;
+        case EVENT_TYPE_JUCE:
+        case EVENT_TYPE_RPC:
+        case EVENT_TYPE_MIRROR:
+        case EVENT_TYPE_JUCE | EVENT_FLAG_INTERNED:
+        case EVENT_TYPE_RPC | EVENT_FLAG_INTERNED:
+            handlePayloadEvent(eventType);
+            break;
+        case EVENT_TYPE_JUCE | EVENT_FLAG_COMPRESSED:
+        case EVENT_TYPE_RPC | EVENT_FLAG_COMPRESSED:
+        case EVENT_TYPE_MIRROR | EVENT_FLAG_COMPRESSED:
+        case EVENT_TYPE_JUCE | EVENT_FLAG_INTERNED | EVENT_FLAG_COMPRESSED:
+        case EVENT_TYPE_RPC | EVENT_FLAG_INTERNED | EVENT_FLAG_COMPRESSED:
+            handleCompressedEvent(static_cast<uint8_t>(eventType & ~EVENT_FLAG_COMPRESSED));
+            break;
+        case EVENT_TYPE_BLOB:
+            handleBlobEvent(fd);
+            fd = -1;
+            break;
+        case EVENT_TYPE_TYPED:
+            handleTypedEvent();
+            break;
+        case EVENT_TYPE_CHUNK:
+            // Chunks never nest
+            if (replayData == nullptr)
+                handleChunk();
+            break;
+        default:
+            break;
+    }
+
+#if JUCE_MAC || JUCE_LINUX
+    // Descriptor attached to a message that doesn't take one
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
 void Ipc::handleCmpEvent()
 {
     uint8_t subtype = 0;
     if (readFully(&subtype, 1) != 1)
         return;
 
-    if (subtype == CMP_EVENT_SURFACE_READY && onFrameReady)
+    switch (subtype)
     {
-        juce::MessageManager::callAsync([this]() {
+        case CMP_EVENT_SURFACE_READY:
+            if (tracer != nullptr)
+                tracer->instant(TRACE_NAME_SURFACE_READY);
             if (onFrameReady)
-                onFrameReady();
-        });
+                post(Delivery::Kind::frameReady);
+            break;
+        case CMP_EVENT_CLOCK_SYNC:
+            handleClockSync();
+            break;
+        case CMP_EVENT_TRACE_DATA:
+            handleTraceData();
+            break;
+        case CMP_EVENT_STATS:
+            handleStats();
+            break;
+        case CMP_EVENT_MEMORY_TRIMMED:
+            handleMemoryTrimmed();
+            break;
+        case CMP_EVENT_HELLO:
+            handleHello();
+            break;
+        default:
+            break;
     }
 }
 
-void Ipc::handleJuceEvent()
+void Ipc::handleClockSync()
+{
+    int64_t times[2] = {};  // Echoed host time, UI time
+    if (readFully(times, sizeof(times)) != static_cast<ssize_t>(sizeof(times)))
+        return;
+
+    if (tracer != nullptr)
+        tracer->addClockSample(times[0], times[1], Tracer::now());
+}
+
+void Ipc::handleTraceData()
+{
+    uint8_t header[5] = {};  // Final flag + record count
+    if (readFully(header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)))
+        return;
+
+    const bool isFinal = header[0] != 0;
+    uint32_t count = 0;
+    std::memcpy(&count, header + 1, sizeof(count));
+
+    if (count > 65536)
+        return;
+
+    std::vector<TraceRecord> records(count);
+    const auto size = static_cast<ssize_t>(count * sizeof(TraceRecord));
+    if (count > 0 && readFully(records.data(), static_cast<size_t>(size)) != size)
+        return;
+
+    if (tracer != nullptr)
+        tracer->addRemoteRecords(records.data(), records.size());
+
+    if (isFinal && onTraceFinished)
+        post(Delivery::Kind::traceFinished);
+}
+
+void Ipc::handleStats()
+{
+    StatsReport report = {};
+    if (readFully(&report, sizeof(report)) != static_cast<ssize_t>(sizeof(report)))
+        return;
+
+    if (onStats)
+        onStats(report);
+}
+
+void Ipc::handleMemoryTrimmed()
+{
+    MemoryTrimReport report = {};
+    if (readFully(&report, sizeof(report)) != static_cast<ssize_t>(sizeof(report)))
+        return;
+
+    if (onMemoryTrimmed)
+        onMemoryTrimmed(report);
+}
+
+void Ipc::handleHello()
+{
+    HelloMessage hello = {};
+    if (readFully(&hello, sizeof(hello)) != static_cast<ssize_t>(sizeof(hello)))
+        return;
+
+    if (hello.magic != IPC_HELLO_MAGIC || hello.version == 0)
+        return;
+
+    // Pick the best settings both sides support
+    Protocol agreed;
+    agreed.version = static_cast<uint16_t>(juce::jmin<int>(hello.version, IPC_PROTOCOL_VERSION));
+    agreed.capabilities = hello.capabilities
+                        & (IPC_CAP_TRACE | IPC_CAP_STATS | IPC_CAP_CHUNKS | IPC_CAP_RPC | IPC_CAP_MIRROR | IPC_CAP_TYPED
+                           | IPC_CAP_BATCH | IPC_CAP_SHUTDOWN | IPC_CAP_MEMORY);
+    agreed.transports = (hello.transports & (IPC_TRANSPORT_SOCKET | IPC_TRANSPORT_BLOB | IPC_TRANSPORT_SURFACE_FD))
+                      | IPC_TRANSPORT_SOCKET;
+    agreed.codecs = (hello.codecs & (compressionEnabled.load() ? IPC_CODEC_RAW | IPC_CODEC_LZ4 | IPC_CODEC_DICT
+                                                               : IPC_CODEC_RAW | IPC_CODEC_DICT))
+                  | IPC_CODEC_RAW;
+    agreed.maxMessageSize = hello.maxMessageSize > 0 ? juce::jmin<uint32_t>(hello.maxMessageSize, IPC_MAX_MESSAGE_SIZE)
+                                                     : IPC_MAX_MESSAGE_SIZE;
+
+    // The reply is queued on the control lane before the new settings apply,
+    // so the UI sees it before any message relying on them
+    sendHello(agreed);
+
+    maxMessageSize.store(agreed.maxMessageSize);
+    codecs.store(agreed.codecs);
+    transports.store(agreed.transports);
+    capabilities.store(agreed.capabilities);
+    version.store(agreed.version);
+
+    if (onHandshake)
+        onHandshake();
+}
+
+void Ipc::handlePayloadEvent(uint8_t eventType)
 {
     uint32_t size = 0;
     if (readFully(&size, sizeof(size)) != sizeof(size))
         return;
 
-    if (size == 0 || size > 1024 * 1024)
+    if (size == 0 || size > IPC_MAX_MESSAGE_SIZE)
+        return;
+
+    TraceScope trace(tracer, TRACE_NAME_IPC_RECEIVE, 5 + size);
+
+    // Only the reader thread touches it, so it's kept between messages
+    rxPayload.resize(size);
+    if (readFully(rxPayload.data(), size) != static_cast<ssize_t>(size))
+        return;
+
+    dispatchPayload(eventType, rxPayload.data(), size);
+}
+
+void Ipc::handleCompressedEvent(uint8_t eventType)
+{
+    uint32_t sizes[2] = {};  // Compressed, uncompressed
+    if (readFully(sizes, sizeof(sizes)) != sizeof(sizes))
+        return;
+
+    const uint32_t compressedSize = sizes[0];
+    const uint32_t size = sizes[1];
+    if (compressedSize == 0 || compressedSize > IPC_MAX_MESSAGE_SIZE || size == 0 || size > IPC_MAX_MESSAGE_SIZE)
+        return;
+
+    TraceScope trace(tracer, TRACE_NAME_IPC_RECEIVE, 9 + compressedSize);
+
+    // Only the reader thread touches these, so they're kept between messages
+    rxCompressed.resize(compressedSize);
+    if (readFully(rxCompressed.data(), compressedSize) != static_cast<ssize_t>(compressedSize))
+        return;
+
+    rxInflated.resize(size);
+    if (!Lz4Compressor::decompress(rxCompressed.data(), compressedSize, rxInflated.data(), size))
+        return;
+
+    dispatchPayload(eventType, rxInflated.data(), size);
+}
+
+void Ipc::handleBlobEvent(int fd)
+{
+    uint8_t header[9] = {};  // Payload event type + 8-byte size
+    const bool ok = readFully(header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+
+    uint64_t size = 0;
+    std::memcpy(&size, header + 1, sizeof(size));
+
+    if (!ok || size == 0 || size > IPC_MAX_BLOB_SIZE || !isBlobPayloadType(header[0]))
+    {
+#if JUCE_MAC || JUCE_LINUX
+        if (fd >= 0)
+            close(fd);
+#endif
+        return;
+    }
+
+    TraceScope trace(tracer, TRACE_NAME_IPC_RECEIVE, static_cast<uint32_t>(10 + size));
+
+    auto blob = SharedBlob::map(fd, static_cast<size_t>(size));
+    if (blob.isValid())
+        dispatchPayload(header[0], blob.getData(), blob.getSize());
+}
+
+void Ipc::handleTypedEvent()
+{
+    uint16_t header[2] = {};  // Message id, size
+    if (readFully(header, sizeof(header)) != sizeof(header))
+        return;
+
+    if (header[1] > IPC_TYPED_MAX_SIZE)
+        return;
+
+    TraceScope trace(tracer, TRACE_NAME_IPC_RECEIVE, 5u + header[1]);
+
+    rxPayload.resize(header[1]);
+    if (readFully(rxPayload.data(), rxPayload.size()) != static_cast<ssize_t>(rxPayload.size()))
+        return;
+
+    if (onTyped)
+        post(Delivery::Kind::typed, {}, header[0], rxPayload.data(), rxPayload.size());
+}
+
+void Ipc::handleChunk()
+{
+    uint8_t header[4] = {};  // Lane + flags + 2-byte length
+    if (readFully(header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)))
+        return;
+
+    const uint8_t lane = header[0];
+    const uint8_t flags = header[1];
+    uint16_t length = 0;
+    std::memcpy(&length, header + 2, sizeof(length));
+
+    uint8_t data[IPC_CHUNK_SIZE];
+    if (length > sizeof(data) || readFully(data, length) != static_cast<ssize_t>(length))
         return;
 
-    juce::MemoryBlock data(size);
-    if (readFully(data.getData(), size) != static_cast<ssize_t>(size))
+    if (lane >= IPC_LANE_COUNT)
         return;
 
-    auto tree = juce::ValueTree::readFromData(data.getData(), size);
-    if (tree.isValid() && onEvent)
+    auto& message = rxChunks[lane];
+    if ((flags & IPC_CHUNK_FIRST) != 0)
     {
-        juce::MessageManager::callAsync([this, tree]() {
-            if (onEvent)
-                onEvent(tree);
-        });
+        message.clear();
+        rxDiscarding[lane] = false;
     }
+
+    // The rest of an oversized message, up to the next one's first chunk
+    if (rxDiscarding[lane])
+        return;
+
+    // Largest inline message plus its header (compressed JUCE events have the longest)
+    if (message.size() + length > IPC_MAX_MESSAGE_SIZE + 9)
+    {
+        message.clear();
+        rxDiscarding[lane] = (flags & IPC_CHUNK_LAST) == 0;
+        return;
+    }
+
+    message.insert(message.end(), data, data + length);
+
+    if ((flags & IPC_CHUNK_LAST) == 0)
+        return;
+
+    // Feed the complete message through the normal handlers
+    replayData = message.data();
+    replayRemaining = message.size();
+
+    uint8_t eventType = 0;
+    if (readFully(&eventType, 1) == 1)
+        dispatchMessage(eventType, -1);
+
+    replayData = nullptr;
+    replayRemaining = 0;
+    message.clear();
+}
+
+void Ipc::dispatchPayload(uint8_t eventType, const void* data, size_t size)
+{
+    const bool interned = (eventType & EVENT_FLAG_INTERNED) != 0;
+
+    switch (eventType & ~EVENT_FLAG_INTERNED)
+    {
+        case EVENT_TYPE_JUCE:
+            dispatchJuceEvent(data, size, interned);
+            break;
+        case EVENT_TYPE_RPC:
+            dispatchRpc(data, size, interned);
+            break;
+        case EVENT_TYPE_MIRROR:
+            if (onMirror && !interned)
+                onMirror(data, size);
+            break;
+        default:
+            break;
+    }
+}
+
+void Ipc::dispatchRpc(const void* data, size_t size, bool interned)
+{
+    RpcHeader header = {};
+    if (size < sizeof(header) || !onRpc)
+        return;
+
+    std::memcpy(&header, data, sizeof(header));
+
+    // Only CANCEL comes without a tree
+    juce::ValueTree tree;
+    if (size > sizeof(header))
+        tree = readTree(static_cast<const uint8_t*>(data) + sizeof(header), size - sizeof(header), interned);
+    else if (header.kind != IPC_RPC_CANCEL)
+        return;
+
+    onRpc(header, tree);
+}
+
+void Ipc::dispatchJuceEvent(const void* data, size_t size, bool interned)
+{
+    if (!onEventView)
+    {
+        auto tree = readTree(data, size, interned);
+        if (tree.isValid() && onEvent)
+            post(Delivery::Kind::event, std::move(tree));
+        return;
+    }
+
+    // Checked here, in order, so the names it defines are learned; read on the message thread
+    const auto view = interned ? ValueTreeView::readInterned(data, size, rxDictionary) : ValueTreeView(data, size);
+    if (!view.isValid())
+        return;
+
+    post(Delivery::Kind::view, {}, 0, data, view.getSize(), interned);
+    if (onEvent)
+        post(Delivery::Kind::event, view.toValueTree());
+}
+
+juce::ValueTree Ipc::readTree(const void* data, size_t size, bool interned)
+{
+    if (!interned)
+        return juce::ValueTree::readFromData(data, size);
+
+    juce::MemoryInputStream stream(data, size, false);
+    return rxDictionary.readTree(stream);
+}
+
+bool Ipc::isBlobPayloadType(uint8_t eventType)
+{
+    return eventType == EVENT_TYPE_JUCE || eventType == EVENT_TYPE_RPC || eventType == EVENT_TYPE_MIRROR
+        || eventType == (EVENT_TYPE_JUCE | EVENT_FLAG_INTERNED) || eventType == (EVENT_TYPE_RPC | EVENT_FLAG_INTERNED);
+}
+
+void Ipc::post(Delivery::Kind kind, juce::ValueTree tree, uint16_t typedId, const void* data, size_t size, bool interned)
+{
+    {
+        std::lock_guard<std::mutex> lock(inboxLock);
+
+        // Both vectors only grow until they fit the busiest burst
+        auto& delivery = inbox.emplace_back();
+        delivery.kind = kind;
+        delivery.posted = tracer != nullptr && tracer->isEnabled() ? Tracer::now() : 0;
+        delivery.tree = std::move(tree);
+        delivery.typedId = typedId;
+        delivery.offset = inboxBytes.size();
+        delivery.size = size;
+        delivery.interned = interned;
+
+        if (size > 0)
+        {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            inboxBytes.insert(inboxBytes.end(), bytes, bytes + size);
+        }
+    }
+
+    // Posts a message created once with the updater, unlike callAsync
+    triggerAsyncUpdate();
+}
+
+void Ipc::handleAsyncUpdate()
+{
+    {
+        std::lock_guard<std::mutex> lock(inboxLock);
+        std::swap(inbox, inboxHandling);
+        std::swap(inboxBytes, inboxBytesHandling);
+    }
+
+    for (const auto& delivery : inboxHandling)
+    {
+        const auto latency = delivery.posted > 0 ? static_cast<uint32_t>((Tracer::now() - delivery.posted) / 1000) : 0u;
+        TraceScope trace(delivery.posted > 0 ? tracer : nullptr, TRACE_NAME_CALL_ASYNC, latency);
+
+        switch (delivery.kind)
+        {
+            case Delivery::Kind::event:
+                if (onEvent)
+                    onEvent(delivery.tree);
+                break;
+            case Delivery::Kind::view:
+                if (onEventView)
+                {
+                    const auto* bytes = inboxBytesHandling.data() + delivery.offset;
+                    onEventView(delivery.interned ? ValueTreeView(bytes, delivery.size, rxDictionary)
+                                                  : ValueTreeView(bytes, delivery.size));
+                }
+                break;
+            case Delivery::Kind::typed:
+                if (onTyped)
+                    onTyped(TypedMessage { delivery.typedId, inboxBytesHandling.data() + delivery.offset, delivery.size });
+                break;
+            case Delivery::Kind::frameReady:
+                if (onFrameReady)
+                    onFrameReady();
+                break;
+            case Delivery::Kind::traceFinished:
+                if (onTraceFinished)
+                    onTraceFinished();
+                break;
+        }
+    }
+
+    // Releases the trees, keeps the storage
+    inboxHandling.clear();
+    inboxBytesHandling.clear();
+
+    // A preset's worth of tree bytes isn't worth keeping around
+    if (inboxBytesHandling.capacity() > BufferPool::maxCapacity)
+        inboxBytesHandling = {};
 }
 
 ssize_t Ipc::readFully(void* buffer, size_t size)
 {
-    size_t totalRead = 0;
     auto* ptr = static_cast<uint8_t*>(buffer);
 
+    // Reassembled chunks are read from memory
+    if (replayData != nullptr)
+    {
+        const size_t n = juce::jmin(size, replayRemaining);
+        std::memcpy(ptr, replayData, n);
+        replayData += n;
+        replayRemaining -= n;
+        return static_cast<ssize_t>(n);
+    }
+
+    size_t totalRead = 0;
+
 #if JUCE_MAC || JUCE_LINUX
     while (totalRead < size && running.load())
     {
@@ -181,46 +1195,148 @@ ssize_t Ipc::readFully(void* buffer, size_t size)
             continue;
         if (n <= 0)
             return totalRead > 0 ? static_cast<ssize_t>(totalRead) : n;
+        if (recorder != nullptr && recorder->isRecording())
+            rxRecord.insert(rxRecord.end(), ptr + totalRead, ptr + totalRead + n);
         totalRead += static_cast<size_t>(n);
+        rxBytes.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
     }
 #endif
     return static_cast<ssize_t>(totalRead);
 }
 
-bool Ipc::writeNonBlocking(const void* data, size_t size)
+bool Ipc::readEventType(uint8_t& type, int& fd)
+{
+    fd = -1;
+
+#if JUCE_MAC || JUCE_LINUX
+    // recvmsg instead of read: a descriptor attached to this byte would
+    // otherwise be discarded by the kernel
+    while (running.load())
+    {
+        struct pollfd pfd = { socketFD, POLLIN, 0 };
+        int ready = poll(&pfd, 1, 100);  // 100ms timeout
+
+        if (ready < 0)
+            return false;
+        if (ready == 0)
+            continue;
+
+        struct iovec iov = { &type, 1 };
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+#if JUCE_LINUX
+        ssize_t n = recvmsg(socketFD, &msg, MSG_CMSG_CLOEXEC);  // Not to leak into UIs spawned later
+#else
+        ssize_t n = recvmsg(socketFD, &msg, 0);
+#endif
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            continue;
+        if (n != 1)
+            return false;
+
+        rxBytes.fetch_add(1, std::memory_order_relaxed);
+        if (recorder != nullptr && recorder->isRecording())
+            rxRecord.assign(1, type);
+
+        for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+                std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+#if JUCE_MAC
+        if (fd >= 0)
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+        return true;
+    }
+#endif
+    return false;
+}
+
+// =============================================================================
+// Socket writes (writer thread only)
+// =============================================================================
+
+bool Ipc::writeWithDescriptor(const void* data, size_t size, int fd)
+{
+#if JUCE_MAC || JUCE_LINUX
+    struct iovec iov = { const_cast<void*>(data), size };
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    // The descriptor travels with the first byte; the rest is a plain write
+    while (running.load())
+    {
+        ssize_t n = sendmsg(socketFD, &msg, sendFlags);
+        if (n > 0)
+        {
+            const auto sent = static_cast<size_t>(n);
+            return sent == size || writeBlocking(static_cast<const uint8_t*>(data) + sent, size - sent);
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            struct pollfd pfd = { socketFD, POLLOUT, 0 };
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        disconnect();
+        return false;
+    }
+    return false;
+#else
+    (void)data;
+    (void)size;
+    (void)fd;
+    return false;
+#endif
+}
+
+bool Ipc::writeBlocking(const void* data, size_t size)
 {
 #if JUCE_MAC || JUCE_LINUX
     size_t totalWritten = 0;
     auto* ptr = static_cast<const uint8_t*>(data);
 
-    // Try a few times with small delays for EAGAIN
-    for (int attempts = 0; attempts < 3 && totalWritten < size; ++attempts)
+    // Wait for room while the UI drains the socket; only stop() or a real
+    // error gives up
+    while (totalWritten < size && running.load())
     {
-        ssize_t n = ::write(socketFD, ptr + totalWritten, size - totalWritten);
+        ssize_t n = send(socketFD, ptr + totalWritten, size - totalWritten, sendFlags);
         if (n > 0)
         {
             totalWritten += static_cast<size_t>(n);
-            attempts = 0;  // Reset on progress
         }
-        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
         {
-            // Socket buffer full - yield briefly and retry
-            continue;
+            struct pollfd pfd = { socketFD, POLLOUT, 0 };
+            poll(&pfd, 1, 100);  // 100ms timeout, allows checking running flag
         }
         else
         {
             // Real error
-            socketFD = -1;
+            disconnect();
             return false;
         }
     }
 
-    if (totalWritten != size)
-    {
-        socketFD = -1;
-        return false;
-    }
-    return true;
+    return totalWritten == size;
 #else
     (void)data;
     (void)size;
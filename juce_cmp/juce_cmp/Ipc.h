@@ -5,11 +5,23 @@
 
 #include <juce_core/juce_core.h>
 #include <juce_data_structures/juce_data_structures.h>
+#include <juce_events/juce_events.h>
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
 #include "ipc_protocol.h"
 #include "input_event.h"
+#include "Trace.h"
+#include "IpcRecorder.h"
+#include "SharedBlob.h"
+#include "Lz4.h"
+#include "IdentifierDictionary.h"
+#include "TypedMessage.h"
+#include "BufferPool.h"
 
 namespace juce_cmp
 {
@@ -20,19 +32,73 @@ namespace juce_cmp
  * Uses a Unix socket for bidirectional communication.
  *
  * Handles both directions:
- * - TX (host → UI): Input events, resize, focus, ValueTree messages
- * - RX (UI → host): Frame ready notification, ValueTree messages
+ * - TX (host → UI): Input events, resize, focus, ValueTree, RPC, mirror and typed messages
+ * - RX (UI → host): Frame ready notification, ValueTree, RPC, mirror and typed messages
  *
- * Note: IOSurface sharing uses separate Mach port IPC (see MachPort.h).
+ * Note: IOSurface sharing uses separate Mach port IPC (see MachPort.h). On
+ * Linux the surface's memory goes over the socket instead, see sendSurface().
+ *
+ * Sending only queues the message; a writer thread drains the queues by lane
+ * priority (input, control, bulk), cutting large messages into chunks so an
+ * input event never waits behind a whole preset. Nothing blocks the caller.
+ *
+ * Large payloads travel out of band as a SharedBlob descriptor when both
+ * sides support IPC_TRANSPORT_BLOB, so the socket only carries a handle.
+ * With compression enabled, mid-sized ones are LZ4 compressed once the UI
+ * agrees to IPC_CODEC_LZ4. Trees on the control lane send their type and
+ * property names as dictionary tokens once the UI agrees to IPC_CODEC_DICT,
+ * so a small message is mostly its values. Typed messages skip ValueTrees
+ * altogether: an id and a fixed-layout struct, see TypedMessage.
+ *
+ * Once warm, input events and typed messages allocate nothing in either
+ * direction: messages are built in pooled buffers (BufferPool), queue nodes
+ * are recycled, the reader thread reuses one receive buffer and hands work
+ * to the message thread through a preallocated inbox rather than callAsync.
+ * ValueTree messages still allocate the tree itself, unless read through
+ * setEventViewHandler() (see ValueTreeView).
  *
  * Protocol: 1-byte event type followed by type-specific payload.
  * See ipc_protocol.h for details.
+ *
+ * Until the UI's CMP_EVENT_HELLO arrives the channel runs the original
+ * protocol (version 0, no capabilities), which is all an older UI binary
+ * understands. Sends needing a capability are skipped while it is missing.
  */
-class Ipc
+class Ipc : private juce::AsyncUpdater
 {
 public:
     using EventHandler = std::function<void(const juce::ValueTree& tree)>;
+    using EventViewHandler = std::function<void(const ValueTreeView& tree)>;
     using FrameReadyHandler = std::function<void()>;
+    using TraceFinishedHandler = std::function<void()>;
+    using StatsHandler = std::function<void(const StatsReport& report)>;
+    using MemoryTrimmedHandler = std::function<void(const MemoryTrimReport& report)>;
+    using RpcHandler = std::function<void(const RpcHeader& header, const juce::ValueTree& tree)>;
+    using MirrorHandler = std::function<void(const void* data, size_t size)>;
+    using TypedHandler = std::function<void(const TypedMessage& message)>;
+    using HandshakeHandler = std::function<void()>;
+    using DisconnectHandler = std::function<void()>;
+
+    /** Traffic counters since the channel was created. */
+    struct Counters
+    {
+        uint64_t txMessages = 0;
+        uint64_t txBytes = 0;
+        uint64_t rxMessages = 0;
+        uint64_t rxBytes = 0;
+        uint64_t txDropped = 0;
+        uint64_t txLaneBytes[IPC_LANE_COUNT] = {};  // Written to the socket, per IPC_LANE_*
+    };
+
+    /** Settings agreed with the UI in the handshake. */
+    struct Protocol
+    {
+        uint16_t version = 0;
+        uint32_t capabilities = 0;
+        uint32_t transports = IPC_TRANSPORT_SOCKET;
+        uint32_t codecs = IPC_CODEC_RAW;
+        uint32_t maxMessageSize = IPC_MAX_MESSAGE_SIZE;
+    };
 
     Ipc();
     ~Ipc();
@@ -41,35 +107,266 @@ public:
     void setSocketFD(int fd);
     void setEventHandler(EventHandler handler) { onEvent = std::move(handler); }
     void setFrameReadyHandler(FrameReadyHandler handler) { onFrameReady = std::move(handler); }
+    /**
+     * Called on the message thread for each ValueTree event, read in place
+     * rather than built; the view is valid for the duration of the call. An
+     * event handler set as well still gets the built tree.
+     */
+    void setEventViewHandler(EventViewHandler handler) { onEventView = std::move(handler); }
+
+    void setTraceFinishedHandler(TraceFinishedHandler handler) { onTraceFinished = std::move(handler); }
+    void setTracer(Tracer* t) { tracer = t; }
+
+    /** Log every message sent and received while the recorder is on, see IpcRecorder. */
+    void setRecorder(IpcRecorder* r) { recorder = r; }
+
+    /** Called on the reader thread (not the message thread) for each UI stats report. */
+    void setStatsHandler(StatsHandler handler) { onStats = std::move(handler); }
+
+    /** Called on the reader thread each time the UI has trimmed its memory. */
+    void setMemoryTrimmedHandler(MemoryTrimmedHandler handler) { onMemoryTrimmed = std::move(handler); }
+
+    /** Called on the reader thread for each RPC message, see Rpc. */
+    void setRpcHandler(RpcHandler handler) { onRpc = std::move(handler); }
 
-    // Lifecycle
+    /** Called on the reader thread for each mirror message (payload after the size), see MirroredValueTree. */
+    void setMirrorHandler(MirrorHandler handler) { onMirror = std::move(handler); }
+
+    /** Called on the message thread for each typed message, see TypedMessage. */
+    void setTypedHandler(TypedHandler handler) { onTyped = std::move(handler); }
+
+    /** Called on the reader thread once the settings agreed with the UI apply. */
+    void setHandshakeHandler(HandshakeHandler handler) { onHandshake = std::move(handler); }
+
+    /**
+     * Called once on the reader or writer thread when the socket closes or
+     * fails while receiving: the UI exited or crashed. Not called for stop().
+     * Messages sent after that are dropped.
+     */
+    void setDisconnectHandler(DisconnectHandler handler) { onDisconnect = std::move(handler); }
+
+    /**
+     * Offer IPC_CODEC_LZ4 in the handshake, so both sides compress JUCE
+     * payloads from IPC_COMPRESS_THRESHOLD on. Off by default: on a local
+     * socket compressing usually costs more than it saves (see
+     * benchmarks/compression_benchmark.cpp). Set before the UI's HELLO arrives.
+     */
+    void setCompressionEnabled(bool enabled) { compressionEnabled.store(enabled); }
+
+    // Lifecycle. With shutdown, CMP_EVENT_SHUTDOWN is written last if the UI
+    // agreed to IPC_CAP_SHUTDOWN and it can go without waiting
     void startReceiving();
-    void stop();
+    void stop(bool shutdown = false);
     bool isValid() const { return socketFD >= 0; }
+    bool isConnected() const { return socketFD >= 0 && !disconnected.load(); }
+
+    // Negotiated protocol (any thread)
+    Protocol getProtocol() const;
+    bool hasCapability(uint32_t capability) const { return (capabilities.load() & capability) != 0; }
+
+    // Statistics (any thread)
+    Counters getCounters() const;
+    size_t getPendingTxBytes() const;
 
     // TX: Host → UI
     void sendInput(InputEvent& event);
-    void sendEvent(const juce::ValueTree& tree);
+    bool sendEvent(const juce::ValueTree& tree, uint8_t lane = IPC_LANE_CONTROL);  // False if not queued, see ComposeComponent
+    void sendClockSync();
+    void sendTraceControl(bool enable);
+
+    /** Ask the UI to release memory (IPC_MEMORY_PRESSURE_*). Returns false if
+     *  not queued, e.g. the UI didn't agree to IPC_CAP_MEMORY. */
+    bool sendMemoryPressure(uint8_t level);
+
+    /**
+     * Pass a surface's shared memory to the UI (CMP_EVENT_SURFACE); the
+     * descriptor is duplicated, so the caller keeps its own. Returns false if
+     * not queued, e.g. the UI didn't agree to IPC_TRANSPORT_SURFACE_FD.
+     */
+    bool sendSurface(int fd, int width, int height, int stride);
+
+    /** Returns false if not queued, e.g. the UI didn't agree to IPC_CAP_RPC. */
+    bool sendRpc(uint8_t kind, uint32_t id, uint32_t timeoutMs, const juce::ValueTree& tree, uint8_t lane);
+
+    /** Returns false if not queued, e.g. the UI didn't agree to IPC_CAP_MIRROR. */
+    bool sendMirror(const void* data, size_t size);
+
+    /** Returns false if not queued, e.g. the UI didn't agree to IPC_CAP_TYPED. */
+    bool sendTyped(uint16_t id, const void* data, size_t size, uint8_t lane);
+
+    /**
+     * Queue messages collected with the add*ToBatch() helpers as one
+     * EVENT_TYPE_BATCH on the control lane, so the UI handles them together.
+     * Returns false if not queued: IPC_CAP_BATCH wasn't agreed or the batch
+     * is over the agreed message size.
+     */
+    bool sendBatch(const std::vector<uint8_t>& batch);
+    static void addTypedToBatch(std::vector<uint8_t>& batch, uint16_t id, const void* data, size_t size);
+    static void addMirrorToBatch(std::vector<uint8_t>& batch, const void* data, size_t size);
+
+    /**
+     * Queue a message encoded elsewhere, as it goes over the socket (e.g. read
+     * back from an IpcRecorder log), with a blob payload passed as a new
+     * SharedBlob if given. Nothing about it is checked or counted as agreed.
+     */
+    bool sendEncoded(const void* data, size_t size, uint8_t lane, const void* blob = nullptr, size_t blobSize = 0);
 
 private:
+    /** A queued message; chunked messages are written a piece at a time. */
+    struct Frame
+    {
+        std::vector<uint8_t> data;
+        SharedBlob blob;          // Descriptor sent along with data, if valid
+        size_t offset = 0;        // Bytes already written
+        bool chunked = false;     // Decided when queued, see enqueue()
+    };
 
     // RX thread methods
     void readerLoop();
+    void dispatchMessage(uint8_t eventType, int fd);
     void handleCmpEvent();
-    void handleJuceEvent();
+    void handlePayloadEvent(uint8_t eventType);
+    void handleCompressedEvent(uint8_t eventType);
+    void handleBlobEvent(int fd);
+    void handleTypedEvent();
+    void handleChunk();
+    void dispatchPayload(uint8_t eventType, const void* data, size_t size);
+    void dispatchJuceEvent(const void* data, size_t size, bool interned);
+    void dispatchRpc(const void* data, size_t size, bool interned);
+    juce::ValueTree readTree(const void* data, size_t size, bool interned);
+    static bool isBlobPayloadType(uint8_t eventType);
+    void handleClockSync();
+    void handleTraceData();
+    void handleStats();
+    void handleMemoryTrimmed();
+    void handleHello();
     ssize_t readFully(void* buffer, size_t size);
+    bool readEventType(uint8_t& type, int& fd);
+
+    /** Work the reader thread hands to the message thread. */
+    struct Delivery
+    {
+        enum class Kind : uint8_t { event, view, typed, frameReady, traceFinished };
+
+        Kind kind = Kind::event;
+        int64_t posted = 0;         // For the queue latency trace, 0 if not tracing
+        juce::ValueTree tree;       // Kind::event
+        uint16_t typedId = 0;       // Kind::typed
+        size_t offset = 0;          // Kind::typed and Kind::view, body in the inbox bytes
+        size_t size = 0;
+        bool interned = false;      // Kind::view, names in rxDictionary
+    };
+
+    // Queue for the message thread, see handleAsyncUpdate()
+    void post(Delivery::Kind kind, juce::ValueTree tree = {}, uint16_t typedId = 0,
+              const void* data = nullptr, size_t size = 0, bool interned = false);
+    void handleAsyncUpdate() override;
 
-    // TX helper (non-blocking with retry)
-    bool writeNonBlocking(const void* data, size_t size);
+    // TX: queue on the calling thread, write on the writer thread
+    bool enqueue(uint8_t lane, std::vector<uint8_t> data, SharedBlob blob = {},
+                 const void* blobData = nullptr, size_t blobSize = 0);  // Blob contents for the recorder
+    void writerLoop();
+    bool writeFrame(uint8_t lane, Frame& frame);
+    bool writeBlocking(const void* data, size_t size);
+    bool writeWithDescriptor(const void* data, size_t size, int fd);
+    bool sendBlob(uint8_t eventType, const void* data, size_t size, uint8_t lane);
+    bool sendTree(uint8_t eventType, const void* header, size_t headerSize, const juce::ValueTree& tree, uint8_t lane);
+    bool sendPayload(uint8_t eventType, std::vector<uint8_t> message, uint8_t lane);  // Payload after 5 bytes of header room
+    bool sendCompressed(uint8_t eventType, const void* data, uint32_t dataSize, uint8_t lane);
+    void sendHello(const Protocol& agreed);
+    void countSent(uint8_t lane, size_t size, bool messageDone);
+    void countDropped();
+    void disconnect();  // Socket closed or failed, see setDisconnectHandler()
 
     // Socket file descriptor (bidirectional)
     int socketFD = -1;
 
+    // Set once the socket has closed or failed, until the next setSocketFD()
+    std::atomic<bool> disconnected { false };
+
     // RX state
     std::atomic<bool> running { false };
     std::thread readerThread;
     EventHandler onEvent;
+    EventViewHandler onEventView;
     FrameReadyHandler onFrameReady;
+    TraceFinishedHandler onTraceFinished;
+    StatsHandler onStats;
+    MemoryTrimmedHandler onMemoryTrimmed;
+    RpcHandler onRpc;
+    MirrorHandler onMirror;
+    TypedHandler onTyped;
+    HandshakeHandler onHandshake;
+    DisconnectHandler onDisconnect;
+
+    // Inline payloads land here, reused between messages
+    std::vector<uint8_t> rxPayload;
+
+    // Bytes of the message being read, while recording
+    std::vector<uint8_t> rxRecord;
+
+    // Chunk reassembly per lane, and the message being replayed from it
+    std::vector<uint8_t> rxChunks[IPC_LANE_COUNT];
+    bool rxDiscarding[IPC_LANE_COUNT] = {};  // Skipping the rest of an oversized message
+    const uint8_t* replayData = nullptr;
+    size_t replayRemaining = 0;
+
+    // Decompression buffers, reused between messages
+    std::vector<uint8_t> rxCompressed;
+    std::vector<uint8_t> rxInflated;
+
+    // Names the UI defined in interned trees
+    IdentifierDecoder rxDictionary;
+
+    // Deliveries waiting for the message thread; swapped with the second
+    // pair when handled, so both keep their capacity
+    std::mutex inboxLock;
+    std::vector<Delivery> inbox, inboxHandling;
+    std::vector<uint8_t> inboxBytes, inboxBytesHandling;
+
+    // TX state
+    static constexpr size_t maxQueuedBytes = 32 * 1024 * 1024;
+    std::thread writerThread;
+    std::mutex txLock;
+    std::condition_variable txReady;
+    std::atomic<size_t> txQueuedBytes { 0 };
+    bool txAtBoundary = true;  // Writer thread: nothing cut off mid-message, see stop()
+
+    // Lists so the writer's reference to a front frame survives pushes. Sent
+    // frames are spliced into txSpareFrames and back, so nodes are reused.
+    std::list<Frame> txQueues[IPC_LANE_COUNT];
+    std::list<Frame> txSpareFrames;
+
+    // Message buffers, back in the pool once written
+    BufferPool txBuffers;
+
+    // Compression context, shared by sending threads
+    std::mutex compressLock;
+    Lz4Compressor txCompressor;
+
+    // Names defined in interned trees sent so far
+    std::mutex dictionaryLock;
+    IdentifierEncoder txDictionary;
+
+    // Negotiated protocol, applied right after the HELLO reply is queued
+    std::atomic<uint16_t> version { 0 };
+    std::atomic<uint32_t> capabilities { 0 };
+    std::atomic<uint32_t> transports { IPC_TRANSPORT_SOCKET };
+    std::atomic<uint32_t> codecs { IPC_CODEC_RAW };
+    std::atomic<uint32_t> maxMessageSize { IPC_MAX_MESSAGE_SIZE };
+    std::atomic<bool> compressionEnabled { false };
+
+    // Traffic counters
+    std::atomic<uint64_t> txMessages { 0 };
+    std::atomic<uint64_t> txBytes { 0 };
+    std::atomic<uint64_t> rxMessages { 0 };
+    std::atomic<uint64_t> rxBytes { 0 };
+    std::atomic<uint64_t> txDropped { 0 };
+    std::atomic<uint64_t> txLaneBytes[IPC_LANE_COUNT] = {};
+
+    // Optional timeline recorder and message log (owned by ComposeProvider)
+    Tracer* tracer = nullptr;
+    IpcRecorder* recorder = nullptr;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Ipc)
 };
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "IpcRecorder.h"
+#include "ipc_protocol.h"
+#include "Trace.h"
+
+namespace juce_cmp
+{
+
+IpcRecorder::IpcRecorder() = default;
+
+IpcRecorder::~IpcRecorder()
+{
+    stop();
+}
+
+bool IpcRecorder::start(const juce::File& file)
+{
+    stop();
+
+    std::lock_guard<std::mutex> lock(lock_);
+
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file, 64 * 1024);
+    if (!stream->openedOk())
+        return false;
+
+    stream->writeInt(static_cast<int>(magic));
+    stream->writeShort(static_cast<short>(formatVersion));
+    stream->writeShort(static_cast<short>(IPC_PROTOCOL_VERSION));
+
+    stream_ = std::move(stream);
+    lastTime_ = 0;
+    recording_.store(true);
+    return true;
+}
+
+void IpcRecorder::stop()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    recording_.store(false);
+    if (stream_ != nullptr)
+        stream_->flush();
+    stream_.reset();
+}
+
+void IpcRecorder::record(Direction direction, uint8_t lane, const void* data, size_t size,
+                         Attachment attachment, const void* blob, size_t blobSize)
+{
+    if (!isRecording())
+        return;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    if (stream_ == nullptr)
+        return;
+
+    // Taken under the lock, so times never go backwards between threads
+    const int64_t now = Tracer::now();
+    const int64_t elapsed = lastTime_ > 0 ? (now - lastTime_) / 1000 : 0;
+    lastTime_ = now;
+
+    const bool hasBlob = attachment == Attachment::blob;
+    stream_->writeByte(static_cast<char>(static_cast<uint8_t>(direction)
+                                         | static_cast<uint8_t>(attachment) << 1
+                                         | (lane & 3) << 3));
+    stream_->writeCompressedInt(static_cast<int>(juce::jmin<int64_t>(elapsed, INT32_MAX)));
+    stream_->writeCompressedInt(static_cast<int>(size));
+    stream_->write(data, size);
+
+    if (hasBlob)
+    {
+        stream_->writeCompressedInt(static_cast<int>(blobSize));
+        stream_->write(blob, blobSize);
+    }
+}
+
+// =============================================================================
+// Reading
+// =============================================================================
+
+bool IpcRecording::load(const juce::File& file)
+{
+    records_.clear();
+
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk())
+        return false;
+
+    if (static_cast<uint32_t>(stream.readInt()) != IpcRecorder::magic
+        || static_cast<uint16_t>(stream.readShort()) != IpcRecorder::formatVersion)
+        return false;
+
+    protocolVersion_ = static_cast<uint16_t>(stream.readShort());
+
+    int64_t time = 0;
+    while (!stream.isExhausted())
+    {
+        Record record;
+        const auto flags = static_cast<uint8_t>(stream.readByte());
+        record.direction = static_cast<IpcRecorder::Direction>(flags & 1);
+        record.attachment = static_cast<IpcRecorder::Attachment>((flags >> 1) & 3);
+        record.lane = static_cast<uint8_t>((flags >> 3) & 3);
+
+        time += static_cast<int64_t>(stream.readCompressedInt()) * 1000;
+        record.time = time;
+
+        // A log cut short (crash, still being written) ends at its last whole record
+        const int size = stream.readCompressedInt();
+        if (size < 0 || size > IPC_MAX_BLOB_SIZE || stream.getNumBytesRemaining() < size)
+            break;
+        record.data.resize(static_cast<size_t>(size));
+        stream.read(record.data.data(), size);
+
+        if (record.attachment == IpcRecorder::Attachment::blob)
+        {
+            const int blobSize = stream.readCompressedInt();
+            if (blobSize < 0 || blobSize > IPC_MAX_BLOB_SIZE || stream.getNumBytesRemaining() < blobSize)
+                break;
+            record.blob.resize(static_cast<size_t>(blobSize));
+            stream.read(record.blob.data(), blobSize);
+        }
+
+        records_.push_back(std::move(record));
+    }
+
+    return true;
+}
+
+}  // namespace juce_cmp
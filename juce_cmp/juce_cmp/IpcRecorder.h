@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace juce_cmp
+{
+
+/**
+ * IpcRecorder - Opt-in log of every IPC message in both directions.
+ *
+ * Each message is stored as it went over the socket, with its lane and a
+ * timestamp, so a session can be replayed into a UI process later (see
+ * benchmarks/ipc_replay.cpp). Blob payloads sent to the UI are stored with
+ * the message; surfaces and the UI's blobs are only marked, their memory
+ * isn't kept.
+ *
+ * Log format, little endian:
+ *   Header   "CMPR", uint16 format version, uint16 IPC protocol version
+ *   Record   uint8 flags (bit 0 direction, bits 1-2 attachment, bits 3-4 lane),
+ *            then as JUCE compressed ints: microseconds since the previous
+ *            record, message size, and the blob size if one follows; the
+ *            message and blob bytes after their sizes
+ *
+ * Recording is for diagnosis, not production: while on, every message costs
+ * a buffered file write under a lock. While off, one relaxed atomic load.
+ */
+class IpcRecorder
+{
+public:
+    enum class Direction : uint8_t { toUi = 0, fromUi = 1 };
+
+    enum class Attachment : uint8_t
+    {
+        none = 0,
+        blob = 1,        // Blob payload follows the message
+        surface = 2,     // A surface descriptor went along
+        descriptor = 3   // Some other descriptor went along, contents not kept
+    };
+
+    static constexpr uint32_t magic = 0x52504D43;  // "CMPR"
+    static constexpr uint16_t formatVersion = 1;
+
+    IpcRecorder();
+    ~IpcRecorder();
+
+    /** Start writing a new log, replacing the file. */
+    bool start(const juce::File& file);
+
+    /** Flush and close the log. */
+    void stop();
+
+    bool isRecording() const noexcept { return recording_.load(std::memory_order_relaxed); }
+
+    /** Append a message (any thread). */
+    void record(Direction direction, uint8_t lane, const void* data, size_t size,
+                Attachment attachment = Attachment::none, const void* blob = nullptr, size_t blobSize = 0);
+
+private:
+    std::atomic<bool> recording_ { false };
+    std::mutex lock_;
+    std::unique_ptr<juce::FileOutputStream> stream_;
+    int64_t lastTime_ = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(IpcRecorder)
+};
+
+/**
+ * IpcRecording - Reads back a log written by IpcRecorder.
+ */
+class IpcRecording
+{
+public:
+    struct Record
+    {
+        IpcRecorder::Direction direction = IpcRecorder::Direction::toUi;
+        IpcRecorder::Attachment attachment = IpcRecorder::Attachment::none;
+        uint8_t lane = 0;
+        int64_t time = 0;  // Nanoseconds since the first record
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> blob;
+    };
+
+    /** Load a whole log, up to the last complete record; false if the file isn't a log. */
+    bool load(const juce::File& file);
+
+    uint16_t getProtocolVersion() const { return protocolVersion_; }
+    const std::vector<Record>& getRecords() const { return records_; }
+
+private:
+    uint16_t protocolVersion_ = 0;
+    std::vector<Record> records_;
+};
+
+}  // namespace juce_cmp
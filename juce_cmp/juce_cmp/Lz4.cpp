@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace juce_cmp
+{
+
+namespace
+{
+    constexpr size_t minMatch = 4;
+    constexpr size_t lastLiterals = 5;   // Block must end with this many literals
+    constexpr size_t matchStartLimit = 12;  // Last match starts at least this far from the end
+    constexpr size_t maxOffset = 65535;
+
+    uint32_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint64_t read64(const uint8_t* p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // Length of the common prefix of a and b, stopping at limit (a < limit)
+    size_t countMatching(const uint8_t* a, const uint8_t* b, const uint8_t* limit)
+    {
+        const uint8_t* const start = a;
+
+        // A word at a time while one fits (assumes little-endian, as both sides are)
+        while (a + sizeof(uint64_t) <= limit)
+        {
+            const uint64_t diff = read64(a) ^ read64(b);
+            if (diff != 0)
+                return static_cast<size_t>(a - start) + static_cast<size_t>(__builtin_ctzll(diff) >> 3);
+            a += sizeof(uint64_t);
+            b += sizeof(uint64_t);
+        }
+
+        while (a < limit && *a == *b)
+        {
+            ++a;
+            ++b;
+        }
+
+        return static_cast<size_t>(a - start);
+    }
+
+    uint32_t hash(uint32_t sequence, int hashLog)
+    {
+        return (sequence * 2654435761u) >> (32 - hashLog);
+    }
+
+    // Length beyond the 4-bit token field, as a run of 255s plus remainder
+    uint8_t* writeLength(uint8_t* op, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+            *op++ = 255;
+        *op++ = static_cast<uint8_t>(length);
+        return op;
+    }
+
+    bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+    {
+        uint8_t b;
+        do
+        {
+            if (ip >= end)
+                return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+}
+
+size_t Lz4Compressor::compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const end = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* const opEnd = dst + dstCapacity;
+
+    if (srcSize >= matchStartLimit + 1)
+    {
+        table_.fill(0);
+
+        const uint8_t* const ipLimit = end - matchStartLimit;
+        const uint8_t* const matchLimit = end - lastLiterals;
+        unsigned misses = 0;
+
+        while (ip <= ipLimit)
+        {
+            const uint32_t sequence = read32(ip);
+            const uint32_t h = hash(sequence, hashLog);
+            const uint8_t* ref = src + table_[h];
+            table_[h] = static_cast<uint32_t>(ip - src);
+
+            if (ref >= ip || static_cast<size_t>(ip - ref) > maxOffset || read32(ref) != sequence)
+            {
+                // Skip faster through data that doesn't compress
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            // Extend backwards over literals, then forwards
+            while (ip > anchor && ref > src && ip[-1] == ref[-1])
+            {
+                --ip;
+                --ref;
+            }
+
+            const uint8_t* matchEnd = ip + minMatch + countMatching(ip + minMatch, ref + minMatch, matchLimit);
+
+            const size_t literalLength = static_cast<size_t>(ip - anchor);
+            const size_t matchLength = static_cast<size_t>(matchEnd - ip) - minMatch;
+
+            // Token + lengths + literals + offset, worst case
+            if (static_cast<size_t>(opEnd - op) < 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1)
+                return 0;
+
+            uint8_t* token = op++;
+            *token = static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchLength, 15));
+            if (literalLength >= 15)
+                op = writeLength(op, literalLength - 15);
+
+            std::memcpy(op, anchor, literalLength);
+            op += literalLength;
+
+            const auto offset = static_cast<uint16_t>(ip - ref);
+            *op++ = static_cast<uint8_t>(offset & 0xFF);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+
+            if (matchLength >= 15)
+                op = writeLength(op, matchLength - 15);
+
+            ip = matchEnd;
+            anchor = ip;
+        }
+    }
+
+    // Remaining input as the final literal-only sequence
+    const size_t literalLength = static_cast<size_t>(end - anchor);
+    if (static_cast<size_t>(opEnd - op) < 1 + literalLength / 255 + 1 + literalLength)
+        return 0;
+
+    *op++ = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+    if (literalLength >= 15)
+        op = writeLength(op, literalLength - 15);
+
+    std::memcpy(op, anchor, literalLength);
+    op += literalLength;
+
+    return static_cast<size_t>(op - dst);
+}
+
+bool Lz4Compressor::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+    const uint8_t* ip = src;
+    const uint8_t* const end = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* const opEnd = dst + dstSize;
+
+    while (ip < end)
+    {
+        const uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, end, literalLength))
+            return false;
+
+        if (literalLength > static_cast<size_t>(end - ip) || literalLength > static_cast<size_t>(opEnd - op))
+            return false;
+
+        std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == end)
+            break;  // Last sequence has no match
+
+        if (end - ip < 2)
+            return false;
+
+        const size_t offset = static_cast<size_t>(ip[0]) | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst))
+            return false;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, end, matchLength))
+            return false;
+        matchLength += minMatch;
+
+        if (matchLength > static_cast<size_t>(opEnd - op))
+            return false;
+
+        // Byte by byte only if the match overlaps the bytes being written
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength)
+            std::memcpy(op, match, matchLength);
+        else
+            for (size_t i = 0; i < matchLength; ++i)
+                op[i] = match[i];
+        op += matchLength;
+    }
+
+    return op == opEnd;
+}
+
+}  // namespace juce_cmp
@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace juce_cmp
+{
+
+/**
+ * Lz4 - Compressor and decompressor for the LZ4 block format.
+ *
+ * Used for IPC_CODEC_LZ4 payloads; compatible with liblz4 and with the
+ * Kotlin implementation in the UI (Lz4.kt). Favours speed over ratio,
+ * which is the right trade for a local socket.
+ *
+ * A compressor keeps its hash table between calls, so keep one per sending
+ * direction instead of allocating per message. Not thread-safe.
+ */
+class Lz4Compressor
+{
+public:
+    /** Worst-case compressed size for n input bytes. */
+    static constexpr size_t maxCompressedSize(size_t n) { return n + n / 255 + 16; }
+
+    /** Returns the compressed size, or 0 if it doesn't fit in dstCapacity. */
+    size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+    /**
+     * Decompress a block that expands to exactly dstSize bytes.
+     * Returns false for malformed input; never reads or writes out of bounds.
+     */
+    static bool decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+private:
+    static constexpr int hashLog = 12;
+
+    std::array<uint32_t, 1u << hashLog> table_ {};
+};
+
+}  // namespace juce_cmp
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "MirroredValueTree.h"
+#include "ComposeComponent.h"
+
+namespace juce_cmp
+{
+
+MirroredValueTree::MirroredValueTree(ComposeComponent& component, const juce::String& name, const juce::ValueTree& tree)
+    : provider_(component.getProvider()), name_(name), tree_(tree)
+{
+    tree_.addListener(this);
+    provider_.addMirror(this);
+
+    // Sent right away if the UI is already connected, otherwise on its handshake
+    resync();
+}
+
+MirroredValueTree::~MirroredValueTree()
+{
+    provider_.removeMirror(this);
+    tree_.removeListener(this);
+}
+
+void MirroredValueTree::resync()
+{
+    needsResync_ = true;
+    ops_.reset();
+    triggerAsyncUpdate();
+}
+
+void MirroredValueTree::flush()
+{
+    cancelPendingUpdate();
+
+    if (!needsResync_ && ops_.getDataSize() == 0)
+        return;
+
+    // Keep collecting until the UI is there to receive; it gets the whole tree then
+    if (!provider_.canMirror())
+    {
+        needsResync_ = true;
+        ops_.reset();
+        return;
+    }
+
+    juce::MemoryOutputStream message;
+    message.writeString(name_);
+    message.writeInt(static_cast<int>(sequence_));
+
+    if (needsResync_)
+    {
+        message.writeByte(static_cast<char>(IPC_MIRROR_REPLACE));
+        message.writeCompressedInt(0);
+        tree_.writeToStream(message);
+    }
+    else
+    {
+        message.write(ops_.getData(), ops_.getDataSize());
+    }
+
+    ops_.reset();
+
+    // A lost batch would leave a gap in the replica, so start over from the whole tree
+    needsResync_ = !provider_.sendMirror(message.getData(), message.getDataSize());
+    if (!needsResync_)
+        ++sequence_;
+}
+
+void MirroredValueTree::handleAsyncUpdate()
+{
+    flush();
+}
+
+bool MirroredValueTree::beginOp(uint8_t op, const juce::ValueTree& node)
+{
+    // The whole tree goes out anyway
+    if (needsResync_)
+        return false;
+
+    path_.clear();
+    for (auto child = node; child != tree_;)
+    {
+        auto parent = child.getParent();
+        if (!parent.isValid())
+        {
+            resync();
+            return false;
+        }
+
+        path_.push_back(parent.indexOf(child));
+        child = parent;
+    }
+
+    ops_.writeByte(static_cast<char>(op));
+    ops_.writeCompressedInt(static_cast<int>(path_.size()));
+    for (auto it = path_.rbegin(); it != path_.rend(); ++it)
+        ops_.writeCompressedInt(*it);
+
+    triggerAsyncUpdate();
+    return true;
+}
+
+void MirroredValueTree::valueTreePropertyChanged(juce::ValueTree& node, const juce::Identifier& property)
+{
+    const auto* value = node.getPropertyPointer(property);
+
+    if (!beginOp(value != nullptr ? IPC_MIRROR_SET_PROPERTY : IPC_MIRROR_REMOVE_PROPERTY, node))
+        return;
+
+    ops_.writeString(property.toString());
+    if (value != nullptr)
+        value->writeToStream(ops_);
+}
+
+void MirroredValueTree::valueTreeChildAdded(juce::ValueTree& parent, juce::ValueTree& child)
+{
+    if (!beginOp(IPC_MIRROR_ADD_CHILD, parent))
+        return;
+
+    // Serialized now: later changes to the child follow as their own operations
+    ops_.writeCompressedInt(parent.indexOf(child));
+    child.writeToStream(ops_);
+}
+
+void MirroredValueTree::valueTreeChildRemoved(juce::ValueTree& parent, juce::ValueTree&, int index)
+{
+    if (beginOp(IPC_MIRROR_REMOVE_CHILD, parent))
+        ops_.writeCompressedInt(index);
+}
+
+void MirroredValueTree::valueTreeChildOrderChanged(juce::ValueTree& parent, int oldIndex, int newIndex)
+{
+    // sort() reports 0, 0: the new order is only known by sending the children again
+    if (oldIndex == newIndex)
+    {
+        if (beginOp(IPC_MIRROR_REPLACE, parent))
+            parent.writeToStream(ops_);
+        return;
+    }
+
+    if (beginOp(IPC_MIRROR_MOVE_CHILD, parent))
+    {
+        ops_.writeCompressedInt(oldIndex);
+        ops_.writeCompressedInt(newIndex);
+    }
+}
+
+void MirroredValueTree::valueTreeRedirected(juce::ValueTree&)
+{
+    resync();
+}
+
+}  // namespace juce_cmp
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+#include <juce_events/juce_events.h>
+#include <cstdint>
+#include <vector>
+#include "ipc_protocol.h"
+
+namespace juce_cmp
+{
+
+class ComposeComponent;
+class ComposeProvider;
+
+/**
+ * MirroredValueTree - Keeps a replica of a ValueTree up to date in the UI.
+ *
+ * Listens to the tree and sends only what changed: property sets and
+ * removals, child additions, removals and moves, each addressed by its path
+ * of child indexes from the root. Changes made during one message-thread tick
+ * go out together as one batch, so traffic follows the size of the change,
+ * not the size of the tree.
+ *
+ * The whole tree is sent when the UI connects, when it asks (its replica
+ * missed a batch or couldn't apply one) and for sorts, which have no cheaper
+ * description. The UI side is juce_cmp.ipc.MirroredValueTree, matched by name.
+ *
+ * Needs IPC_CAP_MIRROR. Message thread only, like the tree it watches.
+ */
+class MirroredValueTree : private juce::ValueTree::Listener,
+                          private juce::AsyncUpdater
+{
+public:
+    MirroredValueTree(ComposeComponent& component, const juce::String& name, const juce::ValueTree& tree);
+    ~MirroredValueTree() override;
+
+    const juce::String& getName() const { return name_; }
+    juce::ValueTree getTree() const { return tree_; }
+
+    /** Send the whole tree with the next batch. */
+    void resync();
+
+    /** Send pending changes now instead of at the end of the tick. */
+    void flush();
+
+private:
+    void valueTreePropertyChanged(juce::ValueTree& node, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree& parent, juce::ValueTree& child) override;
+    void valueTreeChildRemoved(juce::ValueTree& parent, juce::ValueTree& child, int index) override;
+    void valueTreeChildOrderChanged(juce::ValueTree& parent, int oldIndex, int newIndex) override;
+    void valueTreeRedirected(juce::ValueTree& node) override;
+
+    void handleAsyncUpdate() override;
+
+    // Starts an operation on node; false if the whole tree goes out instead
+    bool beginOp(uint8_t op, const juce::ValueTree& node);
+
+    ComposeProvider& provider_;
+    const juce::String name_;
+    juce::ValueTree tree_;
+
+    juce::MemoryOutputStream ops_;  // Operations of the current batch
+    std::vector<int> path_;         // Scratch, reused between operations
+    uint32_t sequence_ = 0;
+    bool needsResync_ = true;       // Next batch is the whole tree
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MirroredValueTree)
+};
+
+}  // namespace juce_cmp
@@ -0,0 +1,270 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "ProcessWatcher.h"
+#include "ChildProcess.h"
+#include "ipc_protocol.h"
+
+#include <algorithm>
+#include <utility>
+
+#if __APPLE__ || __linux__
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+
+#if __linux__
+#include <sys/eventfd.h>
+#elif __APPLE__
+#include <sys/event.h>
+#endif
+
+namespace juce_cmp
+{
+
+ProcessWatcher::ProcessWatcher() = default;
+
+#if __APPLE__ || __linux__
+ProcessWatcher::~ProcessWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        quit_ = true;
+        wake();
+    }
+
+    if (thread_.joinable())
+        thread_.join();
+
+    if (wakeFD_ >= 0)
+        close(wakeFD_);
+}
+
+void ProcessWatcher::reap(pid_t pid, int pidFD, std::string cgroupDir)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    added_.push_back({ pid, pidFD, std::move(cgroupDir),
+                       std::chrono::steady_clock::now() + std::chrono::milliseconds(IPC_SHUTDOWN_TIMEOUT_MS) });
+    start();
+}
+
+int ProcessWatcher::countRunning(const std::string& executable, int maxAgeMs)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& count = counts_[executable];
+
+    const auto age = std::chrono::steady_clock::now() - count.countedAt;
+    if (!count.pending && !quit_ && age > std::chrono::milliseconds(maxAgeMs))
+    {
+        count.pending = true;
+        start();
+    }
+
+    return count.running;
+}
+
+void ProcessWatcher::start()
+{
+    if (running_)
+    {
+        wake();
+        return;
+    }
+
+    // A previous thread ran out of work and returned, or is about to
+    if (thread_.joinable())
+        thread_.join();
+
+    if (wakeFD_ < 0)
+    {
+#if __linux__
+        wakeFD_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#else
+        wakeFD_ = kqueue();
+        if (wakeFD_ >= 0)
+        {
+            struct kevent change;
+            EV_SET(&change, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+            kevent(wakeFD_, &change, 1, nullptr, 0, nullptr);
+        }
+#endif
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void ProcessWatcher::run()
+{
+    std::vector<Child> children;
+
+    for (;;)
+    {
+        bool quit;
+        std::vector<std::string> counting;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            quit = quit_;
+
+            for (auto& [executable, count] : counts_)
+            {
+                if (count.pending)
+                    counting.push_back(executable);
+            }
+
+            for (auto& child : added_)
+            {
+#if __APPLE__
+                // Fails if it exited already, which the check below sees
+                struct kevent change;
+                EV_SET(&change, child.pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr);
+                kevent(wakeFD_, &change, 1, nullptr, 0, nullptr);
+#endif
+                children.push_back(std::move(child));
+            }
+            added_.clear();
+
+            // Nothing left to wait for or count; start() makes a new thread
+            if (children.empty() && counting.empty())
+            {
+                running_ = false;
+                return;
+            }
+        }
+
+        // Reads the whole process table on Linux, hence not on the caller's thread
+        for (const auto& executable : counting)
+        {
+            const int running = quit ? 0 : ChildProcess::countRunning(executable);
+
+            std::lock_guard<std::mutex> lock(lock_);
+            counts_[executable] = { running, std::chrono::steady_clock::now(), false };
+        }
+
+        // EOF or CMP_EVENT_SHUTDOWN first, then SIGTERM, then SIGKILL; all
+        // of it at once when the watcher goes away
+        const auto now = std::chrono::steady_clock::now();
+        auto next = std::chrono::steady_clock::time_point::max();
+
+        for (auto it = children.begin(); it != children.end();)
+        {
+            int status;
+            if (waitpid(it->pid, &status, WNOHANG) != 0)  // Reaped, or not ours to reap
+            {
+                release(*it);
+                it = children.erase(it);
+                continue;
+            }
+
+            if (quit || (it->terminated && now >= it->deadline))
+            {
+                kill(it->pid, SIGKILL);
+                waitpid(it->pid, &status, 0);
+                release(*it);
+                it = children.erase(it);
+                continue;
+            }
+
+            if (now >= it->deadline)
+            {
+                kill(it->pid, SIGTERM);
+                it->terminated = true;
+                it->deadline = now + std::chrono::milliseconds(IPC_SHUTDOWN_TIMEOUT_MS);
+            }
+
+            next = std::min(next, it->deadline);
+            ++it;
+        }
+
+        if (!children.empty())
+            wait(children, next);
+    }
+}
+
+void ProcessWatcher::wait(const std::vector<Child>& children, std::chrono::steady_clock::time_point deadline)
+{
+    using namespace std::chrono;
+    int timeoutMs = static_cast<int>(duration_cast<milliseconds>(deadline - steady_clock::now()).count()) + 1;
+    timeoutMs = std::max(timeoutMs, 0);
+
+    // Without a way to be told, check every 10 ms
+    constexpr int pollIntervalMs = 10;
+
+#if __linux__
+    std::vector<struct pollfd> fds;
+    bool polling = wakeFD_ < 0;
+    if (wakeFD_ >= 0)
+        fds.push_back({ wakeFD_, POLLIN, 0 });
+
+    // Readable once the process exits; no pidfd before Linux 5.3
+    for (const auto& child : children)
+    {
+        if (child.pidFD >= 0)
+            fds.push_back({ child.pidFD, POLLIN, 0 });
+        else
+            polling = true;
+    }
+
+    if (polling)
+        timeoutMs = std::min(timeoutMs, pollIntervalMs);
+
+    poll(fds.data(), static_cast<nfds_t>(fds.size()), timeoutMs);
+
+    if (wakeFD_ >= 0 && (fds[0].revents & POLLIN) != 0)
+    {
+        eventfd_t count;
+        eventfd_read(wakeFD_, &count);
+    }
+#else
+    (void)children;
+
+    if (wakeFD_ < 0)
+    {
+        std::this_thread::sleep_for(milliseconds(std::min(timeoutMs, pollIntervalMs)));
+        return;
+    }
+
+    // Exits and wake-ups alike, handled by the caller's next pass
+    const struct timespec timeout = { timeoutMs / 1000, (timeoutMs % 1000) * 1000000L };
+    struct kevent events[8];
+    kevent(wakeFD_, nullptr, 0, events, 8, &timeout);
+#endif
+}
+
+void ProcessWatcher::wake()
+{
+    if (wakeFD_ < 0)
+        return;
+
+#if __linux__
+    eventfd_write(wakeFD_, 1);
+#else
+    struct kevent change;
+    EV_SET(&change, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+    kevent(wakeFD_, &change, 1, nullptr, 0, nullptr);
+#endif
+}
+
+void ProcessWatcher::release(const Child& child)
+{
+    if (child.pidFD >= 0)
+        close(child.pidFD);
+
+    // Empty now, so it can go
+    if (!child.cgroupDir.empty())
+        rmdir(child.cgroupDir.c_str());
+}
+#else
+ProcessWatcher::~ProcessWatcher() = default;
+
+int ProcessWatcher::countRunning(const std::string& executable, int maxAgeMs)
+{
+    (void)maxAgeMs;
+    return ChildProcess::countRunning(executable);
+}
+#endif
+
+}  // namespace juce_cmp
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __APPLE__ || __linux__
+#include <sys/types.h>
+#endif
+
+namespace juce_cmp
+{
+
+/**
+ * ProcessWatcher - Sees stopped UI processes out on one background thread,
+ * so neither stopping nor destroying an editor waits for them.
+ *
+ * A UI still running gets IPC_SHUTDOWN_TIMEOUT_MS to exit after its socket
+ * closes, then SIGTERM and as long again, then SIGKILL, and is reaped either
+ * way. Exits are seen on a pidfd (Linux 5.3+) or kqueue (macOS), not SIGCHLD,
+ * whose handler would be shared by every plugin in the host process.
+ *
+ * It also counts the UIs running in the host for MemoryPolicy, so the
+ * process table is read on its thread rather than the message thread.
+ *
+ * Keep one where it outlives the editors, e.g. in the AudioProcessor, and
+ * hand it to each ComposeComponent. The thread only runs while there are
+ * UIs to wait for or count. Destroying the watcher kills and reaps the UIs
+ * still left, so none of its code runs once the plugin is unloaded.
+ */
+class ProcessWatcher
+{
+public:
+    ProcessWatcher();
+    ~ProcessWatcher();
+
+    // Non-copyable
+    ProcessWatcher(const ProcessWatcher&) = delete;
+    ProcessWatcher& operator=(const ProcessWatcher&) = delete;
+
+    /** ChildProcess::countRunning(executable) as counted at most maxAgeMs
+     *  ago (any thread); 0 before the first count. Never waits: an older
+     *  count is recounted on the watcher's thread, for a later call. */
+    int countRunning(const std::string& executable, int maxAgeMs);
+
+#if __APPLE__ || __linux__
+    /** Take over a child whose socket was closed (any thread). pidFD (-1 for
+     *  none) is closed and cgroupDir removed once the child is reaped. */
+    void reap(pid_t pid, int pidFD, std::string cgroupDir);
+
+private:
+    struct Child
+    {
+        pid_t pid;
+        int pidFD;
+        std::string cgroupDir;
+        std::chrono::steady_clock::time_point deadline;
+        bool terminated = false;  // SIGTERM sent, SIGKILL at the deadline
+    };
+
+    struct Count
+    {
+        int running = 0;
+        std::chrono::steady_clock::time_point countedAt;
+        bool pending = false;  // Asked for, not counted yet
+    };
+
+    void start();
+    void run();
+    void wait(const std::vector<Child>& children, std::chrono::steady_clock::time_point deadline);
+    void wake();
+    static void release(const Child& child);
+
+    std::mutex lock_;
+    std::vector<Child> added_;  // Not yet picked up by the thread
+    std::map<std::string, Count> counts_;  // By executable
+    bool running_ = false;
+    bool quit_ = false;
+    std::thread thread_;
+
+    // Wakes the thread for new children and quitting: eventfd (Linux), or the
+    // kqueue exits are watched on, through EVFILT_USER (macOS). Made with the thread
+    int wakeFD_ = -1;
+#endif
+};
+
+}  // namespace juce_cmp
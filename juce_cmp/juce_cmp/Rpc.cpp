@@ -0,0 +1,345 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "Rpc.h"
+
+#include <vector>
+
+namespace juce_cmp
+{
+
+namespace
+{
+    constexpr int timerIntervalMs = 20;  // Timeout resolution
+
+    juce::ValueTree makeError(const juce::String& message)
+    {
+        juce::ValueTree error("error");
+        error.setProperty("message", message, nullptr);
+        return error;
+    }
+
+    // Counter comparison that survives the 49-day wrap
+    bool hasPassed(uint32_t deadline, uint32_t now)
+    {
+        return static_cast<int32_t>(now - deadline) >= 0;
+    }
+}
+
+// =============================================================================
+// Reply
+// =============================================================================
+
+struct Rpc::Reply::Call
+{
+    Call(std::shared_ptr<Link> l, uint32_t i) : link(std::move(l)), id(i) {}
+
+    // Last copy of the Reply gone: don't leave the UI waiting
+    ~Call()
+    {
+        std::lock_guard<std::mutex> lock(link->lock);
+        if (link->rpc == nullptr)
+            return;
+
+        if (!answered.load() && !cancelled.load())
+            link->rpc->sendReply(id, IPC_RPC_ERROR, makeError("No reply"));
+
+        link->rpc->forgetIncoming(id);
+    }
+
+    void answer(uint8_t kind, const juce::ValueTree& tree)
+    {
+        if (answered.exchange(true))
+            return;
+
+        std::lock_guard<std::mutex> lock(link->lock);
+        if (link->rpc != nullptr && !cancelled.load())
+            link->rpc->sendReply(id, kind, tree);
+    }
+
+    std::shared_ptr<Link> link;
+    const uint32_t id;
+    std::atomic<bool> answered { false };
+    std::atomic<bool> cancelled { false };
+};
+
+void Rpc::Reply::send(const juce::ValueTree& result) const
+{
+    call->answer(IPC_RPC_RESPONSE, result);
+}
+
+void Rpc::Reply::fail(const juce::String& message) const
+{
+    call->answer(IPC_RPC_ERROR, makeError(message));
+}
+
+bool Rpc::Reply::isCancelled() const
+{
+    return call->cancelled.load();
+}
+
+// =============================================================================
+// Rpc
+// =============================================================================
+
+Rpc::Rpc(Ipc& ipc)
+    : ipc_(ipc), link_(std::make_shared<Link>())
+{
+    link_->rpc = this;
+    ipc_.setRpcHandler([this](const RpcHeader& header, const juce::ValueTree& tree) {
+        handleMessage(header, tree);
+    });
+}
+
+Rpc::~Rpc()
+{
+    // The Ipc is stopped by now, so no more messages come in
+    stopTimer();
+
+    {
+        std::lock_guard<std::mutex> lock(link_->lock);
+        link_->rpc = nullptr;
+    }
+
+    failAll("Disconnected");
+}
+
+uint32_t Rpc::call(const juce::ValueTree& request, Callback callback, int timeoutMs, uint8_t lane)
+{
+    Pending pending;
+    pending.callback = std::move(callback);
+    return start(request, std::move(pending), timeoutMs, lane);
+}
+
+std::future<Rpc::Result> Rpc::callForFuture(const juce::ValueTree& request, int timeoutMs, uint8_t lane)
+{
+    Pending pending;
+    pending.promise = std::make_shared<std::promise<Result>>();
+    auto future = pending.promise->get_future();
+    start(request, std::move(pending), timeoutMs, lane);
+    return future;
+}
+
+uint32_t Rpc::start(const juce::ValueTree& request, Pending pending, int timeoutMs, uint8_t lane)
+{
+    const auto timeout = static_cast<uint32_t>(juce::jmax(0, timeoutMs));
+    pending.hasDeadline = timeout > 0;
+    pending.deadline = juce::Time::getMillisecondCounter() + timeout;
+
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        id = nextId_++;
+        if (nextId_ == 0)
+            nextId_ = 1;
+
+        // Registered before sending, so even the fastest reply finds it
+        pending_.emplace(id, std::move(pending));
+    }
+
+    if (!ipc_.sendRpc(IPC_RPC_REQUEST, id, timeout, request, lane))
+    {
+        complete(id, { {}, "RPC not available" });
+        return id;
+    }
+
+    if (timeout > 0)
+    {
+        // Under the lock, so timerCallback() can't stop it right after
+        std::lock_guard<std::mutex> lock(lock_);
+        if (!isTimerRunning())
+            startTimer(timerIntervalMs);
+    }
+
+    return id;
+}
+
+void Rpc::cancel(uint32_t id)
+{
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        found = pending_.count(id) > 0;
+    }
+
+    if (!found)
+        return;
+
+    ipc_.sendRpc(IPC_RPC_CANCEL, id, 0, {}, IPC_LANE_CONTROL);
+    complete(id, { {}, "Cancelled" });
+}
+
+void Rpc::failAll(const juce::String& error)
+{
+    std::unordered_map<uint32_t, Pending> failed;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        failed.swap(pending_);
+    }
+
+    for (auto& entry : failed)
+        deliver(std::move(entry.second), { {}, error });
+}
+
+size_t Rpc::getNumPending() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return pending_.size();
+}
+
+void Rpc::setHandler(const juce::Identifier& method, Handler handler)
+{
+    if (handler)
+        handlers_[method.toString()] = std::move(handler);
+    else
+        handlers_.erase(method.toString());
+}
+
+void Rpc::complete(uint32_t id, Result result)
+{
+    Pending pending;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = pending_.find(id);
+        if (it == pending_.end())
+            return;  // Already timed out or cancelled
+
+        pending = std::move(it->second);
+        pending_.erase(it);
+    }
+
+    deliver(std::move(pending), std::move(result));
+}
+
+void Rpc::deliver(Pending pending, Result result)
+{
+    if (pending.promise)
+        pending.promise->set_value(result);
+
+    // Doesn't touch the Rpc, which may be gone by the time this runs
+    if (pending.callback)
+    {
+        juce::MessageManager::callAsync([callback = std::move(pending.callback), result = std::move(result)]() {
+            callback(result);
+        });
+    }
+}
+
+void Rpc::timerCallback()
+{
+    const auto now = juce::Time::getMillisecondCounter();
+    std::vector<std::pair<uint32_t, Pending>> expired;
+    bool anyDeadline = false;
+
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto it = pending_.begin(); it != pending_.end();)
+        {
+            if (it->second.hasDeadline && hasPassed(it->second.deadline, now))
+            {
+                expired.emplace_back(it->first, std::move(it->second));
+                it = pending_.erase(it);
+            }
+            else
+            {
+                anyDeadline = anyDeadline || it->second.hasDeadline;
+                ++it;
+            }
+        }
+
+        if (!anyDeadline)
+            stopTimer();
+    }
+
+    for (auto& entry : expired)
+    {
+        // Let the UI stop working on it
+        ipc_.sendRpc(IPC_RPC_CANCEL, entry.first, 0, {}, IPC_LANE_CONTROL);
+        deliver(std::move(entry.second), { {}, "Timed out" });
+    }
+}
+
+// =============================================================================
+// Incoming (IPC reader thread)
+// =============================================================================
+
+void Rpc::handleMessage(const RpcHeader& header, const juce::ValueTree& tree)
+{
+    switch (header.kind)
+    {
+        case IPC_RPC_REQUEST:
+            handleRequest(header.id, tree);
+            break;
+        case IPC_RPC_RESPONSE:
+            complete(header.id, { tree, {} });
+            break;
+        case IPC_RPC_ERROR:
+            complete(header.id, { {}, tree.getProperty("message", "Error").toString() });
+            break;
+        case IPC_RPC_CANCEL:
+            handleCancel(header.id);
+            break;
+        default:
+            break;
+    }
+}
+
+void Rpc::handleRequest(uint32_t id, const juce::ValueTree& request)
+{
+    auto call = std::make_shared<Reply::Call>(link_, id);
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        incoming_[id] = call;
+    }
+
+    juce::MessageManager::callAsync([link = link_, call = std::move(call), request]() mutable {
+        // Only destroyed on this thread, so it stays alive while the handler runs
+        Rpc* rpc = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(link->lock);
+            rpc = link->rpc;
+        }
+
+        Reply reply(std::move(call));
+        if (rpc == nullptr || reply.isCancelled())
+            return;
+
+        auto it = rpc->handlers_.find(request.getType().toString());
+        if (it == rpc->handlers_.end())
+            reply.fail("Unknown method: " + request.getType().toString());
+        else
+            it->second(request, std::move(reply));
+    });
+}
+
+void Rpc::handleCancel(uint32_t id)
+{
+    std::shared_ptr<Reply::Call> call;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = incoming_.find(id);
+        if (it != incoming_.end())
+            call = it->second.lock();
+    }
+
+    // Outside the lock: this may be the last reference, and ~Call takes it
+    if (call != nullptr)
+        call->cancelled.store(true);
+}
+
+// =============================================================================
+// Reply plumbing (called with the link locked)
+// =============================================================================
+
+void Rpc::sendReply(uint32_t id, uint8_t kind, const juce::ValueTree& tree)
+{
+    ipc_.sendRpc(kind, id, 0, tree, IPC_LANE_CONTROL);
+}
+
+void Rpc::forgetIncoming(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    incoming_.erase(id);
+}
+
+}  // namespace juce_cmp
@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+#include <juce_events/juce_events.h>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "ipc_protocol.h"
+#include "Ipc.h"
+
+namespace juce_cmp
+{
+
+/**
+ * Rpc - Request/response calls over Ipc, in both directions.
+ *
+ * A request is a ValueTree whose type names the method; the answer is another
+ * ValueTree or an error message. Each request carries a correlation id, so any
+ * number of calls can be in flight at once and replies may arrive in any order:
+ * ten independent queries cost one round trip, not ten.
+ *
+ * Every call completes exactly once - with the result, an error from the UI,
+ * a timeout, a cancellation or a disconnect - and its pending entry goes away
+ * with it. Needs IPC_CAP_RPC, i.e. a UI that has completed the handshake;
+ * calls made before then fail right away.
+ */
+class Rpc : private juce::Timer
+{
+public:
+    struct Result
+    {
+        juce::ValueTree value;  // Invalid on failure
+        juce::String error;     // Empty on success
+
+        bool wasOk() const { return error.isEmpty(); }
+    };
+
+    /** Called on the message thread. */
+    using Callback = std::function<void(const Result& result)>;
+
+    /**
+     * Answers one request from the UI. Copyable; the first send() or fail()
+     * wins. If every copy is dropped without answering, the UI gets an error.
+     */
+    class Reply
+    {
+    public:
+        void send(const juce::ValueTree& result) const;
+        void fail(const juce::String& message) const;
+
+        /** True once the UI cancelled or gave up waiting; the answer would be ignored. */
+        bool isCancelled() const;
+
+    private:
+        friend class Rpc;
+        struct Call;
+        explicit Reply(std::shared_ptr<Call> c) : call(std::move(c)) {}
+
+        std::shared_ptr<Call> call;
+    };
+
+    /** Called on the message thread for requests from the UI. */
+    using Handler = std::function<void(const juce::ValueTree& request, Reply reply)>;
+
+    static constexpr int defaultTimeoutMs = 5000;
+
+    explicit Rpc(Ipc& ipc);
+    ~Rpc() override;
+
+    /**
+     * Call a UI method. Returns an id for cancel(). Use IPC_LANE_BULK for
+     * requests carrying large trees. A timeout of 0 waits until disconnect.
+     */
+    uint32_t call(const juce::ValueTree& request, Callback callback,
+                  int timeoutMs = defaultTimeoutMs, uint8_t lane = IPC_LANE_CONTROL);
+
+    /**
+     * Same, completing a future instead (from the IPC reader thread, or the
+     * message thread for timeouts). Don't block the message thread on it.
+     */
+    std::future<Result> callForFuture(const juce::ValueTree& request,
+                                      int timeoutMs = defaultTimeoutMs, uint8_t lane = IPC_LANE_CONTROL);
+
+    /** Give up on a call; it completes with an error and the UI is told to stop. */
+    void cancel(uint32_t id);
+
+    /** Fail every pending call, e.g. when the UI went away. Any thread. */
+    void failAll(const juce::String& error);
+
+    /** Number of calls still waiting for an answer. */
+    size_t getNumPending() const;
+
+    /** Register the handler for requests of this type (message thread). */
+    void setHandler(const juce::Identifier& method, Handler handler);
+
+private:
+    struct Pending
+    {
+        Callback callback;
+        std::shared_ptr<std::promise<Result>> promise;
+        bool hasDeadline = false;
+        uint32_t deadline = 0;  // Time::getMillisecondCounter()
+    };
+
+    // Shared with Reply objects, which may outlive this Rpc
+    struct Link
+    {
+        std::mutex lock;
+        Rpc* rpc = nullptr;
+    };
+
+    uint32_t start(const juce::ValueTree& request, Pending pending, int timeoutMs, uint8_t lane);
+    void complete(uint32_t id, Result result);
+    static void deliver(Pending pending, Result result);
+
+    // IPC reader thread
+    void handleMessage(const RpcHeader& header, const juce::ValueTree& tree);
+    void handleRequest(uint32_t id, const juce::ValueTree& request);
+    void handleCancel(uint32_t id);
+
+    // Reply plumbing
+    void sendReply(uint32_t id, uint8_t kind, const juce::ValueTree& tree);
+    void forgetIncoming(uint32_t id);
+
+    void timerCallback() override;
+
+    Ipc& ipc_;
+    std::shared_ptr<Link> link_;
+
+    mutable std::mutex lock_;
+    uint32_t nextId_ = 1;
+    std::unordered_map<uint32_t, Pending> pending_;
+    std::unordered_map<uint32_t, std::weak_ptr<Reply::Call>> incoming_;
+
+    std::map<juce::String, Handler> handlers_;  // Message thread only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Rpc)
+};
+
+}  // namespace juce_cmp
@@ -0,0 +1,191 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "SharedBlob.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if __APPLE__ || __linux__
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif
+
+namespace juce_cmp
+{
+
+namespace
+{
+#if __linux__
+    int createSharedMemory()
+    {
+        return memfd_create("juce_cmp_blob", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    }
+#elif __APPLE__
+    int createSharedMemory()
+    {
+        // No memfd on macOS: create a uniquely named object and unlink it
+        // right away so only the descriptor refers to it
+        for (int attempt = 0; attempt < 8; ++attempt)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+
+            // PSHMNAMLEN is 31 characters
+            const std::string name = "/jcmp." + std::to_string(getpid()) + "."
+                                   + std::to_string((ts.tv_nsec + attempt) % 100000000);
+
+            int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd >= 0)
+            {
+                shm_unlink(name.c_str());
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                return fd;
+            }
+            if (errno != EEXIST)
+                return -1;
+        }
+        return -1;
+    }
+#endif
+}
+
+SharedBlob::~SharedBlob()
+{
+    release();
+}
+
+SharedBlob::SharedBlob(SharedBlob&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0))
+{
+}
+
+SharedBlob& SharedBlob::operator=(SharedBlob&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        fd_ = std::exchange(other.fd_, -1);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+SharedBlob SharedBlob::create(const void* data, size_t size)
+{
+    SharedBlob blob;
+#if __APPLE__ || __linux__
+    if (size == 0)
+        return blob;
+
+    int fd = createSharedMemory();
+    if (fd < 0)
+        return blob;
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        close(fd);
+        return blob;
+    }
+
+    // macOS shared memory objects can't be written with write(), so map it
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(fd);
+        return blob;
+    }
+
+    std::memcpy(mapping, data, size);
+    munmap(mapping, size);
+
+#if __linux__
+    // Writable mappings are gone, so the write seal can be applied
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+#endif
+
+    blob.fd_ = fd;
+    blob.size_ = size;
+#else
+    (void)data;
+    (void)size;
+#endif
+    return blob;
+}
+
+SharedBlob SharedBlob::map(int fd, size_t size)
+{
+    SharedBlob blob;
+#if __APPLE__ || __linux__
+    if (fd < 0)
+        return blob;
+
+    // Never map past the end of the object (SIGBUS on access)
+    struct stat st;
+    if (size == 0 || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size)
+    {
+        close(fd);
+        return blob;
+    }
+
+#if __linux__
+    // Unsealed memory could be truncated by the sender while we read it
+    const int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & F_SEAL_SHRINK) == 0)
+    {
+        close(fd);
+        return blob;
+    }
+#endif
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(fd);
+        return blob;
+    }
+
+    blob.fd_ = fd;
+    blob.data_ = mapping;
+    blob.size_ = size;
+#else
+    (void)fd;
+    (void)size;
+#endif
+    return blob;
+}
+
+SharedBlob SharedBlob::share(int fd)
+{
+    SharedBlob blob;
+#if __APPLE__ || __linux__
+    if (fd >= 0)
+        blob.fd_ = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+#else
+    (void)fd;
+#endif
+    return blob;
+}
+
+void SharedBlob::release()
+{
+#if __APPLE__ || __linux__
+    if (data_ != nullptr)
+        munmap(data_, size_);
+    if (fd_ >= 0)
+        close(fd_);
+#endif
+    fd_ = -1;
+    data_ = nullptr;
+    size_ = 0;
+}
+
+}  // namespace juce_cmp
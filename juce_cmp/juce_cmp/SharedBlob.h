@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+
+namespace juce_cmp
+{
+
+/**
+ * SharedBlob - Read-only shared memory block passed between processes by
+ * file descriptor (SCM_RIGHTS), for payloads too large for the socket.
+ *
+ * On Linux: sealed memfd (the receiver can trust it won't change or shrink).
+ * On macOS: anonymous POSIX shared memory (shm_open + shm_unlink).
+ *
+ * Owns its descriptor and mapping; move-only.
+ */
+class SharedBlob
+{
+public:
+    SharedBlob() = default;
+    ~SharedBlob();
+
+    SharedBlob(SharedBlob&& other) noexcept;
+    SharedBlob& operator=(SharedBlob&& other) noexcept;
+
+    // Non-copyable
+    SharedBlob(const SharedBlob&) = delete;
+    SharedBlob& operator=(const SharedBlob&) = delete;
+
+    /** Sender side: copy data into a new blob. Invalid on failure. */
+    static SharedBlob create(const void* data, size_t size);
+
+    /** Receiver side: take ownership of fd and map size bytes read-only. Invalid on failure. */
+    static SharedBlob map(int fd, size_t size);
+
+    /** Sender side: a duplicate of fd to pass along unmapped, e.g. a Surface. Invalid on failure. */
+    static SharedBlob share(int fd);
+
+    bool isValid() const { return fd_ >= 0; }
+    int getFD() const { return fd_; }
+    const void* getData() const { return data_; }
+    size_t getSize() const { return size_; }
+
+    void release();
+
+private:
+    int fd_ = -1;
+    void* data_ = nullptr;  // Receiver mapping only
+    size_t size_ = 0;
+};
+
+}  // namespace juce_cmp
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "ipc_protocol.h"
+
+namespace juce_cmp
+{
+
+/**
+ * Stats - Snapshot of embedding performance numbers.
+ *
+ * UI process values and rates are refreshed by the child's periodic
+ * CMP_EVENT_STATS report (about once per second) and its
+ * CMP_EVENT_MEMORY_TRIMMED answers; IPC totals are live.
+ */
+struct Stats
+{
+    // UI process
+    float fps = 0.0f;
+    float frameTimeP50 = 0.0f;  // ms
+    float frameTimeP95 = 0.0f;
+    float frameTimeP99 = 0.0f;
+    float frameTimeMax = 0.0f;
+    uint64_t childResidentBytes = 0;
+    double childCpuSeconds = 0.0;
+    float childCpuLoad = 0.0f;  // Fraction of one core over the last interval
+
+    // Memory pressure: level the UI has (IPC_MEMORY_PRESSURE_*), trims it answered
+    uint8_t memoryPressure = IPC_MEMORY_PRESSURE_NONE;
+    uint32_t memoryTrims = 0;
+    uint64_t trimResidentBefore = 0;  // Around the last trim
+    uint64_t trimResidentAfter = 0;
+
+    // IPC rates over the last report interval
+    float txMessagesPerSecond = 0.0f;
+    float txBytesPerSecond = 0.0f;
+    float rxMessagesPerSecond = 0.0f;
+    float rxBytesPerSecond = 0.0f;
+
+    // IPC totals
+    uint64_t txMessages = 0;
+    uint64_t txBytes = 0;
+    uint64_t rxMessages = 0;
+    uint64_t rxBytes = 0;
+    uint64_t txDropped = 0;     // Messages not delivered (socket full or closed)
+    uint64_t txQueueBytes = 0;  // Bytes queued or waiting in the socket send buffer
+    uint64_t txLaneBytes[IPC_LANE_COUNT] = {};  // Per IPC_LANE_*
+};
+
+/**
+ * SeqLock - Single-writer, multi-reader snapshot of a trivially copyable value.
+ *
+ * Readers never block the writer; they retry if a write overlapped the copy.
+ */
+template <typename T>
+class SeqLock
+{
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+    void store(const T& value) noexcept
+    {
+        Words words {};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const auto seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < numWords; ++i)
+            data_[i].store(words[i], std::memory_order_relaxed);
+
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const noexcept
+    {
+        Words words {};
+
+        for (;;)
+        {
+            const auto before = sequence_.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;  // Write in progress
+
+            for (size_t i = 0; i < numWords; ++i)
+                words[i] = data_[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before)
+                break;
+        }
+
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t numWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    using Words = std::array<uint64_t, numWords>;
+
+    std::atomic<uint64_t> sequence_ { 0 };
+    std::array<std::atomic<uint64_t>, numWords> data_ {};
+};
+
+}  // namespace juce_cmp
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "StatsOverlay.h"
+
+namespace juce_cmp
+{
+
+namespace
+{
+    juce::String formatBytes(double bytes)
+    {
+        if (bytes >= 1024.0 * 1024.0)
+            return juce::String(bytes / (1024.0 * 1024.0), 1) + " MB";
+        if (bytes >= 1024.0)
+            return juce::String(bytes / 1024.0, 1) + " KB";
+        return juce::String((int)bytes) + " B";
+    }
+}
+
+StatsOverlay::StatsOverlay(StatsSource source)
+    : source_(std::move(source))
+{
+    setOpaque(false);
+    setInterceptsMouseClicks(false, false);
+    setSize(220, 133);
+    startTimerHz(2);
+}
+
+StatsOverlay::~StatsOverlay()
+{
+    stopTimer();
+}
+
+void StatsOverlay::attach(void* nativeParent)
+{
+    // Re-adding moves the overlay to the top of the parent's subviews
+    if (isOnDesktop())
+        removeFromDesktop();
+
+    if (nativeParent != nullptr)
+        addToDesktop(juce::ComponentPeer::windowIgnoresMouseClicks, nativeParent);
+
+    setVisible(nativeParent != nullptr);
+}
+
+void StatsOverlay::timerCallback()
+{
+    if (source_)
+        stats_ = source_();
+    repaint();
+}
+
+void StatsOverlay::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.65f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 4.0f);
+
+    const juce::String lines[] = {
+        juce::String(stats_.fps, 1) + " fps",
+        "frame p50 " + juce::String(stats_.frameTimeP50, 2) + " p95 " + juce::String(stats_.frameTimeP95, 2)
+            + " ms",
+        "frame p99 " + juce::String(stats_.frameTimeP99, 2) + " max " + juce::String(stats_.frameTimeMax, 2)
+            + " ms",
+        "ui mem " + formatBytes((double)stats_.childResidentBytes)
+            + "  cpu " + juce::String(stats_.childCpuLoad * 100.0f, 0) + "%"
+            + (stats_.memoryPressure > 0 ? "  pressure " + juce::String(stats_.memoryPressure) : juce::String()),
+        "tx " + juce::String(stats_.txMessagesPerSecond, 0) + "/s " + formatBytes(stats_.txBytesPerSecond) + "/s",
+        "rx " + juce::String(stats_.rxMessagesPerSecond, 0) + "/s " + formatBytes(stats_.rxBytesPerSecond) + "/s",
+        "tx queue " + formatBytes((double)stats_.txQueueBytes) + "  dropped " + juce::String((juce::int64)stats_.txDropped),
+        "lanes " + formatBytes((double)stats_.txLaneBytes[IPC_LANE_INPUT])
+            + " / " + formatBytes((double)stats_.txLaneBytes[IPC_LANE_CONTROL])
+            + " / " + formatBytes((double)stats_.txLaneBytes[IPC_LANE_BULK])
+    };
+
+    g.setColour(juce::Colours::white);
+    g.setFont(juce::FontOptions(11.0f).withName(juce::Font::getDefaultMonospacedFontName()));
+
+    auto area = getLocalBounds().reduced(6, 4);
+    for (const auto& line : lines)
+        g.drawText(line, area.removeFromTop(15), juce::Justification::centredLeft, false);
+}
+
+}  // namespace juce_cmp
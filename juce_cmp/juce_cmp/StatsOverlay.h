@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Stats.h"
+#include <functional>
+
+namespace juce_cmp
+{
+
+/**
+ * StatsOverlay - Debug readout of frame times, child resources and IPC traffic.
+ *
+ * The Compose surface is a native view stacked above the JUCE component, so
+ * the overlay is added to the desktop as a child of the same native parent
+ * (after the surface view) instead of being painted by ComposeComponent.
+ */
+class StatsOverlay : public juce::Component, private juce::Timer
+{
+public:
+    using StatsSource = std::function<Stats()>;
+
+    explicit StatsOverlay(StatsSource source);
+    ~StatsOverlay() override;
+
+    /** Attach above the surface view inside the given native parent. */
+    void attach(void* nativeParent);
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    void timerCallback() override;
+
+    StatsSource source_;
+    Stats stats_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StatsOverlay)
+};
+
+}  // namespace juce_cmp
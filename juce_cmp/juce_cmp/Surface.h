@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace juce_cmp
@@ -14,7 +15,9 @@ namespace juce_cmp
  * On macOS: Uses IOSurface for zero-copy GPU sharing.
  *           Surfaces are shared via Mach port IPC (see MachPort.h).
  * On Windows: Will use DXGI shared textures (TODO)
- * On Linux: Will use DMA-BUF file descriptors (TODO)
+ * On Linux: Shared memory (memfd) holding BGRA pixels, passed to the UI by
+ *           descriptor with CMP_EVENT_SURFACE. Enough for headless runs and
+ *           the stub child; DMA-BUF for GPU sharing is still TODO.
  */
 class Surface
 {
@@ -46,17 +49,40 @@ public:
      */
     uint32_t createMachPort() const;
 
-    /** Get the native surface handle (IOSurfaceRef on macOS). */
+    /**
+     * Descriptor of the shared memory (Linux only), for CMP_EVENT_SURFACE.
+     * Still owned by the surface. Returns -1 elsewhere or on failure.
+     */
+    int getFD() const;
+
+    /** Get the native surface handle (IOSurfaceRef on macOS, pixel mapping on Linux). */
     void* getNativeHandle() const;
 
     /** Get current dimensions. */
     int getWidth() const { return width_; }
     int getHeight() const { return height_; }
 
+    /** Row length in pixels (Linux only, equals the width there). */
+    int getStride() const { return width_; }
+
 private:
 #if __APPLE__
     void* surface_ = nullptr;          // IOSurfaceRef
     void* previousSurface_ = nullptr;  // Keep alive during resize transition
+#elif __linux__
+    /** One memfd and its mapping. */
+    struct Buffer
+    {
+        int fd = -1;
+        void* pixels = nullptr;
+        size_t size = 0;
+    };
+
+    static bool allocateBuffer(Buffer& buffer, int width, int height);
+    static void freeBuffer(Buffer& buffer);
+
+    Buffer surface_;
+    Buffer previousSurface_;  // Keep alive during resize transition
 #endif
     int width_ = 0;
     int height_ = 0;
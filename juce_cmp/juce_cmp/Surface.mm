@@ -110,6 +110,11 @@ uint32_t Surface::createMachPort() const
 #endif
 }
 
+int Surface::getFD() const
+{
+    return -1;
+}
+
 void* Surface::getNativeHandle() const
 {
     return surface_;
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "Surface.h"
+
+#include <utility>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+namespace juce_cmp
+{
+
+Surface::Surface() = default;
+
+Surface::~Surface()
+{
+    release();
+}
+
+bool Surface::allocateBuffer(Buffer& buffer, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return false;
+
+    const size_t size = (size_t)width * (size_t)height * 4;
+
+    // Not sealed: the UI writes into it, and it's never resized, only replaced
+    int fd = memfd_create("juce_cmp_surface", MFD_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* pixels = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pixels == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    buffer.fd = fd;
+    buffer.pixels = pixels;
+    buffer.size = size;
+    return true;
+}
+
+void Surface::freeBuffer(Buffer& buffer)
+{
+    if (buffer.pixels != nullptr)
+        munmap(buffer.pixels, buffer.size);
+    if (buffer.fd >= 0)
+        close(buffer.fd);
+    buffer = Buffer();
+}
+
+bool Surface::create(int width, int height)
+{
+    release();
+
+    if (!allocateBuffer(surface_, width, height))
+        return false;
+
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+bool Surface::resize(int width, int height)
+{
+    Buffer newSurface;
+    if (!allocateBuffer(newSurface, width, height))
+        return false;
+
+    // Keep previous surface alive - view may still be displaying it
+    freeBuffer(previousSurface_);
+    previousSurface_ = std::exchange(surface_, newSurface);
+
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+void Surface::release()
+{
+    freeBuffer(previousSurface_);
+    freeBuffer(surface_);
+    width_ = 0;
+    height_ = 0;
+}
+
+bool Surface::isValid() const
+{
+    return surface_.pixels != nullptr;
+}
+
+uint32_t Surface::createMachPort() const
+{
+    return 0;
+}
+
+int Surface::getFD() const
+{
+    return surface_.fd;
+}
+
+void* Surface::getNativeHandle() const
+{
+    return surface_.pixels;
+}
+
+}  // namespace juce_cmp
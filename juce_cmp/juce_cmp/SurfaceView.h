@@ -14,7 +14,7 @@ namespace juce_cmp
  *
  * On macOS: NSView with CALayer for IOSurface display
  * On Windows: Will use HWND with Direct3D (TODO)
- * On Linux: Will use X11/Wayland with Vulkan (TODO)
+ * On Linux: Headless, nothing is displayed yet; X11/Wayland is TODO
  *
  * This is a C++ wrapper around the platform-native view.
  */
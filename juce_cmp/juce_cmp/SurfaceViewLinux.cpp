@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "SurfaceView.h"
+
+namespace juce_cmp
+{
+
+// Headless for now: frames land in the shared Surface and nothing shows them.
+// An X11/Wayland view would display Surface::getNativeHandle() pixels here.
+
+SurfaceView::SurfaceView() = default;
+
+SurfaceView::~SurfaceView()
+{
+    destroy();
+}
+
+bool SurfaceView::create()
+{
+    return true;
+}
+
+void SurfaceView::destroy()
+{
+}
+
+bool SurfaceView::isValid() const
+{
+    return nativeView_ != nullptr;
+}
+
+void SurfaceView::setSurface(void* surface)
+{
+    (void)surface;
+}
+
+void SurfaceView::setPendingSurface(void* surface)
+{
+    (void)surface;
+}
+
+void SurfaceView::setBackingScale(float scale)
+{
+    (void)scale;
+}
+
+void SurfaceView::attachToParent(void* parentView)
+{
+    (void)parentView;
+}
+
+void SurfaceView::detachFromParent()
+{
+}
+
+void SurfaceView::setFrame(int x, int y, int width, int height)
+{
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+}
+
+float SurfaceView::getBackingScaleForView(void* nativeView)
+{
+    (void)nativeView;
+    return 1.0f;
+}
+
+}  // namespace juce_cmp
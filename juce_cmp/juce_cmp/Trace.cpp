@@ -0,0 +1,315 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "Trace.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace juce_cmp
+{
+
+namespace
+{
+    const char* const traceNames[TRACE_NAME_COUNT] = {
+        "IPC send",
+        "IPC receive",
+        "callAsync",
+        "Resize",
+        "Surface swap",
+        "Frame",
+        "Compose",
+        "Flush",
+        "Surface ready"
+    };
+
+    const char* getTraceName(uint8_t name)
+    {
+        return name < TRACE_NAME_COUNT ? traceNames[name] : "Unknown";
+    }
+
+    juce::String formatMicros(int64_t nanos)
+    {
+        return juce::String(static_cast<double>(nanos) / 1000.0, 3);
+    }
+}
+
+struct Tracer::ThreadBuffer
+{
+    std::atomic<std::thread::id> owner {};
+    std::atomic<uint32_t> count { 0 };  // Total records written, wraps over capacity
+    TraceRecord records[bufferCapacity];
+};
+
+Tracer::Tracer() = default;
+
+Tracer::~Tracer() = default;
+
+void Tracer::start()
+{
+    stop();
+
+    // Buffers are never freed while the tracer lives, so a thread that
+    // raced past a previous stop() cannot write into released memory
+    if (!buffers_)
+        buffers_.reset(new ThreadBuffer[maxThreads]);
+
+    for (size_t i = 0; i < maxThreads; ++i)
+    {
+        buffers_[i].owner.store(std::thread::id());
+        buffers_[i].count.store(0);
+    }
+    slotlessRecords_.store(0);
+
+    {
+        std::lock_guard<std::mutex> lock(remoteLock_);
+        if (!remoteRecords_)
+            remoteRecords_.reset(new TraceRecord[remoteCapacity]);
+        remoteCount_ = 0;
+        clockOffset_ = 0;
+        bestRoundTrip_ = -1;
+    }
+
+    startTime_ = now();
+    enabled_.store(true, std::memory_order_release);
+}
+
+void Tracer::stop()
+{
+    enabled_.store(false, std::memory_order_release);
+}
+
+int64_t Tracer::now() noexcept
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::instant(uint8_t name, uint32_t arg) noexcept
+{
+    if (isEnabled())
+        record(name, TRACE_PHASE_INSTANT, now(), 0, arg);
+}
+
+void Tracer::complete(uint8_t name, int64_t startTime, uint32_t arg) noexcept
+{
+    if (isEnabled())
+        record(name, TRACE_PHASE_COMPLETE, startTime, now() - startTime, arg);
+}
+
+void Tracer::setCurrentThreadName(const char* name) noexcept
+{
+    const auto self = std::this_thread::get_id();
+
+    // A thread restarted under the same name (Ipc reader and writer after a
+    // UI restart) continues the previous one's entry and buffer
+    for (auto& entry : threadNames_)
+    {
+        const char* current = entry.name.load();
+        auto previous = entry.thread.load();
+        if (current == nullptr || previous == self || std::strcmp(current, name) != 0)
+            continue;
+
+        if (!entry.thread.compare_exchange_strong(previous, self))
+            continue;
+
+        if (buffers_ && !hasBuffer(self))
+        {
+            for (size_t i = 0; i < maxThreads; ++i)
+            {
+                auto owner = previous;
+                if (buffers_[i].owner.compare_exchange_strong(owner, self, std::memory_order_acq_rel))
+                    break;
+            }
+        }
+        return;
+    }
+
+    for (auto& entry : threadNames_)
+    {
+        auto thread = entry.thread.load();
+        if (thread == std::thread::id() && entry.thread.compare_exchange_strong(thread, self))
+            thread = self;
+
+        if (thread == self)
+        {
+            entry.name.store(name);
+            return;
+        }
+    }
+}
+
+bool Tracer::hasBuffer(std::thread::id thread) const noexcept
+{
+    for (size_t i = 0; i < maxThreads; ++i)
+        if (buffers_[i].owner.load(std::memory_order_acquire) == thread)
+            return true;
+
+    return false;
+}
+
+const char* Tracer::getThreadName(std::thread::id thread) const noexcept
+{
+    for (const auto& entry : threadNames_)
+        if (entry.thread.load() == thread)
+            return entry.name.load();
+
+    return nullptr;
+}
+
+Tracer::ThreadBuffer* Tracer::getBufferForCurrentThread() noexcept
+{
+    const auto self = std::this_thread::get_id();
+
+    for (size_t i = 0; i < maxThreads; ++i)
+    {
+        auto owner = buffers_[i].owner.load(std::memory_order_acquire);
+        if (owner == self)
+            return &buffers_[i];
+
+        // Claim a free slot; on failure someone else took it, keep looking
+        if (owner == std::thread::id() && buffers_[i].owner.compare_exchange_strong(owner, self))
+            return &buffers_[i];
+    }
+
+    return nullptr;  // More threads than slots - drop the event
+}
+
+void Tracer::record(uint8_t name, uint8_t phase, int64_t timestamp, int64_t duration, uint32_t arg) noexcept
+{
+    if (!enabled_.load(std::memory_order_acquire))
+        return;
+
+    auto* buffer = getBufferForCurrentThread();
+    if (buffer == nullptr)
+    {
+        slotlessRecords_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Single writer per buffer, so a plain read-modify-write is enough
+    const uint32_t index = buffer->count.load(std::memory_order_relaxed);
+    auto& r = buffer->records[index % bufferCapacity];
+    r.timestamp = timestamp;
+    r.duration = duration;
+    r.arg = arg;
+    r.name = name;
+    r.phase = phase;
+    r.thread = static_cast<uint16_t>(buffer - buffers_.get());
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::addClockSample(int64_t hostSent, int64_t remoteTime, int64_t hostReceived)
+{
+    const int64_t roundTrip = hostReceived - hostSent;
+    if (roundTrip < 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(remoteLock_);
+    if (bestRoundTrip_ < 0 || roundTrip < bestRoundTrip_)
+    {
+        // Assume symmetric latency: remote clock was read halfway through
+        bestRoundTrip_ = roundTrip;
+        clockOffset_ = remoteTime - (hostSent + roundTrip / 2);
+    }
+}
+
+void Tracer::addRemoteRecords(const TraceRecord* records, size_t count)
+{
+    std::lock_guard<std::mutex> lock(remoteLock_);
+    if (!remoteRecords_)
+        return;
+
+    for (size_t i = 0; i < count; ++i)
+        remoteRecords_[remoteCount_++ % remoteCapacity] = records[i];
+}
+
+bool Tracer::writeChromeTrace(const juce::File& file) const
+{
+    juce::FileOutputStream out(file);
+    if (!out.openedOk())
+        return false;
+
+    out.setPosition(0);
+    out.truncate();
+
+    constexpr int hostPid = 1;
+    constexpr int uiPid = 2;
+    bool first = true;
+
+    auto writeSeparator = [&]() {
+        if (!first)
+            out << ",\n";
+        first = false;
+    };
+
+    auto writeMetadata = [&](const char* kind, int pid, int tid, const juce::String& value) {
+        writeSeparator();
+        out << "{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":" << tid
+            << ",\"args\":{\"name\":" << juce::JSON::toString(value) << "}}";
+    };
+
+    auto writeRecord = [&](const TraceRecord& r, int pid, int64_t offset) {
+        writeSeparator();
+        const int64_t ts = r.timestamp - offset - startTime_;
+        out << "{\"name\":\"" << getTraceName(r.name) << "\",\"pid\":" << pid
+            << ",\"tid\":" << (int)r.thread + 1
+            << ",\"ts\":" << formatMicros(ts);
+        if (r.phase == TRACE_PHASE_COMPLETE)
+            out << ",\"ph\":\"X\",\"dur\":" << formatMicros(r.duration);
+        else
+            out << ",\"ph\":\"i\",\"s\":\"t\"";
+        out << ",\"args\":{\"arg\":" << (juce::int64)r.arg << "}}";
+    };
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    auto writeProcessName = [&](int pid, const char* name, uint64_t dropped) {
+        writeMetadata("process_name", pid, 0,
+                      dropped > 0 ? juce::String(name) + " (" + juce::String((juce::int64)dropped) + " records dropped)"
+                                  : juce::String(name));
+    };
+
+    // Overwritten in full buffers, or never recorded for lack of one
+    uint64_t hostDropped = slotlessRecords_.load(std::memory_order_relaxed);
+
+    if (buffers_)
+    {
+        for (size_t i = 0; i < maxThreads; ++i)
+        {
+            const auto& buffer = buffers_[i];
+            const auto owner = buffer.owner.load();
+            if (owner == std::thread::id())
+                continue;
+
+            const char* name = getThreadName(owner);
+            writeMetadata("thread_name", hostPid, (int)i + 1,
+                          name != nullptr ? juce::String(name) : "Thread " + juce::String((int)i + 1));
+
+            const uint32_t count = buffer.count.load(std::memory_order_acquire);
+            const uint32_t available = juce::jmin(count, bufferCapacity);
+            hostDropped += count - available;
+            for (uint32_t n = count - available; n < count; ++n)
+                writeRecord(buffer.records[n % bufferCapacity], hostPid, 0);
+        }
+    }
+
+    writeProcessName(hostPid, "Host", hostDropped);
+
+    {
+        std::lock_guard<std::mutex> lock(remoteLock_);
+        const uint64_t dropped = remoteCount_ - juce::jmin(remoteCount_, remoteCapacity);
+        writeProcessName(uiPid, "UI", dropped);
+
+        for (uint64_t n = dropped; n < remoteCount_; ++n)
+            writeRecord(remoteRecords_[n % remoteCapacity], uiPid, clockOffset_);
+    }
+
+    out << "\n]}\n";
+    out.flush();
+
+    return out.getStatus().wasOk();
+}
+
+}  // namespace juce_cmp
@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "ipc_protocol.h"
+
+namespace juce_cmp
+{
+
+/**
+ * Tracer - Opt-in timeline recorder for host and UI process events.
+ *
+ * Every recording thread claims one fixed-size ring buffer on first use, so
+ * recording is lock-free and never allocates. While tracing is off, a record
+ * call costs one relaxed atomic load. Buffers are allocated on first start().
+ * A named thread takes over the buffer of the exited one of the same name,
+ * so restarted threads don't use up the slots; records of threads left
+ * without one are counted as dropped in the exported host process name.
+ *
+ * UI process events arrive over IPC (CMP_EVENT_TRACE_DATA) and are moved onto
+ * the host clock using the offset from CMP_EVENT_CLOCK_SYNC round trips (the
+ * sample with the shortest round trip wins). They go to one fixed-size ring
+ * too; when it's full the oldest are dropped, and the drop count is written
+ * into the exported UI process name.
+ *
+ * The result is written as Chrome trace JSON, viewable in chrome://tracing
+ * or https://ui.perfetto.dev
+ */
+class Tracer
+{
+public:
+    Tracer();
+    ~Tracer();
+
+    /** Clear previous data and start recording. */
+    void start();
+
+    /** Stop recording. Recorded data is kept until the next start(). */
+    void stop();
+
+    bool isEnabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /** Monotonic time in nanoseconds. */
+    static int64_t now() noexcept;
+
+    // Recording (any thread)
+    void instant(uint8_t name, uint32_t arg = 0) noexcept;
+    void complete(uint8_t name, int64_t startTime, uint32_t arg = 0) noexcept;
+
+    /** Label the calling thread in the exported trace (may be called while
+     *  tracing is off). Name must outlive the tracer. A thread named like
+     *  one before it continues its timeline, so that one must have exited. */
+    void setCurrentThreadName(const char* name) noexcept;
+
+    // UI process events (called from the IPC reader thread)
+    void addClockSample(int64_t hostSent, int64_t remoteTime, int64_t hostReceived);
+    void addRemoteRecords(const TraceRecord* records, size_t count);
+
+    /** Write host and UI events as Chrome trace JSON. */
+    bool writeChromeTrace(const juce::File& file) const;
+
+private:
+    struct ThreadBuffer;
+
+    struct ThreadName
+    {
+        std::atomic<std::thread::id> thread {};
+        std::atomic<const char*> name { nullptr };
+    };
+
+    ThreadBuffer* getBufferForCurrentThread() noexcept;
+    bool hasBuffer(std::thread::id thread) const noexcept;
+    const char* getThreadName(std::thread::id thread) const noexcept;
+    void record(uint8_t name, uint8_t phase, int64_t timestamp, int64_t duration, uint32_t arg) noexcept;
+
+    static constexpr size_t maxThreads = 8;
+    static constexpr uint32_t bufferCapacity = 8192;
+    static constexpr uint64_t remoteCapacity = 65536;
+
+    std::atomic<bool> enabled_ { false };
+    std::unique_ptr<ThreadBuffer[]> buffers_;
+    ThreadName threadNames_[maxThreads];
+    std::atomic<uint64_t> slotlessRecords_ { 0 };  // From threads without a buffer
+    int64_t startTime_ = 0;
+
+    mutable std::mutex remoteLock_;
+    std::unique_ptr<TraceRecord[]> remoteRecords_;
+    uint64_t remoteCount_ = 0;  // Total records received, wraps over capacity
+    int64_t clockOffset_ = 0;
+    int64_t bestRoundTrip_ = -1;
+
+    JUCE_DECLARE_NON_COPYABLE(Tracer)
+};
+
+/**
+ * TraceScope - RAII helper recording a complete event for its lifetime.
+ * Does nothing when tracer is null or tracing is off at construction.
+ */
+class TraceScope
+{
+public:
+    TraceScope(Tracer* tracer, uint8_t name, uint32_t arg = 0) noexcept
+        : tracer_(tracer != nullptr && tracer->isEnabled() ? tracer : nullptr),
+          name_(name),
+          arg_(arg),
+          start_(tracer_ != nullptr ? Tracer::now() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (tracer_ != nullptr)
+            tracer_->complete(name_, start_, arg_);
+    }
+
+    void setArg(uint32_t arg) noexcept { arg_ = arg; }
+
+private:
+    Tracer* tracer_;
+    uint8_t name_;
+    uint32_t arg_;
+    int64_t start_;
+
+    JUCE_DECLARE_NON_COPYABLE(TraceScope)
+};
+
+}  // namespace juce_cmp
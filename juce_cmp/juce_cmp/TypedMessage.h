@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "ipc_protocol.h"
+
+namespace juce_cmp
+{
+
+/**
+ * TypedMessage - A received EVENT_TYPE_TYPED message, valid during the callback.
+ *
+ * Typed messages are fixed-layout structs generated from a message schema
+ * (see cmake/generate_messages.cmake), with a matching Kotlin data class on
+ * the UI side. They skip ValueTree construction and name lookups entirely:
+ * the fields are copied in and out of a packed little-endian buffer and the
+ * receiver picks the struct by its 16-bit id. The library only carries them;
+ * ids and layouts belong to the app.
+ *
+ * Decode with the dispatch() function generated next to the structs.
+ */
+struct TypedMessage
+{
+    uint16_t id = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+/** Field access for generated encode()/decode(), in the protocol's byte order. */
+namespace wire
+{
+    template <typename T>
+    constexpr size_t sizeOf() noexcept
+    {
+        static_assert(std::is_arithmetic_v<T>, "Typed message fields are numbers or bools");
+        return std::is_same_v<T, bool> ? 1 : sizeof(T);
+    }
+
+    template <typename T>
+    inline void write(uint8_t* out, T value) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            *out = value ? 1 : 0;
+        else
+            std::memcpy(out, &value, sizeof(T));
+    }
+
+    template <typename T>
+    inline T read(const uint8_t* in) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            return *in != 0;
+        }
+        else
+        {
+            T value;
+            std::memcpy(&value, in, sizeof(T));
+            return value;
+        }
+    }
+}
+
+}  // namespace juce_cmp
@@ -0,0 +1,533 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#include "ValueTreeView.h"
+#include "TypedMessage.h"
+
+#include <cstring>
+
+namespace juce_cmp
+{
+
+/** Bounds-checked cursor over the serialized bytes. */
+class ValueTreeView::Reader
+{
+public:
+    Reader(const uint8_t* data, const uint8_t* end) : p_(data), end_(end) {}
+
+    const uint8_t* position() const noexcept { return p_; }
+    size_t remaining() const noexcept { return static_cast<size_t>(end_ - p_); }
+
+    bool skip(size_t size) noexcept
+    {
+        if (size > remaining())
+            return false;
+        p_ += size;
+        return true;
+    }
+
+    bool readByte(uint8_t& value) noexcept
+    {
+        if (p_ == end_)
+            return false;
+        value = *p_++;
+        return true;
+    }
+
+    /** A null-terminated string, left in place. */
+    bool readString(const char*& string) noexcept
+    {
+        const auto* terminator = p_ != end_ ? static_cast<const uint8_t*>(std::memchr(p_, 0, remaining())) : nullptr;
+        if (terminator == nullptr)
+            return false;
+
+        string = reinterpret_cast<const char*>(p_);
+        p_ = terminator + 1;
+        return true;
+    }
+
+    /** OutputStream::writeCompressedInt: a byte count (top bit for negative), then little-endian bytes. */
+    bool readCompressedInt(int& value) noexcept
+    {
+        uint8_t sizeByte = 0;
+        if (!readByte(sizeByte))
+            return false;
+
+        const int numBytes = sizeByte & 0x7F;
+        if (numBytes > 4 || static_cast<size_t>(numBytes) > remaining())
+            return false;
+
+        uint32_t magnitude = 0;
+        for (int i = 0; i < numBytes; ++i)
+            magnitude |= static_cast<uint32_t>(*p_++) << (8 * i);
+
+        value = (sizeByte & 0x80) != 0 ? -static_cast<int>(magnitude) : static_cast<int>(magnitude);
+        return true;
+    }
+
+    bool readVarint(uint32_t& value) noexcept
+    {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            uint8_t byte = 0;
+            if (!readByte(byte))
+                return false;
+
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    /** A property or child count, which can't exceed the bytes left whatever the input claims. */
+    bool readCount(bool interned, int& count) noexcept
+    {
+        if (interned)
+        {
+            uint32_t value = 0;
+            if (!readVarint(value) || value > remaining())
+                return false;
+            count = static_cast<int>(value);
+            return true;
+        }
+
+        return readCompressedInt(count) && count >= 0 && static_cast<size_t>(count) <= remaining();
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+// =============================================================================
+// Value
+// =============================================================================
+
+int ValueTreeView::Value::toInt() const noexcept
+{
+    switch (marker_)
+    {
+        case markerInt:      return wire::read<int32_t>(data_);
+        case markerInt64:    return static_cast<int>(wire::read<int64_t>(data_));
+        case markerDouble:   return static_cast<int>(wire::read<double>(data_));
+        case markerBoolTrue: return 1;
+        case markerString:   return getStringRef().text.getIntValue32();
+        default:             return 0;
+    }
+}
+
+juce::int64 ValueTreeView::Value::toInt64() const noexcept
+{
+    switch (marker_)
+    {
+        case markerInt:      return wire::read<int32_t>(data_);
+        case markerInt64:    return wire::read<int64_t>(data_);
+        case markerDouble:   return static_cast<juce::int64>(wire::read<double>(data_));
+        case markerBoolTrue: return 1;
+        case markerString:   return getStringRef().text.getIntValue64();
+        default:             return 0;
+    }
+}
+
+double ValueTreeView::Value::toDouble() const noexcept
+{
+    switch (marker_)
+    {
+        case markerInt:      return wire::read<int32_t>(data_);
+        case markerInt64:    return static_cast<double>(wire::read<int64_t>(data_));
+        case markerDouble:   return wire::read<double>(data_);
+        case markerBoolTrue: return 1.0;
+        case markerString:   return getStringRef().text.getDoubleValue();
+        default:             return 0.0;
+    }
+}
+
+bool ValueTreeView::Value::toBool() const
+{
+    switch (marker_)
+    {
+        case markerInt:       return wire::read<int32_t>(data_) != 0;
+        case markerInt64:     return wire::read<int64_t>(data_) != 0;
+        case markerDouble:    return wire::read<double>(data_) != 0.0;
+        case markerBoolTrue:  return true;
+        case markerString:    return static_cast<bool>(toVar());
+        default:              return false;
+    }
+}
+
+juce::String ValueTreeView::Value::toString() const
+{
+    if (marker_ != markerString)
+        return toVar().toString();
+
+    // Written with its terminator, which the length leaves out
+    const auto length = size_ > 0 && data_[size_ - 1] == 0 ? size_ - 1 : size_;
+    return juce::String::fromUTF8(reinterpret_cast<const char*>(data_), static_cast<int>(length));
+}
+
+juce::StringRef ValueTreeView::Value::getStringRef() const noexcept
+{
+    if (marker_ != markerString || size_ == 0 || data_[size_ - 1] != 0)
+        return juce::StringRef();
+
+    return juce::StringRef(reinterpret_cast<const char*>(data_));
+}
+
+juce::var ValueTreeView::Value::toVar() const
+{
+    switch (marker_)
+    {
+        case markerVoid:      return {};
+        case markerInt:       return wire::read<int32_t>(data_);
+        case markerInt64:     return static_cast<juce::int64>(wire::read<int64_t>(data_));
+        case markerDouble:    return wire::read<double>(data_);
+        case markerBoolTrue:  return true;
+        case markerBoolFalse: return false;
+        case markerString:    return toString();
+        case markerBinary:    return juce::var(data_, size_);
+        case markerUndefined: return juce::var::undefined();
+        default:
+        {
+            // Arrays and anything newer: let var read its own format
+            if (stream_ == nullptr)
+                return {};
+
+            juce::MemoryInputStream stream(stream_, streamSize_, false);
+            return juce::var::readFromStream(stream);
+        }
+    }
+}
+
+// =============================================================================
+// Iterator
+// =============================================================================
+
+ValueTreeView::Iterator& ValueTreeView::Iterator::operator++()
+{
+    if (--remaining_ > 0)
+        child_ = ValueTreeView(child_.end_, end_, child_.dictionary_, nullptr);
+    else
+        child_ = {};
+
+    return *this;
+}
+
+// =============================================================================
+// ValueTreeView
+// =============================================================================
+
+ValueTreeView::ValueTreeView(const void* data, size_t size)
+    : ValueTreeView(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size, nullptr, nullptr)
+{
+}
+
+ValueTreeView::ValueTreeView(const void* data, size_t size, const IdentifierDecoder& dictionary)
+    : ValueTreeView(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size, &dictionary, nullptr)
+{
+}
+
+ValueTreeView ValueTreeView::readInterned(const void* data, size_t size, IdentifierDecoder& dictionary)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    return ValueTreeView(bytes, bytes + size, &dictionary, &dictionary);
+}
+
+ValueTreeView::ValueTreeView(const uint8_t* data, const uint8_t* end, const IdentifierDecoder* dictionary,
+                             IdentifierDecoder* definer)
+{
+    if (data == nullptr)
+        return;
+
+    Reader in(data, end);
+    if (!scanTree(in, dictionary, definer, 0, this))
+        *this = {};
+}
+
+juce::Identifier ValueTreeView::getType() const
+{
+    return isValid() ? toIdentifier(type_) : juce::Identifier();
+}
+
+bool ValueTreeView::hasType(const juce::Identifier& type) const noexcept
+{
+    return isValid() && matches(type_, type);
+}
+
+juce::Identifier ValueTreeView::getPropertyName(int index) const
+{
+    Reader in(properties_, end_);
+    for (int i = 0; i < numProperties_; ++i)
+    {
+        Name name;
+        Value value;
+        readName(in, dictionary_, nullptr, name);
+        readValue(in, dictionary_ != nullptr, value);
+
+        if (i == index)
+            return toIdentifier(name);
+    }
+    return {};
+}
+
+bool ValueTreeView::hasProperty(const juce::Identifier& name) const noexcept
+{
+    Reader in(properties_, end_);
+    for (int i = 0; i < numProperties_; ++i)
+    {
+        Name candidate;
+        Value value;
+        readName(in, dictionary_, nullptr, candidate);
+        readValue(in, dictionary_ != nullptr, value);
+
+        if (matches(candidate, name))
+            return true;
+    }
+    return false;
+}
+
+ValueTreeView::Value ValueTreeView::getProperty(const juce::Identifier& name) const noexcept
+{
+    // Already checked, so reading can't fail
+    Reader in(properties_, end_);
+    for (int i = 0; i < numProperties_; ++i)
+    {
+        Name candidate;
+        Value value;
+        readName(in, dictionary_, nullptr, candidate);
+        readValue(in, dictionary_ != nullptr, value);
+
+        if (matches(candidate, name))
+            return value;
+    }
+    return {};
+}
+
+ValueTreeView ValueTreeView::getChild(int index) const noexcept
+{
+    int i = 0;
+    for (auto child : *this)
+    {
+        if (i++ == index)
+            return child;
+    }
+    return {};
+}
+
+ValueTreeView ValueTreeView::getChildWithName(const juce::Identifier& type) const noexcept
+{
+    for (auto child : *this)
+    {
+        if (child.hasType(type))
+            return child;
+    }
+    return {};
+}
+
+ValueTreeView::Iterator ValueTreeView::begin() const noexcept
+{
+    if (numChildren_ == 0)
+        return end();
+
+    return Iterator(ValueTreeView(children_, end_, dictionary_, nullptr), end_, numChildren_);
+}
+
+juce::ValueTree ValueTreeView::toValueTree() const
+{
+    if (!isValid())
+        return {};
+
+    if (dictionary_ == nullptr)
+        return juce::ValueTree::readFromData(data_, getSize());
+
+    juce::ValueTree tree(getType());
+
+    Reader in(properties_, end_);
+    for (int i = 0; i < numProperties_; ++i)
+    {
+        Name name;
+        Value value;
+        readName(in, dictionary_, nullptr, name);
+        readValue(in, true, value);
+        tree.setProperty(toIdentifier(name), value.toVar(), nullptr);
+    }
+
+    for (auto child : *this)
+        tree.appendChild(child.toValueTree(), nullptr);
+
+    return tree;
+}
+
+bool ValueTreeView::scanTree(Reader& in, const IdentifierDecoder* dictionary, IdentifierDecoder* definer, int depth,
+                             ValueTreeView* view)
+{
+    const bool interned = dictionary != nullptr;
+    const auto* start = in.position();
+
+    Name type;
+    if (depth > maxDepth || !readName(in, dictionary, definer, type))
+        return false;
+
+    int numProperties = 0;
+    if (!in.readCount(interned, numProperties))
+        return false;
+
+    const auto* properties = in.position();
+    for (int i = 0; i < numProperties; ++i)
+    {
+        Name name;
+        Value value;
+        if (!readName(in, dictionary, definer, name) || !readValue(in, interned, value))
+            return false;
+    }
+
+    int numChildren = 0;
+    if (!in.readCount(interned, numChildren))
+        return false;
+
+    const auto* children = in.position();
+    for (int i = 0; i < numChildren; ++i)
+    {
+        if (!scanTree(in, dictionary, definer, depth + 1, nullptr))
+            return false;
+    }
+
+    if (view != nullptr)
+    {
+        view->data_ = start;
+        view->end_ = in.position();
+        view->dictionary_ = dictionary;
+        view->type_ = type;
+        view->numProperties_ = numProperties;
+        view->numChildren_ = numChildren;
+        view->properties_ = properties;
+        view->children_ = children;
+    }
+    return true;
+}
+
+bool ValueTreeView::readName(Reader& in, const IdentifierDecoder* dictionary, IdentifierDecoder* definer, Name& name)
+{
+    name = {};
+
+    uint32_t reference = IPC_DICT_LITERAL;
+    if (dictionary != nullptr && !in.readVarint(reference))
+        return false;
+
+    if (reference >= IPC_DICT_FIRST_TOKEN)
+    {
+        name.entry = dictionary->lookup(reference - IPC_DICT_FIRST_TOKEN);
+        return name.entry != nullptr;  // Out of step with the encoder if missing
+    }
+
+    if (!in.readString(name.string) || *name.string == 0)
+        return false;
+
+    return reference != IPC_DICT_DEFINE || definer == nullptr || definer->define(juce::Identifier(name.string));
+}
+
+bool ValueTreeView::readValue(Reader& in, bool interned, Value& value)
+{
+    value = {};
+
+    if (!interned)
+        return readStreamValue(in, value);
+
+    if (!in.readByte(value.marker_))
+        return false;
+
+    value.data_ = in.position();
+
+    switch (value.marker_)
+    {
+        case IPC_DICT_VAR_VOID:
+        case Value::markerBoolTrue:
+        case Value::markerBoolFalse:
+        case Value::markerUndefined:
+            return true;
+
+        case Value::markerInt:
+            value.size_ = 4;
+            return in.skip(value.size_);
+
+        case Value::markerDouble:
+        case Value::markerInt64:
+            value.size_ = 8;
+            return in.skip(value.size_);
+
+        case Value::markerString:
+        {
+            const char* string = nullptr;
+            if (!in.readString(string))
+                return false;
+            value.size_ = static_cast<size_t>(in.position() - value.data_);
+            return true;
+        }
+
+        case Value::markerBinary:
+        {
+            int size = 0;
+            if (!in.readCount(true, size))
+                return false;
+            value.data_ = in.position();
+            value.size_ = static_cast<size_t>(size);
+            return in.skip(value.size_);
+        }
+
+        case IPC_DICT_VAR_STREAM:
+            return readStreamValue(in, value);
+
+        default:
+            return false;
+    }
+}
+
+bool ValueTreeView::readStreamValue(Reader& in, Value& value)
+{
+    // var::writeToStream: byte count, then marker and data
+    const auto* start = in.position();
+
+    int numBytes = 0;
+    if (!in.readCompressedInt(numBytes) || numBytes < 0 || static_cast<size_t>(numBytes) > in.remaining())
+        return false;
+
+    value = {};
+    if (numBytes == 0)
+        return true;
+
+    in.readByte(value.marker_);
+    value.data_ = in.position();
+    value.size_ = static_cast<size_t>(numBytes - 1);
+    in.skip(value.size_);
+
+    value.stream_ = start;
+    value.streamSize_ = static_cast<size_t>(in.position() - start);
+
+    // Fixed-size values must be all there
+    switch (value.marker_)
+    {
+        case Value::markerInt:    return value.size_ >= 4;
+        case Value::markerDouble:
+        case Value::markerInt64:  return value.size_ >= 8;
+        default:                  return true;
+    }
+}
+
+bool ValueTreeView::matches(const Name& name, const juce::Identifier& identifier) noexcept
+{
+    if (name.entry != nullptr)
+        return *name.entry == identifier;
+
+    return name.string != nullptr && std::strcmp(name.string, identifier.getCharPointer().getAddress()) == 0;
+}
+
+juce::Identifier ValueTreeView::toIdentifier(const Name& name)
+{
+    if (name.entry != nullptr)
+        return *name.entry;
+
+    return name.string != nullptr ? juce::Identifier(name.string) : juce::Identifier();
+}
+
+}  // namespace juce_cmp
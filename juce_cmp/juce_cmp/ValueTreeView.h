@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+#include <cstdint>
+#include "IdentifierDictionary.h"
+
+namespace juce_cmp
+{
+
+/**
+ * ValueTreeView - Reads a serialized ValueTree in place, without building it.
+ *
+ * Wraps bytes in ValueTree::writeToStream format, or in the interned
+ * IPC_CODEC_DICT format given the decoder that holds its names, and answers
+ * the usual questions - type, properties by name, children - by scanning
+ * them. Nothing is allocated, so a handler that reads an id and a value never
+ * pays for ref-counted nodes, vars and name lookups. Call toValueTree() to
+ * keep the whole tree.
+ *
+ * The input is checked once when the view is created; a malformed one gives
+ * an invalid view. The bytes must outlive the view and its children.
+ */
+class ValueTreeView
+{
+public:
+    /** A property value in place. Strings and binary data stay in the buffer until converted. */
+    class Value
+    {
+    public:
+        bool isVoid() const noexcept { return marker_ == markerVoid; }
+        bool isUndefined() const noexcept { return marker_ == markerUndefined; }
+        bool isInt() const noexcept { return marker_ == markerInt; }
+        bool isInt64() const noexcept { return marker_ == markerInt64; }
+        bool isDouble() const noexcept { return marker_ == markerDouble; }
+        bool isBool() const noexcept { return marker_ == markerBoolTrue || marker_ == markerBoolFalse; }
+        bool isString() const noexcept { return marker_ == markerString; }
+        bool isBinaryData() const noexcept { return marker_ == markerBinary; }
+
+        // Converted like juce::var does; numbers are parsed out of strings without copying them
+        int toInt() const noexcept;
+        juce::int64 toInt64() const noexcept;
+        double toDouble() const noexcept;
+        bool toBool() const;
+        juce::String toString() const;
+
+        /** The characters of a string value, empty for other types. */
+        juce::StringRef getStringRef() const noexcept;
+
+        /** The bytes of a binary value. */
+        const void* getData() const noexcept { return data_; }
+        size_t getSize() const noexcept { return size_; }
+
+        juce::var toVar() const;
+
+    private:
+        friend class ValueTreeView;
+
+        // JUCE's VariantStreamMarkers, plus void
+        enum : uint8_t
+        {
+            markerVoid = 0,
+            markerInt = 1,
+            markerBoolTrue = 2,
+            markerBoolFalse = 3,
+            markerDouble = 4,
+            markerString = 5,
+            markerInt64 = 6,
+            markerArray = 7,
+            markerBinary = 8,
+            markerUndefined = 9
+        };
+
+        uint8_t marker_ = markerVoid;
+        const uint8_t* data_ = nullptr;    // After the marker
+        size_t size_ = 0;
+        const uint8_t* stream_ = nullptr;  // The whole var::writeToStream form, for types only var can read
+        size_t streamSize_ = 0;
+    };
+
+    class Iterator;
+
+    ValueTreeView() = default;
+
+    /** Bytes in ValueTree::writeToStream format. */
+    ValueTreeView(const void* data, size_t size);
+
+    /** Bytes in the interned format whose names are already in dictionary, which must outlive the view. */
+    ValueTreeView(const void* data, size_t size, const IdentifierDecoder& dictionary);
+
+    /**
+     * A newly received interned tree: also adds the names it defines to
+     * dictionary, as IdentifierDecoder::readTree() would. Call exactly once
+     * per message, in the order received.
+     */
+    static ValueTreeView readInterned(const void* data, size_t size, IdentifierDecoder& dictionary);
+
+    bool isValid() const noexcept { return data_ != nullptr; }
+
+    juce::Identifier getType() const;
+    bool hasType(const juce::Identifier& type) const noexcept;
+
+    int getNumProperties() const noexcept { return numProperties_; }
+    juce::Identifier getPropertyName(int index) const;
+    bool hasProperty(const juce::Identifier& name) const noexcept;
+
+    /** Void if there's no such property. */
+    Value getProperty(const juce::Identifier& name) const noexcept;
+
+    int getNumChildren() const noexcept { return numChildren_; }
+    ValueTreeView getChild(int index) const noexcept;
+    ValueTreeView getChildWithName(const juce::Identifier& type) const noexcept;
+
+    Iterator begin() const noexcept;
+    Iterator end() const noexcept;
+
+    /** Bytes this tree takes up, children included. */
+    size_t getSize() const noexcept { return static_cast<size_t>(end_ - data_); }
+
+    /** Build the whole tree, as ValueTree::readFromData() or IdentifierDecoder::readTree() would. */
+    juce::ValueTree toValueTree() const;
+
+private:
+    /** A type or property name: a string in the buffer or a dictionary token. */
+    struct Name
+    {
+        const char* string = nullptr;
+        const juce::Identifier* entry = nullptr;
+    };
+
+    class Reader;
+
+    static constexpr int maxDepth = 256;  // Bounds the recursion on malformed input
+
+    ValueTreeView(const uint8_t* data, const uint8_t* end, const IdentifierDecoder* dictionary, IdentifierDecoder* definer);
+
+    // Checks one tree, children included, and fills in view if given
+    static bool scanTree(Reader& in, const IdentifierDecoder* dictionary, IdentifierDecoder* definer, int depth,
+                         ValueTreeView* view);
+    static bool readName(Reader& in, const IdentifierDecoder* dictionary, IdentifierDecoder* definer, Name& name);
+    static bool readValue(Reader& in, bool interned, Value& value);
+    static bool readStreamValue(Reader& in, Value& value);
+    static bool matches(const Name& name, const juce::Identifier& identifier) noexcept;
+    static juce::Identifier toIdentifier(const Name& name);
+
+    const uint8_t* data_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    const IdentifierDecoder* dictionary_ = nullptr;  // Interned format if set
+    Name type_;
+    int numProperties_ = 0;
+    int numChildren_ = 0;
+    const uint8_t* properties_ = nullptr;
+    const uint8_t* children_ = nullptr;
+};
+
+/** Iterates children without building them. */
+class ValueTreeView::Iterator
+{
+public:
+    ValueTreeView operator*() const { return child_; }
+    Iterator& operator++();
+    bool operator==(const Iterator& other) const noexcept { return remaining_ == other.remaining_; }
+    bool operator!=(const Iterator& other) const noexcept { return remaining_ != other.remaining_; }
+
+private:
+    friend class ValueTreeView;
+    Iterator(ValueTreeView child, const uint8_t* end, int remaining) : child_(child), end_(end), remaining_(remaining) {}
+
+    ValueTreeView child_;
+    const uint8_t* end_ = nullptr;
+    int remaining_ = 0;
+};
+
+inline ValueTreeView::Iterator ValueTreeView::end() const noexcept { return Iterator({}, nullptr, 0); }
+
+}  // namespace juce_cmp
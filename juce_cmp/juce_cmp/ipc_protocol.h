@@ -16,29 +16,376 @@
 extern "C" {
 #endif
 
+/*
+ * Protocol version, passed to the UI as --protocol=<version>.
+ *
+ * Version 0 is the original protocol (no handshake). From version 1 on, a UI
+ * launched with --protocol sends CMP_EVENT_HELLO first; the host answers with
+ * the negotiated settings. Messages needing a capability are only sent once
+ * both sides have agreed on it, so either side can talk to an older peer.
+ */
+#define IPC_PROTOCOL_VERSION        1
+#define IPC_HELLO_MAGIC             0x504D434A  /* "JCMP" little-endian */
+#define IPC_MAX_MESSAGE_SIZE        (1024 * 1024)
+
+/*
+ * Capabilities (HelloMessage.capabilities bitmask)
+ */
+#define IPC_CAP_TRACE               (1u << 0)  /* CLOCK_SYNC, TRACE_CONTROL, TRACE_DATA */
+#define IPC_CAP_STATS               (1u << 1)  /* STATS */
+#define IPC_CAP_CHUNKS              (1u << 2)  /* EVENT_TYPE_CHUNK */
+#define IPC_CAP_RPC                 (1u << 3)  /* EVENT_TYPE_RPC */
+#define IPC_CAP_MIRROR              (1u << 4)  /* EVENT_TYPE_MIRROR */
+#define IPC_CAP_TYPED               (1u << 5)  /* EVENT_TYPE_TYPED */
+#define IPC_CAP_BATCH               (1u << 6)  /* EVENT_TYPE_BATCH */
+#define IPC_CAP_SHUTDOWN            (1u << 7)  /* CMP_EVENT_SHUTDOWN */
+#define IPC_CAP_MEMORY              (1u << 8)  /* CMP_EVENT_MEMORY_PRESSURE, CMP_EVENT_MEMORY_TRIMMED */
+
+/*
+ * Transports (HelloMessage.transports bitmask)
+ */
+#define IPC_TRANSPORT_SOCKET        (1u << 0)  /* Inline payloads on the socket, always set */
+#define IPC_TRANSPORT_BLOB          (1u << 1)  /* EVENT_TYPE_BLOB: shared memory passed by fd */
+#define IPC_TRANSPORT_SURFACE_FD    (1u << 2)  /* CMP_EVENT_SURFACE: shared pixel buffer by fd (Linux) */
+
+/*
+ * Payloads from this size on go out as EVENT_TYPE_BLOB when IPC_TRANSPORT_BLOB
+ * was agreed; the inline limit still applies otherwise.
+ */
+#define IPC_BLOB_THRESHOLD          (64 * 1024)
+#define IPC_MAX_BLOB_SIZE           (256 * 1024 * 1024)
+
+/*
+ * Payload codecs (HelloMessage.codecs bitmask)
+ */
+#define IPC_CODEC_RAW               (1u << 0)  /* Uncompressed, always set */
+#define IPC_CODEC_LZ4               (1u << 1)  /* LZ4 block format */
+#define IPC_CODEC_DICT              (1u << 2)  /* Interned identifiers, see EVENT_FLAG_INTERNED */
+
+/*
+ * JUCE payloads from this size on are compressed when IPC_CODEC_LZ4 was
+ * agreed; smaller ones cost more to compress than they save on a local socket.
+ * Sent raw anyway if compression doesn't shrink them.
+ */
+#define IPC_COMPRESS_THRESHOLD      (4 * 1024)
+
 /*
  * Event types (first byte of every message)
  */
 #define EVENT_TYPE_INPUT            0
 #define EVENT_TYPE_CMP              1
 #define EVENT_TYPE_JUCE             2
+#define EVENT_TYPE_BLOB             3
+#define EVENT_TYPE_CHUNK            4
+#define EVENT_TYPE_RPC              5
+#define EVENT_TYPE_MIRROR           6
+#define EVENT_TYPE_TYPED            7
+#define EVENT_TYPE_BATCH            8
+
+#define EVENT_FLAG_COMPRESSED       0x80  /* Or'ed into EVENT_TYPE_JUCE, _RPC or _MIRROR, see below */
+#define EVENT_FLAG_INTERNED         0x40  /* Or'ed into EVENT_TYPE_JUCE or _RPC, see below */
+
+/*
+ * Lanes, highest priority first. Each side sends queued messages from the
+ * highest-priority lane that has any; large messages are cut into chunks so
+ * other lanes can interleave. Order is kept within a lane, not across lanes.
+ */
+#define IPC_LANE_INPUT              0  /* Input events */
+#define IPC_LANE_CONTROL            1  /* Protocol messages, small ValueTrees */
+#define IPC_LANE_BULK               2  /* Large ValueTrees (state, presets) */
+#define IPC_LANE_COUNT              3
+
+#define IPC_CHUNK_SIZE              (16 * 1024)  /* Messages above this are chunked */
+
+#define IPC_TYPED_MAX_SIZE          1024  /* Largest EVENT_TYPE_TYPED message body */
+
+#define IPC_SHUTDOWN_TIMEOUT_MS     1000  /* Time the UI gets to exit once the host closes */
+
+/*
+ * Memory pressure levels (CMP_EVENT_MEMORY_PRESSURE)
+ */
+#define IPC_MEMORY_PRESSURE_NONE     0  /* Back to normal, nothing to release */
+#define IPC_MEMORY_PRESSURE_MODERATE 1  /* Trim caches, collect garbage */
+#define IPC_MEMORY_PRESSURE_CRITICAL 2  /* Also drop GPU resources and shrink the heap */
+
+/*
+ * Identifier dictionary (IPC_CODEC_DICT). Names in interned trees start with
+ * a 7-bit varint reference: DEFINE or LITERAL followed by the null-terminated
+ * UTF-8 string, or FIRST_TOKEN + n for the n-th name defined so far. Each
+ * direction has its own dictionary of up to MAX_ENTRIES names.
+ */
+#define IPC_DICT_DEFINE             0  /* Name follows and gets the next token */
+#define IPC_DICT_LITERAL            1  /* Name follows, dictionary is full */
+#define IPC_DICT_FIRST_TOKEN        2
+#define IPC_DICT_MAX_ENTRIES        1024
+
+/*
+ * Property values in interned trees: a JUCE var stream marker and its data,
+ * without the size prefix var::writeToStream puts first. 0 is void, strings
+ * are null-terminated UTF-8, binary data has a varint size; other types
+ * (arrays, objects) use VAR_STREAM followed by var::writeToStream.
+ */
+#define IPC_DICT_VAR_VOID           0x00
+#define IPC_DICT_VAR_STREAM         0xFF
+
+/*
+ * Chunk flags (CHUNK event)
+ */
+#define IPC_CHUNK_FIRST             (1u << 0)
+#define IPC_CHUNK_LAST              (1u << 1)
+
+/*
+ * RPC message kinds (RpcHeader.kind)
+ */
+#define IPC_RPC_REQUEST             0  /* ValueTree whose type names the method */
+#define IPC_RPC_RESPONSE            1  /* Result ValueTree */
+#define IPC_RPC_ERROR               2  /* ValueTree "error" with a "message" property */
+#define IPC_RPC_CANCEL              3  /* No ValueTree; the caller gave up */
+
+/*
+ * Mirror operations (EVENT_TYPE_MIRROR). Paths are a compressed-int depth
+ * followed by that many compressed-int child indexes from the root; strings,
+ * ints, vars and trees use JUCE's binary stream encoding.
+ */
+#define IPC_MIRROR_SET_PROPERTY     0  /* path + name + var */
+#define IPC_MIRROR_REMOVE_PROPERTY  1  /* path + name */
+#define IPC_MIRROR_ADD_CHILD        2  /* parent path + index + ValueTree */
+#define IPC_MIRROR_REMOVE_CHILD     3  /* parent path + index */
+#define IPC_MIRROR_MOVE_CHILD       4  /* parent path + old index + new index */
+#define IPC_MIRROR_REPLACE          5  /* path + ValueTree; empty path = whole tree */
+#define IPC_MIRROR_RESYNC_REQUEST   6  /* UI→Host, no fields: send the whole tree */
 
 /*
  * CMP event types (second byte for EVENT_TYPE_CMP)
  */
 #define CMP_EVENT_SURFACE_READY     0  /* UI→Host: surface ready to display */
+#define CMP_EVENT_CLOCK_SYNC        1  /* Bidirectional: clock offset sample */
+#define CMP_EVENT_TRACE_CONTROL     2  /* Host→UI: start/stop trace recording */
+#define CMP_EVENT_TRACE_DATA        3  /* UI→Host: batch of trace records */
+#define CMP_EVENT_STATS             4  /* UI→Host: periodic performance report */
+#define CMP_EVENT_HELLO             5  /* Bidirectional: version and capability handshake */
+#define CMP_EVENT_SURFACE           6  /* Host→UI: new surface to render into (Linux) */
+#define CMP_EVENT_SHUTDOWN          7  /* Host→UI: exit now, the host is closing */
+#define CMP_EVENT_MEMORY_PRESSURE   8  /* Host→UI: release what can be rebuilt */
+#define CMP_EVENT_MEMORY_TRIMMED    9  /* UI→Host: resident memory after a trim */
 
 /**
  * CMP event payload - 1 byte subtype, follows EVENT_TYPE_CMP prefix.
  *   CMP_EVENT_SURFACE_READY: Surface rendered and ready to display (no additional data)
+ *   CMP_EVENT_CLOCK_SYNC:    Host→UI: 8-byte host time (ns)
+ *                            UI→Host: 8-byte host time echoed + 8-byte UI time (ns)
+ *   CMP_EVENT_TRACE_CONTROL: 1 byte, nonzero = start recording, zero = stop
+ *   CMP_EVENT_TRACE_DATA:    1-byte final flag + 4-byte record count + TraceRecord[count]
+ *                            (final flag is set on the batch answering a stop request)
+ *   CMP_EVENT_STATS:         StatsReport, sent about once per second
+ *   CMP_EVENT_HELLO:         HelloMessage. UI→Host: what the UI supports;
+ *                            Host→UI: what both sides will use
+ *   CMP_EVENT_SURFACE:       4-byte width + 4-byte height + 4-byte stride (pixels, BGRA)
+ *                            One descriptor is attached to the prefix byte with
+ *                            SCM_RIGHTS: shared memory of stride * height * 4
+ *                            bytes the UI maps read-write and renders into,
+ *                            answering with SURFACE_READY. Only sent when
+ *                            IPC_TRANSPORT_SURFACE_FD was agreed.
+ *   CMP_EVENT_SHUTDOWN:      No additional data. The last message before the
+ *                            host closes the socket: the UI saves what it must
+ *                            and exits with status 0. The host sends SIGTERM
+ *                            after IPC_SHUTDOWN_TIMEOUT_MS, and SIGKILL as much
+ *                            later. Only sent when IPC_CAP_SHUTDOWN was agreed;
+ *                            otherwise EOF alone tells the UI to exit.
+ *   CMP_EVENT_MEMORY_PRESSURE: 1-byte IPC_MEMORY_PRESSURE_* level, sent when
+ *                            it changes. MODERATE: the UI trims its font and
+ *                            resource caches and collects garbage. CRITICAL:
+ *                            also drops its GPU resources (offscreen layers
+ *                            included, rebuilt on the next frame) and lets the
+ *                            heap shrink. NONE releases nothing. The UI
+ *                            answers each trim with CMP_EVENT_MEMORY_TRIMMED.
+ *   CMP_EVENT_MEMORY_TRIMMED: MemoryTrimReport. Only with IPC_CAP_MEMORY agreed.
  *
  * Note: IOSurface sharing uses Mach port IPC (see MachPort.h), not socket.
+ *       The Linux backend shares plain memory with CMP_EVENT_SURFACE instead.
  *
  * INPUT event payload - see InputEvent.h
  *
  * JUCE event payload - follows EVENT_TYPE_JUCE prefix.
  *   4-byte size (little-endian) + ValueTree binary data
+ *
+ * RPC event payload - follows EVENT_TYPE_RPC prefix.
+ *   4-byte size + RpcHeader + ValueTree binary data (none for IPC_RPC_CANCEL)
+ *   The size covers the header and the tree, so RPC messages can be
+ *   compressed and passed as blobs exactly like JUCE events.
+ *
+ * MIRROR event payload - follows EVENT_TYPE_MIRROR prefix.
+ *   4-byte size + mirror name (null-terminated UTF-8) + 4-byte batch sequence
+ *   + IPC_MIRROR_* operations, each a 1-byte code and its fields.
+ *   Host→UI batches are numbered consecutively per mirror; a batch starting
+ *   with a whole-tree REPLACE restarts the count. A UI that sees a gap or
+ *   can't apply an operation asks for a resync (sequence 0, one
+ *   IPC_MIRROR_RESYNC_REQUEST).
+ *
+ * TYPED event payload - follows EVENT_TYPE_TYPED prefix.
+ *   2-byte message id + 2-byte size + fields, packed little-endian in schema
+ *   order (up to IPC_TYPED_MAX_SIZE bytes). Ids and layouts come from the
+ *   app's message schema, which host and UI code are generated from; see
+ *   TypedMessage.h. Never compressed, chunked or sent as a blob.
+ *
+ * BATCH event payload - follows EVENT_TYPE_BATCH prefix.
+ *   4-byte size + messages, each a 4-byte size + a complete message starting
+ *   with its own event type byte (TYPED, or uncompressed JUCE or MIRROR;
+ *   never blobs, chunks or batches). Handled in order, as if each had come
+ *   on its own. The host sends the state it keeps for the UI this way when
+ *   a UI connects, see ComposeProvider::sendState(). Only sent when
+ *   IPC_CAP_BATCH was agreed; may be chunked like any large message.
+ *
+ * Interned payload - follows (EVENT_TYPE_JUCE or EVENT_TYPE_RPC) | EVENT_FLAG_INTERNED.
+ *   Same as the plain payload, but the ValueTree uses the compact encoding:
+ *   type name + varint property count + (name + value) per property + varint
+ *   child count + children, names and values per IPC_DICT_*. Only sent when
+ *   IPC_CODEC_DICT was agreed, and only on IPC_LANE_CONTROL: within a lane,
+ *   messages arrive in the order they were sent, so a name is always defined
+ *   before its token is used. May be compressed or sent as a blob on top.
+ *
+ * Compressed payload - follows (EVENT_TYPE_JUCE, _RPC or _MIRROR) | EVENT_FLAG_COMPRESSED.
+ *   4-byte compressed size + 4-byte uncompressed size + LZ4 block
+ *   Only sent when IPC_CODEC_LZ4 was agreed. Both sizes obey the inline limit.
+ *
+ * CHUNK event payload - follows EVENT_TYPE_CHUNK prefix.
+ *   1-byte lane + 1-byte IPC_CHUNK_* flags + 2-byte length + data
+ *   The data of a lane's chunks, FIRST through LAST, concatenate to one
+ *   complete message (starting with its own event type byte).
+ *
+ * BLOB event payload - follows EVENT_TYPE_BLOB prefix.
+ *   1-byte event type of the payload (EVENT_TYPE_JUCE, _RPC or _MIRROR) + 8-byte size
+ *   One descriptor is attached to the prefix byte with SCM_RIGHTS; it refers
+ *   to shared memory holding what would otherwise follow the inline size
+ *   field. The receiver maps it read-only and closes it when done.
+ */
+
+/*
+ * Trace event names (TraceRecord.name field), shared by host and UI
+ */
+#define TRACE_NAME_IPC_SEND         0  /* arg = bytes */
+#define TRACE_NAME_IPC_RECEIVE      1  /* arg = bytes */
+#define TRACE_NAME_CALL_ASYNC       2  /* arg = queue latency (us) */
+#define TRACE_NAME_RESIZE           3  /* arg = width << 16 | height (pixels) */
+#define TRACE_NAME_SURFACE_SWAP     4
+#define TRACE_NAME_FRAME            5  /* arg = frame number */
+#define TRACE_NAME_COMPOSE          6  /* scene.render() */
+#define TRACE_NAME_FLUSH            7  /* GPU flush and submit */
+#define TRACE_NAME_SURFACE_READY    8
+#define TRACE_NAME_COUNT            9
+
+/*
+ * Trace event phases (TraceRecord.phase field)
+ */
+#define TRACE_PHASE_INSTANT         0
+#define TRACE_PHASE_COMPLETE        1
+
+/**
+ * Trace record - 24 bytes, little-endian.
+ * Timestamps use the sender's monotonic clock; the host converts UI
+ * timestamps using the offset measured with CMP_EVENT_CLOCK_SYNC.
+ */
+#pragma pack(push, 1)
+typedef struct {
+    int64_t  timestamp; /* Start time (ns) */
+    int64_t  duration;  /* Duration (ns), TRACE_PHASE_COMPLETE only */
+    uint32_t arg;       /* Name-specific argument */
+    uint8_t  name;      /* TRACE_NAME_* */
+    uint8_t  phase;     /* TRACE_PHASE_* */
+    uint16_t thread;    /* Sender-local thread index */
+} TraceRecord;
+#pragma pack(pop)
+
+#ifdef __cplusplus
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must be 24 bytes");
+#else
+_Static_assert(sizeof(TraceRecord) == 24, "TraceRecord must be 24 bytes");
+#endif
+
+/**
+ * Stats report - 40 bytes, little-endian.
+ * Frame times cover frames rendered since the previous report.
+ */
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t intervalMs;    /* Time covered by this report */
+    uint32_t frames;        /* Frames rendered in the interval */
+    uint32_t frameTimeP50;  /* Frame time percentiles (us) */
+    uint32_t frameTimeP95;
+    uint32_t frameTimeP99;
+    uint32_t frameTimeMax;
+    uint64_t residentBytes; /* UI process resident memory */
+    uint64_t cpuTimeNs;     /* UI process total CPU time */
+} StatsReport;
+#pragma pack(pop)
+
+#ifdef __cplusplus
+static_assert(sizeof(StatsReport) == 40, "StatsReport must be 40 bytes");
+#else
+_Static_assert(sizeof(StatsReport) == 40, "StatsReport must be 40 bytes");
+#endif
+
+/**
+ * Memory trim report - 24 bytes, little-endian, answers CMP_EVENT_MEMORY_PRESSURE.
+ */
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  level;          /* IPC_MEMORY_PRESSURE_* handled */
+    uint8_t  reserved[3];
+    uint32_t durationUs;     /* Time the trim took */
+    uint64_t residentBefore; /* UI process resident memory before and after */
+    uint64_t residentAfter;
+} MemoryTrimReport;
+#pragma pack(pop)
+
+#ifdef __cplusplus
+static_assert(sizeof(MemoryTrimReport) == 24, "MemoryTrimReport must be 24 bytes");
+#else
+_Static_assert(sizeof(MemoryTrimReport) == 24, "MemoryTrimReport must be 24 bytes");
+#endif
+
+/**
+ * Hello message - 24 bytes, little-endian.
+ * The host answers with the lower version, the intersection of the bitmasks
+ * and the smaller maximum message size.
  */
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t magic;          /* IPC_HELLO_MAGIC */
+    uint16_t version;        /* IPC_PROTOCOL_VERSION */
+    uint16_t reserved;
+    uint32_t capabilities;   /* IPC_CAP_* */
+    uint32_t transports;     /* IPC_TRANSPORT_* */
+    uint32_t codecs;         /* IPC_CODEC_* */
+    uint32_t maxMessageSize; /* Largest payload the sender accepts */
+} HelloMessage;
+#pragma pack(pop)
+
+#ifdef __cplusplus
+static_assert(sizeof(HelloMessage) == 24, "HelloMessage must be 24 bytes");
+#else
+_Static_assert(sizeof(HelloMessage) == 24, "HelloMessage must be 24 bytes");
+#endif
+
+/**
+ * RPC header - 12 bytes, little-endian, starts every RPC event payload.
+ * Ids are chosen by the side sending the request; each side has its own
+ * id space, so a response's id refers to a request the receiver sent.
+ */
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t  kind;          /* IPC_RPC_* */
+    uint8_t  reserved[3];
+    uint32_t id;            /* Correlation id, echoed by RESPONSE/ERROR/CANCEL */
+    uint32_t timeoutMs;     /* REQUEST: how long the caller waits, 0 = no limit */
+} RpcHeader;
+#pragma pack(pop)
+
+#ifdef __cplusplus
+static_assert(sizeof(RpcHeader) == 12, "RpcHeader must be 12 bytes");
+#else
+_Static_assert(sizeof(RpcHeader) == 12, "RpcHeader must be 12 bytes");
+#endif
 
 #ifdef __cplusplus
 }
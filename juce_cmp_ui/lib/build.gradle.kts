@@ -2,6 +2,7 @@ plugins {
     kotlin("jvm")
     alias(libs.plugins.composeMultiplatform)
     alias(libs.plugins.composeCompiler)
+    alias(libs.plugins.jmh)
 }
 
 group = "com.github.juce-cmp"
@@ -9,6 +10,29 @@ version = "1.0.0"
 
 kotlin {
     jvmToolchain(21)
+
+    // Benchmarks and the corpus check exercise internal classes (src/jmh)
+    target.compilations.getByName("jmh").associateWith(target.compilations.getByName("main"))
+}
+
+// ./gradlew :lib:jmh (macOS, needs the native library in resources)
+jmh {
+    // Allocation rate (gc.alloc.rate.norm) next to every result
+    profilers.add("gc")
+
+    // CorpusBenchmark reads the corpus from valuetree-corpus generate
+    providers.gradleProperty("corpus").orNull?.let {
+        jvmArgsAppend.add("-Djuce_cmp.corpus=${file(it).absolutePath}")
+    }
+}
+
+// ./gradlew :lib:corpusCheck -Pcorpus=<dir>, between valuetree-corpus generate and verify
+tasks.register<JavaExec>("corpusCheck") {
+    group = "verification"
+    description = "Checks the ValueTree codecs against a corpus from valuetree-corpus"
+    classpath = sourceSets["jmh"].runtimeClasspath
+    mainClass.set("juce_cmp.ipc.CorpusCheckKt")
+    args(file(providers.gradleProperty("corpus").getOrElse(".")).absolutePath)
 }
 
 dependencies {
@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.concurrent.TimeUnit
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+
+/*
+ * ValueTree codec of the UI side: "built" is JuceValueTree, "view" and
+ * "writer" are ValueTreeView and ValueTreeWriter over the same bytes. Trees
+ * are the demo's parameter change and a preset with one child per parameter,
+ * in the JUCE stream format and the interned format of the control lane.
+ *
+ * Run with ./gradlew :lib:jmh. With the gc profiler, gc.alloc.rate.norm
+ * should be 0 B/op for view and writer.
+ */
+
+private const val PRESET_SIZE = 128
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+open class CodecBenchmark {
+    @Param("param", "preset")
+    @JvmField
+    var tree = ""
+
+    @Param("plain", "interned")
+    @JvmField
+    var format = ""
+
+    private lateinit var data: ByteArray
+    private lateinit var buffer: ByteBuffer
+    private val dictionary = IdentifierDecoder()
+    private val view = ValueTreeView()
+    private val child = ValueTreeView()
+    private val writer = ValueTreeWriter()
+
+    @Setup(Level.Trial)
+    fun setUp() {
+        val built = if (tree == "param") makeParam(3, 0.5) else makePreset()
+
+        data = if (format == "plain") {
+            built.toByteArray()
+        } else {
+            // Second message, so names are tokens like in steady state
+            val encoder = IdentifierEncoder()
+            val first = ValueTreeWriter()
+            built.writeTo(first, encoder)
+            JuceValueTree.readFrom(ByteBuffer.wrap(first.toByteArray()).order(ByteOrder.LITTLE_ENDIAN), dictionary)
+
+            val second = ValueTreeWriter()
+            built.writeTo(second, encoder)
+            second.toByteArray()
+        }
+        buffer = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN)
+    }
+
+    @Benchmark
+    fun readBuilt(): Double {
+        buffer.clear()
+        val tree = if (format == "plain") JuceValueTree.readFrom(buffer) else JuceValueTree.readFrom(buffer, dictionary)
+        if (tree.numChildren == 0) return tree["id"].toInt() + tree["value"].toDouble()
+
+        var sum = 0.0
+        for (i in 0 until tree.numChildren) sum += tree.getChild(i)!!["value"].toDouble()
+        return sum
+    }
+
+    @Benchmark
+    fun readView(): Double {
+        buffer.clear()
+        if (format == "plain") view.reset(buffer) else view.reset(buffer, dictionary)
+        if (view.numChildren == 0) return view.getInt("id") + view.getDouble("value")
+
+        var sum = 0.0
+        view.forEachChild(child) { sum += it.getDouble("value") }
+        return sum
+    }
+
+    @Benchmark
+    fun writeBuilt(): ByteArray {
+        return if (tree == "param") makeParam(3, 0.5).toByteArray() else makePreset().toByteArray()
+    }
+
+    @Benchmark
+    fun writeStreamed(): Int {
+        writer.reset()
+        if (tree == "param") {
+            writeParam(3, 0.5)
+        } else {
+            writer.startTree("preset", 1)
+            writer.property("name", "Init")
+            writer.startChildren(PRESET_SIZE)
+            for (i in 0 until PRESET_SIZE) writeParam(i, i / PRESET_SIZE.toDouble())
+        }
+        return writer.size
+    }
+
+    private fun writeParam(id: Int, value: Double) {
+        writer.startTree("param", 2)
+        writer.property("id", id)
+        writer.property("value", value)
+        writer.startChildren(0)
+    }
+
+    private fun makeParam(id: Int, value: Double) = JuceValueTree("param").also {
+        it["id"] = id
+        it["value"] = value
+    }
+
+    private fun makePreset() = JuceValueTree("preset").also {
+        it["name"] = "Init"
+        for (i in 0 until PRESET_SIZE) it.addChild(makeParam(i, i / PRESET_SIZE.toDouble()))
+    }
+}
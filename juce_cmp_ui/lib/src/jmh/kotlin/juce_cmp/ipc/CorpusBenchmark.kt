@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.concurrent.TimeUnit
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+
+/*
+ * Encode and decode throughput over the valuetree-corpus cases, the JVM
+ * counterpart of `valuetree-corpus bench`: JuceValueTree, ValueTreeView and
+ * the interned codec. Divide the case's size by the time per operation to
+ * compare with the MB/s there.
+ *
+ * ./gradlew :lib:jmh -Pcorpus=<dir> (from valuetree-corpus generate)
+ */
+
+@State(Scope.Thread)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+open class CorpusBenchmark {
+    // As written by makeCorpus() in valuetree_corpus.cpp
+    @Param("param", "preset", "scalars", "strings", "binary", "unsupported", "unicode-names", "deep",
+           "children", "wide", "large-binary", "large-string")
+    @JvmField
+    var corpusCase = ""
+
+    private lateinit var plain: ByteBuffer
+    private lateinit var tree: JuceValueTree
+    private lateinit var interned: ByteBuffer
+    private val view = ValueTreeView()
+    private val writer = ValueTreeWriter()
+    private val encoder = IdentifierEncoder()
+    private val decoder = IdentifierDecoder()
+
+    @Setup(Level.Trial)
+    fun setUp() {
+        val dir = System.getProperty("juce_cmp.corpus")
+            ?: throw IllegalStateException("Pass -Pcorpus=<dir> from valuetree-corpus generate")
+        val data = File(dir, "$corpusCase.tree").readBytes()
+        plain = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN)
+        tree = JuceValueTree.fromByteArray(data)
+
+        // Second message of a fresh dictionary, so names are tokens like in steady state
+        val first = ValueTreeWriter()
+        tree.writeTo(first, encoder)
+        JuceValueTree.readFrom(ByteBuffer.wrap(first.toByteArray()).order(ByteOrder.LITTLE_ENDIAN), decoder)
+
+        val second = ValueTreeWriter()
+        tree.writeTo(second, encoder)
+        interned = ByteBuffer.wrap(second.toByteArray()).order(ByteOrder.LITTLE_ENDIAN)
+    }
+
+    @Benchmark
+    fun encode(): Int {
+        writer.reset()
+        tree.writeTo(writer)
+        return writer.size
+    }
+
+    @Benchmark
+    fun decode(): JuceValueTree {
+        plain.clear()
+        return JuceValueTree.readFrom(plain)
+    }
+
+    @Benchmark
+    fun readView(): Int {
+        view.reset(plain.clear())
+        return view.size
+    }
+
+    @Benchmark
+    fun encodeInterned(): Int {
+        writer.reset()
+        tree.writeTo(writer, encoder)
+        return writer.size
+    }
+
+    @Benchmark
+    fun decodeInterned(): JuceValueTree {
+        interned.clear()
+        return JuceValueTree.readFrom(interned, decoder)
+    }
+}
@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.io.ByteArrayOutputStream
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.system.exitProcess
+
+/*
+ * JVM side of valuetree-corpus (benchmarks/valuetree_corpus.cpp): reads the
+ * corpus JUCE wrote, checks JuceValueTree, ValueTreeView, ValueTreeWriter and
+ * the interned codec against it, and writes back what the JVM encodes
+ * (<case>.jvm.tree, interned.jvm.stream) for `valuetree-corpus verify`.
+ *
+ * ./gradlew :lib:corpusCheck -Pcorpus=<dir>
+ */
+
+private class Checker {
+    var checks = 0
+    var failures = 0
+
+    fun expect(ok: Boolean, case: String, what: String) {
+        checks++
+        if (ok) return
+        failures++
+        println("FAIL %-16s %s".format(case, what))
+    }
+}
+
+/** Messages prefixed with their 4-byte size, as views into one buffer. */
+private fun loadMessages(file: File): List<ByteBuffer> {
+    if (!file.isFile) return emptyList()
+    val stream = ByteBuffer.wrap(file.readBytes()).order(ByteOrder.LITTLE_ENDIAN)
+
+    val messages = ArrayList<ByteBuffer>()
+    while (stream.remaining() >= 4) {
+        val size = stream.int
+        if (size < 0 || size > stream.remaining()) break
+        messages.add(stream.slice(stream.position(), size).order(ByteOrder.LITTLE_ENDIAN))
+        stream.position(stream.position() + size)
+    }
+    return messages
+}
+
+private fun loadCaseNames(dir: File): List<String> {
+    val file = File(dir, "cases.txt")
+    return if (file.isFile) file.readLines().filter { it.isNotEmpty() } else emptyList()
+}
+
+/** Stream what [view] holds through [writer], using the typed calls where Var has one. */
+private fun stream(view: ValueTreeView, writer: ValueTreeWriter) {
+    writer.startTree(view.type, view.numProperties)
+    for (i in 0 until view.numProperties) {
+        val name = view.getPropertyName(i)!!
+        when (val value = view.getVar(name)) {
+            is Var.IntVal -> writer.property(name, value.value)
+            is Var.Int64Val -> writer.property(name, value.value)
+            is Var.DoubleVal -> writer.property(name, value.value)
+            is Var.BoolVal -> writer.property(name, value.value)
+            is Var.StrVal -> writer.property(name, value.value)
+            is Var.BinaryVal -> writer.property(name, value.value)
+            is Var.Void -> writer.property(name, value)
+        }
+    }
+    writer.startChildren(view.numChildren)
+    view.forEachChild { stream(it, writer) }
+}
+
+/** Property by property and child by child, as the getters see them. */
+private fun matches(view: ValueTreeView, tree: JuceValueTree): Boolean {
+    if (!view.hasType(tree.type) || view.numProperties != tree.numProperties || view.numChildren != tree.numChildren) {
+        return false
+    }
+
+    for (i in 0 until tree.numProperties) {
+        val name = tree.getPropertyName(i)!!
+        val value = tree.getProperty(i)
+        if (view.getPropertyName(i) != name || view.getVar(name) != value) return false
+
+        // The unboxed getters convert like Var does
+        if (view.getLong(name) != value.toLong() || view.getBool(name) != value.toBool()) return false
+        if (view.getDouble(name).toRawBits() != value.toDouble().toRawBits()) return false
+    }
+
+    var i = 0
+    var childrenMatch = true
+    view.forEachChild { childrenMatch = childrenMatch && matches(it, tree.getChild(i++)!!) }
+    return childrenMatch
+}
+
+fun main(args: Array<String>) {
+    val dir = File(args.firstOrNull() ?: "")
+    val names = loadCaseNames(dir)
+    if (names.isEmpty()) {
+        System.err.println("No corpus in ${dir.absolutePath}, run valuetree-corpus generate first")
+        exitProcess(1)
+    }
+
+    val check = Checker()
+    val interned = loadMessages(File(dir, "interned.stream"))
+    val decoder = IdentifierDecoder()
+    val viewDecoder = IdentifierDecoder()
+    val encoder = IdentifierEncoder()
+    val jvmInterned = ByteArrayOutputStream()
+    val view = ValueTreeView()
+    val writer = ValueTreeWriter()
+
+    for ((index, case) in names.withIndex()) {
+        val plain = File(dir, "$case.tree").readBytes()
+        val expectedFile = File(dir, "$case.jvm-expected.tree")
+        val lossless = !expectedFile.isFile
+        val expected = if (lossless) plain else expectedFile.readBytes()
+
+        // JuceValueTree
+        val tree = JuceValueTree.fromByteArray(plain)
+        val encoded = tree.toByteArray()
+        check.expect(tree.isValid && encoded.contentEquals(expected), case, "JuceValueTree round trip")
+        File(dir, "$case.jvm.tree").writeBytes(encoded)
+
+        // ValueTreeView and ValueTreeWriter over the same bytes
+        check.expect(view.reset(plain) && view.size == plain.size, case, "ValueTreeView extent")
+        check.expect(view.toTree().toByteArray().contentEquals(expected), case, "ValueTreeView.toTree")
+        check.expect(matches(view, tree), case, "ValueTreeView getters")
+
+        writer.reset()
+        stream(view, writer)
+        check.expect(writer.toByteArray().contentEquals(expected), case, "ValueTreeWriter")
+
+        // Interned, with one decoder per reader like the receiving side keeps
+        val message = interned.getOrNull(index)
+        check.expect(message != null, case, "missing from interned.stream")
+        if (message != null) {
+            val decoded = JuceValueTree.readFrom(message.duplicate().order(ByteOrder.LITTLE_ENDIAN), decoder)
+            check.expect(decoded.toByteArray().contentEquals(expected), case, "IdentifierDecoder")
+
+            val internedView = ValueTreeView()
+            val viewValid = internedView.readInterned(message, viewDecoder)
+            check.expect(viewValid && matches(internedView, tree), case, "ValueTreeView.readInterned")
+        }
+
+        // Written back through one encoder, like the sending side keeps
+        val output = ValueTreeWriter()
+        tree.writeTo(output, encoder)
+        if (lossless && message != null) {
+            val juce = ByteArray(message.remaining()).also { message.duplicate().get(it) }
+            check.expect(output.toByteArray().contentEquals(juce), case, "IdentifierEncoder, same bytes as JUCE side")
+        }
+        jvmInterned.write(ByteBuffer.allocate(4).order(ByteOrder.LITTLE_ENDIAN).putInt(output.size).array())
+        jvmInterned.write(output.array, 0, output.size)
+    }
+
+    File(dir, "interned.jvm.stream").writeBytes(jvmInterned.toByteArray())
+
+    println("${names.size} cases, ${check.checks} checks, ${check.failures} failed")
+    exitProcess(if (check.failures == 0) 0 else 1)
+}
@@ -0,0 +1,176 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import com.sun.jna.Library
+import com.sun.jna.Memory
+import com.sun.jna.Native
+import com.sun.jna.Pointer
+import java.util.concurrent.TimeUnit
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.annotations.TearDown
+
+/*
+ * Socket transport of the UI side: "legacy" is how Ipc did I/O before
+ * FdChannel (a JNA Library proxy, writes copied through a 1 KB native
+ * buffer, reads copied out of one byte at a time), "channel" is FdChannel
+ * with direct buffers. Message sizes are a typed parameter message, a small
+ * tree and a whole chunk.
+ *
+ * Run with ./gradlew :lib:jmh. The gc profiler adds gc.alloc.rate.norm,
+ * which should be 0 B/op for the channel.
+ */
+
+/** The proxy-mapped calls, as Ipc used them. */
+private interface LegacySocketLib : Library {
+    fun socketReadAt(socketFD: Int, buffer: Pointer, offset: Long, length: Long): Long
+    fun socketWriteAt(socketFD: Int, buffer: Pointer, offset: Long, length: Long): Long
+    fun socketPair(fds: IntArray): Int
+    fun blobClose(fd: Int)
+
+    companion object {
+        val INSTANCE: LegacySocketLib by lazy {
+            val libFile = Native.extractFromResourcePath("iosurface_renderer")
+            Native.load(libFile.absolutePath, LegacySocketLib::class.java)
+        }
+    }
+}
+
+/** One end of the socket pair, used from a single thread. */
+private interface Transport {
+    fun write(): Boolean
+    fun read(): Int  // First byte, or -1 if the socket closed
+}
+
+private class LegacyTransport(private val fd: Int, size: Int) : Transport {
+    private val lib = LegacySocketLib.INSTANCE
+    private val message = ByteArray(size)
+    private val received = ByteArray(size)
+    private val writeBuffer = Memory(1024)
+    private val readBuffer = Memory(1024)
+
+    override fun write(): Boolean {
+        var offset = 0
+        while (offset < message.size) {
+            val count = minOf(1024, message.size - offset)
+            writeBuffer.write(0, message, offset, count)
+            val n = lib.socketWriteAt(fd, writeBuffer, 0, count.toLong())
+            if (n <= 0) return false
+            offset += n.toInt()
+        }
+        return true
+    }
+
+    override fun read(): Int {
+        var offset = 0
+        while (offset < received.size) {
+            val n = lib.socketReadAt(fd, readBuffer, 0, minOf(1024, received.size - offset).toLong())
+            if (n <= 0) return -1
+            for (i in 0 until n.toInt()) received[offset + i] = readBuffer.getByte(i.toLong())
+            offset += n.toInt()
+        }
+        return received[0].toInt() and 0xFF
+    }
+}
+
+private class ChannelTransport(fd: Int, private val size: Int) : Transport {
+    private val channel = FdChannel(fd)
+    private val buffer = NativeBuffer(size)
+
+    override fun write(): Boolean = channel.writeFully(buffer, 0, size)
+
+    override fun read(): Int {
+        if (!channel.readFully(buffer, 0, size)) return -1
+        return buffer.buffer.get(0).toInt() and 0xFF
+    }
+}
+
+@State(Scope.Thread)
+abstract class TransportState {
+    @Param("legacy", "channel")
+    @JvmField
+    var transport = ""
+
+    @Param("21", "1024", "4096")
+    @JvmField
+    var size = 0
+
+    private val fds = IntArray(2)
+    private lateinit var near: Transport
+    private lateinit var far: Transport
+
+    @Setup(Level.Trial)
+    fun setUp() {
+        check(LegacySocketLib.INSTANCE.socketPair(fds) == 0) { "socketpair failed" }
+        near = create(fds[0])
+        far = create(fds[1])
+        started()
+    }
+
+    @TearDown(Level.Trial)
+    fun tearDown() {
+        LegacySocketLib.INSTANCE.blobClose(fds[0])
+        stopped()
+        LegacySocketLib.INSTANCE.blobClose(fds[1])
+    }
+
+    private fun create(fd: Int): Transport =
+        if (transport == "legacy") LegacyTransport(fd, size) else ChannelTransport(fd, size)
+
+    protected open fun started() {}
+    protected open fun stopped() {}
+
+    protected fun send() = near.write()
+    protected fun receive() = near.read()
+    protected fun receiveFar() = far.read()
+
+    /** Send back whatever arrives at the far end, until the socket closes. */
+    protected fun echo() {
+        while (far.read() >= 0 && far.write()) {}
+    }
+}
+
+/** One message written on one end and read on the other, by the same thread. */
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+open class TransportThroughput : TransportState() {
+    @Benchmark
+    fun message(): Int {
+        send()
+        return receiveFar()
+    }
+}
+
+/** One message to an echo thread and back. */
+@BenchmarkMode(Mode.SampleTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+open class TransportRoundTrip : TransportState() {
+    private var echoThread: Thread? = null
+
+    override fun started() {
+        echoThread = Thread({ echo() }, "Echo").apply {
+            isDaemon = true
+            start()
+        }
+    }
+
+    override fun stopped() {
+        echoThread?.join()
+        echoThread = null
+    }
+
+    @Benchmark
+    fun roundTrip(): Int {
+        send()
+        return receive()
+    }
+}
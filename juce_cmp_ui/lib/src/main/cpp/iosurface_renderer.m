@@ -3,6 +3,13 @@
 
 #import <stdlib.h>
 #import <unistd.h>
+#import <fcntl.h>
+#import <errno.h>
+#import <string.h>
+#import <stdio.h>
+#import <sys/mman.h>
+#import <sys/socket.h>
+#import <sys/stat.h>
 #import <mach/mach.h>
 #import <servers/bootstrap.h>
 #import <IOSurface/IOSurface.h>
@@ -101,16 +108,134 @@ void flushAndSync(void* context) {
     }
 }
 
-// Read data from a socket file descriptor
+// Read data from a socket file descriptor into buffer + offset (the offset
+// spares the caller a pointer object per partial read)
 // Returns number of bytes read, or -1 on error
-ssize_t socketRead(int socketFD, void* buffer, size_t length) {
-    return read(socketFD, buffer, length);
+ssize_t socketReadAt(int socketFD, void* buffer, size_t offset, size_t length) {
+    return read(socketFD, (char*)buffer + offset, length);
 }
 
-// Write data to a socket file descriptor
+// Write data at buffer + offset to a socket file descriptor
 // Returns number of bytes written, or -1 on error
-ssize_t socketWrite(int socketFD, const void* buffer, size_t length) {
-    return write(socketFD, buffer, length);
+ssize_t socketWriteAt(int socketFD, const void* buffer, size_t offset, size_t length) {
+    return write(socketFD, (const char*)buffer + offset, length);
+}
+
+// Connected pair of Unix sockets, for benchmarks outside a host
+// Returns 0 on success, or -1 on error
+int socketPair(int* fds) {
+    return socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+}
+
+// Read from a socket, also receiving a descriptor attached with SCM_RIGHTS
+// (*outFd is -1 if none). Returns number of bytes read, or -1 on error
+ssize_t socketReceive(int socketFD, void* buffer, size_t length, int* outFd) {
+    struct iovec iov = { buffer, length };
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    *outFd = -1;
+    ssize_t n = recvmsg(socketFD, &msg, 0);
+    if (n > 0) {
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                memcpy(outFd, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+    }
+    return n;
+}
+
+// Write to a socket with a descriptor attached to the first byte
+// Returns number of bytes written, or -1 on error
+ssize_t socketWriteWithFd(int socketFD, const void* buffer, size_t length, int fd) {
+    struct iovec iov = { (void*)buffer, length };
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    return sendmsg(socketFD, &msg, 0);
+}
+
+// Copy data into a new anonymous shared memory object (see SharedBlob.h)
+// Returns its descriptor, or -1 on error
+int blobCreate(const void* data, size_t size) {
+    static int counter = 0;
+
+    int fd = -1;
+    for (int attempt = 0; attempt < 8 && fd < 0; ++attempt) {
+        char name[32];  // PSHMNAMLEN is 31
+        snprintf(name, sizeof(name), "/jcmp.%d.%d", getpid(), counter++);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            shm_unlink(name);
+        } else if (errno != EEXIST) {
+            return -1;
+        }
+    }
+    if (fd < 0) return -1;
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    memcpy(mapping, data, size);
+    munmap(mapping, size);
+    return fd;
+}
+
+// Map a received blob read-only. Returns NULL on error (fd stays open)
+void* blobMap(int fd, size_t size) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < size) return NULL;
+
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    return mapping == MAP_FAILED ? NULL : mapping;
+}
+
+void blobUnmap(void* mapping, size_t size) {
+    munmap(mapping, size);
+}
+
+void blobClose(int fd) {
+    close(fd);
+}
+
+// Physical memory footprint of this process (what Activity Monitor shows)
+// Returns 0 on error
+uint64_t getResidentMemory(void) {
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.phys_footprint;
 }
 
 // Connect to parent's Mach service and establish bidirectional channel
@@ -6,10 +6,18 @@ package juce_cmp
 import androidx.compose.runtime.Composable
 import juce_cmp.ipc.Ipc
 import juce_cmp.ipc.JuceValueTree
+import juce_cmp.ipc.Lane
+import juce_cmp.ipc.MirroredValueTree
+import juce_cmp.ipc.Mirrors
+import juce_cmp.ipc.Rpc
+import juce_cmp.ipc.TypedMessage
+import juce_cmp.ipc.ValueTreeView
+import juce_cmp.ipc.ValueTreeWriter
 import juce_cmp.renderer.runIOSurfaceRenderer
 import java.io.FileDescriptor
 import java.io.FileOutputStream
 import java.io.PrintStream
+import java.nio.ByteBuffer
 
 /**
  * Main entry point for the juce_cmp library.
@@ -22,6 +30,7 @@ object Library {
     private var socketFD: Int? = null
     private var scaleFactor: Float = 1f
     private var machServiceName: String? = null
+    private var frameClockHz: Int = 0
     private var ipc: Ipc? = null
 
     /**
@@ -31,12 +40,39 @@ object Library {
         get() = socketFD != null
 
     /**
-     * Send a JuceValueTree event to the host.
+     * Send a JuceValueTree event to the host. Use Lane.BULK for large trees
+     * so they don't hold up small events (order is kept within a lane only).
      */
-    fun send(tree: JuceValueTree) {
-        ipc?.send(tree)
+    fun send(tree: JuceValueTree, lane: Int = Lane.CONTROL) {
+        ipc?.send(tree, lane)
     }
 
+    /** Send a tree streamed into [writer] without building it (see ValueTreeWriter). */
+    fun send(writer: ValueTreeWriter, lane: Int = Lane.CONTROL) {
+        ipc?.send(writer, lane)
+    }
+
+    /**
+     * Send a message generated from the app's schema (see TypedMessage). Returns
+     * false if not sent, e.g. in standalone mode or before the host's handshake.
+     */
+    fun send(message: TypedMessage, lane: Int = Lane.CONTROL): Boolean = ipc?.send(message, lane) ?: false
+
+    /**
+     * Request/response calls to and from the host, null in standalone mode.
+     * Example: `val info = Library.rpc?.call(JuceValueTree("getPluginInfo"))`
+     */
+    var rpc: Rpc? = null
+        private set
+
+    private var mirrors: Mirrors? = null
+
+    /**
+     * Replica of the host ValueTree mirrored under [name] (see MirroredValueTree.h),
+     * null in standalone mode. Example: `Library.mirror("state")?.read { it["gain"] }`
+     */
+    fun mirror(name: String): MirroredValueTree? = mirrors?.get(name)
+
     /**
      * Initialize the juce_cmp library.
      *
@@ -77,8 +113,25 @@ object Library {
                 .firstOrNull { it.startsWith("--mach-service=") }
                 ?.substringAfter("=")
 
+            // Parse --frame-clock=<fps>: animations follow a virtual clock (ipc-replay)
+            frameClockHz = args
+                .firstOrNull { it.startsWith("--frame-clock=") }
+                ?.substringAfter("=")
+                ?.toIntOrNull()
+                ?.coerceAtLeast(0)
+                ?: 0
+
+            // Parse --protocol=<version>; absent for hosts predating the handshake
+            val protocolVersion = args
+                .firstOrNull { it.startsWith("--protocol=") }
+                ?.substringAfter("=")
+                ?.toIntOrNull()
+                ?: 0
+
             // Create IPC channel on the inherited socket FD
-            ipc = Ipc(socketFD!!)
+            ipc = Ipc(socketFD!!, protocolVersion)
+            rpc = Rpc(ipc!!)
+            mirrors = Mirrors(ipc!!)
 
             // Redirect System.out to stderr so library noise doesn't corrupt our protocol
             System.setOut(PrintStream(FileOutputStream(FileDescriptor.err), true))
@@ -92,16 +145,29 @@ object Library {
      * the connection. Mirrors the Compose `application { }` pattern.
      *
      * @param onEvent Optional callback when host sends events (JuceValueTree payload)
+     * @param onEventView Optional callback reading host events in place instead, without
+     *                    allocating; replaces onEvent when set. Called on the IPC thread,
+     *                    the view is only valid during the call (see ValueTreeView)
+     * @param onMessage Optional callback when host sends typed messages; decode them
+     *                  with the code generated from the schema
      * @param onFrameRendered Optional callback after each frame (for debugging/capture)
+     * @param onShutdown Optional callback when the host closes the UI, on the IPC thread
+     *                   right before the process exits; keep it under a second
      * @param content The Compose content to render
      */
     fun host(
         onEvent: ((tree: JuceValueTree) -> Unit)? = null,
+        onEventView: ((tree: ValueTreeView) -> Unit)? = null,
+        onMessage: ((id: Int, payload: ByteBuffer) -> Unit)? = null,
         onFrameRendered: ((frameNumber: Long, surface: org.jetbrains.skia.Surface) -> Unit)? = null,
+        onShutdown: (() -> Unit)? = null,
         content: @Composable () -> Unit
     ) {
         val fd = socketFD ?: error("host() called but not in embedded mode")
         val channel = ipc ?: error("host() called but IPC not initialized")
+        channel.onTyped = onMessage
+        channel.onJuceEventView = onEventView
+        channel.onShutdown = onShutdown
 
         runIOSurfaceRenderer(
             socketFD = fd,
@@ -110,6 +176,7 @@ object Library {
             ipc = channel,
             onFrameRendered = onFrameRendered,
             onJuceEvent = onEvent,
+            frameClockHz = frameClockHz,
             content = content
         )
     }
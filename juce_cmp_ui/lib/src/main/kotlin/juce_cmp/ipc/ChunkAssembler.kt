@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.io.ByteArrayOutputStream
+
+/**
+ * Puts EventType.CHUNK messages back together, per lane - counterpart of
+ * Ipc::handleChunk() on the host.
+ *
+ * A message growing past [maxSize] is dropped with the rest of its chunks,
+ * up to the next FIRST one, so its tail is never taken for a whole message.
+ * Not thread-safe.
+ */
+internal class ChunkAssembler(private val maxSize: Int) {
+    private val messages = Array(Lane.COUNT) { ByteArrayOutputStream() }
+    private val discarding = BooleanArray(Lane.COUNT)
+
+    /** Add [length] bytes of [data]; the whole message once its LAST chunk is in, null until then. */
+    fun add(lane: Int, flags: Int, data: ByteArray, length: Int): ByteArray? {
+        val message = messages[lane]
+        if ((flags and ChunkFlag.FIRST) != 0) {
+            message.reset()
+            discarding[lane] = false
+        }
+
+        if (discarding[lane]) return null
+
+        if (message.size() + length > maxSize) {
+            message.reset()
+            discarding[lane] = (flags and ChunkFlag.LAST) == 0
+            return null
+        }
+
+        message.write(data, 0, length)
+        if ((flags and ChunkFlag.LAST) == 0) return null
+
+        return message.toByteArray().also { message.reset() }
+    }
+}
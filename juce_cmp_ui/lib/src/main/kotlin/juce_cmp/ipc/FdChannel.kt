@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import com.sun.jna.Native
+import com.sun.jna.Pointer
+import com.sun.jna.ptr.IntByReference
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Socket calls, direct mapped (Native.register) rather than through a
+ * Library proxy, which reflects and boxes its arguments on every call.
+ */
+internal object SocketNative {
+    init {
+        val libFile = Native.extractFromResourcePath("iosurface_renderer")
+        Native.register(SocketNative::class.java, libFile.absolutePath)
+    }
+
+    @JvmStatic external fun socketReadAt(socketFD: Int, buffer: Pointer, offset: Long, length: Long): Long
+    @JvmStatic external fun socketWriteAt(socketFD: Int, buffer: Pointer, offset: Long, length: Long): Long
+    @JvmStatic external fun socketReceive(socketFD: Int, buffer: Pointer, length: Long, outFd: IntByReference): Long
+    @JvmStatic external fun socketWriteWithFd(socketFD: Int, buffer: Pointer, length: Long, fd: Int): Long
+}
+
+/** A direct buffer of [capacity] bytes and its address, for the native calls. */
+internal class NativeBuffer(val capacity: Int) {
+    val buffer: ByteBuffer = ByteBuffer.allocateDirect(capacity).order(ByteOrder.LITTLE_ENDIAN)
+    val address: Pointer = Native.getDirectBufferPointer(buffer)
+}
+
+// Heap data is copied through a direct buffer of this size, like the JDK's own channels do
+private const val STAGING_SIZE = 64 * 1024
+
+/**
+ * Blocking channel over an inherited socket descriptor.
+ *
+ * The JDK can't open a SocketChannel on an existing descriptor, so this
+ * does the same job: each read or write is one native call moving bytes
+ * straight between a direct buffer and the socket. Heap buffers go through
+ * a staging buffer in bulk. One thread may read while another writes.
+ */
+internal class FdChannel(private val fd: Int) {
+    private val staging = NativeBuffer(STAGING_SIZE)  // Writer only
+
+    /** Read exactly [length] bytes to [offset] in [target]. False if the socket closed. */
+    fun readFully(target: NativeBuffer, offset: Int, length: Int): Boolean {
+        var done = 0
+        while (done < length) {
+            val n = SocketNative.socketReadAt(fd, target.address, (offset + done).toLong(), (length - done).toLong())
+            if (n <= 0) return false
+            done += n.toInt()
+        }
+        return true
+    }
+
+    /** Read up to [length] bytes to the start of [target], taking a descriptor sent with them into [outFd]. */
+    fun receive(target: NativeBuffer, length: Int, outFd: IntByReference): Int =
+        SocketNative.socketReceive(fd, target.address, length.toLong(), outFd).toInt()
+
+    /** Write [length] bytes of [source] from [offset]. False if the socket closed. */
+    fun writeFully(source: NativeBuffer, offset: Int, length: Int): Boolean {
+        var done = 0
+        while (done < length) {
+            val n = SocketNative.socketWriteAt(fd, source.address, (offset + done).toLong(), (length - done).toLong())
+            if (n <= 0) return false
+            done += n.toInt()
+        }
+        return true
+    }
+
+    /** Write [length] bytes of a heap [source] from [offset], staged in bulk. */
+    fun writeFully(source: ByteBuffer, offset: Int, length: Int): Boolean {
+        if (source.isDirect) throw IllegalArgumentException("Direct buffers are written as NativeBuffer")
+
+        var done = 0
+        while (done < length) {
+            val count = minOf(STAGING_SIZE, length - done)
+            staging.buffer.put(0, source, offset + done, count)
+            if (!writeFully(staging, 0, count)) return false
+            done += count
+        }
+        return true
+    }
+
+    /** Write [length] bytes of a heap [source] with [descriptor] attached to the first byte. */
+    fun writeWithFd(source: ByteBuffer, length: Int, descriptor: Int): Boolean {
+        val count = minOf(STAGING_SIZE, length)
+        staging.buffer.put(0, source, 0, count)
+        val n = SocketNative.socketWriteWithFd(fd, staging.address, count.toLong(), descriptor).toInt()
+        if (n <= 0) return false
+
+        // The descriptor went with the first byte, the rest is a plain write
+        return if (n < count) writeFully(staging, n, count - n) && writeFully(source, count, length - count)
+        else writeFully(source, count, length - count)
+    }
+}
@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.io.OutputStream
+import java.nio.ByteBuffer
+
+/**
+ * Sender side of the identifier dictionary (Codec.DICT) - counterpart of
+ * IdentifierDictionary.h.
+ *
+ * The first use of a type or property name sends the string and assigns it
+ * the next token; later uses send only the token. Each direction has one
+ * encoder and one decoder, which must see the same messages in the same
+ * order, see EventType.FLAG_INTERNED. Not thread-safe.
+ */
+internal class IdentifierEncoder {
+    private val tokens = HashMap<String, Int>()
+    private val entries = ArrayList<String>()
+
+    /** Number of names defined so far. */
+    val size: Int get() = entries.size
+
+    /** Forget names defined after the first [size], e.g. of a message that was never sent. */
+    fun truncate(size: Int) {
+        while (entries.size > size) {
+            tokens.remove(entries.removeAt(entries.size - 1))
+        }
+    }
+
+    fun writeName(output: OutputStream, name: String) {
+        val token = tokens[name]
+        if (token != null) {
+            writeVarint(output, Dict.FIRST_TOKEN + token)
+            return
+        }
+
+        if (entries.size < Dict.MAX_ENTRIES) {
+            tokens[name] = entries.size
+            entries.add(name)
+            writeVarint(output, Dict.DEFINE)
+        } else {
+            writeVarint(output, Dict.LITERAL)
+        }
+        JuceIO.writeString(output, name)
+    }
+
+    /** A property value: JUCE var stream marker and data, without the size prefix. */
+    fun writeValue(output: OutputStream, value: Var) {
+        when (value) {
+            is Var.Void -> output.write(Dict.VAR_VOID)
+            is Var.IntVal -> {
+                output.write(VAR_MARKER_INT)
+                JuceIO.writeInt(output, value.value)
+            }
+            is Var.BoolVal -> output.write(if (value.value) VAR_MARKER_BOOL_TRUE else VAR_MARKER_BOOL_FALSE)
+            is Var.DoubleVal -> {
+                output.write(VAR_MARKER_DOUBLE)
+                JuceIO.writeDouble(output, value.value)
+            }
+            is Var.StrVal -> {
+                output.write(VAR_MARKER_STRING)
+                JuceIO.writeString(output, value.value)
+            }
+            is Var.Int64Val -> {
+                output.write(VAR_MARKER_INT64)
+                JuceIO.writeInt64(output, value.value)
+            }
+            is Var.BinaryVal -> {
+                output.write(VAR_MARKER_BINARY)
+                writeVarint(output, value.value.size)
+                output.write(value.value)
+            }
+        }
+    }
+
+    companion object {
+        // JUCE VariantStreamMarkers
+        internal const val VAR_MARKER_INT = 1
+        internal const val VAR_MARKER_BOOL_TRUE = 2
+        internal const val VAR_MARKER_BOOL_FALSE = 3
+        internal const val VAR_MARKER_DOUBLE = 4
+        internal const val VAR_MARKER_STRING = 5
+        internal const val VAR_MARKER_INT64 = 6
+        internal const val VAR_MARKER_BINARY = 8
+        internal const val VAR_MARKER_UNDEFINED = 9
+
+        fun writeVarint(output: OutputStream, value: Int) {
+            var v = value
+            while ((v and 0x7F.inv()) != 0) {
+                output.write((v and 0x7F) or 0x80)
+                v = v ushr 7
+            }
+            output.write(v)
+        }
+    }
+}
+
+/**
+ * Receiver side of the identifier dictionary. Known names come back as the
+ * String read on first use, so repeated messages allocate no name strings.
+ * Throws on malformed input.
+ */
+internal class IdentifierDecoder {
+    private val entries = ArrayList<String>()
+
+    fun readName(buffer: ByteBuffer): String {
+        val reference = readVarint(buffer)
+        if (reference >= Dict.FIRST_TOKEN) {
+            // Out of step with the encoder if missing
+            return lookup(reference - Dict.FIRST_TOKEN) ?: throw IllegalStateException("Unknown token")
+        }
+
+        val name = JuceIO.readString(buffer)
+        check(name.isNotEmpty()) { "Empty name" }
+
+        if (reference == Dict.DEFINE) define(name)
+        return name
+    }
+
+    /** The name of [token], null if it wasn't defined. */
+    fun lookup(token: Int): String? = entries.getOrNull(token)
+
+    /** Assign [name] the next token, as a DEFINE reference does. */
+    fun define(name: String) {
+        check(entries.size < Dict.MAX_ENTRIES) { "Dictionary full" }
+        entries.add(name)
+    }
+
+    /** A property value as written by IdentifierEncoder.writeValue(). */
+    fun readValue(buffer: ByteBuffer): Var {
+        return when (val marker = buffer.get().toInt() and 0xFF) {
+            Dict.VAR_VOID -> Var.Void
+            IdentifierEncoder.VAR_MARKER_INT -> Var.IntVal(buffer.getInt())
+            IdentifierEncoder.VAR_MARKER_BOOL_TRUE -> Var.BoolVal(true)
+            IdentifierEncoder.VAR_MARKER_BOOL_FALSE -> Var.BoolVal(false)
+            IdentifierEncoder.VAR_MARKER_DOUBLE -> Var.DoubleVal(buffer.getDouble())
+            IdentifierEncoder.VAR_MARKER_STRING -> Var.StrVal(JuceIO.readString(buffer))
+            IdentifierEncoder.VAR_MARKER_INT64 -> Var.Int64Val(buffer.getLong())
+            IdentifierEncoder.VAR_MARKER_BINARY -> {
+                val bytes = ByteArray(readCount(buffer))
+                buffer.get(bytes)
+                Var.BinaryVal(bytes)
+            }
+            IdentifierEncoder.VAR_MARKER_UNDEFINED -> Var.Void
+            Dict.VAR_STREAM -> Var.readFrom(buffer)
+            else -> throw IllegalStateException("Unknown value marker $marker")
+        }
+    }
+
+    /** A count, which can't exceed the bytes left whatever the input claims. */
+    fun readCount(buffer: ByteBuffer): Int {
+        val count = readVarint(buffer)
+        check(count in 0..buffer.remaining()) { "Bad count" }
+        return count
+    }
+
+    private fun readVarint(buffer: ByteBuffer): Int {
+        var value = 0
+        var shift = 0
+        while (shift < 35) {
+            val b = buffer.get().toInt() and 0xFF
+            value = value or ((b and 0x7F) shl shift)
+            if ((b and 0x80) == 0) return value
+            shift += 7
+        }
+        throw IllegalStateException("Bad varint")
+    }
+}
@@ -4,19 +4,25 @@
 package juce_cmp.ipc
 
 import com.sun.jna.Library
-import com.sun.jna.Memory
 import com.sun.jna.Native
 import com.sun.jna.Pointer
+import com.sun.jna.ptr.IntByReference
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
+import java.util.concurrent.locks.ReentrantLock
+import kotlin.concurrent.withLock
 import juce_cmp.input.InputEvent
+import juce_cmp.trace.Trace
 
 /**
- * Native library interface for socket I/O operations.
+ * Native library interface for shared memory blobs (see SharedBlob.h on the
+ * host). Socket I/O goes through FdChannel.
  */
 private interface SocketLib : Library {
-    fun socketRead(socketFD: Int, buffer: Pointer, length: Long): Long
-    fun socketWrite(socketFD: Int, buffer: Pointer, length: Long): Long
+    fun blobCreate(data: ByteArray, size: Long): Int
+    fun blobMap(fd: Int, size: Long): Pointer?
+    fun blobUnmap(mapping: Pointer, size: Long)
+    fun blobClose(fd: Int)
 
     companion object {
         val INSTANCE: SocketLib by lazy {
@@ -26,34 +32,159 @@ private interface SocketLib : Library {
     }
 }
 
+// Small messages (typed, input-sized, CMP) are built in pooled frames of this size
+private const val POOLED_FRAME_SIZE = 5 + TYPED_MAX_SIZE
+private const val MAX_POOLED_FRAMES = 64
+
 /**
  * Bidirectional IPC channel between UI and host process.
  *
- * Uses a Unix socket for bidirectional communication via native JNA calls.
+ * Uses a Unix socket for bidirectional communication, see FdChannel.
  * Protocol: 1-byte event type followed by type-specific payload.
  * See ipc_protocol.h for details.
  *
  * - Receiving runs on a background thread (host → UI)
- * - Sending is synchronous and thread-safe (UI → host)
+ * - Sending is thread-safe and only queues; a writer thread drains the queues
+ *   by lane priority, cutting large messages into chunks (UI → host)
+ * - Large payloads go through shared memory (EventType.BLOB) when agreed
+ * - Mid-sized ValueTrees are LZ4 compressed when Codec.LZ4 was agreed
+ * - Typed messages (see TypedMessage) skip ValueTrees altogether
+ * - Once warm, receiving reuses one direct buffer and small messages are
+ *   sent from pooled direct frames, so typed traffic doesn't allocate per
+ *   message; neither side copies through an intermediate buffer
+ *
+ * If the host announced a protocol version (--protocol), a HELLO with our
+ * capabilities is sent before anything else and the host answers with the
+ * settings both sides support. Older hosts get no HELLO and only ever see
+ * version 0 messages.
  */
-class Ipc(private val socketFD: Int) {
+class Ipc(private val socketFD: Int, private val hostProtocolVersion: Int = 0) {
     @Volatile
     private var running = false
     private var thread: Thread? = null
-    private val writeLock = Any()
+    private var writerThread: Thread? = null
+
+    private val channel = FdChannel(socketFD)
+
+    // Receive buffer, grown to the largest inline message and handed to the
+    // handlers (see readFully)
+    private var readBuffer = NativeBuffer(1024)
+    private val receivedFd = IntByReference(-1)
+
+    // Reassembled chunks per lane, and the message being replayed from one; the
+    // limit is the largest inline message plus its header (compressed JUCE events)
+    private val rxChunks = ChunkAssembler(MAX_MESSAGE_SIZE + 9)
+    private val rxChunk = ByteArray(CHUNK_SIZE)
+    private var replay: ByteBuffer? = null
+
+    // Compressed payloads, reused between messages
+    private var rxCompressed = ByteArray(0)
+
+    // ---- TX queues (one per lane, guarded by txLock) ----
 
-    // Reusable buffers for native I/O
-    private val readBuffer = Memory(1024)
-    private val writeBuffer = Memory(1024)
+    /**
+     * A queued message, [length] bytes of [buffer]. Pooled frames are direct
+     * ([native]), written without a copy and returned to [framePool] after.
+     */
+    private class Frame(val native: NativeBuffer?, val buffer: ByteBuffer) {
+        val pooled: Boolean get() = native != null
+        var length = 0
+        var fd = -1
+        var chunked = false
+        var offset = 0
+    }
+
+    private val txLock = ReentrantLock()
+    private val txReady = txLock.newCondition()
+    private val txQueues = Array(Lane.COUNT) { ArrayDeque<Frame>() }
+    private val framePool = ArrayDeque<Frame>()
+
+    // Only the writer thread uses it
+    private val chunkHeader = NativeBuffer(5)
 
     /** Returns true if the receiver is still running (socket not closed) */
     val isRunning: Boolean get() = running
 
+    // ---- Negotiated protocol (set by the host's HELLO reply) ----
+
+    @Volatile
+    var protocolVersion = 0
+        private set
+
+    @Volatile
+    private var capabilities = 0
+
+    @Volatile
+    private var transports = Transport.SOCKET
+
+    @Volatile
+    private var codecs = Codec.RAW
+
+    @Volatile
+    private var maxMessageSize = MAX_MESSAGE_SIZE
+
+    // Compression context, shared by sending threads
+    private val compressor = Lz4Compressor()
+
+    // Names defined in interned trees, per direction (the encoder is the lock for sending them)
+    private val txDictionary = IdentifierEncoder()
+    private val rxDictionary = IdentifierDecoder()
+
+    // Interned trees are encoded here, under the txDictionary lock
+    private val txWriter = ValueTreeWriter()
+
+    // Every JUCE event is read through it when onJuceEventView is set (receiving thread only)
+    private val rxView = ValueTreeView()
+
+    fun hasCapability(capability: Int): Boolean = (capabilities and capability) != 0
+
     // ---- Receiving (Host → UI) ----
 
     private var onInputEvent: ((InputEvent) -> Unit)? = null
     private var onJuceEvent: ((JuceValueTree) -> Unit)? = null
 
+    /**
+     * Called on the receiving thread for each JUCE event, read in place
+     * instead of built (see ValueTreeView); onJuceEvent isn't called while
+     * this is set. The view is reused and only valid during the call.
+     */
+    @Volatile
+    var onJuceEventView: ((ValueTreeView) -> Unit)? = null
+
+    /** Called on the receiving thread for each RPC message, see Rpc. */
+    @Volatile
+    var onRpc: ((kind: Int, id: Int, timeoutMs: Int, tree: JuceValueTree?) -> Unit)? = null
+
+    /**
+     * Called on the receiving thread for each mirror message (payload after
+     * the size), see MirroredValueTree. The buffer is only valid during the call.
+     */
+    @Volatile
+    var onMirror: ((payload: ByteBuffer) -> Unit)? = null
+
+    /**
+     * Called on the receiving thread for each typed message, see TypedMessage.
+     * The buffer holds the fields and is only valid during the call.
+     */
+    @Volatile
+    var onTyped: ((id: Int, payload: ByteBuffer) -> Unit)? = null
+
+    /**
+     * Called on the receiving thread when the host closes the UI on purpose
+     * (CmpEvent.SHUTDOWN), right before the process exits. The host sends
+     * SIGTERM after about a second.
+     */
+    @Volatile
+    var onShutdown: (() -> Unit)? = null
+
+    /**
+     * Called on the receiving thread when the host raises or lowers memory
+     * pressure (CmpEvent.MEMORY_PRESSURE, a MemoryPressure level). The
+     * renderer trims between frames and answers with [sendMemoryTrimmed].
+     */
+    @Volatile
+    var onMemoryPressure: ((level: Int) -> Unit)? = null
+
     fun startReceiving(
         onInputEvent: (InputEvent) -> Unit,
         onJuceEvent: ((JuceValueTree) -> Unit)? = null
@@ -62,20 +193,22 @@ class Ipc(private val socketFD: Int) {
         this.onInputEvent = onInputEvent
         this.onJuceEvent = onJuceEvent
         running = true
+        writerThread = Thread({ writerLoop() }, "IpcWriter").apply {
+            isDaemon = true
+            start()
+        }
+        if (hostProtocolVersion >= 1) {
+            sendHello()
+        }
         thread = Thread({
             while (running) {
                 try {
-                    val eventType = readByte()
+                    val eventType = readEventType()
                     if (eventType < 0) {
                         running = false
                         kotlin.system.exitProcess(0)
                     }
-
-                    when (eventType) {
-                        EventType.INPUT -> handleInputEvent()
-                        EventType.CMP -> handleCmpEvent()
-                        EventType.JUCE -> handleJuceEvent()
-                    }
+                    dispatchMessage(eventType, receivedFd.value)
                 } catch (e: Exception) {
                     // Silently ignore exceptions when running
                 }
@@ -89,36 +222,81 @@ class Ipc(private val socketFD: Int) {
         running = false
         thread?.interrupt()
         thread = null
+        txLock.withLock { txReady.signalAll() }
+        writerThread = null
+    }
+
+    private fun dispatchMessage(eventType: Int, receivedFd: Int) {
+        var fd = receivedFd
+        when (eventType) {
+            EventType.INPUT -> handleInputEvent()
+            EventType.CMP -> handleCmpEvent()
+            EventType.JUCE, EventType.RPC, EventType.MIRROR,
+            EventType.JUCE or EventType.FLAG_INTERNED,
+            EventType.RPC or EventType.FLAG_INTERNED -> handlePayloadEvent(eventType)
+            EventType.JUCE or EventType.FLAG_COMPRESSED,
+            EventType.RPC or EventType.FLAG_COMPRESSED,
+            EventType.MIRROR or EventType.FLAG_COMPRESSED,
+            EventType.JUCE or EventType.FLAG_INTERNED or EventType.FLAG_COMPRESSED,
+            EventType.RPC or EventType.FLAG_INTERNED or EventType.FLAG_COMPRESSED -> handleCompressedEvent(eventType and EventType.FLAG_COMPRESSED.inv())
+            EventType.BLOB -> {
+                handleBlobEvent(fd)
+                fd = -1
+            }
+            EventType.TYPED -> handleTypedEvent()
+            EventType.BATCH -> handleBatch()
+            EventType.CHUNK -> if (replay == null) handleChunk()  // Chunks never nest
+        }
+        // Descriptor attached to a message that doesn't take one
+        if (fd >= 0) SocketLib.INSTANCE.blobClose(fd)
     }
 
     private fun readByte(): Int {
-        val n = SocketLib.INSTANCE.socketRead(socketFD, readBuffer, 1)
-        if (n <= 0) return -1
-        return readBuffer.getByte(0).toInt() and 0xFF
+        replay?.let { return if (it.hasRemaining()) it.get().toInt() and 0xFF else -1 }
+        if (!channel.readFully(readBuffer, 0, 1)) return -1
+        return readBuffer.buffer.get(0).toInt() and 0xFF
     }
 
-    private fun readFully(size: Int): ByteArray? {
-        val data = ByteArray(size)
-        var offset = 0
-        while (offset < size && running) {
-            val toRead = minOf(1024L, (size - offset).toLong())
-            val n = SocketLib.INSTANCE.socketRead(socketFD, readBuffer, toRead)
-            if (n <= 0) return null
-            for (i in 0 until n.toInt()) {
-                data[offset + i] = readBuffer.getByte(i.toLong())
-            }
-            offset += n.toInt()
+    /** Read the event type byte with recvmsg, so an attached descriptor lands in [receivedFd]. */
+    private fun readEventType(): Int {
+        if (channel.receive(readBuffer, 1, receivedFd) <= 0) return -1
+        return readBuffer.buffer.get(0).toInt() and 0xFF
+    }
+
+    /**
+     * Read [size] bytes. Returns a little-endian view of them that is only
+     * valid until the next read, or null if the socket closed.
+     */
+    private fun readFully(size: Int): ByteBuffer? {
+        replay?.let {
+            if (it.remaining() < size) return null
+            val view = it.slice().order(ByteOrder.LITTLE_ENDIAN)
+            view.limit(size)
+            it.position(it.position() + size)
+            return view
         }
-        return if (offset == size) data else null
+
+        if (size > readBuffer.capacity) growReadBuffer(size)
+        if (!channel.readFully(readBuffer, 0, size)) return null
+
+        val view = readBuffer.buffer
+        view.clear()
+        view.limit(size)
+        return view
+    }
+
+    private fun growReadBuffer(size: Int) {
+        var capacity = readBuffer.capacity
+        while (capacity < size) capacity *= 2
+        readBuffer = NativeBuffer(capacity)
     }
 
     private fun handleInputEvent() {
-        val buffer = readFully(16) ?: run {
+        val byteBuffer = readFully(16) ?: run {
             running = false
             kotlin.system.exitProcess(0)
         }
 
-        val byteBuffer = ByteBuffer.wrap(buffer).order(ByteOrder.LITTLE_ENDIAN)
         val event = InputEvent(
             type = byteBuffer.get().toInt() and 0xFF,
             action = byteBuffer.get().toInt() and 0xFF,
@@ -140,57 +318,477 @@ class Ipc(private val socketFD: Int) {
             kotlin.system.exitProcess(0)
         }
 
-        // CmpEvent.FRAME_READY is UI → Host only
+        // CmpEvent.SURFACE_READY is UI → Host only
         // IOSurface sharing uses Mach port IPC, not socket events
+        when (subtype) {
+            CmpEvent.CLOCK_SYNC -> {
+                val hostTime = (readFully(8) ?: return).long
+                sendClockSync(hostTime, Trace.now())
+            }
+            CmpEvent.TRACE_CONTROL -> {
+                val enable = readByte()
+                if (enable > 0) Trace.start() else if (enable == 0) Trace.stop(this)
+            }
+            CmpEvent.HELLO -> {
+                handleHello(readFully(HELLO_MESSAGE_SIZE) ?: return)
+            }
+            CmpEvent.MEMORY_PRESSURE -> {
+                val level = readByte()
+                if (level >= 0) onMemoryPressure?.invoke(level)
+            }
+            CmpEvent.SHUTDOWN -> {
+                running = false
+                onShutdown?.invoke()
+                kotlin.system.exitProcess(0)
+            }
+        }
+    }
+
+    private fun handleHello(hello: ByteBuffer) {
+        if (hello.int != HELLO_MAGIC) return
+        val version = hello.short.toInt() and 0xFFFF
+        hello.short  // reserved
+        val agreedCapabilities = hello.int
+        val agreedTransports = hello.int
+        val agreedCodecs = hello.int
+        val agreedMaxMessageSize = hello.int
+
+        maxMessageSize = if (agreedMaxMessageSize > 0) agreedMaxMessageSize else MAX_MESSAGE_SIZE
+        codecs = agreedCodecs or Codec.RAW
+        transports = agreedTransports or Transport.SOCKET
+        capabilities = agreedCapabilities
+        protocolVersion = version
+    }
+
+    private fun handleTypedEvent() {
+        val header = readFully(4) ?: return
+        val id = header.short.toInt() and 0xFFFF
+        val size = header.short.toInt() and 0xFFFF
+        if (size > TYPED_MAX_SIZE) return
+
+        val payload = readFully(size) ?: return
+        Trace.scope(TraceName.IPC_RECEIVE, 5 + size) {
+            onTyped?.invoke(id, payload)
+        }
+    }
+
+    private fun handleBlobEvent(fd: Int) {
+        val header = readFully(9)
+        if (header == null || fd < 0) {
+            if (fd >= 0) SocketLib.INSTANCE.blobClose(fd)
+            return
+        }
+
+        val eventType = header.get().toInt() and 0xFF
+        val size = header.long
+
+        try {
+            if (!isBlobPayloadType(eventType) || size <= 0 || size > MAX_BLOB_SIZE) return
+
+            val mapping = SocketLib.INSTANCE.blobMap(fd, size) ?: return
+            try {
+                // Parse straight from the shared mapping, no copy into the heap first
+                Trace.scope(TraceName.IPC_RECEIVE, (10 + size).toInt()) {
+                    dispatchPayload(eventType, mapping.getByteBuffer(0, size).order(ByteOrder.LITTLE_ENDIAN))
+                }
+            } finally {
+                SocketLib.INSTANCE.blobUnmap(mapping, size)
+            }
+        } finally {
+            SocketLib.INSTANCE.blobClose(fd)
+        }
+    }
+
+    private fun handleChunk() {
+        val header = readFully(4) ?: return
+        val lane = header.get().toInt() and 0xFF
+        val flags = header.get().toInt() and 0xFF
+        val length = header.short.toInt() and 0xFFFF
+
+        val data = readFully(length) ?: return
+        if (lane >= Lane.COUNT || length > CHUNK_SIZE) return
+
+        data.get(rxChunk, 0, length)
+        val message = rxChunks.add(lane, flags, rxChunk, length) ?: return
+
+        // Feed the complete message through the normal handlers
+        replay = ByteBuffer.wrap(message)
+        try {
+            val eventType = readByte()
+            if (eventType >= 0) dispatchMessage(eventType, -1)
+        } finally {
+            replay = null
+        }
+    }
+
+    /** The host's state for a UI that just connected; each message handled as if it came on its own. */
+    private fun handleBatch() {
+        val size = (readFully(4) ?: return).int
+        if (size <= 0 || size > MAX_MESSAGE_SIZE) return
+        val payload = readFully(size) ?: return
+
+        // Copied, views from readFully() only last until the next read
+        val batch = ByteBuffer.allocate(size).order(ByteOrder.LITTLE_ENDIAN)
+        batch.put(payload).flip()
+
+        // Batches may arrive chunked, then they are being replayed already
+        val outer = replay
+        try {
+            while (batch.remaining() >= 4) {
+                val length = batch.int
+                if (length <= 0 || length > batch.remaining()) break
+
+                val message = batch.slice().order(ByteOrder.LITTLE_ENDIAN)
+                message.limit(length)
+                batch.position(batch.position() + length)
+
+                replay = message
+                when (val eventType = readByte()) {
+                    EventType.TYPED, EventType.JUCE, EventType.MIRROR -> dispatchMessage(eventType, -1)
+                }
+            }
+        } finally {
+            replay = outer
+        }
     }
 
-    private fun handleJuceEvent() {
-        val sizeBuffer = readFully(4) ?: run {
+    private fun handlePayloadEvent(eventType: Int) {
+        val size = (readFully(4) ?: run {
             running = false
             kotlin.system.exitProcess(0)
-        }
+        }).int
 
-        val size = ByteBuffer.wrap(sizeBuffer).order(ByteOrder.LITTLE_ENDIAN).int
-        if (size > 0 && onJuceEvent != null) {
+        if (size > 0 && size <= MAX_MESSAGE_SIZE) {
             val payload = readFully(size) ?: run {
                 running = false
                 kotlin.system.exitProcess(0)
             }
 
-            val tree = JuceValueTree.fromByteArray(payload)
-            onJuceEvent?.invoke(tree)
+            Trace.scope(TraceName.IPC_RECEIVE, 5 + size) {
+                dispatchPayload(eventType, payload)
+            }
+        }
+    }
+
+    private fun handleCompressedEvent(eventType: Int) {
+        val sizes = readFully(8) ?: return
+        val compressedSize = sizes.int
+        val size = sizes.int
+        if (compressedSize <= 0 || compressedSize > MAX_MESSAGE_SIZE || size <= 0 || size > MAX_MESSAGE_SIZE) return
+
+        val payload = readFully(compressedSize) ?: return
+        if (rxCompressed.size < compressedSize) rxCompressed = ByteArray(compressedSize)
+        payload.get(rxCompressed, 0, compressedSize)
+
+        Trace.scope(TraceName.IPC_RECEIVE, 9 + compressedSize) {
+            val data = Lz4Compressor.decompress(rxCompressed, 0, compressedSize, size) ?: return
+            dispatchPayload(eventType, ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN))
         }
     }
 
+    /** Hand a complete JUCE, RPC or mirror payload (ValueTree data, RPC header first) to its handler. */
+    private fun dispatchPayload(eventType: Int, payload: ByteBuffer) {
+        val interned = (eventType and EventType.FLAG_INTERNED) != 0
+        when (eventType and EventType.FLAG_INTERNED.inv()) {
+            EventType.MIRROR -> if (!interned) onMirror?.invoke(payload)
+            EventType.RPC -> {
+                val handler = onRpc ?: return
+                if (payload.remaining() < RPC_HEADER_SIZE) return
+                val kind = payload.get().toInt() and 0xFF
+                payload.position(payload.position() + 3)  // reserved
+                val id = payload.int
+                val timeoutMs = payload.int
+                // Only CANCEL comes without a tree
+                val tree = if (payload.hasRemaining()) readTree(payload, interned) else null
+                if (tree == null && kind != RpcKind.CANCEL) return
+                handler(kind, id, timeoutMs, tree)
+            }
+            EventType.JUCE -> {
+                val viewHandler = onJuceEventView
+                val handler = onJuceEvent
+                if (viewHandler != null || handler == null) {
+                    // Even when nobody listens, the names an interned tree defines must be taken
+                    val valid = if (interned) rxView.readInterned(payload, rxDictionary) else rxView.reset(payload)
+                    if (valid) viewHandler?.invoke(rxView)
+                    return
+                }
+                handler(readTree(payload, interned))
+            }
+        }
+    }
+
+    private fun readTree(payload: ByteBuffer, interned: Boolean): JuceValueTree =
+        if (interned) JuceValueTree.readFrom(payload, rxDictionary) else JuceValueTree.fromByteBuffer(payload)
+
+    private fun isBlobPayloadType(eventType: Int): Boolean = when (eventType) {
+        EventType.JUCE, EventType.RPC, EventType.MIRROR,
+        EventType.JUCE or EventType.FLAG_INTERNED,
+        EventType.RPC or EventType.FLAG_INTERNED -> true
+        else -> false
+    }
+
     // ---- Sending (UI → Host) ----
 
-    private fun writeFully(data: ByteArray) {
-        var offset = 0
-        while (offset < data.size) {
-            val toWrite = minOf(1024, data.size - offset)
-            for (i in 0 until toWrite) {
-                writeBuffer.setByte(i.toLong(), data[offset + i])
+    /** A frame to write a message of up to [size] bytes into, pooled if small. */
+    private fun obtainFrame(size: Int): Frame {
+        if (size > POOLED_FRAME_SIZE) return Frame(null, ByteBuffer.allocate(size).order(ByteOrder.LITTLE_ENDIAN))
+        val frame = txLock.withLock { framePool.removeLastOrNull() }
+            ?: NativeBuffer(POOLED_FRAME_SIZE).let { Frame(it, it.buffer) }
+        frame.buffer.clear()
+        return frame
+    }
+
+    /** Queue a complete message. [fd], if any, is sent with it and then closed. */
+    private fun enqueue(lane: Int, data: ByteArray, fd: Int = -1) {
+        val frame = Frame(null, ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN))
+        frame.buffer.position(data.size)
+        enqueue(lane, frame, fd)
+    }
+
+    /** Queue the message written to [frame]'s buffer. */
+    private fun enqueue(lane: Int, frame: Frame, fd: Int = -1) {
+        frame.length = frame.buffer.position()
+        frame.fd = fd
+        frame.offset = 0
+        // Decided now rather than when written, so nothing queued before the
+        // HELLO reply is chunked
+        frame.chunked = frame.length > CHUNK_SIZE && fd < 0 && hasCapability(Capability.CHUNKS)
+        txLock.withLock {
+            txQueues[lane.coerceIn(0, Lane.COUNT - 1)].addLast(frame)
+            txReady.signal()
+        }
+    }
+
+    private fun writerLoop() {
+        while (running) {
+            val lane: Int
+            val frame: Frame
+            txLock.withLock {
+                var next = txQueues.indexOfFirst { it.isNotEmpty() }
+                while (next < 0 && running) {
+                    txReady.await()
+                    next = txQueues.indexOfFirst { it.isNotEmpty() }
+                }
+                if (next < 0) return
+                lane = next
+                frame = txQueues[lane].first()
+            }
+
+            // Only this thread removes frames, so the front one stays put while unlocked
+            writeFrame(lane, frame)
+
+            if (frame.offset == frame.length) {
+                txLock.withLock {
+                    txQueues[lane].removeFirst()
+                    if (frame.pooled && framePool.size < MAX_POOLED_FRAMES) framePool.addLast(frame)
+                }
+            }
+        }
+    }
+
+    private fun writeFrame(lane: Int, frame: Frame) {
+        if (!frame.chunked) {
+            Trace.scope(TraceName.IPC_SEND, frame.length) {
+                if (frame.fd >= 0) {
+                    channel.writeWithFd(frame.buffer, frame.length, frame.fd)
+                    SocketLib.INSTANCE.blobClose(frame.fd)  // The host holds its own reference
+                } else {
+                    write(frame, 0, frame.length)
+                }
             }
-            val n = SocketLib.INSTANCE.socketWrite(socketFD, writeBuffer, toWrite.toLong())
-            if (n <= 0) return
-            offset += n.toInt()
+            frame.offset = frame.length
+            return
         }
+
+        // One chunk, then back to the loop so higher lanes can go first
+        val length = minOf(CHUNK_SIZE, frame.length - frame.offset)
+        var flags = 0
+        if (frame.offset == 0) flags = flags or ChunkFlag.FIRST
+        if (frame.offset + length == frame.length) flags = flags or ChunkFlag.LAST
+
+        chunkHeader.buffer.clear()
+        chunkHeader.buffer.put(EventType.CHUNK.toByte())
+        chunkHeader.buffer.put(lane.toByte())
+        chunkHeader.buffer.put(flags.toByte())
+        chunkHeader.buffer.putShort(length.toShort())
+
+        Trace.scope(TraceName.IPC_SEND, 5 + length) {
+            channel.writeFully(chunkHeader, 0, 5)
+            write(frame, frame.offset, length)
+        }
+        frame.offset += length
+    }
+
+    private fun write(frame: Frame, offset: Int, length: Int): Boolean {
+        val native = frame.native ?: return channel.writeFully(frame.buffer, offset, length)
+        return channel.writeFully(native, offset, length)
     }
 
     /**
-     * Send a JuceValueTree to the host.
+     * Send a JuceValueTree to the host. Trees on the same [lane] arrive in
+     * order; use Lane.BULK for large ones so they don't hold up small events.
      * Format: EventType.JUCE + 4-byte size + ValueTree bytes
      */
-    fun send(tree: JuceValueTree) {
-        val treeBytes = tree.toByteArray()
-        val sizeBuffer = ByteBuffer.allocate(4).order(ByteOrder.LITTLE_ENDIAN)
-        sizeBuffer.putInt(treeBytes.size)
+    fun send(tree: JuceValueTree, lane: Int = Lane.CONTROL) {
+        sendTree(EventType.JUCE, null, tree, lane)
+    }
+
+    /**
+     * Send the tree streamed into [writer] (see ValueTreeWriter), which can be
+     * reset and reused as soon as this returns.
+     * Format: EventType.JUCE + 4-byte size + ValueTree bytes
+     */
+    fun send(writer: ValueTreeWriter, lane: Int = Lane.CONTROL) {
+        sendPayload(EventType.JUCE, writer.array, writer.size, lane)
+    }
+
+    /**
+     * Send an RPC message; [tree] is null only for RpcKind.CANCEL.
+     * Format: EventType.RPC + 4-byte size + RpcHeader + ValueTree bytes
+     * Returns false if not queued, e.g. the host didn't agree to Capability.RPC.
+     */
+    fun sendRpc(kind: Int, id: Int, timeoutMs: Int, tree: JuceValueTree?, lane: Int = Lane.CONTROL): Boolean {
+        if (!hasCapability(Capability.RPC)) return false
+
+        val header = ByteBuffer.allocate(RPC_HEADER_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+        header.put(kind.toByte())
+        header.put(ByteArray(3))  // reserved
+        header.putInt(id)
+        header.putInt(timeoutMs)
+
+        return sendTree(EventType.RPC, header.array(), tree, lane)
+    }
+
+    /** Send [header] and [tree], interning the tree's names when the host agreed to Codec.DICT. */
+    private fun sendTree(eventType: Int, header: ByteArray?, tree: JuceValueTree?, lane: Int): Boolean {
+        // Interning relies on the order within a lane; the control lane carries small messages
+        if (lane != Lane.CONTROL || (codecs and Codec.DICT) == 0) {
+            val output = ValueTreeWriter()
+            header?.let { output.write(it) }
+            tree?.writeTo(output)
+            return sendPayload(eventType, output.array, output.size, lane)
+        }
+
+        // Encoded and queued in one go, so names are defined in the order the host reads them
+        synchronized(txDictionary) {
+            val output = txWriter
+            output.reset()
+            header?.let { output.write(it) }
+
+            val defined = txDictionary.size
+            tree?.writeTo(output, txDictionary)
+            if (sendPayload(eventType or EventType.FLAG_INTERNED, output.array, output.size, lane)) return true
+
+            // The host never sees the names this message defined
+            txDictionary.truncate(defined)
+            return false
+        }
+    }
+
+    /**
+     * Send a mirror message (see MirroredValueTree).
+     * Format: EventType.MIRROR + 4-byte size + payload
+     * Returns false if not queued, e.g. the host didn't agree to Capability.MIRROR.
+     */
+    fun sendMirror(payload: ByteArray): Boolean {
+        if (!hasCapability(Capability.MIRROR)) return false
+        return sendPayload(EventType.MIRROR, payload, payload.size, Lane.CONTROL)
+    }
+
+    /**
+     * Send a message generated from the schema.
+     * Format: EventType.TYPED + 2-byte message id + 2-byte size + fields
+     * Returns false if not queued, e.g. the host didn't agree to Capability.TYPED.
+     */
+    fun send(message: TypedMessage, lane: Int = Lane.CONTROL): Boolean {
+        if (!hasCapability(Capability.TYPED) || message.wireSize > TYPED_MAX_SIZE) return false
+
+        val frame = obtainFrame(5 + message.wireSize)
+        frame.buffer.put(EventType.TYPED.toByte())
+        frame.buffer.putShort(message.messageId.toShort())
+        frame.buffer.putShort(message.wireSize.toShort())
+        message.encode(frame.buffer)
+        enqueue(lane, frame)
+        return true
+    }
 
-        synchronized(writeLock) {
-            writeFully(byteArrayOf(EventType.JUCE.toByte()))
-            writeFully(sizeBuffer.array())
-            writeFully(treeBytes)
+    /**
+     * Send the first [size] bytes of [payload] (JUCE, RPC or mirror) the cheapest
+     * way the host agreed to. They're copied, so [payload] can be reused on return.
+     */
+    private fun sendPayload(eventType: Int, payload: ByteArray, size: Int, lane: Int): Boolean {
+        // Large payloads go through shared memory, only a handle uses the socket
+        if (size >= BLOB_THRESHOLD && (transports and Transport.BLOB) != 0) {
+            if (sendBlob(eventType, payload, size, lane)) return true
         }
+
+        if (size > maxMessageSize) return false  // Host would drop it
+
+        if (size >= COMPRESS_THRESHOLD && (codecs and Codec.LZ4) != 0) {
+            if (sendCompressed(eventType, payload, size, lane)) return true
+        }
+
+        val frame = obtainFrame(5 + size)
+        frame.buffer.put(eventType.toByte())
+        frame.buffer.putInt(size)
+        frame.buffer.put(payload, 0, size)
+        enqueue(lane, frame)
+        return true
+    }
+
+    /**
+     * Send [payload] LZ4 compressed, unless that doesn't make it smaller.
+     * Format: eventType | EventType.FLAG_COMPRESSED + 4-byte compressed size
+     *         + 4-byte size + LZ4 block
+     */
+    private fun sendCompressed(eventType: Int, payload: ByteArray, size: Int, lane: Int): Boolean {
+        val message = ByteArray(9 + Lz4Compressor.maxCompressedSize(size))
+        val compressedSize = synchronized(compressor) { compressor.compress(payload, size, message, 9) }
+        if (compressedSize == 0 || compressedSize >= size) return false
+
+        ByteBuffer.wrap(message, 0, 9).order(ByteOrder.LITTLE_ENDIAN).apply {
+            put((eventType or EventType.FLAG_COMPRESSED).toByte())
+            putInt(compressedSize)
+            putInt(size)
+        }
+        enqueue(lane, message.copyOf(9 + compressedSize))
+        return true
+    }
+
+    /**
+     * Send [payload] as shared memory, falling back to inline on failure.
+     * Format: EventType.BLOB (fd attached) + payload event type + 8-byte size
+     */
+    private fun sendBlob(eventType: Int, payload: ByteArray, size: Int, lane: Int): Boolean {
+        if (size > MAX_BLOB_SIZE) return false
+        val fd = SocketLib.INSTANCE.blobCreate(payload, size.toLong())
+        if (fd < 0) return false
+
+        val header = ByteBuffer.allocate(10).order(ByteOrder.LITTLE_ENDIAN)
+        header.put(EventType.BLOB.toByte())
+        header.put(eventType.toByte())
+        header.putLong(size.toLong())
+        enqueue(lane, header.array(), fd)
+        return true
+    }
+
+    /**
+     * Offer our protocol version and capabilities to the host.
+     * Format: EventType.CMP + CmpEvent.HELLO + HelloMessage (see ipc_protocol.h)
+     */
+    private fun sendHello() {
+        val message = ByteBuffer.allocate(2 + HELLO_MESSAGE_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+        message.put(EventType.CMP.toByte())
+        message.put(CmpEvent.HELLO.toByte())
+        message.putInt(HELLO_MAGIC)
+        message.putShort(PROTOCOL_VERSION.toShort())
+        message.putShort(0)
+        message.putInt(Capability.TRACE or Capability.STATS or Capability.CHUNKS or Capability.RPC or Capability.MIRROR or Capability.TYPED
+            or Capability.BATCH or Capability.SHUTDOWN or Capability.MEMORY)
+        message.putInt(Transport.SOCKET or Transport.BLOB)
+        message.putInt(Codec.RAW or Codec.LZ4 or Codec.DICT)
+        message.putInt(MAX_MESSAGE_SIZE)
+        enqueue(Lane.CONTROL, message.array())
     }
 
     /**
@@ -198,8 +796,86 @@ class Ipc(private val socketFD: Int) {
      * Format: EventType.CMP + CmpEvent.SURFACE_READY
      */
     fun sendSurfaceReady() {
-        synchronized(writeLock) {
-            writeFully(byteArrayOf(EventType.CMP.toByte(), CmpEvent.SURFACE_READY.toByte()))
-        }
+        Trace.instant(TraceName.SURFACE_READY)
+        val frame = obtainFrame(2)
+        frame.buffer.put(EventType.CMP.toByte())
+        frame.buffer.put(CmpEvent.SURFACE_READY.toByte())
+        enqueue(Lane.CONTROL, frame)
+    }
+
+    /**
+     * Answer a host clock sync request.
+     * Format: EventType.CMP + CmpEvent.CLOCK_SYNC + 8-byte host time + 8-byte UI time
+     */
+    private fun sendClockSync(hostTime: Long, uiTime: Long) {
+        val frame = obtainFrame(18)
+        frame.buffer.put(EventType.CMP.toByte())
+        frame.buffer.put(CmpEvent.CLOCK_SYNC.toByte())
+        frame.buffer.putLong(hostTime)
+        frame.buffer.putLong(uiTime)
+        enqueue(Lane.CONTROL, frame)
+    }
+
+    /**
+     * Send a batch of trace records (records occupy [batch] up to its position).
+     * Format: EventType.CMP + CmpEvent.TRACE_DATA + 1-byte final flag + 4-byte count + records
+     */
+    fun sendTraceData(batch: ByteBuffer, count: Int, final: Boolean) {
+        val message = ByteBuffer.allocate(7 + batch.position()).order(ByteOrder.LITTLE_ENDIAN)
+        message.put(EventType.CMP.toByte())
+        message.put(CmpEvent.TRACE_DATA.toByte())
+        message.put((if (final) 1 else 0).toByte())
+        message.putInt(count)
+        message.put(batch.array(), 0, batch.position())
+        enqueue(Lane.CONTROL, message.array())
+    }
+
+    /**
+     * Send a periodic performance report.
+     * Format: EventType.CMP + CmpEvent.STATS + StatsReport (see ipc_protocol.h)
+     */
+    fun sendStats(
+        intervalMs: Int,
+        frames: Int,
+        frameTimeP50: Int,
+        frameTimeP95: Int,
+        frameTimeP99: Int,
+        frameTimeMax: Int,
+        residentBytes: Long,
+        cpuTimeNs: Long
+    ) {
+        val frame = obtainFrame(2 + STATS_REPORT_SIZE)
+        val message = frame.buffer
+        message.put(EventType.CMP.toByte())
+        message.put(CmpEvent.STATS.toByte())
+        message.putInt(intervalMs)
+        message.putInt(frames)
+        message.putInt(frameTimeP50)
+        message.putInt(frameTimeP95)
+        message.putInt(frameTimeP99)
+        message.putInt(frameTimeMax)
+        message.putLong(residentBytes)
+        message.putLong(cpuTimeNs)
+        enqueue(Lane.CONTROL, frame)
+    }
+
+    /**
+     * Report the resident memory around a trim asked for with CmpEvent.MEMORY_PRESSURE.
+     * Format: EventType.CMP + CmpEvent.MEMORY_TRIMMED + MemoryTrimReport (see ipc_protocol.h)
+     */
+    fun sendMemoryTrimmed(level: Int, durationUs: Int, residentBefore: Long, residentAfter: Long) {
+        if (!hasCapability(Capability.MEMORY)) return
+
+        val frame = obtainFrame(2 + MEMORY_TRIM_REPORT_SIZE)
+        val message = frame.buffer
+        message.put(EventType.CMP.toByte())
+        message.put(CmpEvent.MEMORY_TRIMMED.toByte())
+        message.put(level.toByte())
+        message.put(0.toByte())  // reserved
+        message.putShort(0)
+        message.putInt(durationUs)
+        message.putLong(residentBefore)
+        message.putLong(residentAfter)
+        enqueue(Lane.CONTROL, frame)
     }
 }
@@ -10,15 +10,168 @@ package juce_cmp.ipc
  * Uses a Unix socket pair for bidirectional communication.
  */
 
+// Protocol version, received from the host as --protocol=<version> (0 = no handshake)
+const val PROTOCOL_VERSION = 1
+const val HELLO_MAGIC = 0x504D434A  // "JCMP" little-endian
+const val MAX_MESSAGE_SIZE = 1024 * 1024
+
+// Capabilities (Hello.capabilities bitmask)
+object Capability {
+    const val TRACE = 1 shl 0   // CLOCK_SYNC, TRACE_CONTROL, TRACE_DATA
+    const val STATS = 1 shl 1   // STATS
+    const val CHUNKS = 1 shl 2  // EventType.CHUNK
+    const val RPC = 1 shl 3     // EventType.RPC
+    const val MIRROR = 1 shl 4  // EventType.MIRROR
+    const val TYPED = 1 shl 5   // EventType.TYPED
+    const val BATCH = 1 shl 6   // EventType.BATCH
+    const val SHUTDOWN = 1 shl 7  // CmpEvent.SHUTDOWN
+    const val MEMORY = 1 shl 8    // CmpEvent.MEMORY_PRESSURE, MEMORY_TRIMMED
+}
+
+// Transports (Hello.transports bitmask)
+object Transport {
+    const val SOCKET = 1 shl 0  // Inline payloads on the socket, always set
+    const val BLOB = 1 shl 1    // EventType.BLOB: shared memory passed by fd
+    const val SURFACE_FD = 1 shl 2  // CmpEvent.SURFACE: shared pixel buffer by fd (Linux)
+}
+
+// Payloads from this size on go out as EventType.BLOB when Transport.BLOB was agreed
+const val BLOB_THRESHOLD = 64 * 1024
+const val MAX_BLOB_SIZE = 256 * 1024 * 1024
+
+// Payload codecs (Hello.codecs bitmask)
+object Codec {
+    const val RAW = 1 shl 0     // Uncompressed, always set
+    const val LZ4 = 1 shl 1     // LZ4 block format
+    const val DICT = 1 shl 2    // Interned identifiers, see EventType.FLAG_INTERNED
+}
+
+// JUCE payloads from this size on are compressed when Codec.LZ4 was agreed
+const val COMPRESS_THRESHOLD = 4 * 1024
+
 // Event types (first byte of every message)
 object EventType {
     const val INPUT = 0
     const val CMP = 1
     const val JUCE = 2
+    const val BLOB = 3  // Payload event type + 8-byte size, fd attached via SCM_RIGHTS
+    const val CHUNK = 4 // Lane + flags + 2-byte length + part of a message
+    const val RPC = 5   // 4-byte size + RpcHeader + ValueTree bytes
+    const val MIRROR = 6 // 4-byte size + mirror name + 4-byte sequence + MirrorOp operations
+    const val TYPED = 7  // 2-byte message id + 2-byte size + fields, see TypedMessage
+    const val BATCH = 8  // 4-byte size + messages, each a 4-byte size + TYPED, JUCE or MIRROR message
+
+    const val FLAG_COMPRESSED = 0x80  // Or'ed into JUCE, RPC or MIRROR: compressed size + size + LZ4 block
+    const val FLAG_INTERNED = 0x40    // Or'ed into JUCE or RPC: tree in the Codec.DICT format, control lane only
+}
+
+// Largest EventType.TYPED message body
+const val TYPED_MAX_SIZE = 1024
+
+// RPC message kinds (RpcHeader.kind)
+object RpcKind {
+    const val REQUEST = 0   // ValueTree whose type names the method
+    const val RESPONSE = 1  // Result ValueTree
+    const val ERROR = 2     // ValueTree "error" with a "message" property
+    const val CANCEL = 3    // No ValueTree; the caller gave up
+}
+
+// Mirror operations (EventType.MIRROR). Paths are a compressed-int depth plus
+// that many compressed-int child indexes from the root.
+object MirrorOp {
+    const val SET_PROPERTY = 0      // path + name + Var
+    const val REMOVE_PROPERTY = 1   // path + name
+    const val ADD_CHILD = 2         // parent path + index + ValueTree
+    const val REMOVE_CHILD = 3      // parent path + index
+    const val MOVE_CHILD = 4        // parent path + old index + new index
+    const val REPLACE = 5           // path + ValueTree; empty path = whole tree
+    const val RESYNC_REQUEST = 6    // UI→Host, no fields: send the whole tree
+}
+
+// Lanes, highest priority first. Order is kept within a lane, not across lanes.
+object Lane {
+    const val INPUT = 0     // Input events
+    const val CONTROL = 1   // Protocol messages, small ValueTrees
+    const val BULK = 2      // Large ValueTrees (state, presets)
+    const val COUNT = 3
+}
+
+// Messages above this size are sent as chunks when Capability.CHUNKS was agreed
+const val CHUNK_SIZE = 16 * 1024
+
+// Chunk flags
+object ChunkFlag {
+    const val FIRST = 1 shl 0
+    const val LAST = 1 shl 1
+}
+
+// Identifier dictionary (Codec.DICT): each name in an interned tree starts with
+// a varint reference, DEFINE or LITERAL + the string, or FIRST_TOKEN + n
+object Dict {
+    const val DEFINE = 0        // Name follows and gets the next token
+    const val LITERAL = 1       // Name follows, dictionary is full
+    const val FIRST_TOKEN = 2
+    const val MAX_ENTRIES = 1024
+
+    // Values: JUCE var stream marker + data without the size prefix, or one of these
+    const val VAR_VOID = 0x00
+    const val VAR_STREAM = 0xFF  // var::writeToStream follows (arrays, objects)
 }
 
 // CMP event types (second byte for EventType.CMP)
 // Note: IOSurface sharing uses Mach port IPC, not socket
 object CmpEvent {
     const val SURFACE_READY = 0   // UI→Host: first frame rendered to new surface
+    const val CLOCK_SYNC = 1      // Bidirectional: clock offset sample
+    const val TRACE_CONTROL = 2   // Host→UI: start/stop trace recording
+    const val TRACE_DATA = 3      // UI→Host: batch of trace records
+    const val STATS = 4           // UI→Host: periodic frame time and resource report
+    const val HELLO = 5           // Bidirectional: version and capability handshake
+    const val SURFACE = 6         // Host→UI: width + height + stride, fd attached (Linux)
+    const val SHUTDOWN = 7        // Host→UI: the host is closing, exit now
+    const val MEMORY_PRESSURE = 8 // Host→UI: 1-byte MemoryPressure level, release what can be rebuilt
+    const val MEMORY_TRIMMED = 9  // UI→Host: MemoryTrimReport after a trim
+}
+
+// Memory pressure levels (CmpEvent.MEMORY_PRESSURE)
+object MemoryPressure {
+    const val NONE = 0       // Back to normal, nothing to release
+    const val MODERATE = 1   // Trim caches, collect garbage
+    const val CRITICAL = 2   // Also drop GPU resources and shrink the heap
 }
+
+// Trace event names (TraceRecord.name), shared with the host
+object TraceName {
+    const val IPC_SEND = 0
+    const val IPC_RECEIVE = 1
+    const val CALL_ASYNC = 2
+    const val RESIZE = 3
+    const val SURFACE_SWAP = 4
+    const val FRAME = 5
+    const val COMPOSE = 6
+    const val FLUSH = 7
+    const val SURFACE_READY = 8
+}
+
+// Trace event phases (TraceRecord.phase)
+object TracePhase {
+    const val INSTANT = 0
+    const val COMPLETE = 1
+}
+
+// HelloMessage: magic(4) + version(2) + reserved(2) + capabilities(4) + transports(4)
+//               + codecs(4) + maxMessageSize(4)
+const val HELLO_MESSAGE_SIZE = 24
+
+// RpcHeader: kind(1) + reserved(3) + id(4) + timeoutMs(4)
+const val RPC_HEADER_SIZE = 12
+
+// StatsReport: intervalMs(4) + frames(4) + frame time p50/p95/p99/max in µs (4 each)
+//              + residentBytes(8) + cpuTimeNs(8)
+const val STATS_REPORT_SIZE = 40
+
+// MemoryTrimReport: level(1) + reserved(3) + durationUs(4) + residentBefore(8) + residentAfter(8)
+const val MEMORY_TRIM_REPORT_SIZE = 24
+
+// TraceRecord: timestamp(8) + duration(8) + arg(4) + name(1) + phase(1) + thread(2)
+const val TRACE_RECORD_SIZE = 24
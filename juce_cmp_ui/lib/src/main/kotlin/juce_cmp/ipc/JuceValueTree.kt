@@ -3,7 +3,6 @@
 
 package juce_cmp.ipc
 
-import java.io.ByteArrayOutputStream
 import java.io.InputStream
 import java.io.OutputStream
 import java.nio.ByteBuffer
@@ -33,7 +32,10 @@ import java.nio.ByteOrder
 class JuceValueTree(
     val type: String = ""
 ) {
-    private val properties = LinkedHashMap<String, Var>()
+    // Parallel lists in insertion order, looked up linearly like JUCE's NamedValueSet:
+    // trees have few properties, and getPropertyName(index) stays O(1)
+    private val names = ArrayList<String>()
+    private val values = ArrayList<Var>()
     private val children = mutableListOf<JuceValueTree>()
 
     /**
@@ -44,7 +46,7 @@ class JuceValueTree(
     /**
      * Number of properties.
      */
-    val numProperties: Int get() = properties.size
+    val numProperties: Int get() = names.size
 
     /**
      * Number of children.
@@ -53,47 +55,63 @@ class JuceValueTree(
 
     // --- Property access ---
 
-    operator fun get(name: String): Var = properties[name] ?: Var.Void
+    operator fun get(name: String): Var {
+        val index = names.indexOf(name)
+        return if (index >= 0) values[index] else Var.Void
+    }
 
     operator fun set(name: String, value: Var) {
-        properties[name] = value
+        val index = names.indexOf(name)
+        if (index >= 0) {
+            values[index] = value
+        } else {
+            names.add(name)
+            values.add(value)
+        }
     }
 
     operator fun set(name: String, value: Int) {
-        properties[name] = Var.IntVal(value)
+        set(name, Var.IntVal(value))
     }
 
     operator fun set(name: String, value: Long) {
-        properties[name] = Var.Int64Val(value)
+        set(name, Var.Int64Val(value))
     }
 
     operator fun set(name: String, value: Double) {
-        properties[name] = Var.DoubleVal(value)
+        set(name, Var.DoubleVal(value))
     }
 
     operator fun set(name: String, value: Float) {
-        properties[name] = Var.DoubleVal(value.toDouble())
+        set(name, Var.DoubleVal(value.toDouble()))
     }
 
     operator fun set(name: String, value: Boolean) {
-        properties[name] = Var.BoolVal(value)
+        set(name, Var.BoolVal(value))
     }
 
     operator fun set(name: String, value: String) {
-        properties[name] = Var.StrVal(value)
+        set(name, Var.StrVal(value))
     }
 
     operator fun set(name: String, value: ByteArray) {
-        properties[name] = Var.BinaryVal(value)
+        set(name, Var.BinaryVal(value))
     }
 
-    fun hasProperty(name: String): Boolean = properties.containsKey(name)
+    fun hasProperty(name: String): Boolean = names.contains(name)
 
     fun removeProperty(name: String) {
-        properties.remove(name)
+        val index = names.indexOf(name)
+        if (index >= 0) {
+            names.removeAt(index)
+            values.removeAt(index)
+        }
     }
 
-    fun getPropertyName(index: Int): String? = properties.keys.elementAtOrNull(index)
+    fun getPropertyName(index: Int): String? = names.getOrNull(index)
+
+    /** Value of the property at [index], Void if out of range. */
+    fun getProperty(index: Int): Var = values.getOrNull(index) ?: Var.Void
 
     // --- Child access ---
 
@@ -123,7 +141,7 @@ class JuceValueTree(
      * Serialize to binary format compatible with JUCE's ValueTree::readFromData().
      */
     fun toByteArray(): ByteArray {
-        val output = ByteArrayOutputStream()
+        val output = ValueTreeWriter()
         writeTo(output)
         return output.toByteArray()
     }
@@ -136,12 +154,12 @@ class JuceValueTree(
         JuceIO.writeString(output, type)
 
         // Property count (compressed int)
-        JuceIO.writeCompressedInt(output, properties.size)
+        JuceIO.writeCompressedInt(output, names.size)
 
         // Properties
-        for ((name, value) in properties) {
-            JuceIO.writeString(output, name)
-            value.writeTo(output)
+        for (i in names.indices) {
+            JuceIO.writeString(output, names[i])
+            values[i].writeTo(output)
         }
 
         // Child count (compressed int)
@@ -153,7 +171,29 @@ class JuceValueTree(
         }
     }
 
+    /**
+     * Write in the compact Codec.DICT format: same layout as writeTo(), but
+     * names are [dictionary] tokens, counts are varints and values have no
+     * size prefix.
+     */
+    internal fun writeTo(output: OutputStream, dictionary: IdentifierEncoder) {
+        dictionary.writeName(output, type)
+
+        IdentifierEncoder.writeVarint(output, names.size)
+        for (i in names.indices) {
+            dictionary.writeName(output, names[i])
+            dictionary.writeValue(output, values[i])
+        }
+
+        IdentifierEncoder.writeVarint(output, children.size)
+        for (child in children) {
+            child.writeTo(output, dictionary)
+        }
+    }
+
     companion object {
+        private const val MAX_DEPTH = 256  // Bounds the recursion on malformed input
+
         /**
          * Invalid/empty tree singleton.
          */
@@ -167,6 +207,13 @@ class JuceValueTree(
             return readFrom(buffer)
         }
 
+        /**
+         * Deserialize from a buffer (e.g. a shared memory mapping) without copying it first.
+         */
+        fun fromByteBuffer(data: ByteBuffer): JuceValueTree {
+            return readFrom(data.duplicate().order(ByteOrder.LITTLE_ENDIAN))
+        }
+
         /**
          * Read from an input stream in JUCE-compatible binary format.
          */
@@ -175,7 +222,11 @@ class JuceValueTree(
             return fromByteArray(data)
         }
 
-        private fun readFrom(buffer: ByteBuffer): JuceValueTree {
+        /**
+         * Read one tree at the buffer's position, advancing past it, e.g. from
+         * a message carrying more data after the tree. Little-endian buffer.
+         */
+        internal fun readFrom(buffer: ByteBuffer): JuceValueTree {
             // Type (null-terminated UTF-8 string)
             val type = JuceIO.readString(buffer)
             if (type.isEmpty()) return invalid
@@ -187,7 +238,7 @@ class JuceValueTree(
             repeat(numProps) {
                 val name = JuceIO.readString(buffer)
                 val value = Var.readFrom(buffer)
-                tree.properties[name] = value
+                tree[name] = value
             }
 
             // Child count (compressed int)
@@ -198,16 +249,37 @@ class JuceValueTree(
 
             return tree
         }
+
+        /**
+         * Read a tree in the compact Codec.DICT format at the buffer's position,
+         * advancing past it. Throws on malformed input.
+         */
+        internal fun readFrom(buffer: ByteBuffer, dictionary: IdentifierDecoder, depth: Int = 0): JuceValueTree {
+            check(depth <= MAX_DEPTH) { "Tree too deep" }
+
+            val tree = JuceValueTree(dictionary.readName(buffer))
+
+            repeat(dictionary.readCount(buffer)) {
+                val name = dictionary.readName(buffer)
+                tree[name] = dictionary.readValue(buffer)
+            }
+
+            repeat(dictionary.readCount(buffer)) {
+                tree.children.add(readFrom(buffer, dictionary, depth + 1))
+            }
+
+            return tree
+        }
     }
 
     override fun toString(): String = buildString {
         append("JuceValueTree($type) { ")
-        if (properties.isNotEmpty()) {
+        if (names.isNotEmpty()) {
             append("props: ")
-            append(properties.entries.joinToString(", ") { "${it.key}=${it.value}" })
+            append(names.indices.joinToString(", ") { "${names[it]}=${values[it]}" })
         }
         if (children.isNotEmpty()) {
-            if (properties.isNotEmpty()) append(", ")
+            if (names.isNotEmpty()) append(", ")
             append("children: ${children.size}")
         }
         append(" }")
@@ -227,6 +299,10 @@ object JuceIO {
      * Write a null-terminated UTF-8 string (JUCE OutputStream::writeString).
      */
     fun writeString(output: OutputStream, s: String) {
+        if (output is ValueTreeWriter) {
+            output.writeString(s)  // Encodes in place
+            return
+        }
         val bytes = s.toByteArray(Charsets.UTF_8)
         output.write(bytes)
         output.write(0)  // null terminator
@@ -236,13 +312,24 @@ object JuceIO {
      * Read a null-terminated UTF-8 string (JUCE InputStream::readString).
      */
     fun readString(buffer: ByteBuffer): String {
-        val bytes = mutableListOf<Byte>()
-        while (buffer.hasRemaining()) {
-            val b = buffer.get()
-            if (b == 0.toByte()) break
-            bytes.add(b)
+        val start = buffer.position()
+        var end = start
+        while (end < buffer.limit() && buffer.get(end) != 0.toByte()) end++
+
+        val string = decodeUtf8(buffer, start, end - start)
+        buffer.position(minOf(end + 1, buffer.limit()))  // Past the terminator
+        return string
+    }
+
+    /** [length] UTF-8 bytes at [offset] in [buffer], decoded without moving its position. */
+    internal fun decodeUtf8(buffer: ByteBuffer, offset: Int, length: Int): String {
+        if (length == 0) return ""
+        if (buffer.hasArray()) {
+            return String(buffer.array(), buffer.arrayOffset() + offset, length, Charsets.UTF_8)
         }
-        return String(bytes.toByteArray(), Charsets.UTF_8)
+        val bytes = ByteArray(length)
+        buffer.get(offset, bytes)
+        return String(bytes, Charsets.UTF_8)
     }
 
     /**
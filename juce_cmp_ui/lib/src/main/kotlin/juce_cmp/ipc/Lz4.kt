@@ -0,0 +1,175 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+/**
+ * LZ4 block format compressor - counterpart of Lz4.h on the host.
+ *
+ * Keeps its hash table between calls, so keep one per sending direction.
+ * Not thread-safe.
+ */
+internal class Lz4Compressor {
+    private val table = IntArray(1 shl HASH_LOG)
+
+    /** Compress [length] bytes of [src] into [dst] at [dstOffset]. Returns the compressed size, or 0 if it doesn't fit. */
+    fun compress(src: ByteArray, length: Int, dst: ByteArray, dstOffset: Int): Int {
+        val end = length
+        var ip = 0
+        var anchor = 0
+        var op = dstOffset
+
+        if (end >= MATCH_START_LIMIT + 1) {
+            table.fill(0)
+
+            val ipLimit = end - MATCH_START_LIMIT
+            val matchLimit = end - LAST_LITERALS
+            var misses = 0
+
+            while (ip <= ipLimit) {
+                val sequence = readInt(src, ip)
+                val h = hash(sequence)
+                var ref = table[h]
+                table[h] = ip
+
+                if (ref >= ip || ip - ref > MAX_OFFSET || readInt(src, ref) != sequence) {
+                    // Skip faster through data that doesn't compress
+                    ip += 1 + (misses++ shr 6)
+                    continue
+                }
+                misses = 0
+
+                // Extend backwards over literals, then forwards
+                while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                    ip--
+                    ref--
+                }
+
+                var matchEnd = ip + MIN_MATCH
+                var refEnd = ref + MIN_MATCH
+                while (matchEnd < matchLimit && src[matchEnd] == src[refEnd]) {
+                    matchEnd++
+                    refEnd++
+                }
+
+                val literalLength = ip - anchor
+                val matchLength = matchEnd - ip - MIN_MATCH
+
+                if (dst.size - op < 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1) return 0
+
+                val token = op++
+                dst[token] = ((minOf(literalLength, 15) shl 4) or minOf(matchLength, 15)).toByte()
+                if (literalLength >= 15) op = writeLength(dst, op, literalLength - 15)
+
+                System.arraycopy(src, anchor, dst, op, literalLength)
+                op += literalLength
+
+                val offset = ip - ref
+                dst[op++] = offset.toByte()
+                dst[op++] = (offset shr 8).toByte()
+
+                if (matchLength >= 15) op = writeLength(dst, op, matchLength - 15)
+
+                ip = matchEnd
+                anchor = ip
+            }
+        }
+
+        // Remaining input as the final literal-only sequence
+        val literalLength = end - anchor
+        if (dst.size - op < 1 + literalLength / 255 + 1 + literalLength) return 0
+
+        dst[op++] = (minOf(literalLength, 15) shl 4).toByte()
+        if (literalLength >= 15) op = writeLength(dst, op, literalLength - 15)
+
+        System.arraycopy(src, anchor, dst, op, literalLength)
+        op += literalLength
+
+        return op - dstOffset
+    }
+
+    private fun hash(sequence: Int): Int = ((sequence * -1640531535) ushr (32 - HASH_LOG))
+
+    companion object {
+        private const val HASH_LOG = 12
+        private const val MIN_MATCH = 4
+        private const val LAST_LITERALS = 5      // Block must end with this many literals
+        private const val MATCH_START_LIMIT = 12 // Last match starts at least this far from the end
+        private const val MAX_OFFSET = 65535
+
+        /** Worst-case compressed size for [n] input bytes. */
+        fun maxCompressedSize(n: Int): Int = n + n / 255 + 16
+
+        /**
+         * Decompress [length] bytes of [src] from [offset] into a block of exactly
+         * [size] bytes. Returns null for malformed input.
+         */
+        fun decompress(src: ByteArray, offset: Int, length: Int, size: Int): ByteArray? {
+            val dst = ByteArray(size)
+            val end = offset + length
+            var ip = offset
+            var op = 0
+
+            while (ip < end) {
+                val token = src[ip++].toInt() and 0xFF
+
+                var literalLength = token ushr 4
+                if (literalLength == 15) {
+                    var b: Int
+                    do {
+                        if (ip >= end) return null
+                        b = src[ip++].toInt() and 0xFF
+                        literalLength += b
+                    } while (b == 255)
+                }
+
+                if (literalLength > end - ip || literalLength > size - op) return null
+                System.arraycopy(src, ip, dst, op, literalLength)
+                ip += literalLength
+                op += literalLength
+
+                if (ip == end) break  // Last sequence has no match
+                if (end - ip < 2) return null
+
+                val matchOffset = (src[ip].toInt() and 0xFF) or ((src[ip + 1].toInt() and 0xFF) shl 8)
+                ip += 2
+                if (matchOffset == 0 || matchOffset > op) return null
+
+                var matchLength = token and 15
+                if (matchLength == 15) {
+                    var b: Int
+                    do {
+                        if (ip >= end) return null
+                        b = src[ip++].toInt() and 0xFF
+                        matchLength += b
+                    } while (b == 255)
+                }
+                matchLength += MIN_MATCH
+                if (matchLength > size - op) return null
+
+                // Byte by byte: the match may overlap the bytes being written
+                var match = op - matchOffset
+                repeat(matchLength) { dst[op++] = dst[match++] }
+            }
+
+            return if (op == size) dst else null
+        }
+
+        private fun readInt(b: ByteArray, i: Int): Int =
+            (b[i].toInt() and 0xFF) or
+            ((b[i + 1].toInt() and 0xFF) shl 8) or
+            ((b[i + 2].toInt() and 0xFF) shl 16) or
+            ((b[i + 3].toInt() and 0xFF) shl 24)
+
+        private fun writeLength(dst: ByteArray, start: Int, length: Int): Int {
+            var op = start
+            var remaining = length
+            while (remaining >= 255) {
+                dst[op++] = 255.toByte()
+                remaining -= 255
+            }
+            dst[op++] = remaining.toByte()
+            return op
+        }
+    }
+}
@@ -0,0 +1,188 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import java.io.ByteArrayOutputStream
+import java.nio.ByteBuffer
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.CopyOnWriteArrayList
+
+/**
+ * Replica of a host ValueTree - counterpart of MirroredValueTree.h.
+ *
+ * The host sends only what changed, in one batch per message-thread tick;
+ * batches are applied in place on the receiving thread. A replica that
+ * misses a batch or can't apply one asks the host for the whole tree and
+ * ignores changes until it arrives. Needs Capability.MIRROR.
+ *
+ * Get one with Library.mirror(name), using the name given on the host.
+ */
+class MirroredValueTree internal constructor(val name: String, private val ipc: Ipc) {
+    private val lock = Any()
+    private var root = JuceValueTree.invalid
+    private var synced = false
+    private var resyncRequested = false
+    private var nextSequence = 0
+    private val listeners = CopyOnWriteArrayList<() -> Unit>()
+    private val revisionFlow = MutableStateFlow(0L)
+
+    /** Bumped after every applied batch; collect it (e.g. collectAsState()) to re-read the tree. */
+    val revision: StateFlow<Long> = revisionFlow.asStateFlow()
+
+    /** Whether the replica holds the host's tree yet. */
+    val isSynced: Boolean get() = synchronized(lock) { synced }
+
+    /**
+     * Read the replica. Don't keep nodes beyond the block: later batches
+     * change them in place. The tree is invalid until the first sync.
+     */
+    fun <T> read(block: (JuceValueTree) -> T): T = synchronized(lock) { block(root) }
+
+    /** Called on the receiving thread after each applied batch. */
+    fun addListener(listener: () -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: () -> Unit) {
+        listeners.remove(listener)
+    }
+
+    /** Ask the host for the whole tree. */
+    fun requestResync() {
+        val message = ByteArrayOutputStream()
+        JuceIO.writeString(message, name)
+        JuceIO.writeInt(message, 0)
+        message.write(MirrorOp.RESYNC_REQUEST)
+
+        // Set first: the answer may arrive before sendMirror() returns
+        synchronized(lock) { resyncRequested = true }
+        if (!ipc.sendMirror(message.toByteArray())) {
+            synchronized(lock) { resyncRequested = false }
+        }
+    }
+
+    // Receiving thread; [payload] is positioned after the name
+    internal fun apply(payload: ByteBuffer) {
+        val sequence = payload.int
+        val restart = isWholeTree(payload)
+
+        val applied = synchronized(lock) {
+            if (!restart && (!synced || sequence != nextSequence)) {
+                // Missed a batch: wait for the whole tree
+                synced = false
+                false
+            } else {
+                try {
+                    while (payload.hasRemaining()) applyOp(payload)
+                    nextSequence = sequence + 1
+                    synced = true
+                    resyncRequested = false
+                    true
+                } catch (e: RuntimeException) {
+                    // Malformed or out of step; the tree may be half updated
+                    synced = false
+                    false
+                }
+            }
+        }
+
+        if (applied) {
+            revisionFlow.value += 1
+            listeners.forEach { it() }
+        } else if (!synchronized(lock) { resyncRequested }) {
+            requestResync()
+        }
+    }
+
+    // A batch starting with a whole-tree REPLACE stands on its own
+    private fun isWholeTree(payload: ByteBuffer): Boolean {
+        val position = payload.position()
+        return payload.remaining() >= 2 &&
+            (payload.get(position).toInt() and 0xFF) == MirrorOp.REPLACE &&
+            payload.get(position + 1).toInt() == 0
+    }
+
+    private fun applyOp(buffer: ByteBuffer) {
+        when (val op = buffer.get().toInt() and 0xFF) {
+            MirrorOp.SET_PROPERTY -> {
+                val node = readPath(buffer)
+                val property = JuceIO.readString(buffer)
+                node[property] = Var.readFrom(buffer)
+            }
+            MirrorOp.REMOVE_PROPERTY -> {
+                val node = readPath(buffer)
+                node.removeProperty(JuceIO.readString(buffer))
+            }
+            MirrorOp.ADD_CHILD -> {
+                val parent = readPath(buffer)
+                val index = JuceIO.readCompressedInt(buffer)
+                parent.addChild(JuceValueTree.readFrom(buffer), index)
+            }
+            MirrorOp.REMOVE_CHILD -> {
+                val parent = readPath(buffer)
+                parent.removeChild(JuceIO.readCompressedInt(buffer)) ?: throw IllegalStateException("No such child")
+            }
+            MirrorOp.MOVE_CHILD -> {
+                val parent = readPath(buffer)
+                val oldIndex = JuceIO.readCompressedInt(buffer)
+                val newIndex = JuceIO.readCompressedInt(buffer)
+                val child = parent.removeChild(oldIndex) ?: throw IllegalStateException("No such child")
+                parent.addChild(child, newIndex)
+            }
+            MirrorOp.REPLACE -> {
+                val depth = JuceIO.readCompressedInt(buffer)
+                if (depth == 0) {
+                    root = JuceValueTree.readFrom(buffer)
+                } else {
+                    var parent = root
+                    repeat(depth - 1) { parent = childAt(parent, JuceIO.readCompressedInt(buffer)) }
+                    val index = JuceIO.readCompressedInt(buffer)
+                    childAt(parent, index)  // Throws if missing
+                    parent.removeChild(index)
+                    parent.addChild(JuceValueTree.readFrom(buffer), index)
+                }
+            }
+            else -> throw IllegalStateException("Unknown mirror operation $op")
+        }
+    }
+
+    private fun readPath(buffer: ByteBuffer): JuceValueTree {
+        var node = root
+        repeat(JuceIO.readCompressedInt(buffer)) { node = childAt(node, JuceIO.readCompressedInt(buffer)) }
+        return node
+    }
+
+    private fun childAt(node: JuceValueTree, index: Int): JuceValueTree =
+        node.getChild(index) ?: throw IllegalStateException("No such child")
+}
+
+/** Routes mirror messages to replicas by name. */
+internal class Mirrors(private val ipc: Ipc) {
+    private val replicas = ConcurrentHashMap<String, MirroredValueTree>()
+
+    init {
+        ipc.onMirror = ::handleMessage
+    }
+
+    fun get(name: String): MirroredValueTree {
+        replicas[name]?.let { return it }
+
+        val replica = MirroredValueTree(name, ipc)
+        replicas.putIfAbsent(name, replica)?.let { return it }
+
+        // Registered first so the answer finds it; the host may have sent the tree before it existed
+        replica.requestResync()
+        return replica
+    }
+
+    // Receiving thread
+    private fun handleMessage(payload: ByteBuffer) {
+        val name = JuceIO.readString(payload)
+        if (payload.remaining() < 4) return
+        replicas[name]?.apply(payload)
+    }
+}
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import kotlinx.coroutines.CancellableContinuation
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.CoroutineStart
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.suspendCancellableCoroutine
+import kotlinx.coroutines.withTimeout
+import kotlinx.coroutines.withTimeoutOrNull
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.coroutines.cancellation.CancellationException
+import kotlin.coroutines.resume
+import kotlin.coroutines.resumeWithException
+
+/** A call failed: error from the host, timeout, or RPC not available. */
+class RpcException(message: String) : Exception(message)
+
+/**
+ * Request/response calls over Ipc, in both directions - counterpart of Rpc.h.
+ *
+ * A request is a JuceValueTree whose type names the method. Each request
+ * carries a correlation id, so calls can be made concurrently and replies
+ * arrive in any order: ten independent queries cost one round trip, not ten.
+ *
+ * Cancelling a calling coroutine (or its timeout) removes the pending entry
+ * and tells the host to stop. Needs Capability.RPC from the handshake.
+ */
+class Rpc(private val ipc: Ipc) {
+    private val nextId = AtomicInteger(1)
+    private val pending = ConcurrentHashMap<Int, CancellableContinuation<JuceValueTree>>()
+    private val incoming = ConcurrentHashMap<Int, Job>()
+    private val handlers = ConcurrentHashMap<String, suspend (JuceValueTree) -> JuceValueTree>()
+    private val scope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+
+    init {
+        ipc.onRpc = ::handleMessage
+    }
+
+    /**
+     * Call a host method. Throws RpcException on error or timeout;
+     * [timeoutMs] = 0 waits until the host answers or the caller is cancelled.
+     */
+    suspend fun call(request: JuceValueTree, timeoutMs: Long = DEFAULT_TIMEOUT_MS, lane: Int = Lane.CONTROL): JuceValueTree {
+        val id = nextId.getAndIncrement()
+        val timeout = timeoutMs.coerceIn(0L, Int.MAX_VALUE.toLong())
+
+        val exchange: suspend () -> JuceValueTree = {
+            suspendCancellableCoroutine { continuation ->
+                // Registered before sending, so even the fastest reply finds it
+                pending[id] = continuation
+                continuation.invokeOnCancellation {
+                    if (pending.remove(id) != null) {
+                        ipc.sendRpc(RpcKind.CANCEL, id, 0, null)
+                    }
+                }
+                if (!ipc.sendRpc(RpcKind.REQUEST, id, timeout.toInt(), request, lane)) {
+                    pending.remove(id)
+                    continuation.resumeWithException(RpcException("RPC not available"))
+                }
+            }
+        }
+
+        if (timeout == 0L) return exchange()
+        return withTimeoutOrNull(timeout) { exchange() } ?: throw RpcException("Timed out")
+    }
+
+    /**
+     * Answer host requests whose type is [method]. The handler runs on a
+     * background dispatcher and is cancelled if the host gives up; throw
+     * to send an error back.
+     */
+    fun setHandler(method: String, handler: (suspend (JuceValueTree) -> JuceValueTree)?) {
+        if (handler != null) handlers[method] = handler else handlers.remove(method)
+    }
+
+    /** Number of calls still waiting for an answer. */
+    val numPending: Int get() = pending.size
+
+    // Receiving thread
+    private fun handleMessage(kind: Int, id: Int, timeoutMs: Int, tree: JuceValueTree?) {
+        when (kind) {
+            RpcKind.REQUEST -> handleRequest(id, timeoutMs, tree ?: return)
+            RpcKind.RESPONSE -> if (tree != null) pending.remove(id)?.resume(tree)
+            RpcKind.ERROR -> pending.remove(id)?.resumeWithException(
+                RpcException(tree?.get("message")?.toStr()?.ifEmpty { null } ?: "Error")
+            )
+            RpcKind.CANCEL -> incoming.remove(id)?.cancel()
+        }
+    }
+
+    private fun handleRequest(id: Int, timeoutMs: Int, request: JuceValueTree) {
+        val handler = handlers[request.type]
+        if (handler == null) {
+            ipc.sendRpc(RpcKind.ERROR, id, 0, errorTree("Unknown method: ${request.type}"))
+            return
+        }
+
+        // Started after it is registered, so a CANCEL can always find it
+        val job = scope.launch(start = CoroutineStart.LAZY) {
+            try {
+                val result = if (timeoutMs > 0) withTimeout(timeoutMs.toLong()) { handler(request) } else handler(request)
+                ipc.sendRpc(RpcKind.RESPONSE, id, 0, result)
+            } catch (e: CancellationException) {
+                // Host cancelled or stopped waiting; nobody to answer
+            } catch (e: Exception) {
+                ipc.sendRpc(RpcKind.ERROR, id, 0, errorTree(e.message ?: e.toString()))
+            }
+        }
+        incoming[id] = job
+        job.invokeOnCompletion { incoming.remove(id, job) }
+        job.start()
+    }
+
+    private fun errorTree(message: String) = JuceValueTree("error").also { it["message"] = message }
+
+    companion object {
+        const val DEFAULT_TIMEOUT_MS = 5000L
+    }
+}
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.nio.ByteBuffer
+
+/**
+ * A fixed-layout message generated from the app's message schema -
+ * counterpart of TypedMessage.h. Sent with Library.send(message) and
+ * received through Library.host(onMessage = ...), where the generated
+ * decode(id, buffer) turns it back into a data class.
+ */
+interface TypedMessage {
+    /** Id from the schema. */
+    val messageId: Int
+
+    /** Bytes written by encode(). */
+    val wireSize: Int
+
+    /** Write the fields, packed in schema order, into a little-endian buffer. */
+    fun encode(buffer: ByteBuffer)
+}
@@ -0,0 +1,456 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Reads a serialized ValueTree in place - counterpart of ValueTreeView.h.
+ *
+ * Wraps bytes in JuceValueTree/ValueTree::writeToStream format, or in the
+ * interned Codec.DICT format, and answers the usual questions - type,
+ * properties by name, children - by scanning them. Numbers and booleans come
+ * back unboxed and names are compared against the bytes, so a handler that
+ * reads an id and a value allocates nothing. Call toTree() to keep the whole
+ * tree.
+ *
+ * A view is a reusable flyweight: reset() points it at new bytes, getChild()
+ * and forEachChild() fill in a view you pass. The input is checked once by
+ * reset(); a malformed one gives an invalid view. The bytes must not change
+ * while the view is in use. Not thread-safe.
+ */
+class ValueTreeView {
+    private var buffer: ByteBuffer = EMPTY
+    private var dictionary: IdentifierDecoder? = null  // Interned format if set
+    private var limit = 0
+    private var start = -1
+    private var end = -1
+    private var typeAt = 0
+    private var propertiesAt = 0
+
+    @PublishedApi
+    internal var childrenAt = 0
+
+    var numProperties = 0
+        private set
+
+    var numChildren = 0
+        private set
+
+    // Reading position, and what the last readName()/readValue() passed over
+    private var pos = 0
+    private var nameToken = -1  // Dictionary token, or the string below if -1
+    private var nameAt = 0
+    private var nameLength = 0
+    private var marker = VAR_VOID
+    private var dataAt = 0
+    private var dataSize = 0
+
+    val isValid: Boolean get() = start >= 0
+
+    /** Bytes this tree takes up, children included. */
+    val size: Int get() = if (isValid) end - start else 0
+
+    /**
+     * A tree in JuceValueTree.writeTo() format at the buffer's position,
+     * which is left unchanged. Little-endian buffer. False if malformed.
+     */
+    fun reset(buffer: ByteBuffer): Boolean = attach(buffer, null, null)
+
+    fun reset(data: ByteArray): Boolean = reset(ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN))
+
+    /** An interned tree whose names are already in [dictionary]. */
+    internal fun reset(buffer: ByteBuffer, dictionary: IdentifierDecoder): Boolean = attach(buffer, dictionary, null)
+
+    /**
+     * A newly received interned tree: also adds the names it defines to
+     * [dictionary], as IdentifierDecoder.readName() would. Call exactly once
+     * per message, in the order received.
+     */
+    internal fun readInterned(buffer: ByteBuffer, dictionary: IdentifierDecoder): Boolean =
+        attach(buffer, dictionary, dictionary)
+
+    // ---- Type ----
+
+    /** The type, as a new String; prefer hasType() to check it. */
+    val type: String
+        get() {
+            if (!isValid) return ""
+            pos = typeAt
+            readName(null)
+            return nameString()
+        }
+
+    fun hasType(type: String): Boolean {
+        if (!isValid) return false
+        pos = typeAt
+        readName(null)
+        return nameMatches(type)
+    }
+
+    // ---- Properties ----
+
+    fun hasProperty(name: String): Boolean = findProperty(name)
+
+    fun getPropertyName(index: Int): String? {
+        if (index !in 0 until numProperties) return null
+        pos = propertiesAt
+        repeat(index) {
+            readName(null)
+            readValue()
+        }
+        readName(null)
+        return nameString()
+    }
+
+    /** Converted like Var.toInt(); [default] if there's no such property. */
+    fun getInt(name: String, default: Int = 0): Int {
+        if (!findProperty(name)) return default
+        return when (marker) {
+            VAR_MARKER_INT -> buffer.getInt(dataAt)
+            VAR_MARKER_INT64 -> buffer.getLong(dataAt).toInt()
+            VAR_MARKER_DOUBLE -> buffer.getDouble(dataAt).toInt()
+            VAR_MARKER_BOOL_TRUE -> 1
+            VAR_MARKER_STRING -> stringValue().toIntOrNull() ?: 0
+            else -> 0
+        }
+    }
+
+    /** Converted like Var.toLong(); [default] if there's no such property. */
+    fun getLong(name: String, default: Long = 0L): Long {
+        if (!findProperty(name)) return default
+        return when (marker) {
+            VAR_MARKER_INT -> buffer.getInt(dataAt).toLong()
+            VAR_MARKER_INT64 -> buffer.getLong(dataAt)
+            VAR_MARKER_DOUBLE -> buffer.getDouble(dataAt).toLong()
+            VAR_MARKER_BOOL_TRUE -> 1L
+            VAR_MARKER_STRING -> stringValue().toLongOrNull() ?: 0L
+            else -> 0L
+        }
+    }
+
+    /** Converted like Var.toDouble(); [default] if there's no such property. */
+    fun getDouble(name: String, default: Double = 0.0): Double {
+        if (!findProperty(name)) return default
+        return when (marker) {
+            VAR_MARKER_INT -> buffer.getInt(dataAt).toDouble()
+            VAR_MARKER_INT64 -> buffer.getLong(dataAt).toDouble()
+            VAR_MARKER_DOUBLE -> buffer.getDouble(dataAt)
+            VAR_MARKER_BOOL_TRUE -> 1.0
+            VAR_MARKER_STRING -> stringValue().toDoubleOrNull() ?: 0.0
+            else -> 0.0
+        }
+    }
+
+    /** Converted like Var.toBool(); [default] if there's no such property. */
+    fun getBool(name: String, default: Boolean = false): Boolean {
+        if (!findProperty(name)) return default
+        return when (marker) {
+            VAR_MARKER_INT -> buffer.getInt(dataAt) != 0
+            VAR_MARKER_INT64 -> buffer.getLong(dataAt) != 0L
+            VAR_MARKER_DOUBLE -> buffer.getDouble(dataAt) != 0.0
+            VAR_MARKER_BOOL_TRUE -> true
+            VAR_MARKER_STRING -> stringValue().let { it.isNotEmpty() && it != "0" && it.lowercase() != "false" }
+            else -> false
+        }
+    }
+
+    /** Converted like Var.toStr(), as a new String; [default] if there's no such property. */
+    fun getString(name: String, default: String = ""): String {
+        if (!findProperty(name)) return default
+        return if (marker == VAR_MARKER_STRING) stringValue() else currentVar().toStr()
+    }
+
+    /** The value as a new Var, Void if there's no such property. */
+    fun getVar(name: String): Var = if (findProperty(name)) currentVar() else Var.Void
+
+    // ---- Children ----
+
+    /** Point [into] at child [index], or return null if out of range. */
+    fun getChild(index: Int, into: ValueTreeView = ValueTreeView()): ValueTreeView? {
+        if (index !in 0 until numChildren) return null
+        var at = childrenAt
+        repeat(index) { at = skipTree(at) }
+        into.attachChild(this, at)
+        return into
+    }
+
+    /** Call [block] with each child in turn, all read through [child]. */
+    inline fun forEachChild(child: ValueTreeView = ValueTreeView(), block: (ValueTreeView) -> Unit) {
+        var at = childrenAt
+        repeat(numChildren) {
+            at = child.attachChild(this, at)
+            block(child)
+        }
+    }
+
+    /** Build the whole tree, as JuceValueTree.fromByteArray() would. */
+    fun toTree(): JuceValueTree {
+        if (!isValid) return JuceValueTree.invalid
+
+        val tree = JuceValueTree(type)
+        pos = propertiesAt
+        repeat(numProperties) {
+            readName(null)
+            val name = nameString()
+            readValue()
+            tree[name] = currentVar()
+        }
+        forEachChild { tree.addChild(it.toTree()) }
+        return tree
+    }
+
+    override fun toString(): String = if (isValid) "ValueTreeView($type, $numProperties properties, $numChildren children)"
+                                      else "ValueTreeView(invalid)"
+
+    // ---- Reading ----
+
+    private fun attach(buffer: ByteBuffer, dictionary: IdentifierDecoder?, definer: IdentifierDecoder?): Boolean {
+        require(buffer.order() == ByteOrder.LITTLE_ENDIAN) { "Little-endian buffer required" }
+        this.buffer = buffer
+        this.dictionary = dictionary
+        limit = buffer.limit()
+        pos = buffer.position()
+
+        val valid = try {
+            scanTree(0, definer, true)
+            true
+        } catch (e: IllegalStateException) {
+            false
+        }
+        if (!valid) clear()
+        return valid
+    }
+
+    /** Point at the child tree at [at] in [parent], already checked. Returns where the next one starts. */
+    @PublishedApi
+    internal fun attachChild(parent: ValueTreeView, at: Int): Int {
+        buffer = parent.buffer
+        dictionary = parent.dictionary
+        limit = parent.limit
+        pos = at
+        scanTree(0, null, true)
+        return end
+    }
+
+    private fun clear() {
+        buffer = EMPTY
+        dictionary = null
+        start = -1
+        end = -1
+        numProperties = 0
+        numChildren = 0
+    }
+
+    private fun skipTree(at: Int): Int {
+        pos = at
+        scanTree(0, null, false)
+        return pos
+    }
+
+    /** Check one tree at pos, children included, leaving pos after it. Throws if malformed. */
+    private fun scanTree(depth: Int, definer: IdentifierDecoder?, fill: Boolean) {
+        check(depth <= MAX_DEPTH) { "Tree too deep" }
+
+        val treeStart = pos
+        readName(definer)
+
+        val properties = readCount()
+        val propertiesStart = pos
+        repeat(properties) {
+            readName(definer)
+            readValue()
+        }
+
+        val children = readCount()
+        val childrenStart = pos
+        repeat(children) { scanTree(depth + 1, definer, false) }
+
+        if (fill) {
+            start = treeStart
+            end = pos
+            typeAt = treeStart
+            propertiesAt = propertiesStart
+            childrenAt = childrenStart
+            numProperties = properties
+            numChildren = children
+        }
+    }
+
+    private fun readName(definer: IdentifierDecoder?) {
+        val dictionary = dictionary
+        val reference = if (dictionary != null) readVarint() else Dict.LITERAL
+        if (reference >= Dict.FIRST_TOKEN) {
+            nameToken = reference - Dict.FIRST_TOKEN
+            // Out of step with the encoder if missing
+            checkNotNull(dictionary!!.lookup(nameToken)) { "Unknown token" }
+            return
+        }
+
+        nameToken = -1
+        nameAt = pos
+        nameLength = readStringLength()
+        check(nameLength > 0) { "Empty name" }
+
+        if (reference == Dict.DEFINE) definer?.define(JuceIO.decodeUtf8(buffer, nameAt, nameLength))
+    }
+
+    private fun nameString(): String =
+        if (nameToken >= 0) dictionary!!.lookup(nameToken)!! else JuceIO.decodeUtf8(buffer, nameAt, nameLength)
+
+    private fun nameMatches(name: String): Boolean {
+        if (nameToken >= 0) return dictionary!!.lookup(nameToken) == name
+
+        // ASCII compared byte by byte, anything else decoded
+        var p = nameAt
+        val nameEnd = nameAt + nameLength
+        for (c in name) {
+            if (c.code >= 0x80) return JuceIO.decodeUtf8(buffer, nameAt, nameLength) == name
+            if (p == nameEnd || buffer.get(p++).toInt() != c.code) return false
+        }
+        return p == nameEnd
+    }
+
+    private fun findProperty(name: String): Boolean {
+        if (!isValid) return false
+        pos = propertiesAt
+        repeat(numProperties) {
+            readName(null)
+            val matches = nameMatches(name)
+            readValue()
+            if (matches) return true
+        }
+        return false
+    }
+
+    /** A property value: sets marker, dataAt and dataSize (string length without terminator). */
+    private fun readValue() {
+        if (dictionary == null) {
+            readStreamValue()
+            return
+        }
+
+        marker = readByte()
+        dataAt = pos
+        dataSize = 0
+        when (marker) {
+            VAR_VOID, VAR_MARKER_BOOL_TRUE, VAR_MARKER_BOOL_FALSE, VAR_MARKER_UNDEFINED -> {}
+            VAR_MARKER_INT -> skipData(4)
+            VAR_MARKER_DOUBLE, VAR_MARKER_INT64 -> skipData(8)
+            VAR_MARKER_STRING -> dataSize = readStringLength()
+            VAR_MARKER_BINARY -> {
+                val size = readCount()
+                dataAt = pos
+                skipData(size)
+            }
+            Dict.VAR_STREAM -> readStreamValue()
+            else -> throw IllegalStateException("Unknown value marker $marker")
+        }
+    }
+
+    /** A value in var::writeToStream format: compressed size, then marker and data. */
+    private fun readStreamValue() {
+        val size = readCompressedInt()
+        check(size in 0..limit - pos) { "Bad value size" }
+        if (size == 0) {
+            marker = VAR_VOID
+            dataAt = pos
+            dataSize = 0
+            return
+        }
+
+        marker = buffer.get(pos).toInt() and 0xFF
+        dataAt = pos + 1
+        dataSize = size - 1
+        pos += size
+
+        val minimum = when (marker) {
+            VAR_MARKER_INT -> 4
+            VAR_MARKER_DOUBLE, VAR_MARKER_INT64 -> 8
+            VAR_MARKER_STRING -> 1  // Terminator
+            else -> 0
+        }
+        check(dataSize >= minimum) { "Bad value size" }
+        if (marker == VAR_MARKER_STRING) dataSize--
+    }
+
+    /** The value readValue() passed over, as a new Var. */
+    private fun currentVar(): Var = when (marker) {
+        VAR_MARKER_INT -> Var.IntVal(buffer.getInt(dataAt))
+        VAR_MARKER_INT64 -> Var.Int64Val(buffer.getLong(dataAt))
+        VAR_MARKER_DOUBLE -> Var.DoubleVal(buffer.getDouble(dataAt))
+        VAR_MARKER_BOOL_TRUE -> Var.BoolVal(true)
+        VAR_MARKER_BOOL_FALSE -> Var.BoolVal(false)
+        VAR_MARKER_STRING -> Var.StrVal(stringValue())
+        VAR_MARKER_BINARY -> Var.BinaryVal(ByteArray(dataSize).also { buffer.get(dataAt, it) })
+        else -> Var.Void  // Void, undefined, and types Var doesn't have
+    }
+
+    private fun stringValue(): String = JuceIO.decodeUtf8(buffer, dataAt, dataSize)
+
+    private fun readByte(): Int {
+        check(pos < limit) { "Truncated" }
+        return buffer.get(pos++).toInt() and 0xFF
+    }
+
+    private fun skipData(size: Int) {
+        check(size <= limit - pos) { "Truncated" }
+        dataSize = size
+        pos += size
+    }
+
+    /** Length of the null-terminated string at pos, moving pos past the terminator. */
+    private fun readStringLength(): Int {
+        val at = pos
+        while (readByte() != 0) {}
+        return pos - at - 1
+    }
+
+    /** A count, which can't exceed the bytes left whatever the input claims. */
+    private fun readCount(): Int {
+        val count = if (dictionary != null) readVarint() else readCompressedInt()
+        check(count in 0..limit - pos) { "Bad count" }
+        return count
+    }
+
+    private fun readVarint(): Int {
+        var value = 0
+        var shift = 0
+        while (shift < 35) {
+            val b = readByte()
+            value = value or ((b and 0x7F) shl shift)
+            if ((b and 0x80) == 0) return value
+            shift += 7
+        }
+        throw IllegalStateException("Bad varint")
+    }
+
+    private fun readCompressedInt(): Int {
+        val numBytes = readByte()
+        check(numBytes <= 4) { "Bad compressed int" }
+        var value = 0
+        for (i in 0 until numBytes) {
+            value = value or (readByte() shl (i * 8))
+        }
+        return value
+    }
+
+    private companion object {
+        const val MAX_DEPTH = 256  // Bounds the recursion on malformed input
+
+        val EMPTY: ByteBuffer = ByteBuffer.allocate(0).order(ByteOrder.LITTLE_ENDIAN)
+
+        // JUCE VariantStreamMarkers, plus void
+        const val VAR_VOID = Dict.VAR_VOID
+        const val VAR_MARKER_INT = IdentifierEncoder.VAR_MARKER_INT
+        const val VAR_MARKER_BOOL_TRUE = IdentifierEncoder.VAR_MARKER_BOOL_TRUE
+        const val VAR_MARKER_BOOL_FALSE = IdentifierEncoder.VAR_MARKER_BOOL_FALSE
+        const val VAR_MARKER_DOUBLE = IdentifierEncoder.VAR_MARKER_DOUBLE
+        const val VAR_MARKER_STRING = IdentifierEncoder.VAR_MARKER_STRING
+        const val VAR_MARKER_INT64 = IdentifierEncoder.VAR_MARKER_INT64
+        const val VAR_MARKER_BINARY = IdentifierEncoder.VAR_MARKER_BINARY
+        const val VAR_MARKER_UNDEFINED = IdentifierEncoder.VAR_MARKER_UNDEFINED
+    }
+}
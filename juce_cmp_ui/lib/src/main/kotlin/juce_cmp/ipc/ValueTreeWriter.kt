@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import java.io.OutputStream
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Reusable buffer for writing ValueTrees in JUCE's writeToStream format.
+ *
+ * Either pass it to JuceValueTree.writeTo(), or stream a tree straight from
+ * your own state without building one:
+ *
+ *     writer.reset()
+ *     writer.startTree("param", 2)
+ *     writer.property("id", 3)
+ *     writer.property("value", 0.5)
+ *     writer.startChildren(0)
+ *     Library.send(writer)
+ *
+ * The buffer grows as needed and is kept between trees, strings are encoded
+ * in place, so a writer in steady use doesn't allocate. Not thread-safe.
+ */
+class ValueTreeWriter(initialCapacity: Int = 256) : OutputStream() {
+    private var buffer: ByteBuffer = allocate(initialCapacity)
+
+    /** Bytes written since the last reset(). */
+    val size: Int get() = buffer.position()
+
+    /** The backing array; the first [size] bytes are valid until the next write. */
+    val array: ByteArray get() = buffer.array()
+
+    /** Start over, keeping the buffer unless a large tree grew it beyond [RETAINED_CAPACITY]. */
+    fun reset() {
+        if (buffer.capacity() > RETAINED_CAPACITY) buffer = allocate(RETAINED_CAPACITY)
+        buffer.clear()
+    }
+
+    fun toByteArray(): ByteArray = buffer.array().copyOf(size)
+
+    // ---- Streaming a tree ----
+
+    /** A tree of [type] with [numProperties] properties, written next with property(). */
+    fun startTree(type: String, numProperties: Int) {
+        writeString(type)
+        writeCompressedInt(numProperties)
+    }
+
+    fun property(name: String, value: Int) {
+        writeString(name)
+        writeCompressedInt(5)  // Marker + int
+        writeByte(VAR_MARKER_INT)
+        ensure(4)
+        buffer.putInt(value)
+    }
+
+    fun property(name: String, value: Long) {
+        writeString(name)
+        writeCompressedInt(9)  // Marker + int64
+        writeByte(VAR_MARKER_INT64)
+        ensure(8)
+        buffer.putLong(value)
+    }
+
+    fun property(name: String, value: Double) {
+        writeString(name)
+        writeCompressedInt(9)  // Marker + double
+        writeByte(VAR_MARKER_DOUBLE)
+        ensure(8)
+        buffer.putDouble(value)
+    }
+
+    fun property(name: String, value: Boolean) {
+        writeString(name)
+        writeCompressedInt(1)  // Marker only
+        writeByte(if (value) VAR_MARKER_BOOL_TRUE else VAR_MARKER_BOOL_FALSE)
+    }
+
+    fun property(name: String, value: String) {
+        writeString(name)
+        writeCompressedInt(1 + utf8Length(value) + 1)  // Marker + bytes + terminator
+        writeByte(VAR_MARKER_STRING)
+        writeString(value)
+    }
+
+    fun property(name: String, value: ByteArray) {
+        writeString(name)
+        writeCompressedInt(1 + value.size)  // Marker + data
+        writeByte(VAR_MARKER_BINARY)
+        write(value, 0, value.size)
+    }
+
+    fun property(name: String, value: Var) {
+        writeString(name)
+        value.writeTo(this)
+    }
+
+    /** After the properties: [numChildren] trees follow, each from startTree(). */
+    fun startChildren(numChildren: Int) {
+        writeCompressedInt(numChildren)
+    }
+
+    // ---- JUCE OutputStream encoding ----
+
+    /** Null-terminated UTF-8, like JuceIO.writeString() but without a temporary array. */
+    fun writeString(s: String) {
+        ensure(s.length * 3 + 1)  // Worst case: every char takes 3 bytes
+        var i = 0
+        while (i < s.length) {
+            val c = s[i++].code
+            when {
+                c < 0x80 -> buffer.put(c.toByte())
+                c < 0x800 -> {
+                    buffer.put((0xC0 or (c shr 6)).toByte())
+                    buffer.put((0x80 or (c and 0x3F)).toByte())
+                }
+                Character.isHighSurrogate(c.toChar()) && i < s.length && Character.isLowSurrogate(s[i]) -> {
+                    val cp = Character.toCodePoint(c.toChar(), s[i++])
+                    buffer.put((0xF0 or (cp shr 18)).toByte())
+                    buffer.put((0x80 or ((cp shr 12) and 0x3F)).toByte())
+                    buffer.put((0x80 or ((cp shr 6) and 0x3F)).toByte())
+                    buffer.put((0x80 or (cp and 0x3F)).toByte())
+                }
+                Character.isSurrogate(c.toChar()) -> buffer.put('?'.code.toByte())  // Unpaired, as String.toByteArray() does
+                else -> {
+                    buffer.put((0xE0 or (c shr 12)).toByte())
+                    buffer.put((0x80 or ((c shr 6) and 0x3F)).toByte())
+                    buffer.put((0x80 or (c and 0x3F)).toByte())
+                }
+            }
+        }
+        buffer.put(0)
+    }
+
+    fun writeCompressedInt(value: Int) {
+        val unsigned = value.toUInt()
+        val numBytes = when {
+            value < 0 -> 4  // Negative numbers always use 4 bytes
+            unsigned <= 0xFFu -> 1
+            unsigned <= 0xFFFFu -> 2
+            unsigned <= 0xFFFFFFu -> 3
+            else -> 4
+        }
+        ensure(1 + numBytes)
+        buffer.put(numBytes.toByte())
+        for (i in 0 until numBytes) {
+            buffer.put((value shr (i * 8)).toByte())
+        }
+    }
+
+    override fun write(b: Int) = writeByte(b)
+
+    override fun write(b: ByteArray, off: Int, len: Int) {
+        ensure(len)
+        buffer.put(b, off, len)
+    }
+
+    private fun writeByte(b: Int) {
+        ensure(1)
+        buffer.put(b.toByte())
+    }
+
+    private fun ensure(count: Int) {
+        if (buffer.remaining() >= count) return
+        val grown = allocate(maxOf(buffer.capacity() * 2, buffer.position() + count))
+        buffer.flip()
+        grown.put(buffer)
+        buffer = grown
+    }
+
+    private companion object {
+        const val RETAINED_CAPACITY = 64 * 1024
+
+        // JUCE VariantStreamMarkers
+        const val VAR_MARKER_INT = 1
+        const val VAR_MARKER_BOOL_TRUE = 2
+        const val VAR_MARKER_BOOL_FALSE = 3
+        const val VAR_MARKER_DOUBLE = 4
+        const val VAR_MARKER_STRING = 5
+        const val VAR_MARKER_INT64 = 6
+        const val VAR_MARKER_BINARY = 8
+
+        fun allocate(capacity: Int): ByteBuffer =
+            ByteBuffer.allocate(maxOf(capacity, 16)).order(ByteOrder.LITTLE_ENDIAN)
+
+        /** Bytes writeString() produces for [s], terminator excluded. */
+        fun utf8Length(s: String): Int {
+            var length = 0
+            var i = 0
+            while (i < s.length) {
+                val c = s[i++]
+                length += when {
+                    c.code < 0x80 -> 1
+                    c.code < 0x800 -> 2
+                    Character.isHighSurrogate(c) && i < s.length && Character.isLowSurrogate(s[i]) -> { i++; 4 }
+                    Character.isSurrogate(c) -> 1
+                    else -> 3
+                }
+            }
+            return length
+        }
+    }
+}
@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.renderer
+
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.Recomposer
+import androidx.compose.ui.InternalComposeUiApi
+import androidx.compose.ui.graphics.asComposeCanvas
+import androidx.compose.ui.scene.CanvasLayersComposeScene
+import androidx.compose.ui.unit.Density
+import androidx.compose.ui.unit.IntSize
+import kotlinx.coroutines.Dispatchers
+import org.jetbrains.skia.Color
+import org.jetbrains.skia.Surface
+import java.lang.management.ManagementFactory
+
+/**
+ * Numbers from one [renderHeadless] run, over the measured frames only.
+ *
+ * @property frameTimesNs Time of each frame: recomposition, layout and drawing
+ * @property recompositions Composition passes the scene's recomposer applied
+ * @property allocatedBytes Allocated by the rendering thread
+ * @property elapsedNs Wall time of all measured frames
+ */
+class HeadlessRun(
+    val frameTimesNs: LongArray,
+    val recompositions: Long,
+    val allocatedBytes: Long,
+    val elapsedNs: Long
+)
+
+/**
+ * Renders Compose content offscreen for benchmarks, with the Skia raster
+ * backend: no GPU, no host, no surface sharing.
+ *
+ * Every frame is rendered, invalidated or not, on a virtual frame clock
+ * like the embedded renderer's `--frame-clock`, so animations take the
+ * same steps on every run and machine. The scene works in pixels with the
+ * density set to [scaleFactor], as in embedded mode.
+ *
+ * @param width Width in logical pixels
+ * @param height Height in logical pixels
+ * @param frames Frames to measure
+ * @param warmupFrames Frames rendered before measuring (JIT, first composition)
+ * @param onMeasureStart Called before the first measured frame, e.g. to reset counters
+ */
+@OptIn(InternalComposeUiApi::class)
+fun renderHeadless(
+    width: Int,
+    height: Int,
+    scaleFactor: Float = 1f,
+    frames: Int,
+    warmupFrames: Int = 0,
+    frameClockHz: Int = 60,
+    onMeasureStart: (() -> Unit)? = null,
+    content: @Composable () -> Unit
+): HeadlessRun {
+    val pixelWidth = (width * scaleFactor).toInt()
+    val pixelHeight = (height * scaleFactor).toInt()
+    val frameNs = 1_000_000_000L / frameClockHz.coerceAtLeast(1)
+
+    val surface = Surface.makeRasterN32Premul(pixelWidth, pixelHeight)
+    val scene = CanvasLayersComposeScene(
+        density = Density(scaleFactor),
+        size = IntSize(pixelWidth, pixelHeight),
+        coroutineContext = Dispatchers.Unconfined,
+        invalidate = {}
+    )
+
+    // Recomposition runs inline on this thread (Unconfined), so its allocations count here
+    val threads = ManagementFactory.getThreadMXBean() as com.sun.management.ThreadMXBean
+    val threadId = Thread.currentThread().threadId()
+
+    try {
+        scene.setContent(content)
+
+        val frameTimes = LongArray(frames)
+        var recompositionsStart = 0L
+        var allocatedStart = 0L
+        var start = 0L
+
+        for (i in 0 until warmupFrames + frames) {
+            if (i == warmupFrames) {
+                onMeasureStart?.invoke()
+                recompositionsStart = recomposerChanges()
+                allocatedStart = threads.getThreadAllocatedBytes(threadId)
+                start = System.nanoTime()
+            }
+
+            val frameStart = System.nanoTime()
+            val canvas = surface.canvas
+            canvas.clear(Color.TRANSPARENT)
+            scene.render(canvas.asComposeCanvas(), i * frameNs)
+            if (i >= warmupFrames) frameTimes[i - warmupFrames] = System.nanoTime() - frameStart
+        }
+
+        return HeadlessRun(
+            frameTimesNs = frameTimes,
+            recompositions = recomposerChanges() - recompositionsStart,
+            allocatedBytes = threads.getThreadAllocatedBytes(threadId) - allocatedStart,
+            elapsedNs = System.nanoTime() - start
+        )
+    } finally {
+        scene.close()
+        surface.close()
+    }
+}
+
+/** Changes applied by every running recomposer; only the benchmark's scene runs one here. */
+private fun recomposerChanges(): Long =
+    Recomposer.runningRecomposers.value.sumOf { it.changeCount }
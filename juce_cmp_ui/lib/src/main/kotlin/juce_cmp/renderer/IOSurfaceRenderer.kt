@@ -16,14 +16,19 @@ import com.sun.jna.ptr.IntByReference
 import kotlinx.coroutines.*
 import juce_cmp.ipc.Ipc
 import juce_cmp.ipc.JuceValueTree
+import juce_cmp.ipc.MemoryPressure
+import juce_cmp.ipc.TraceName
 import juce_cmp.input.InputDispatcher
 import juce_cmp.input.InputEvent
 import juce_cmp.input.InputType
+import juce_cmp.trace.FrameStats
+import juce_cmp.trace.Trace
 import org.jetbrains.skia.*
 import java.util.concurrent.ConcurrentLinkedQueue
 import java.util.concurrent.CountDownLatch
 import java.util.concurrent.TimeUnit
 import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.atomic.AtomicReference
 
 /**
@@ -34,6 +39,7 @@ import java.util.concurrent.atomic.AtomicReference
  * @param ipc The IPC channel for communication with host
  * @param onFrameRendered Optional callback invoked after each frame is rendered
  * @param onJuceEvent Optional callback when host sends events of type JUCE (JuceValueTree payload)
+ * @param frameClockHz Frames per second of a virtual frame clock, 0 for the system clock
  * @param content The Compose content to render
  */
 fun runIOSurfaceRenderer(
@@ -43,9 +49,10 @@ fun runIOSurfaceRenderer(
     ipc: Ipc,
     onFrameRendered: ((frameNumber: Long, surface: Surface) -> Unit)? = null,
     onJuceEvent: ((tree: JuceValueTree) -> Unit)? = null,
+    frameClockHz: Int = 0,
     content: @Composable () -> Unit
 ) {
-    runIOSurfaceRendererImpl(socketFD, scaleFactor, machServiceName, ipc, onFrameRendered, onJuceEvent, content)
+    runIOSurfaceRendererImpl(socketFD, scaleFactor, machServiceName, ipc, onFrameRendered, onJuceEvent, frameClockHz, content)
 }
 
 /**
@@ -114,6 +121,19 @@ private fun createRenderResourcesFromIOSurface(
     return createRenderResourcesFromTexture(metalContext, devicePtr, queuePtr, texturePtr, widthRef.value, heightRef.value)
 }
 
+/**
+ * Same texture, new DirectContext: whatever Skia cached on the GPU is released.
+ */
+private fun RenderResources.withNewContext(
+    metalContext: Pointer,
+    devicePtr: Pointer,
+    queuePtr: Pointer
+): RenderResources {
+    skiaSurface.close()
+    directContext.close()
+    return createRenderResourcesFromTexture(metalContext, devicePtr, queuePtr, texturePtr, width, height)
+}
+
 /**
  * Creates RenderResources from an already-created texture pointer.
  */
@@ -177,6 +197,7 @@ private fun runIOSurfaceRendererImpl(
     ipc: Ipc,
     onFrameRendered: ((frameNumber: Long, surface: Surface) -> Unit)? = null,
     onJuceEvent: ((tree: JuceValueTree) -> Unit)? = null,
+    frameClockHz: Int = 0,
     content: @Composable () -> Unit
 ) {
     if (machServiceName == null) {
@@ -213,6 +234,15 @@ private fun runIOSurfaceRendererImpl(
         // Event queue for input events
         val eventQueue = ConcurrentLinkedQueue<InputEvent>()
 
+        // Memory pressure from the host, trimmed on the render thread
+        val pendingTrim = AtomicInteger(MemoryPressure.NONE)
+        ipc.onMemoryPressure = { level ->
+            if (level != MemoryPressure.NONE) {
+                pendingTrim.set(level)
+                needsRedraw.set(true)
+            }
+        }
+
         // Start receiving events from host via socket (must be before surface thread so isRunning is true)
         ipc.startReceiving(
             onInputEvent = { event ->
@@ -276,6 +306,7 @@ private fun runIOSurfaceRendererImpl(
             // Render loop
             runBlocking {
                 var frameCount = 0
+                val frameStats = FrameStats(ipc)
                 var surfaceChanged = true  // Initial surface needs SURFACE_READY signal
 
                 while (ipc.isRunning) {
@@ -288,6 +319,7 @@ private fun runIOSurfaceRendererImpl(
 
                         if (newSurface != null) {
                             // New surface arrived - swap it in
+                            Trace.instant(TraceName.SURFACE_SWAP)
                             resources.close()
                             resources = createRenderResourcesFromIOSurface(metalContext, devicePtr, queuePtr, newSurface)
 
@@ -317,16 +349,31 @@ private fun runIOSurfaceRendererImpl(
                             surfaceChanged = true
                         }
 
+                        // Between frames, as the GPU context belongs to this thread
+                        val trimLevel = pendingTrim.getAndSet(MemoryPressure.NONE)
+                        if (trimLevel != MemoryPressure.NONE) {
+                            trimMemory(ipc, trimLevel) {
+                                resources = resources.withNewContext(metalContext, devicePtr, queuePtr)
+                            }
+                            needsRedraw.set(true)
+                        }
+
                         // Process input events
                         while (true) {
                             val event = eventQueue.poll() ?: break
                             inputDispatcher.dispatch(event)
                         }
 
-                        // Render
+                        // Render; on a virtual clock animations step the same every frame,
+                        // however long frames take, so a replayed session renders the same frames
+                        val frameTime = if (frameClockHz > 0) frameCount * (1_000_000_000L / frameClockHz) else frameStart
                         val canvas = resources.skiaSurface.canvas
-                        scene.render(canvas.asComposeCanvas(), frameStart)
-                        resources.skiaSurface.flushAndSubmit(syncCpu = true)
+                        Trace.scope(TraceName.COMPOSE) {
+                            scene.render(canvas.asComposeCanvas(), frameTime)
+                        }
+                        Trace.scope(TraceName.FLUSH) {
+                            resources.skiaSurface.flushAndSubmit(syncCpu = true)
+                        }
 
                         onFrameRendered?.invoke(frameCount.toLong(), resources.skiaSurface)
 
@@ -335,6 +382,9 @@ private fun runIOSurfaceRendererImpl(
                             ipc.sendSurfaceReady()
                             surfaceChanged = false
                         }
+                        Trace.complete(TraceName.FRAME, frameStart, frameCount)
+                        frameStats.frameRendered(frameStart)
+                        Trace.flushIfDue(ipc)
                         frameCount++
                         needsRedraw.set(false)
                     } catch (e: CancellationException) {
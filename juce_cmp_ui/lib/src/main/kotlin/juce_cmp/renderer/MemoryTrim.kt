@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.renderer
+
+import com.sun.management.HotSpotDiagnosticMXBean
+import juce_cmp.ipc.Ipc
+import juce_cmp.ipc.MemoryPressure
+import juce_cmp.trace.residentMemory
+import org.jetbrains.skia.Graphics
+import java.lang.management.ManagementFactory
+
+/**
+ * Releases what the UI can rebuild when the host raises memory pressure
+ * (CmpEvent.MEMORY_PRESSURE), and reports the resident memory before and
+ * after (CmpEvent.MEMORY_TRIMMED).
+ *
+ * MODERATE purges Skia's font and resource caches and collects garbage.
+ * CRITICAL also drops the GPU context with [dropGpuResources], which frees
+ * its texture cache and the offscreen layers in it (rebuilt on the next
+ * frame, composition state is kept), and collects with the heap's free
+ * ratios lowered so the heap hands memory back to the OS.
+ *
+ * Call on the render thread, between frames.
+ */
+internal fun trimMemory(ipc: Ipc, level: Int, dropGpuResources: () -> Unit) {
+    if (level == MemoryPressure.NONE) return
+
+    val start = System.nanoTime()
+    val before = residentMemory()
+
+    Graphics.purgeFontCache()
+    Graphics.purgeResourceCache()
+
+    if (level >= MemoryPressure.CRITICAL) {
+        dropGpuResources()
+        Graphics.purgeAllCaches()
+        collectGarbage(shrinkHeap = true)
+    } else {
+        collectGarbage(shrinkHeap = false)
+    }
+
+    ipc.sendMemoryTrimmed(level, ((System.nanoTime() - start) / 1000).toInt(), before, residentMemory())
+}
+
+/**
+ * Full collection. G1 and Parallel uncommit what's free above MaxHeapFreeRatio
+ * after one; with [shrinkHeap] both ratios are lowered for this collection
+ * (they're manageable, settable at runtime) and put back after.
+ */
+private fun collectGarbage(shrinkHeap: Boolean) {
+    val vm = if (shrinkHeap) ManagementFactory.getPlatformMXBean(HotSpotDiagnosticMXBean::class.java) else null
+    val min = vm?.let { runCatching { it.getVMOption("MinHeapFreeRatio").value }.getOrNull() }
+    val max = vm?.let { runCatching { it.getVMOption("MaxHeapFreeRatio").value }.getOrNull() }
+
+    // Min never above max: lowered min first, raised max first when restoring
+    if (vm != null && min != null && max != null) {
+        runCatching {
+            vm.setVMOption("MinHeapFreeRatio", "0")
+            vm.setVMOption("MaxHeapFreeRatio", "10")
+        }
+    }
+
+    try {
+        System.gc()
+    } finally {
+        if (vm != null && min != null && max != null) {
+            runCatching {
+                vm.setVMOption("MaxHeapFreeRatio", max)
+                vm.setVMOption("MinHeapFreeRatio", min)
+            }
+        }
+    }
+}
@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.trace
+
+import com.sun.jna.Library
+import com.sun.jna.Native
+import java.lang.management.ManagementFactory
+import juce_cmp.ipc.Capability
+import juce_cmp.ipc.Ipc
+
+/**
+ * Native library interface for process resource queries.
+ */
+private interface ProcessLib : Library {
+    fun getResidentMemory(): Long
+
+    companion object {
+        val INSTANCE: ProcessLib by lazy {
+            val libFile = Native.extractFromResourcePath("iosurface_renderer")
+            Native.load(libFile.absolutePath, ProcessLib::class.java)
+        }
+    }
+}
+
+/** Resident memory of this process, 0 if it can't be read. */
+internal fun residentMemory(): Long =
+    try { ProcessLib.INSTANCE.getResidentMemory() } catch (e: Throwable) { 0L }
+
+/**
+ * Collects frame times on the render thread and reports them to the host
+ * about once per second (CmpEvent.STATS), together with the process memory
+ * footprint and CPU time. The host turns these into ComposeProvider::getStats().
+ *
+ * Not thread-safe: call [frameRendered] from the render loop only.
+ */
+class FrameStats(private val ipc: Ipc) {
+    private companion object {
+        const val REPORT_INTERVAL_NS = 1_000_000_000L
+        const val MAX_FRAMES = 1024
+    }
+
+    private val frameTimes = IntArray(MAX_FRAMES)  // µs
+    private val sorted = IntArray(MAX_FRAMES)
+    private var frames = 0
+    private var intervalStart = System.nanoTime()
+
+    private val osBean = ManagementFactory.getOperatingSystemMXBean() as? com.sun.management.OperatingSystemMXBean
+
+    /** Record one frame that started at [frameStart] (System.nanoTime) and just finished. */
+    fun frameRendered(frameStart: Long) {
+        val now = System.nanoTime()
+        if (frames < MAX_FRAMES) {
+            frameTimes[frames] = ((now - frameStart) / 1000).toInt()
+        }
+        frames++
+
+        if (now - intervalStart >= REPORT_INTERVAL_NS) {
+            report(now)
+        }
+    }
+
+    private fun report(now: Long) {
+        if (!ipc.hasCapability(Capability.STATS)) {
+            frames = 0
+            intervalStart = now
+            return
+        }
+
+        val count = minOf(frames, MAX_FRAMES)
+        System.arraycopy(frameTimes, 0, sorted, 0, count)
+        sorted.sort(0, count)
+
+        fun percentile(p: Int): Int = if (count == 0) 0 else sorted[minOf(count - 1, count * p / 100)]
+
+        ipc.sendStats(
+            intervalMs = ((now - intervalStart) / 1_000_000).toInt(),
+            frames = frames,
+            frameTimeP50 = percentile(50),
+            frameTimeP95 = percentile(95),
+            frameTimeP99 = percentile(99),
+            frameTimeMax = if (count == 0) 0 else sorted[count - 1],
+            residentBytes = residentMemory(),
+            cpuTimeNs = osBean?.processCpuTime?.coerceAtLeast(0L) ?: 0L
+        )
+
+        frames = 0
+        intervalStart = now
+    }
+}
@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.trace
+
+import juce_cmp.ipc.Ipc
+import juce_cmp.ipc.TRACE_RECORD_SIZE
+import juce_cmp.ipc.TracePhase
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * Timeline recorder for the UI process - counterpart of Trace.h on the host.
+ *
+ * Each thread records into its own fixed-size ring (single writer, drained by
+ * one flusher at a time), so recording never blocks or allocates. While
+ * tracing is off, a record call is a single volatile read.
+ *
+ * The host turns recording on and off with CmpEvent.TRACE_CONTROL. Records
+ * are shipped in batches (CmpEvent.TRACE_DATA) and merged into the host
+ * timeline using the clock offset measured with CmpEvent.CLOCK_SYNC.
+ */
+object Trace {
+    private const val CAPACITY = 4096
+    private const val MAX_BATCH = 1024
+    private const val FLUSH_INTERVAL_NS = 250_000_000L
+
+    @Volatile
+    var isEnabled = false
+        private set
+
+    private class ThreadBuffer(val index: Int) {
+        val timestamps = LongArray(CAPACITY)
+        val durations = LongArray(CAPACITY)
+        val args = IntArray(CAPACITY)
+        val names = ByteArray(CAPACITY)
+        val phases = ByteArray(CAPACITY)
+
+        @Volatile var head = 0L  // Written by the owning thread
+        @Volatile var tail = 0L  // Written by the flusher
+    }
+
+    private val threadCount = AtomicInteger(0)
+    private val buffers = CopyOnWriteArrayList<ThreadBuffer>()
+    private val localBuffer = ThreadLocal.withInitial {
+        ThreadBuffer(threadCount.getAndIncrement()).also { buffers.add(it) }
+    }
+
+    private val flushLock = Any()
+    private var lastFlush = 0L
+    private val batch = ByteBuffer.allocate(MAX_BATCH * TRACE_RECORD_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+
+    /** Monotonic time in nanoseconds. */
+    fun now(): Long = System.nanoTime()
+
+    /** Discard stale records and start recording. */
+    fun start() {
+        synchronized(flushLock) {
+            for (b in buffers) b.tail = b.head
+            lastFlush = now()
+        }
+        isEnabled = true
+    }
+
+    /** Stop recording and send everything left as the final batch. */
+    fun stop(ipc: Ipc) {
+        isEnabled = false
+        flush(ipc, final = true)
+    }
+
+    fun instant(name: Int, arg: Int = 0) {
+        if (isEnabled) record(name, TracePhase.INSTANT, now(), 0L, arg)
+    }
+
+    fun complete(name: Int, startTime: Long, arg: Int = 0) {
+        if (isEnabled) record(name, TracePhase.COMPLETE, startTime, now() - startTime, arg)
+    }
+
+    /** Record [block] as a complete event. */
+    inline fun <T> scope(name: Int, arg: Int = 0, block: () -> T): T {
+        if (!isEnabled) return block()
+        val start = now()
+        try {
+            return block()
+        } finally {
+            complete(name, start, arg)
+        }
+    }
+
+    /** Ship pending records if the flush interval has elapsed. Call once per frame. */
+    fun flushIfDue(ipc: Ipc) {
+        if (isEnabled && now() - lastFlush >= FLUSH_INTERVAL_NS) {
+            flush(ipc, final = false)
+        }
+    }
+
+    private fun record(name: Int, phase: Int, timestamp: Long, duration: Long, arg: Int) {
+        val b = localBuffer.get()
+        val head = b.head
+        if (head - b.tail >= CAPACITY) return  // Full until next flush - drop
+
+        val i = (head % CAPACITY).toInt()
+        b.timestamps[i] = timestamp
+        b.durations[i] = duration
+        b.args[i] = arg
+        b.names[i] = name.toByte()
+        b.phases[i] = phase.toByte()
+        b.head = head + 1
+    }
+
+    private fun flush(ipc: Ipc, final: Boolean) {
+        synchronized(flushLock) {
+            lastFlush = now()
+            batch.clear()
+            var count = 0
+
+            for (b in buffers) {
+                var tail = b.tail
+                val head = b.head
+                while (tail < head) {
+                    if (count == MAX_BATCH) {
+                        ipc.sendTraceData(batch, count, final = false)
+                        batch.clear()
+                        count = 0
+                    }
+                    val i = (tail % CAPACITY).toInt()
+                    batch.putLong(b.timestamps[i])
+                    batch.putLong(b.durations[i])
+                    batch.putInt(b.args[i])
+                    batch.put(b.names[i])
+                    batch.put(b.phases[i])
+                    batch.putShort(b.index.toShort())
+                    tail++
+                    count++
+                }
+                b.tail = tail
+            }
+
+            if (count > 0 || final) {
+                ipc.sendTraceData(batch, count, final)
+            }
+        }
+    }
+}
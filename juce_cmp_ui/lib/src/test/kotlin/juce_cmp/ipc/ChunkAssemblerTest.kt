@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2026 Luciano Iam <oss@lucianoiam.com>
+// SPDX-License-Identifier: MIT
+
+package juce_cmp.ipc
+
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertNull
+
+class ChunkAssemblerTest {
+    private fun bytes(vararg values: Int) = ByteArray(values.size) { values[it].toByte() }
+
+    @Test
+    fun joinsChunksOfOneMessage() {
+        val assembler = ChunkAssembler(maxSize = 16)
+
+        assertNull(assembler.add(Lane.BULK, ChunkFlag.FIRST, bytes(1, 2), 2))
+        assertNull(assembler.add(Lane.BULK, 0, bytes(3, 4), 2))
+        assertContentEquals(bytes(1, 2, 3, 4, 5), assembler.add(Lane.BULK, ChunkFlag.LAST, bytes(5), 1))
+    }
+
+    @Test
+    fun keepsLanesApart() {
+        val assembler = ChunkAssembler(maxSize = 16)
+
+        assertNull(assembler.add(Lane.BULK, ChunkFlag.FIRST, bytes(1), 1))
+        assertContentEquals(bytes(9), assembler.add(Lane.INPUT, ChunkFlag.FIRST or ChunkFlag.LAST, bytes(9), 1))
+        assertContentEquals(bytes(1, 2), assembler.add(Lane.BULK, ChunkFlag.LAST, bytes(2), 1))
+    }
+
+    @Test
+    fun dropsTheRestOfAnOversizedMessage() {
+        val assembler = ChunkAssembler(maxSize = 4)
+
+        assertNull(assembler.add(Lane.BULK, ChunkFlag.FIRST, bytes(1, 2, 3), 3))
+        assertNull(assembler.add(Lane.BULK, 0, bytes(4, 5, 6), 3))  // Over the limit
+        assertNull(assembler.add(Lane.BULK, 0, bytes(7), 1))
+        assertNull(assembler.add(Lane.BULK, ChunkFlag.LAST, bytes(8), 1))  // Not a message of its own
+
+        // The next message is whole again
+        assertNull(assembler.add(Lane.BULK, ChunkFlag.FIRST, bytes(10), 1))
+        assertContentEquals(bytes(10, 11), assembler.add(Lane.BULK, ChunkFlag.LAST, bytes(11), 1))
+    }
+
+    @Test
+    fun oversizedLastChunkLeavesNothingBehind() {
+        val assembler = ChunkAssembler(maxSize = 4)
+
+        assertNull(assembler.add(Lane.BULK, ChunkFlag.FIRST, bytes(1, 2, 3), 3))
+        assertNull(assembler.add(Lane.BULK, ChunkFlag.LAST, bytes(4, 5), 2))
+
+        // No FIRST seen since, but the oversized message ended with its LAST
+        assertContentEquals(bytes(6), assembler.add(Lane.BULK, ChunkFlag.FIRST or ChunkFlag.LAST, bytes(6), 1))
+    }
+}